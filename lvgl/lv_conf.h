@@ -30,7 +30,12 @@
  * - LV_STDLIB_RTTHREAD:    RT-Thread implementation
  * - LV_STDLIB_CUSTOM:      Implement the functions externally
  */
+#ifdef LVGL_SLAB_ALLOC
+/* Size class pools with a C heap fallback, implemented in src/slab_alloc.c */
+#define LV_USE_STDLIB_MALLOC    LV_STDLIB_CUSTOM
+#else
 #define LV_USE_STDLIB_MALLOC    LV_STDLIB_BUILTIN
+#endif
 
 /** Possible values
  * - LV_STDLIB_BUILTIN:     LVGL's built in implementation
@@ -515,8 +520,13 @@
 /** Define a custom attribute for `lv_timer_handler` function */
 #define LV_ATTRIBUTE_TIMER_HANDLER
 
-/** Define a custom attribute for `lv_display_flush_ready` function */
+/** Define a custom attribute for `lv_display_flush_ready` function
+ *  It marks lv_display_flush_is_last() too, both are called from the flush path in SRAM. */
+#ifdef HOT_PATHS_IN_SRAM
+#define LV_ATTRIBUTE_FLUSH_READY __attribute__((section(".time_critical.lvgl")))
+#else
 #define LV_ATTRIBUTE_FLUSH_READY
+#endif
 
 /** Align VG_LITE buffers on this number of bytes.
  *  @note  vglite_src_buf_aligned() uses this value to validate alignment of passed buffer pointers. */
@@ -532,8 +542,14 @@
 /** Compiler prefix for a large array declaration in RAM */
 #define LV_ATTRIBUTE_LARGE_RAM_ARRAY
 
-/** Place performance critical functions into a faster memory (e.g RAM) */
+/** Place performance critical functions into a faster memory (e.g RAM)
+ *  LVGL marks its SW blend and memcpy/memset kernels with this. With HOT_PATHS_IN_SRAM they
+ *  join the SDK's .time_critical sections, which are copied to SRAM at boot. */
+#ifdef HOT_PATHS_IN_SRAM
+#define LV_ATTRIBUTE_FAST_MEM __attribute__((section(".time_critical.lvgl")))
+#else
 #define LV_ATTRIBUTE_FAST_MEM
+#endif
 
 /** Export integer constant to binding. This macro is used with constants in the form of LV_<CONST> that
  *  should also appear on LVGL binding API such as MicroPython. */
@@ -558,6 +574,13 @@
  *   FONT USAGE
  *===================*/
 
+/* The UI sizes are replaced by subsets generated by tools/ui_fonts.py when UI_FONT_SUBSET is set */
+#ifdef UI_FONT_SUBSET
+    #define UI_FONT_STOCK 0
+#else
+    #define UI_FONT_STOCK 1
+#endif
+
 /* Montserrat fonts with ASCII range and some symbols using bpp = 4
  * https://fonts.google.com/specimen/Montserrat */
 #define LV_FONT_MONTSERRAT_8  0
@@ -566,11 +589,11 @@
 #define LV_FONT_MONTSERRAT_14 0
 #define LV_FONT_MONTSERRAT_16 0
 #define LV_FONT_MONTSERRAT_18 0
-#define LV_FONT_MONTSERRAT_20 1
+#define LV_FONT_MONTSERRAT_20 UI_FONT_STOCK
 #define LV_FONT_MONTSERRAT_22 0
 #define LV_FONT_MONTSERRAT_24 0
 #define LV_FONT_MONTSERRAT_26 0
-#define LV_FONT_MONTSERRAT_28 1
+#define LV_FONT_MONTSERRAT_28 UI_FONT_STOCK
 #define LV_FONT_MONTSERRAT_30 0
 #define LV_FONT_MONTSERRAT_32 0
 #define LV_FONT_MONTSERRAT_34 0
@@ -580,7 +603,7 @@
 #define LV_FONT_MONTSERRAT_42 0
 #define LV_FONT_MONTSERRAT_44 0
 #define LV_FONT_MONTSERRAT_46 0
-#define LV_FONT_MONTSERRAT_48 1
+#define LV_FONT_MONTSERRAT_48 UI_FONT_STOCK
 
 /* Demonstrate special features */
 #define LV_FONT_MONTSERRAT_28_COMPRESSED    0  /**< bpp = 3 */
@@ -603,10 +626,18 @@
  *  #define LV_FONT_CUSTOM_DECLARE   LV_FONT_DECLARE(my_font_1) LV_FONT_DECLARE(my_font_2)
  *  @endcode
  */
-#define LV_FONT_CUSTOM_DECLARE
+#ifdef UI_FONT_SUBSET
+    #define LV_FONT_CUSTOM_DECLARE LV_FONT_DECLARE(ui_font_20) LV_FONT_DECLARE(ui_font_28) LV_FONT_DECLARE(ui_font_48)
+#else
+    #define LV_FONT_CUSTOM_DECLARE
+#endif
 
 /** Always set a default font */
-#define LV_FONT_DEFAULT &lv_font_montserrat_28
+#ifdef UI_FONT_SUBSET
+    #define LV_FONT_DEFAULT &ui_font_28
+#else
+    #define LV_FONT_DEFAULT &lv_font_montserrat_28
+#endif
 
 /** Enable handling large font and/or fonts with a lot of characters.
  *  The limit depends on the font size, font face and bpp.
@@ -614,7 +645,11 @@
 #define LV_FONT_FMT_TXT_LARGE 0
 
 /** Enables/disables support for compressed fonts. */
-#define LV_USE_FONT_COMPRESSED 0
+#ifdef UI_FONT_SUBSET_COMPRESSED
+    #define LV_USE_FONT_COMPRESSED 1
+#else
+    #define LV_USE_FONT_COMPRESSED 0
+#endif
 
 /** Enable drawing placeholders when glyph dsc is not found. */
 #define LV_USE_FONT_PLACEHOLDER 1
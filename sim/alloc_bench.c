@@ -0,0 +1,79 @@
+// Boots the firmware built with LVGL_ALLOC_BENCHMARK on the host and reports what its alloc
+// benchmark prints: the ui_init() widget set created and deleted 50 times, as objects created
+// and deleted a second and the allocator's peak bytes. alloc_bench runs it on the slab
+// allocator (LVGL_SLAB_ALLOC), alloc_bench_builtin_heap on LVGL's builtin heap, or on the
+// stand-in's C heap path without lvgl/lvgl. The benchmark never calls the SDK, so it is timed
+// by the host's clock; the slab peak counts whole blocks, the heap peaks the bytes asked for.
+//
+// Fails when the benchmark line is missing, on ERROR lines and asserts.
+
+#include "host_board.h"
+#include "host_sdk.h"
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define US_PER_S      (1000000ull)
+#define BOOT_MAX_US   (5 * US_PER_S)
+
+int firmware_main();
+
+static int round_us = -1;
+static int ops_per_s = -1;
+static int peak_bytes = -1;
+
+static void alloc_line(const char *line)
+{
+    sscanf(line, "Alloc benchmark: %d us per UI create and delete, %d objects/s, peak %d bytes", &round_us,
+           &ops_per_s, &peak_bytes);
+    if (strstr(line, "LVGL heap after init")) {
+        host_sdk_stop();
+    }
+}
+
+static uint64_t host_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * US_PER_S + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void run_firmware()
+{
+    firmware_main();
+}
+
+int main()
+{
+    host_sdk_reset();
+    host_board_reset();
+    host_uart_on_line(alloc_line);
+    bench_set_cpu_clock(host_us);
+    host_sdk_run(run_firmware, BOOT_MAX_US);
+
+    int failures = 0;
+    if (ops_per_s < 0 || peak_bytes < 0) {
+        printf("alloc_bench: FAIL no alloc benchmark line\n");
+        failures++;
+    }
+    else {
+#ifdef LVGL_SLAB_ALLOC
+        const char *allocator = "slab allocator";
+#else
+        const char *allocator = "builtin heap";
+#endif
+        printf("alloc_bench: %s %d objects/s, %d us per UI create and delete, peak %d bytes\n", allocator,
+               ops_per_s, round_us, peak_bytes);
+    }
+
+    host_sdk_stats_t stats;
+    host_sdk_get_stats(&stats);
+    if (stats.uart_error_lines || stats.asserts) {
+        printf("alloc_bench: FAIL %d ERROR lines, %d asserts\n", (int)stats.uart_error_lines, (int)stats.asserts);
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+// Boots the firmware built with BENCHMARK_SUITE on the host and writes its 'bench' lines to a
+// file for tools/bench_compare.py. Stops once the suite is done.
+//
+// Benchmarks that wait on the hardware run in virtual time: send_lcd_data() through the
+// SPI model and the ST7789 model behind it, the renders and the main loop with the host CPU
+// time LVGL takes to render put on the virtual clock (lvgl_glue.c). The touch conversions,
+// sanitise_reading() and get_reading(), ui.show_time and ui.glyph_lookup never call the SDK
+// and so never move the virtual clock; they are timed by the host's own clock instead. With
+// the LVGL stand-in the render times are its modelled M0+ costs.
+//
+// A line can start with the shell prompt, the main loop benchmark runs the shell.
+//
+// bench_suite_no_glyph_cache is the same suite with glyph_cache_init() failing, so the clock
+// is drawn by the label renderer: the ui.render_clock results with and without the cache.
+// bench_suite_local_styles runs it on the UI built with UI_LOCAL_STYLES. Both print the LVGL
+// heap after init, the stand-in's own allocations without lvgl/lvgl.
+//
+// Fails when a benchmark is missing, or send_lcd_data() moves more bytes a second than the
+// SPI clock allows or less than half of that.
+//
+//   bench_suite bench.txt && tools/bench_compare.py compare baseline.json bench.txt
+
+#include "host_board.h"
+#include "host_sdk.h"
+
+#include "bench.h"
+#include "clock_plan.h"
+#include "glyph_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define US_PER_S       (1000000ull)
+#define SUITE_MAX_US   (120 * US_PER_S)
+#define BOOT_SYS_HZ    (125000000)
+
+int firmware_main();
+
+static const char *const expected[] = {
+    "touch.sanitise_reading",
+    "touch.get_reading",
+    "ui.show_time",
+    "ui.glyph_lookup",
+    "ui.render_button",
+    "ui.render_full.idle",
+    "ui.render_clock.idle",
+    "lcd.send_lcd_data",
+    "main.loop_iteration",
+};
+
+#define EXPECTED_COUNT   (sizeof(expected) / sizeof(expected[0]))
+
+static FILE *out = NULL;
+static bool seen[EXPECTED_COUNT];
+static bool done = false;
+static uint32_t flush_bytes_per_s = 0;
+
+static void bench_line(const char *line)
+{
+    if (strstr(line, "LVGL heap after init")) {
+#ifdef HOST_LVGL_STANDIN
+        printf("bench_suite: %s (LVGL stand-in, modelled)\n", line);
+#else
+        printf("bench_suite: %s\n", line);
+#endif
+    }
+    line = strstr(line, "bench {");
+    if (!line) {
+        return;
+    }
+    fprintf(out, "%s\n", line);
+
+    char name[48];
+    unsigned long bytes_per_s = 0;
+    if (sscanf(line, "bench {\"name\": \"%47[^\"]\", \"iterations\": %*d, \"total_us\": %*d, \"ns_per_op\": %*d, "
+                     "\"bytes_per_s\": %lu", name, &bytes_per_s) == 2) {
+        for (size_t i = 0; i < EXPECTED_COUNT; i++) {
+            seen[i] |= strcmp(name, expected[i]) == 0;
+        }
+        if (strcmp(name, "lcd.send_lcd_data") == 0) {
+            flush_bytes_per_s = (uint32_t)bytes_per_s;
+        }
+    }
+    if (strncmp(line, "bench {\"done\"", 13) == 0) {
+        done = true;
+        host_sdk_stop();
+    }
+}
+
+static uint64_t host_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * US_PER_S + (uint64_t)ts.tv_nsec / 1000;
+}
+
+#ifdef BENCH_NO_GLYPH_CACHE
+// Linked with --wrap=glyph_cache_init.
+int __wrap_glyph_cache_init(const lv_font_t *font, lv_color_t bg, const lv_color_t *colours, size_t colour_count)
+{
+    (void)font;
+    (void)bg;
+    (void)colours;
+    (void)colour_count;
+    return -1;
+}
+#endif
+
+static void run_firmware()
+{
+    firmware_main();
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        printf("usage: bench_suite <results file>\n");
+        return 2;
+    }
+    out = fopen(argv[1], "w");
+    if (!out) {
+        printf("bench_suite: cannot write %s\n", argv[1]);
+        return 2;
+    }
+
+    host_sdk_reset();
+    host_board_reset();
+    host_uart_on_line(bench_line);
+    bench_set_cpu_clock(host_us);
+    host_sdk_run(run_firmware, SUITE_MAX_US);
+    fclose(out);
+
+    int failures = 0;
+    if (!done) {
+        printf("bench_suite: FAIL the suite did not finish in %d s\n", (int)(SUITE_MAX_US / US_PER_S));
+        failures++;
+    }
+    for (size_t i = 0; i < EXPECTED_COUNT; i++) {
+        if (!seen[i]) {
+            printf("bench_suite: FAIL no result for %s\n", expected[i]);
+            failures++;
+        }
+    }
+
+    // Eight bits a byte at the SPI clock, less the gaps between draw buffers.
+    clock_plan_t plan;
+    clock_plan_make(BOOT_SYS_HZ, &plan);
+    const uint32_t wire_bytes_per_s = plan.lcd_spi_hz / 8;
+    printf("bench_suite: send_lcd_data %d bytes/s, the SPI clock allows %d\n", (int)flush_bytes_per_s,
+           (int)wire_bytes_per_s);
+    if (flush_bytes_per_s > wire_bytes_per_s || flush_bytes_per_s < wire_bytes_per_s / 2) {
+        printf("bench_suite: FAIL send_lcd_data out of range\n");
+        failures++;
+    }
+
+    host_sdk_stats_t stats;
+    host_sdk_get_stats(&stats);
+    if (stats.uart_error_lines || stats.asserts) {
+        printf("bench_suite: FAIL %d ERROR lines, %d asserts\n", (int)stats.uart_error_lines, (int)stats.asserts);
+        failures++;
+    }
+    if (!failures) {
+        printf("bench_suite: results written to %s\n", argv[1]);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+// Boot to first frame and boot to touch ready on the virtual clock, with the time every boot
+// step finished, as the firmware prints them.
+//
+// The LCD reset holds the panel for 25 ms and waits 125 ms after releasing it. The boot
+// sequencer runs lv_init(), the UI assets, touch and battery in those waits, and builds the
+// UI while the ST7789 init sequence sleeps. Fails when one of them finished after the wait
+// it belongs in, when either time is over its limit or a line is missing, on ERROR lines
+// and asserts.
+//
+// The times are modelled, not measured. The panel and SPI waits come from the device models.
+// The CPU time in between is the stand-in's cycle charges without lvgl/lvgl, or with it the
+// host's own time for LVGL's renders (lvgl_glue.c), far less than an M0+ takes. Only a boot on
+// hardware gives the real figures; the report says which model these come from.
+//
+//   boot_time --max-first-frame-ms 600 --max-touch-ms 450
+
+#include "host_board.h"
+#include "host_sdk.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define US_PER_S      (1000000ull)
+#define BOOT_MAX_US   (5 * US_PER_S)
+#define MAX_STEPS     (16)
+#define LCD_WAKE_US   (125 * 1000)   // After "lcd release", as in display_framework.c
+
+int firmware_main();
+
+// Steps with no part in the panel's init, and the LCD step whose waits they run in.
+typedef struct {
+    const char *step;
+    const char *during;
+    uint32_t wait_after_us;   // The wait follows the LCD step
+} overlap_t;
+
+static const overlap_t overlapped[] = {
+    {"lvgl init", "lcd release", LCD_WAKE_US},
+    {"ui assets", "lcd release", LCD_WAKE_US},
+    {"touch",     "lcd release", LCD_WAKE_US},
+    {"battery",   "lcd release", LCD_WAKE_US},
+    {"ui build",  "lcd panel",   0},
+};
+
+#define OVERLAPPED_COUNT   (sizeof(overlapped) / sizeof(overlapped[0]))
+
+typedef struct {
+    char name[24];
+    uint32_t done_us;
+} step_time_t;
+
+static step_time_t steps[MAX_STEPS];
+static size_t step_count = 0;
+static int first_frame_ms = -1;
+static int touch_ready_ms = -1;
+static uint32_t max_first_frame_ms = 0;   // 0: not checked
+static uint32_t max_touch_ms = 0;
+
+static void boot_line(const char *line)
+{
+    // "Boot: <name> done at <us> us"
+    const char *end = strstr(line, " done at ");
+    if (strncmp(line, "Boot: ", 6) == 0 && end && step_count < MAX_STEPS) {
+        step_time_t *step = &steps[step_count++];
+        snprintf(step->name, sizeof(step->name), "%.*s", (int)(end - line - 6), line + 6);
+        step->done_us = (uint32_t)strtoul(end + strlen(" done at "), NULL, 10);
+    }
+    sscanf(line, "Boot to first frame: %d ms", &first_frame_ms);
+    sscanf(line, "Boot to touch ready: %d ms", &touch_ready_ms);
+    if (first_frame_ms >= 0 && touch_ready_ms >= 0) {
+        host_sdk_stop();
+    }
+}
+
+static const step_time_t *find_step(const char *name)
+{
+    for (size_t i = 0; i < step_count; i++) {
+        if (strcmp(steps[i].name, name) == 0) {
+            return &steps[i];
+        }
+    }
+    return NULL;
+}
+
+static void run_firmware()
+{
+    firmware_main();
+}
+
+static bool parse_args(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 >= argc) {
+            printf("boot_time: %s needs a value\n", argv[i]);
+            return false;
+        }
+        if (strcmp(argv[i], "--max-first-frame-ms") == 0) {
+            max_first_frame_ms = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--max-touch-ms") == 0) {
+            max_touch_ms = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        }
+        else {
+            printf("boot_time: unknown option %s\n", argv[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (!parse_args(argc, argv)) {
+        return 2;
+    }
+
+    host_sdk_reset();
+    host_board_reset();
+    host_uart_on_line(boot_line);
+    host_sdk_run(run_firmware, BOOT_MAX_US);
+
+    for (size_t i = 0; i < step_count; i++) {
+        printf("boot_time: %-12s done at %7.1f ms\n", steps[i].name, steps[i].done_us / 1000.0);
+    }
+#ifdef HOST_LVGL_STANDIN
+    const char *model = "LVGL stand-in";
+#else
+    const char *model = "LVGL renders on host CPU time";
+#endif
+    printf("boot_time: first frame %d ms, touch ready %d ms (modelled, %s)\n", first_frame_ms, touch_ready_ms,
+           model);
+
+    int failures = 0;
+    if (first_frame_ms < 0 || touch_ready_ms < 0) {
+        printf("boot_time: FAIL no first frame or touch ready line in %d s\n", (int)(BOOT_MAX_US / US_PER_S));
+        failures++;
+    }
+    if (max_first_frame_ms && first_frame_ms > (int)max_first_frame_ms) {
+        printf("boot_time: FAIL first frame after %d ms, limit %d ms\n", first_frame_ms, (int)max_first_frame_ms);
+        failures++;
+    }
+    if (max_touch_ms && touch_ready_ms > (int)max_touch_ms) {
+        printf("boot_time: FAIL touch ready after %d ms, limit %d ms\n", touch_ready_ms, (int)max_touch_ms);
+        failures++;
+    }
+
+    for (size_t i = 0; i < OVERLAPPED_COUNT; i++) {
+        const overlap_t *o = &overlapped[i];
+        const step_time_t *step = find_step(o->step);
+        const step_time_t *lcd = find_step(o->during);
+        if (!step || !lcd) {
+            printf("boot_time: FAIL no '%s' step\n", step ? o->during : o->step);
+            failures++;
+        }
+        else if (step->done_us > lcd->done_us + o->wait_after_us) {
+            printf("boot_time: FAIL '%s' done after the waits of '%s'\n", o->step, o->during);
+            failures++;
+        }
+    }
+
+    host_sdk_stats_t stats;
+    host_sdk_get_stats(&stats);
+    if (stats.uart_error_lines || stats.asserts) {
+        printf("boot_time: FAIL %d ERROR lines, %d asserts\n", (int)stats.uart_error_lines, (int)stats.asserts);
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
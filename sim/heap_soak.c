@@ -0,0 +1,191 @@
+// Soaks the firmware built with LVGL_HEAP_PROFILER on the host: hours of the user going into
+// the set screen, changing the time and setting it, with the screen left to sleep in between.
+//
+// The UI creates its objects once, at boot. The first round of taps may still allocate for
+// whatever it shows first; after that the heap must stay where that round left it. Fails when
+// the live blocks or bytes at the end differ from those after the first round, when the peak
+// went up after it, on a failed or untracked allocation, or when the 'heap' report has no
+// slab occupancy.
+//
+//   heap_soak --hours 4 --interact 60
+
+#include "host_board.h"
+#include "host_sdk.h"
+#include "virtual_clock.h"
+
+#include "heap_profiler.h"
+#include "ui_layout.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define US_PER_S          (1000000ull)
+#define FIRST_TAP_US      (5 * US_PER_S)
+#define TAP_HOLD_US       (150 * 1000)
+#define TAP_GAP_US        (600 * 1000)
+#define SETTLE_US         (2 * US_PER_S)   // After a round of taps, before the heap is read
+
+int firmware_main();
+
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+} tap_point_t;
+
+// Wake the screen, into the set screen, an hour and a minute on, and Set.
+static const tap_point_t round_taps[] = {
+    {UI_PROP_SCREEN_WIDTH_PX / 2, UI_LAYOUT_CLOCK_Y + UI_LAYOUT_CLOCK_HEIGHT / 2},
+    {UI_PROP_SCREEN_WIDTH_PX / 2, UI_LAYOUT_CLOCK_Y + UI_LAYOUT_CLOCK_HEIGHT / 2},
+    {UI_LAYOUT_LEFT_X + UI_LAYOUT_THIRD_WIDTH / 2, UI_LAYOUT_ROW_TOP_Y + UI_LAYOUT_BTN_HEIGHT / 2},
+    {UI_LAYOUT_RIGHT_X + UI_LAYOUT_THIRD_WIDTH / 2, UI_LAYOUT_ROW_TOP_Y + UI_LAYOUT_BTN_HEIGHT / 2},
+    {UI_LAYOUT_SET_X + UI_LAYOUT_THIRD_WIDTH / 2, UI_LAYOUT_SET_Y + UI_LAYOUT_BTN_HEIGHT / 2},
+};
+
+#define ROUND_TAPS   (sizeof(round_taps) / sizeof(round_taps[0]))
+
+static double hours = 1;
+static uint32_t interact_s = 60;
+
+static size_t tap_next = 0;
+static uint32_t rounds = 0;
+static bool have_baseline = false;
+static heap_profile_totals_t baseline;
+static bool report_done = false;
+static uint32_t slab_lines = 0;
+
+static int64_t release_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    host_board_touch(false, 0, 0);
+    return 0;
+}
+
+static int64_t baseline_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    heap_profiler_get_totals(&baseline);
+    have_baseline = true;
+    return 0;
+}
+
+static int64_t round_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    const tap_point_t *p = &round_taps[tap_next++];
+    host_board_touch(true, p->x, p->y);
+    virtual_clock_add_alarm(virtual_clock_now_us() + TAP_HOLD_US, release_cb, NULL);
+    if (tap_next < ROUND_TAPS) {
+        return (int64_t)TAP_GAP_US;
+    }
+
+    tap_next = 0;
+    if (rounds++ == 0) {
+        virtual_clock_add_alarm(virtual_clock_now_us() + SETTLE_US, baseline_cb, NULL);
+    }
+    return (int64_t)interact_s * US_PER_S - (int64_t)(ROUND_TAPS - 1) * TAP_GAP_US;
+}
+
+static int64_t report_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    host_uart_rx("heap\r");
+    return 0;
+}
+
+static void heap_line(const char *line)
+{
+    if (strstr(line, "  slab ")) {
+        slab_lines++;
+    }
+    if (strstr(line, "heap profile done")) {
+        report_done = true;
+        host_sdk_stop();
+    }
+}
+
+static void run_firmware()
+{
+    firmware_main();
+}
+
+static bool parse_args(int argc, char **argv)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--hours") == 0) {
+            hours = atof(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--interact") == 0) {
+            interact_s = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        }
+        else {
+            printf("heap_soak: unknown option %s\n", argv[i]);
+            return false;
+        }
+    }
+    if ((argc % 2) == 0 || interact_s * US_PER_S <= ROUND_TAPS * TAP_GAP_US + SETTLE_US) {
+        printf("usage: heap_soak [--hours H] [--interact S], S over %d s\n",
+               (int)((ROUND_TAPS * TAP_GAP_US + SETTLE_US) / US_PER_S));
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (!parse_args(argc, argv)) {
+        return 2;
+    }
+
+    const uint64_t soak_us = (uint64_t)(hours * 3600 * US_PER_S);
+    host_sdk_reset();
+    host_board_reset();
+    host_uart_on_line(heap_line);
+    virtual_clock_add_alarm(FIRST_TAP_US, round_cb, NULL);
+    // The last round is back on the main screen by the time the report is asked for.
+    virtual_clock_add_alarm(soak_us, report_cb, NULL);
+    host_sdk_run(run_firmware, soak_us + 10 * US_PER_S);
+
+    heap_profile_totals_t end;
+    heap_profiler_get_totals(&end);
+    printf("heap_soak: %d rounds of taps in %.2f h, %d allocs, %d frees\n", (int)rounds, hours, (int)end.allocs,
+           (int)end.frees);
+    printf("heap_soak: after the first round %d blocks, %d bytes, peak %d bytes; at the end %d blocks, %d bytes, "
+           "peak %d bytes\n", (int)baseline.live, (int)baseline.live_bytes, (int)baseline.peak_bytes, (int)end.live,
+           (int)end.live_bytes, (int)end.peak_bytes);
+
+    int failures = 0;
+    if (!have_baseline || rounds < 2) {
+        printf("heap_soak: FAIL %d rounds of taps, the soak needs two or more\n", (int)rounds);
+        failures++;
+    }
+    else if (end.live != baseline.live || end.live_bytes != baseline.live_bytes) {
+        printf("heap_soak: FAIL the heap went from %d blocks, %d bytes to %d blocks, %d bytes\n", (int)baseline.live,
+               (int)baseline.live_bytes, (int)end.live, (int)end.live_bytes);
+        failures++;
+    }
+    else if (end.peak_bytes != baseline.peak_bytes) {
+        printf("heap_soak: FAIL the peak went from %d to %d bytes\n", (int)baseline.peak_bytes, (int)end.peak_bytes);
+        failures++;
+    }
+    if (end.failed || end.untracked) {
+        printf("heap_soak: FAIL %d failed, %d untracked allocations\n", (int)end.failed, (int)end.untracked);
+        failures++;
+    }
+    if (!report_done || slab_lines == 0) {
+        printf("heap_soak: FAIL the heap report has %d slab lines\n", (int)slab_lines);
+        failures++;
+    }
+
+    host_sdk_stats_t stats;
+    host_sdk_get_stats(&stats);
+    if (stats.uart_error_lines || stats.asserts) {
+        printf("heap_soak: FAIL %d ERROR lines, %d asserts\n", (int)stats.uart_error_lines, (int)stats.asserts);
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,321 @@
+#include "host_board.h"
+#include "host_sdk.h"
+#include "virtual_clock.h"
+
+#include "kv_store.h"
+#include "stack_monitor.h"
+#include "pico/time.h"
+
+#include <string.h>
+
+// Pins as wired in pins.h and touch_screen.c.
+#define PIN_LCD_DCX        (3)
+#define PIN_LCD_RESETn     (4)
+#define PIN_LCD_CSn        (17)
+#define PIN_TOUCH_IRQ      (11)
+#define PIN_TOUCH_CSn      (13)
+
+// ---------------------------------------------------------------------------------------
+// ST7789: the commands the firmware sends and the waits the datasheet asks for after them.
+
+#define ST7789_SWRESET     (0x01)
+#define ST7789_SLPIN       (0x10)
+#define ST7789_SLPOUT      (0x11)
+#define ST7789_DISPOFF     (0x28)
+#define ST7789_DISPON      (0x29)
+#define ST7789_CASET       (0x2a)
+#define ST7789_RASET       (0x2b)
+#define ST7789_RAMWR       (0x2c)
+
+#define PANEL_RESET_US     (120 * 1000)   // Reset to sleep out
+#define PANEL_SLEEP_US     (120 * 1000)   // Sleep in to sleep out and back
+#define PANEL_CMD_WAIT_US  (5 * 1000)     // After reset, sleep in and sleep out
+
+typedef struct {
+    uint8_t cmd;
+    uint8_t params[4];
+    uint32_t param_cnt;
+    bool pixel_hi_pending;     // 8 bit pixel writes, first byte held
+    uint8_t pixel_hi;
+    uint16_t x0, x1, y0, y1;
+    uint16_t x, y;
+    uint64_t reset_us;         // Last hardware or software reset
+    uint64_t sleep_in_us;
+    uint64_t sleep_out_us;
+    uint64_t busy_until_us;    // No command before this
+    host_panel_stats_t stats;
+    uint16_t frame[HOST_PANEL_WIDTH * HOST_PANEL_HEIGHT];
+} panel_t;
+
+static panel_t panel;
+
+static void panel_violation(const char *what)
+{
+    panel.stats.violations++;
+    printf("host_board: ST7789 %s at %d ms\n", what, (int)(virtual_clock_now_us() / 1000));
+}
+
+static void panel_command(uint8_t cmd)
+{
+    const uint64_t now_us = virtual_clock_now_us();
+    if (now_us < panel.busy_until_us) {
+        panel_violation("command too soon after reset or sleep change");
+    }
+
+    panel.cmd = cmd;
+    panel.param_cnt = 0;
+    panel.pixel_hi_pending = false;
+    panel.stats.commands++;
+
+    switch (cmd) {
+    case ST7789_SWRESET:
+        panel.reset_us = now_us;
+        panel.busy_until_us = now_us + PANEL_CMD_WAIT_US;
+        panel.stats.sleeping = true;
+        panel.stats.display_on = false;
+        break;
+    case ST7789_SLPIN:
+        if (now_us - panel.sleep_out_us < PANEL_SLEEP_US) {
+            panel_violation("sleep in less than 120 ms after sleep out");
+        }
+        panel.sleep_in_us = now_us;
+        panel.busy_until_us = now_us + PANEL_CMD_WAIT_US;
+        panel.stats.sleeping = true;
+        panel.stats.sleep_ins++;
+        break;
+    case ST7789_SLPOUT:
+        if (now_us - panel.reset_us < PANEL_RESET_US || (panel.stats.sleep_ins && now_us - panel.sleep_in_us < PANEL_SLEEP_US)) {
+            panel_violation("sleep out less than 120 ms after reset or sleep in");
+        }
+        panel.sleep_out_us = now_us;
+        panel.busy_until_us = now_us + PANEL_CMD_WAIT_US;
+        panel.stats.sleeping = false;
+        panel.stats.sleep_outs++;
+        break;
+    case ST7789_DISPOFF:
+        panel.stats.display_on = false;
+        break;
+    case ST7789_DISPON:
+        panel.stats.display_on = true;
+        break;
+    case ST7789_RAMWR:
+        panel.x = panel.x0;
+        panel.y = panel.y0;
+        panel.stats.flushes++;
+        break;
+    default:
+        break;
+    }
+}
+
+static void panel_pixel(uint16_t color)
+{
+    if (panel.x < HOST_PANEL_WIDTH && panel.y < HOST_PANEL_HEIGHT) {
+        panel.frame[panel.y * HOST_PANEL_WIDTH + panel.x] = color;
+    }
+    panel.stats.pixels++;
+    if (++panel.x > panel.x1) {
+        panel.x = panel.x0;
+        panel.y = (panel.y < panel.y1) ? panel.y + 1 : panel.y0;
+    }
+}
+
+static void panel_data(uint16_t word, uint data_bits)
+{
+    if (panel.cmd == ST7789_RAMWR) {
+        if (data_bits == 16) {
+            panel_pixel(word);
+        }
+        else if (panel.pixel_hi_pending) {
+            panel.pixel_hi_pending = false;
+            panel_pixel((uint16_t)(panel.pixel_hi << 8) | (word & 0xffu));
+        }
+        else {
+            panel.pixel_hi_pending = true;
+            panel.pixel_hi = (uint8_t)word;
+        }
+        return;
+    }
+
+    if (panel.param_cnt < sizeof(panel.params)) {
+        panel.params[panel.param_cnt] = (uint8_t)word;
+    }
+    if (++panel.param_cnt == 4 && (panel.cmd == ST7789_CASET || panel.cmd == ST7789_RASET)) {
+        const uint16_t start = (uint16_t)((panel.params[0] << 8) | panel.params[1]);
+        const uint16_t end = (uint16_t)((panel.params[2] << 8) | panel.params[3]);
+        if (start > end) {
+            panel_violation("window start after its end");
+        }
+        if (panel.cmd == ST7789_CASET) {
+            panel.x0 = start;
+            panel.x1 = end;
+        }
+        else {
+            panel.y0 = start;
+            panel.y1 = end;
+        }
+    }
+}
+
+static uint16_t panel_transfer(uint16_t tx, uint data_bits)
+{
+    if (host_gpio_out(PIN_LCD_CSn)) {
+        return 0;
+    }
+    if (!host_gpio_out(PIN_LCD_RESETn)) {
+        panel_violation("write during reset");
+        return 0;
+    }
+    if (!host_gpio_out(PIN_LCD_DCX)) {
+        panel_command((uint8_t)tx);
+    }
+    else {
+        panel_data(tx, data_bits);
+    }
+    return 0;
+}
+
+static const host_spi_device_t panel_device = {.transfer = panel_transfer};
+
+// ---------------------------------------------------------------------------------------
+// XPT2046: a control byte selects the channel, the next two bytes clock out the conversion
+// as touch_screen.c reads it. Readings follow the default calibration of 200 to 1800 across
+// the panel; X runs from the right edge of the display.
+
+#define TOUCH_READING_MIN   (200)
+#define TOUCH_READING_SPAN  (1600)
+#define TOUCH_CHANNEL_Y     (1)
+#define TOUCH_CHANNEL_X     (5)
+
+static struct {
+    bool down;
+    uint16_t x;
+    uint16_t y;
+    uint16_t shift;      // Conversion being clocked out, MSB first
+    uint32_t bytes_left;
+} touch;
+
+static uint16_t touch_reading(uint channel)
+{
+    if (!touch.down || (channel != TOUCH_CHANNEL_X && channel != TOUCH_CHANNEL_Y)) {
+        return 0;
+    }
+    if (channel == TOUCH_CHANNEL_Y) {
+        return (uint16_t)(TOUCH_READING_MIN + touch.y * TOUCH_READING_SPAN / HOST_PANEL_HEIGHT);
+    }
+    // Rounded up, so the driver's division lands back on the same pixel.
+    const uint32_t from_right = HOST_PANEL_WIDTH - touch.x;
+    return (uint16_t)(TOUCH_READING_MIN + (from_right * TOUCH_READING_SPAN + HOST_PANEL_WIDTH - 1) / HOST_PANEL_WIDTH);
+}
+
+static uint16_t touch_transfer(uint16_t tx, uint data_bits)
+{
+    (void)data_bits;
+    if (host_gpio_out(PIN_TOUCH_CSn)) {
+        touch.bytes_left = 0;
+        return 0;
+    }
+    if (touch.bytes_left) {
+        touch.bytes_left--;
+        return touch.bytes_left ? (touch.shift >> 8) : (touch.shift & 0xffu);
+    }
+    if (tx & 0x80u) {
+        touch.shift = (uint16_t)(touch_reading((tx >> 4) & 7u) << 4);
+        touch.bytes_left = 2;
+    }
+    return 0;
+}
+
+static const host_spi_device_t touch_device = {.transfer = touch_transfer};
+
+void host_board_touch(bool down, uint16_t x, uint16_t y)
+{
+    touch.down = down;
+    touch.x = (x < HOST_PANEL_WIDTH) ? x : HOST_PANEL_WIDTH - 1;
+    touch.y = (y < HOST_PANEL_HEIGHT) ? y : HOST_PANEL_HEIGHT - 1;
+    host_gpio_set_input(PIN_TOUCH_IRQ, !down);
+}
+
+// ---------------------------------------------------------------------------------------
+
+void host_board_reset()
+{
+    memset(&panel, 0, sizeof(panel));
+    panel.stats.sleeping = true;
+    memset(&touch, 0, sizeof(touch));
+    host_spi_attach(spi0, &panel_device);
+    host_spi_attach(spi1, &touch_device);
+    host_gpio_set_input(PIN_TOUCH_IRQ, true);
+}
+
+void host_board_get_panel_stats(host_panel_stats_t *stats)
+{
+    *stats = panel.stats;
+}
+
+const uint16_t *host_board_framebuffer()
+{
+    return panel.frame;
+}
+
+// ---------------------------------------------------------------------------------------
+// Flash: the RAM image of kv_flash_ram.c at the speed of the on-board chip. Interrupts are
+// not held off meanwhile, as flash_safe_execute() does on the device.
+
+#define FLASH_PROGRAM_US   (800)
+#define FLASH_ERASE_US     (50 * 1000)
+
+static const kv_flash_port_t *ram_port = NULL;
+
+static const uint8_t *board_flash_read(uint32_t offset)
+{
+    return ram_port->read(offset);
+}
+
+static bool board_flash_program(uint32_t offset, const uint8_t *page)
+{
+    host_cpu_us(HostCpuFlash, FLASH_PROGRAM_US);
+    return ram_port->program(offset, page);
+}
+
+static bool board_flash_erase(uint32_t offset)
+{
+    host_cpu_us(HostCpuFlash, FLASH_ERASE_US);
+    return ram_port->erase(offset);
+}
+
+static uint32_t board_flash_now_us()
+{
+    return time_us_32();
+}
+
+const kv_flash_port_t *kv_flash_pico_port()
+{
+    static kv_flash_port_t port;
+    ram_port = kv_flash_ram_port();
+    port = *ram_port;
+    port.read = board_flash_read;
+    port.program = board_flash_program;
+    port.erase = board_flash_erase;
+    port.now_us = board_flash_now_us;
+    return &port;
+}
+
+// ---------------------------------------------------------------------------------------
+// Stack monitor: the host stack is not the firmware's, the report says so on the UART.
+
+void stack_monitor_paint()
+{
+}
+
+stack_usage_t stack_monitor_usage(stack_id_t stack)
+{
+    (void)stack;
+    const stack_usage_t usage = {0, 0};
+    return usage;
+}
+
+void stack_monitor_report()
+{
+    host_printf("Stack high water: not measured on the host\n\r");
+}
@@ -0,0 +1,36 @@
+#ifndef _HOST_BOARD_H
+#define _HOST_BOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The board around the RP2040 in the host simulator: the ST7789 panel on SPI0, the XPT2046
+// touch controller on SPI1, the flash chip under the KV store and the stack monitor, which
+// has no linker script stack on a host.
+
+#define HOST_PANEL_WIDTH    (240)
+#define HOST_PANEL_HEIGHT   (320)
+
+typedef struct {
+    uint32_t commands;
+    uint32_t flushes;          // RAMWR commands
+    uint64_t pixels;
+    uint32_t sleep_ins;
+    uint32_t sleep_outs;
+    uint32_t violations;       // Commands the datasheet timing or state does not allow
+    bool sleeping;
+    bool display_on;
+} host_panel_stats_t;
+
+// Attaches the models to the host SDK. Call after host_sdk_reset().
+void host_board_reset();
+
+// Pen down at a display pixel, or lifted. Pulls the pen IRQ line like the XPT2046 does.
+void host_board_touch(bool down, uint16_t x, uint16_t y);
+
+void host_board_get_panel_stats(host_panel_stats_t *stats);
+
+// What the panel shows, RGB565 as sent, HOST_PANEL_WIDTH * HOST_PANEL_HEIGHT.
+const uint16_t *host_board_framebuffer();
+
+#endif   // _HOST_BOARD_H
@@ -0,0 +1,1749 @@
+#include "host_sdk.h"
+#include "virtual_clock.h"
+
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/pwm.h"
+#include "hardware/spi.h"
+#include "hardware/structs/scb.h"
+#include "hardware/structs/systick.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <string.h>
+
+// The Pico SDK calls the firmware makes, on the virtual clock. CPU work is charged in
+// cycles at the current clk_sys, transfers at the rate their dividers give at the current
+// clk_peri, and idling jumps to the next interrupt. Interrupts are virtual clock alarms that
+// run their handler at the exact time, preempting the firmware wherever it is.
+
+#define DEFAULT_READ_CYCLES   (300)
+#define TIGHT_LOOP_CYCLES     (4)
+#define ADC_READ_US           (2)       // 96 cycles of the 48 MHz ADC clock
+#define ADC_REF_MV            (3300)
+#define UART_FIFO_DEPTH       (32)
+#define UART_BITS_PER_CHAR    (10)
+#define UART_LINE_SIZE        (160)
+#define UART_RX_SIZE          (256)
+#define IRQ_MAX_HANDLERS      (4)
+
+const char *const host_cpu_names[HostCpuCount] = {
+    "run", "render", "lcd", "touch", "uart", "flash", "wait", "sleep",
+};
+
+static host_sdk_stats_t stats;
+static uint32_t read_cycles = DEFAULT_READ_CYCLES;
+static uint64_t cycle_rem = 0;   // Cycle time below a ns, in units of 1 / clk_sys
+static uint64_t ns_rem = 0;      // Charged time below a us
+
+// host_sdk_run() state. After the run nothing moves the clock any more, so the report can
+// read the firmware's statistics through its own functions.
+static jmp_buf run_exit;
+static bool running = false;
+static bool stopping = false;
+static bool stopped = false;
+static bool run_ok = true;
+
+static uint32_t clk_hz[CLK_COUNT];
+
+clocks_hw_t host_clocks_hw;
+systick_hw_t host_systick_hw;
+armv6m_scb_hw_t host_scb_hw;
+pwm_hw_t host_pwm_hw;
+
+static void pio_sync();
+static void pio_dma_started();
+
+// ---------------------------------------------------------------------------------------
+// Run control and CPU time
+
+static void stop_run()
+{
+    if (running) {
+        running = false;
+        longjmp(run_exit, 1);
+    }
+}
+
+static void fail(const char *what)
+{
+    printf("host_sdk: %s at %d ms\n", what, (int)(virtual_clock_now_us() / 1000));
+    run_ok = false;
+    stop_run();
+}
+
+static void check_stop()
+{
+    if (stopping) {
+        stop_run();
+    }
+}
+
+static void charge_ns(host_cpu_t category, uint64_t ns)
+{
+    if (stopped) {
+        return;
+    }
+    ns_rem += ns;
+    const uint64_t us = ns_rem / 1000;
+    ns_rem %= 1000;
+    if (us) {
+        virtual_clock_run(us, category);
+    }
+}
+
+void host_cpu_cycles(host_cpu_t category, uint64_t cycles)
+{
+    const uint64_t num = cycles * 1000000000ull + cycle_rem;
+    cycle_rem = num % clk_hz[clk_sys];
+    charge_ns(category, num / clk_hz[clk_sys]);
+}
+
+void host_cpu_us(host_cpu_t category, uint64_t us)
+{
+    charge_ns(category, us * 1000);
+}
+
+void host_set_read_cycles(uint32_t cycles)
+{
+    read_cycles = cycles;
+}
+
+// ---------------------------------------------------------------------------------------
+// Interrupts
+
+static irq_handler_t irq_handlers[NUM_IRQS][IRQ_MAX_HANDLERS];
+static bool irq_enabled[NUM_IRQS];
+
+void irq_set_enabled(uint num, bool enabled)
+{
+    if (num < NUM_IRQS) {
+        irq_enabled[num] = enabled;
+    }
+}
+
+bool irq_is_enabled(uint num)
+{
+    return num < NUM_IRQS && irq_enabled[num];
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler)
+{
+    if (num < NUM_IRQS) {
+        memset(irq_handlers[num], 0, sizeof(irq_handlers[num]));
+        irq_handlers[num][0] = handler;
+    }
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority)
+{
+    (void)order_priority;
+    for (size_t i = 0; num < NUM_IRQS && i < IRQ_MAX_HANDLERS; i++) {
+        if (!irq_handlers[num][i]) {
+            irq_handlers[num][i] = handler;
+            return;
+        }
+    }
+    fail("too many shared IRQ handlers");
+}
+
+void irq_remove_handler(uint num, irq_handler_t handler)
+{
+    for (size_t i = 0; num < NUM_IRQS && i < IRQ_MAX_HANDLERS; i++) {
+        if (irq_handlers[num][i] == handler) {
+            irq_handlers[num][i] = NULL;
+        }
+    }
+}
+
+static void raise_irq(uint num)
+{
+    if (!irq_enabled[num]) {
+        return;
+    }
+    stats.irqs++;
+    for (size_t i = 0; i < IRQ_MAX_HANDLERS; i++) {
+        if (irq_handlers[num][i]) {
+            irq_handlers[num][i]();
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// SysTick: an alarm every rvr + 1 cycles while enabled, in phase.
+
+__attribute__((weak)) void isr_systick(void)
+{
+}
+
+static virtual_alarm_id_t systick_alarm = 0;
+
+static bool systick_on()
+{
+    const uint32_t on = M0PLUS_SYST_CSR_ENABLE_BITS | M0PLUS_SYST_CSR_TICKINT_BITS;
+    return (systick_hw->csr & on) == on;
+}
+
+static uint64_t systick_period_us()
+{
+    const uint64_t us = ((uint64_t)systick_hw->rvr + 1) * 1000000ull / clk_hz[clk_sys];
+    return us ? us : 1;
+}
+
+static int64_t systick_fire(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    if (!systick_on()) {
+        systick_alarm = 0;
+        return 0;
+    }
+    stats.irqs++;
+    stats.systicks++;
+    isr_systick();
+    return -(int64_t)systick_period_us();
+}
+
+// Every SDK call looks at the SysTick registers the firmware may have written since.
+static void sync()
+{
+    if (systick_on() && !systick_alarm) {
+        systick_alarm = virtual_clock_add_alarm(virtual_clock_now_us() + systick_period_us(), systick_fire, NULL);
+    }
+    else if (!systick_on() && systick_alarm) {
+        virtual_clock_cancel(systick_alarm);
+        systick_alarm = 0;
+    }
+    check_stop();
+}
+
+void tight_loop_contents(void)
+{
+    sync();
+    host_cpu_cycles(HostCpuRun, TIGHT_LOOP_CYCLES);
+}
+
+// ---------------------------------------------------------------------------------------
+// Time and alarms
+
+typedef struct {
+    virtual_alarm_id_t id;   // 0 while free
+    alarm_callback_t cb;
+    void *user_data;
+    repeating_timer_t *timer;
+} fw_alarm_t;
+
+static fw_alarm_t fw_alarms[VIRTUAL_CLOCK_MAX_ALARMS];
+
+static int64_t fw_alarm_fire(virtual_alarm_id_t id, void *user_data)
+{
+    fw_alarm_t *a = user_data;
+    stats.irqs++;
+
+    int64_t again;
+    if (a->timer) {
+        again = a->timer->callback(a->timer) ? a->timer->delay_us : 0;
+    }
+    else {
+        again = a->cb(id, a->user_data);
+    }
+
+    // Cancelled from its own callback, the slot may hold another alarm by now.
+    if (again == 0 && a->id == id) {
+        a->id = 0;
+        if (a->timer) {
+            a->timer->alarm_id = 0;
+        }
+    }
+    return again;
+}
+
+static alarm_id_t add_fw_alarm(uint64_t at_us, alarm_callback_t cb, void *user_data, repeating_timer_t *timer)
+{
+    for (size_t i = 0; i < VIRTUAL_CLOCK_MAX_ALARMS; i++) {
+        fw_alarm_t *a = &fw_alarms[i];
+        if (a->id == 0) {
+            const virtual_alarm_id_t id = virtual_clock_add_alarm(at_us, fw_alarm_fire, a);
+            if (id <= 0) {
+                break;
+            }
+            *a = (fw_alarm_t){.id = id, .cb = cb, .user_data = user_data, .timer = timer};
+            return id;
+        }
+    }
+    fail("out of alarm slots");
+    return 0;
+}
+
+uint64_t time_us_64(void)
+{
+    sync();
+    host_cpu_cycles(HostCpuRun, read_cycles);
+    return virtual_clock_now_us();
+}
+
+uint32_t time_us_32(void)
+{
+    return (uint32_t)time_us_64();
+}
+
+absolute_time_t get_absolute_time(void)
+{
+    return time_us_64();
+}
+
+absolute_time_t make_timeout_time_ms(uint32_t ms)
+{
+    return delayed_by_ms(get_absolute_time(), ms);
+}
+
+void sleep_until(absolute_time_t t)
+{
+    sync();
+    const uint64_t now_us = virtual_clock_now_us();
+    if (t > now_us && !stopped) {
+        virtual_clock_run(t - now_us, HostCpuWait);
+    }
+    check_stop();
+}
+
+void sleep_us(uint64_t us)
+{
+    sleep_until(virtual_clock_now_us() + us);
+}
+
+void sleep_ms(uint32_t ms)
+{
+    sleep_us((uint64_t)ms * 1000);
+}
+
+alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback, void *user_data, bool fire_if_past)
+{
+    sync();
+    const uint64_t now_us = virtual_clock_now_us();
+    if (time <= now_us && !fire_if_past) {
+        return 0;
+    }
+    return add_fw_alarm(time > now_us ? time : now_us, callback, user_data, NULL);
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past)
+{
+    return add_alarm_at(virtual_clock_now_us() + us, callback, user_data, fire_if_past);
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past)
+{
+    return add_alarm_in_us((uint64_t)ms * 1000, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t alarm_id)
+{
+    sync();
+    for (size_t i = 0; alarm_id > 0 && i < VIRTUAL_CLOCK_MAX_ALARMS; i++) {
+        if (fw_alarms[i].id == alarm_id) {
+            fw_alarms[i].id = 0;
+            return virtual_clock_cancel(alarm_id);
+        }
+    }
+    return false;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out)
+{
+    sync();
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+    const uint64_t first_us = (uint64_t)(delay_us < 0 ? -delay_us : delay_us);
+    out->alarm_id = add_fw_alarm(virtual_clock_now_us() + first_us, NULL, NULL, out);
+    return out->alarm_id > 0;
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer)
+{
+    const bool cancelled = cancel_alarm(timer->alarm_id);
+    timer->alarm_id = 0;
+    return cancelled;
+}
+
+// ---------------------------------------------------------------------------------------
+// Sleep
+
+void __wfi(void)
+{
+    sync();
+    stats.wfi++;
+    const bool deep = (scb_hw->scr & M0PLUS_SCR_SLEEPDEEP_BITS) != 0;
+
+    // Gated clocks stop their peripherals: a pending alarm needs the timer, the pen down
+    // interrupt the IO bank.
+    if (deep) {
+        bool alarm_pending = false;
+        for (size_t i = 0; i < VIRTUAL_CLOCK_MAX_ALARMS; i++) {
+            alarm_pending |= (fw_alarms[i].id != 0);
+        }
+        if ((alarm_pending && !(clocks_hw->sleep_en1 & CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS)) ||
+            (irq_enabled[IO_IRQ_BANK0] && !(clocks_hw->sleep_en0 & CLOCKS_SLEEP_EN0_CLK_SYS_IO_BITS))) {
+            stats.sleep_gating_errors++;
+        }
+    }
+
+    const uint32_t irqs = stats.irqs;
+    while (stats.irqs == irqs) {
+        if (!virtual_clock_wait(UINT64_MAX, deep ? HostCpuSleep : HostCpuWait)) {
+            fail("WFI with no interrupt that could wake the core");
+        }
+        check_stop();
+    }
+}
+
+void __wfe(void)
+{
+    __wfi();
+}
+
+// ---------------------------------------------------------------------------------------
+// Clocks
+
+uint32_t clock_get_hz(clock_handle_t clock)
+{
+    return clock < CLK_COUNT ? clk_hz[clock] : 0;
+}
+
+bool clock_configure(clock_handle_t clock, uint32_t src, uint32_t auxsrc, uint32_t src_freq, uint32_t freq)
+{
+    (void)src;
+    (void)auxsrc;
+    if (clock >= CLK_COUNT || freq == 0 || freq > src_freq) {
+        return false;
+    }
+    pio_sync();   // Up to now at the old clk_sys
+    clk_hz[clock] = freq;
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------
+// GPIO
+
+typedef struct {
+    bool out;
+    bool out_level;
+    bool in_level;
+    gpio_function_t fn;
+    uint32_t irq_mask;
+    uint32_t irq_pending;
+    irq_handler_t handler;
+} gpio_state_t;
+
+static gpio_state_t gpios[NUM_BANK0_GPIOS];
+static void (*gpio_change_cb)(uint gpio, bool level) = NULL;
+
+void gpio_init(uint gpio)
+{
+    gpios[gpio].out = false;
+    gpios[gpio].out_level = false;
+    gpios[gpio].fn = GPIO_FUNC_SIO;
+}
+
+void gpio_set_dir(uint gpio, bool out)
+{
+    gpios[gpio].out = out;
+}
+
+void gpio_put(uint gpio, bool value)
+{
+    const bool changed = (gpios[gpio].out_level != value);
+    gpios[gpio].out_level = value;
+    if (changed && gpio_change_cb) {
+        gpio_change_cb(gpio, value);
+    }
+}
+
+bool gpio_get(uint gpio)
+{
+    return gpios[gpio].out ? gpios[gpio].out_level : gpios[gpio].in_level;
+}
+
+void gpio_set_function(uint gpio, gpio_function_t fn)
+{
+    gpios[gpio].fn = fn;
+}
+
+void gpio_pull_up(uint gpio)
+{
+    gpios[gpio].in_level = true;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled)
+{
+    sync();
+    gpios[gpio].irq_pending &= ~event_mask;
+    if (enabled) {
+        gpios[gpio].irq_mask |= event_mask;
+    }
+    else {
+        gpios[gpio].irq_mask &= ~event_mask;
+    }
+}
+
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask)
+{
+    gpios[gpio].irq_pending &= ~event_mask;
+}
+
+void gpio_add_raw_irq_handler(uint gpio, irq_handler_t handler)
+{
+    gpios[gpio].handler = handler;
+}
+
+void host_gpio_set_input(uint gpio, bool level)
+{
+    gpio_state_t *g = &gpios[gpio];
+    if (g->in_level == level) {
+        return;
+    }
+    g->in_level = level;
+    g->irq_pending |= level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+
+    if ((g->irq_pending & g->irq_mask) && irq_enabled[IO_IRQ_BANK0] && g->handler) {
+        stats.irqs++;
+        g->handler();
+    }
+}
+
+bool host_gpio_out(uint gpio)
+{
+    return gpios[gpio].out_level;
+}
+
+void host_gpio_on_change(void (*cb)(uint gpio, bool level))
+{
+    gpio_change_cb = cb;
+}
+
+// ---------------------------------------------------------------------------------------
+// SPI
+
+struct spi_inst {
+    host_cpu_t category;
+    uint prescale;
+    uint postdiv;
+    uint data_bits;
+    uint64_t rem;   // Wire time below a ns
+    const host_spi_device_t *device;
+};
+
+spi_inst_t host_spi0 = {.category = HostCpuLcd};
+spi_inst_t host_spi1 = {.category = HostCpuTouch};
+
+// Same search as the SDK: smallest even prescaler, then the largest rate not above baudrate.
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate)
+{
+    const uint freq_in = clk_hz[clk_peri];
+    uint prescale;
+    for (prescale = 2; prescale <= 254; prescale += 2) {
+        if (freq_in < (uint64_t)prescale * 256 * baudrate) {
+            break;
+        }
+    }
+    hard_assert(prescale <= 254);
+
+    uint postdiv;
+    for (postdiv = 256; postdiv > 1; --postdiv) {
+        if (freq_in / (prescale * (postdiv - 1)) > baudrate) {
+            break;
+        }
+    }
+    spi->prescale = prescale;
+    spi->postdiv = postdiv;
+    return freq_in / (prescale * postdiv);
+}
+
+uint spi_get_baudrate(const spi_inst_t *spi)
+{
+    return clk_hz[clk_peri] / (spi->prescale * spi->postdiv);
+}
+
+uint spi_init(spi_inst_t *spi, uint baudrate)
+{
+    spi->data_bits = 8;
+    return spi_set_baudrate(spi, baudrate);
+}
+
+void spi_deinit(spi_inst_t *spi)
+{
+    spi->prescale = 0;
+}
+
+void host_spi_attach(spi_inst_t *spi, const host_spi_device_t *device)
+{
+    spi->device = device;
+}
+
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order)
+{
+    (void)cpol;
+    (void)cpha;
+    (void)order;
+    spi->data_bits = data_bits;
+}
+
+static uint16_t spi_word(spi_inst_t *spi, uint16_t tx)
+{
+    hard_assert(spi->prescale != 0);
+    return spi->device ? spi->device->transfer(tx, spi->data_bits) : 0;
+}
+
+static void spi_wire_time(spi_inst_t *spi, size_t words)
+{
+    const uint64_t num = (uint64_t)words * spi->data_bits * 1000000000ull + spi->rem;
+    const uint baud = spi_get_baudrate(spi);
+    spi->rem = num % baud;
+    charge_ns(spi->category, num / baud);
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len)
+{
+    sync();
+    for (size_t i = 0; i < len; i++) {
+        spi_word(spi, src[i]);
+    }
+    spi_wire_time(spi, len);
+    return (int)len;
+}
+
+int spi_write16_blocking(spi_inst_t *spi, const uint16_t *src, size_t len)
+{
+    sync();
+    for (size_t i = 0; i < len; i++) {
+        spi_word(spi, src[i]);
+    }
+    spi_wire_time(spi, len);
+    return (int)len;
+}
+
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len)
+{
+    sync();
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = (uint8_t)spi_word(spi, repeated_tx_data);
+    }
+    spi_wire_time(spi, len);
+    return (int)len;
+}
+
+// ---------------------------------------------------------------------------------------
+// ADC
+
+static uint32_t adc_mv[5];
+static uint adc_input = 0;
+
+void adc_init(void)
+{
+}
+
+void adc_gpio_init(uint gpio)
+{
+    gpios[gpio].fn = GPIO_FUNC_NULL;
+}
+
+void adc_select_input(uint input)
+{
+    adc_input = input;
+}
+
+uint16_t adc_read(void)
+{
+    host_cpu_us(HostCpuRun, ADC_READ_US);
+    const uint32_t raw = adc_mv[adc_input] * 4096 / ADC_REF_MV;
+    return (uint16_t)(raw > 4095 ? 4095 : raw);
+}
+
+void host_adc_set_mv(uint input, uint32_t mv)
+{
+    adc_mv[input] = mv;
+}
+
+// ---------------------------------------------------------------------------------------
+// UART: the TX FIFO drains one character per 10 bit times, worked out when looked at.
+
+struct uart_inst {
+    uint32_t ibrd;
+    uint32_t fbrd;
+    uint64_t tx_done_ns;   // When the last queued character is out
+    char line[UART_LINE_SIZE];
+    size_t line_len;
+    char rx[UART_RX_SIZE];
+    size_t rx_head;
+    size_t rx_count;
+};
+
+uart_inst_t host_uart0;
+
+static void (*uart_line_cb)(const char *line) = NULL;
+static bool uart_echo = false;
+
+uint uart_set_baudrate(uart_inst_t *uart, uint baudrate)
+{
+    const uint32_t div = (uint32_t)((8ull * clk_hz[clk_peri] / baudrate) + 1);
+    uart->ibrd = div >> 7;
+    if (uart->ibrd == 0) {
+        uart->ibrd = 1;
+        uart->fbrd = 0;
+    }
+    else if (uart->ibrd >= 65535) {
+        uart->ibrd = 65535;
+        uart->fbrd = 0;
+    }
+    else {
+        uart->fbrd = (div & 0x7f) >> 1;
+    }
+    return (uint)((4ull * clk_hz[clk_peri]) / (64 * uart->ibrd + uart->fbrd));
+}
+
+uint uart_init(uart_inst_t *uart, uint baudrate)
+{
+    uart->tx_done_ns = 0;
+    return uart_set_baudrate(uart, baudrate);
+}
+
+static uint64_t uart_char_ns(const uart_inst_t *uart)
+{
+    const uint64_t baud = (4ull * clk_hz[clk_peri]) / (64 * uart->ibrd + uart->fbrd);
+    return UART_BITS_PER_CHAR * 1000000000ull / baud;
+}
+
+static uint64_t now_ns()
+{
+    return virtual_clock_now_us() * 1000 + ns_rem;
+}
+
+static uint32_t uart_tx_level(const uart_inst_t *uart)
+{
+    const uint64_t now = now_ns();
+    if (uart->tx_done_ns <= now) {
+        return 0;
+    }
+    const uint64_t char_ns = uart_char_ns(uart);
+    return (uint32_t)((uart->tx_done_ns - now + char_ns - 1) / char_ns);
+}
+
+bool uart_is_writable(uart_inst_t *uart)
+{
+    sync();
+    return uart_tx_level(uart) < UART_FIFO_DEPTH;
+}
+
+static void uart_line_char(uart_inst_t *uart, char c)
+{
+    if (c == '\r') {
+        return;
+    }
+    if (c != '\n') {
+        if (uart->line_len < sizeof(uart->line) - 1) {
+            uart->line[uart->line_len++] = c;
+        }
+        return;
+    }
+
+    uart->line[uart->line_len] = '\0';
+    uart->line_len = 0;
+    if (strstr(uart->line, "ERROR")) {
+        stats.uart_error_lines++;
+    }
+    if (uart_echo) {
+        printf("%s\n", uart->line);
+    }
+    if (uart_line_cb) {
+        uart_line_cb(uart->line);
+    }
+}
+
+void uart_putc_raw(uart_inst_t *uart, char c)
+{
+    sync();
+    // A full FIFO holds the writer until the oldest character has gone out.
+    const uint32_t level = uart_tx_level(uart);
+    if (level >= UART_FIFO_DEPTH) {
+        const uint64_t room_ns = uart->tx_done_ns - (UART_FIFO_DEPTH - 1) * uart_char_ns(uart);
+        charge_ns(HostCpuUart, room_ns - now_ns());
+    }
+    const uint64_t now = now_ns();
+    uart->tx_done_ns = ((uart->tx_done_ns > now) ? uart->tx_done_ns : now) + uart_char_ns(uart);
+    stats.uart_chars++;
+    uart_line_char(uart, c);
+}
+
+void uart_putc(uart_inst_t *uart, char c)
+{
+    uart_putc_raw(uart, c);
+}
+
+void uart_puts(uart_inst_t *uart, const char *s)
+{
+    while (*s) {
+        uart_putc(uart, *s++);
+    }
+}
+
+void uart_tx_wait_blocking(uart_inst_t *uart)
+{
+    sync();
+    const uint64_t now = now_ns();
+    if (uart->tx_done_ns > now) {
+        charge_ns(HostCpuUart, uart->tx_done_ns - now);
+    }
+}
+
+bool uart_is_readable(uart_inst_t *uart)
+{
+    sync();
+    return uart->rx_count > 0;
+}
+
+char uart_getc(uart_inst_t *uart)
+{
+    sync();
+    if (uart->rx_count == 0) {
+        return 0;
+    }
+    const char c = uart->rx[uart->rx_head];
+    uart->rx_head = (uart->rx_head + 1) % UART_RX_SIZE;
+    uart->rx_count--;
+    return c;
+}
+
+void host_uart_rx(const char *text)
+{
+    uart_inst_t *uart = uart0;
+    for (; *text && uart->rx_count < UART_RX_SIZE; text++) {
+        uart->rx[(uart->rx_head + uart->rx_count) % UART_RX_SIZE] = *text;
+        uart->rx_count++;
+    }
+}
+
+void host_uart_on_line(void (*cb)(const char *line))
+{
+    uart_line_cb = cb;
+}
+
+void host_uart_echo(bool echo)
+{
+    uart_echo = echo;
+}
+
+bool stdio_init_all(void)
+{
+    uart_init(uart0, 115200);
+    return true;
+}
+
+// stdio on the UART, with the SDK's default CRLF translation.
+int host_printf(const char *fmt, ...)
+{
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    const int len = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    for (const char *c = buf; *c; c++) {
+        if (*c == '\n') {
+            uart_putc(uart0, '\r');
+        }
+        uart_putc(uart0, *c);
+    }
+    return len;
+}
+
+// ---------------------------------------------------------------------------------------
+// PWM
+
+void pwm_init(uint slice_num, pwm_config *c, bool start)
+{
+    pwm_slice_hw_t *s = &pwm_hw->slice[slice_num];
+    s->csr = c->csr | (start ? 1u : 0u);
+    s->div = c->div;
+    s->top = c->top;
+    s->ctr = 0;
+    s->cc = 0;
+}
+
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level)
+{
+    pwm_slice_hw_t *s = &pwm_hw->slice[slice_num];
+    s->cc = chan ? ((s->cc & 0xffffu) | ((uint32_t)level << 16)) : ((s->cc & 0xffff0000u) | level);
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled)
+{
+    pwm_slice_hw_t *s = &pwm_hw->slice[slice_num];
+    s->csr = enabled ? (s->csr | 1u) : (s->csr & ~1u);
+}
+
+void pwm_set_clkdiv_int_frac(uint slice_num, uint8_t integer, uint8_t fract)
+{
+    pwm_hw->slice[slice_num].div = ((uint32_t)integer << 4) | (fract & 0xfu);
+}
+
+// One wrap of the slice, in ns.
+static uint64_t pwm_period_ns(uint slice_num)
+{
+    const pwm_slice_hw_t *s = &pwm_hw->slice[slice_num];
+    return ((uint64_t)s->top + 1) * s->div * 1000000000ull / (16ull * clk_hz[clk_sys]);
+}
+
+// ---------------------------------------------------------------------------------------
+// DMA
+
+#define DMA_CTRL_EN_BITS          (1u << 0)
+#define DMA_CTRL_SIZE_LSB         (2)
+#define DMA_CTRL_INCR_READ_BITS   (1u << 4)
+#define DMA_CTRL_INCR_WRITE_BITS  (1u << 5)
+#define DMA_CTRL_TREQ_LSB         (15)
+#define DMA_CTRL_TREQ_MASK        (0x3fu << DMA_CTRL_TREQ_LSB)
+
+typedef struct {
+    bool claimed;
+    uint32_t ctrl;
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint32_t count;
+    uint32_t done;
+    uint64_t start_ns;
+    uint64_t period_ns;    // 0: unpaced
+    bool busy;
+    bool pio_paced;        // Fed to a PIO TX FIFO
+    bool pio_done;         // Completed by the PIO, interrupt still to raise
+    bool irq0_enabled;
+    bool irq0_status;
+    virtual_alarm_id_t alarm;
+    dma_channel_hw_t hw;
+} dma_state_t;
+
+static dma_state_t dmas[NUM_DMA_CHANNELS];
+
+int dma_claim_unused_channel(bool required)
+{
+    for (int i = 0; i < NUM_DMA_CHANNELS; i++) {
+        if (!dmas[i].claimed) {
+            dmas[i].claimed = true;
+            return i;
+        }
+    }
+    hard_assert(!required);
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel)
+{
+    dmas[channel].claimed = false;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    (void)channel;
+    const dma_channel_config c = {
+        .ctrl = DMA_CTRL_EN_BITS | ((uint32_t)DMA_SIZE_32 << DMA_CTRL_SIZE_LSB) | DMA_CTRL_INCR_READ_BITS |
+                ((uint32_t)DREQ_FORCE << DMA_CTRL_TREQ_LSB),
+    };
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size)
+{
+    c->ctrl = (c->ctrl & ~(3u << DMA_CTRL_SIZE_LSB)) | ((uint32_t)size << DMA_CTRL_SIZE_LSB);
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr)
+{
+    c->ctrl = incr ? (c->ctrl | DMA_CTRL_INCR_READ_BITS) : (c->ctrl & ~DMA_CTRL_INCR_READ_BITS);
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr)
+{
+    c->ctrl = incr ? (c->ctrl | DMA_CTRL_INCR_WRITE_BITS) : (c->ctrl & ~DMA_CTRL_INCR_WRITE_BITS);
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq)
+{
+    c->ctrl = (c->ctrl & ~DMA_CTRL_TREQ_MASK) | ((dreq << DMA_CTRL_TREQ_LSB) & DMA_CTRL_TREQ_MASK);
+}
+
+static void dma_copy_next(dma_state_t *d)
+{
+    const uint32_t size = 1u << ((d->ctrl >> DMA_CTRL_SIZE_LSB) & 3u);
+    const uint8_t *src = (const uint8_t *)d->read_addr + ((d->ctrl & DMA_CTRL_INCR_READ_BITS) ? d->done * size : 0);
+    uint8_t *dst = (uint8_t *)d->write_addr + ((d->ctrl & DMA_CTRL_INCR_WRITE_BITS) ? d->done * size : 0);
+    uint32_t value = 0;
+    memcpy(&value, src, size);
+    if (size == 2 && !(d->ctrl & DMA_CTRL_INCR_WRITE_BITS)) {
+        value |= value << 16;
+        memcpy((void *)((uintptr_t)dst & ~(uintptr_t)3), &value, 4);
+    }
+    else {
+        memcpy(dst, &value, size);
+    }
+    d->done++;
+    d->hw.transfer_count = d->count - d->done;
+}
+
+static void dma_complete(dma_state_t *d)
+{
+    if (d->alarm) {
+        virtual_clock_cancel(d->alarm);
+        d->alarm = 0;
+    }
+    d->irq0_status = true;
+    if (d->irq0_enabled) {
+        raise_irq(DMA_IRQ_0);
+    }
+}
+
+// Carries out the transfers due by now. 16 bit writes to a fixed address land in both
+// halves of the word, as the bus replicates them. Channels paced by a PIO TX FIFO move as
+// the state machine pulls, see pio_sync().
+static void dma_update(uint channel)
+{
+    dma_state_t *d = &dmas[channel];
+    if (d->pio_paced) {
+        pio_sync();
+    }
+    if (!d->busy || d->pio_paced) {
+        return;
+    }
+
+    uint32_t due = d->count;
+    if (d->period_ns) {
+        const uint64_t n = (now_ns() - d->start_ns) / d->period_ns;
+        due = (n < d->count) ? (uint32_t)n : d->count;
+    }
+    while (d->done < due) {
+        dma_copy_next(d);
+    }
+
+    if (d->done == d->count) {
+        d->busy = false;
+        dma_complete(d);
+    }
+}
+
+static int64_t dma_done_fire(virtual_alarm_id_t id, void *user_data)
+{
+    dma_state_t *d = user_data;
+    if (d->alarm == id) {
+        d->alarm = 0;
+    }
+    dma_update((uint)(d - dmas));
+    return 0;
+}
+
+static void dma_start(uint channel)
+{
+    dma_state_t *d = &dmas[channel];
+    const uint dreq = (d->ctrl & DMA_CTRL_TREQ_MASK) >> DMA_CTRL_TREQ_LSB;
+    d->done = 0;
+    d->busy = true;
+    d->start_ns = now_ns();
+    d->period_ns = (dreq >= DREQ_PWM_WRAP0 && dreq < DREQ_PWM_WRAP0 + NUM_PWM_SLICES) ? pwm_period_ns(dreq - DREQ_PWM_WRAP0) : 0;
+    d->pio_paced = (dreq == DREQ_PIO0_TX0 + (dreq & 3u) || dreq == DREQ_PIO1_TX0 + (dreq & 3u)) && d->count;
+    d->pio_done = false;
+    d->hw.transfer_count = d->count;
+
+    if (d->pio_paced) {
+        pio_dma_started();
+    }
+    else if (d->period_ns && d->count) {
+        const uint64_t end_ns = d->start_ns + d->count * d->period_ns;
+        d->alarm = virtual_clock_add_alarm((end_ns + 999) / 1000, dma_done_fire, d);
+    }
+    else {
+        dma_update(channel);
+    }
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger)
+{
+    sync();
+    dma_state_t *d = &dmas[channel];
+    d->ctrl = config->ctrl;
+    d->write_addr = write_addr;
+    d->read_addr = read_addr;
+    d->count = transfer_count;
+    if (trigger) {
+        dma_start(channel);
+    }
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count)
+{
+    sync();
+    dma_state_t *d = &dmas[channel];
+    d->read_addr = read_addr;
+    d->count = transfer_count;
+    dma_start(channel);
+}
+
+void dma_channel_abort(uint channel)
+{
+    sync();
+    dma_state_t *d = &dmas[channel];
+    if (!d->busy) {
+        return;
+    }
+    // The transfers due by now have happened, the rest never will.
+    const bool irq0_enabled = d->irq0_enabled;
+    d->irq0_enabled = false;
+    dma_update(channel);
+    d->irq0_enabled = irq0_enabled;
+    d->busy = false;
+    d->pio_done = false;
+    if (d->alarm) {
+        virtual_clock_cancel(d->alarm);
+        d->alarm = 0;
+    }
+}
+
+bool dma_channel_is_busy(uint channel)
+{
+    sync();
+    dma_update(channel);
+    return dmas[channel].busy;
+}
+
+dma_channel_hw_t *dma_channel_hw_addr(uint channel)
+{
+    dma_update(channel);
+    return &dmas[channel].hw;
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled)
+{
+    dmas[channel].irq0_enabled = enabled;
+}
+
+bool dma_channel_get_irq0_status(uint channel)
+{
+    return dmas[channel].irq0_status;
+}
+
+void dma_channel_acknowledge_irq0(uint channel)
+{
+    dmas[channel].irq0_status = false;
+}
+
+uint32_t host_pwm_duty(uint gpio)
+{
+    const uint slice = pwm_gpio_to_slice_num(gpio);
+    for (uint i = 0; i < NUM_DMA_CHANNELS; i++) {
+        dma_update(i);
+    }
+
+    const pwm_slice_hw_t *s = &pwm_hw->slice[slice];
+    if (!(s->csr & 1u)) {
+        return 0;
+    }
+    const uint32_t level = pwm_gpio_to_channel(gpio) ? (s->cc >> 16) : (s->cc & 0xffffu);
+    return (level > s->top) ? 65536 : (uint32_t)(((uint64_t)level << 16) / (s->top + 1));
+}
+
+// ---------------------------------------------------------------------------------------
+// PIO: state machines step cycle by cycle up to now whenever the firmware looks at them,
+// and every microsecond while a DMA channel feeds one. A PULL on an empty FIFO skips
+// straight to now, nothing can fill the FIFO before the next call. FDEBUG reads back with
+// PIO_FDEBUG_WRITTEN set, a firmware write clears it and is applied at the next call, where
+// its write-1-to-clear takes effect.
+
+#define PIO_FIFO_DEPTH        (4)
+#define PIO_READ_CYCLES       (4)          // A register read and the loop around it
+#define PIO_POLL_US           (1)
+#define PIO_FDEBUG_WRITTEN    (1u << 31)   // Reserved on the device
+
+typedef struct {
+    bool claimed;
+    bool enabled;
+    pio_sm_config config;
+    uint8_t pc;
+    uint32_t osr;
+    uint32_t isr;
+    uint32_t x;
+    uint32_t y;
+    uint32_t delay;        // Cycles left
+    uint32_t fifo[2 * PIO_FIFO_DEPTH];
+    uint32_t fifo_head;
+    uint32_t fifo_level;
+    uint64_t next_ps;      // When the next cycle runs
+} pio_sm_state_t;
+
+typedef struct {
+    uint16_t instr[PIO_INSTRUCTION_COUNT];
+    uint32_t used;         // Instruction memory, a bit per slot
+    uint32_t fdebug;
+    pio_sm_state_t sm[NUM_PIO_STATE_MACHINES];
+} pio_state_t;
+
+pio_hw_t host_pio0_hw;
+pio_hw_t host_pio1_hw;
+
+static pio_state_t pios[NUM_PIOS];
+static uint32_t pio_pins;
+static bool pio_syncing = false;
+static virtual_alarm_id_t pio_poll_alarm = 0;
+static void (*pio_pins_cb)(uint64_t at_ns, uint32_t pins) = NULL;
+
+static pio_state_t *pio_state(PIO pio)
+{
+    return &pios[pio == pio1 ? 1 : 0];
+}
+
+static uint32_t pio_fifo_depth(const pio_sm_state_t *s)
+{
+    return (s->config.fifo_join == PIO_FIFO_JOIN_TX) ? 2 * PIO_FIFO_DEPTH : PIO_FIFO_DEPTH;
+}
+
+static uint64_t pio_cycle_ps(const pio_sm_state_t *s)
+{
+    const uint64_t div256 = ((uint64_t)s->config.clkdiv_int << 8) + s->config.clkdiv_frac;
+    return div256 * 1000000000000ull / (256ull * clk_hz[clk_sys]);
+}
+
+static void pio_fifo_push(pio_sm_state_t *s, uint32_t word)
+{
+    s->fifo[(s->fifo_head + s->fifo_level) % pio_fifo_depth(s)] = word;
+    s->fifo_level++;
+}
+
+static uint32_t pio_fifo_pop(pio_sm_state_t *s)
+{
+    const uint32_t word = s->fifo[s->fifo_head];
+    s->fifo_head = (s->fifo_head + 1) % pio_fifo_depth(s);
+    s->fifo_level--;
+    return word;
+}
+
+static void pio_set_pins(uint base, uint count, uint32_t value)
+{
+    for (uint i = 0; i < count; i++) {
+        const uint32_t bit = 1u << ((base + i) % 32);
+        pio_pins = (value >> i) & 1u ? (pio_pins | bit) : (pio_pins & ~bit);
+    }
+}
+
+static void pio_publish_pins(uint64_t at_ps, uint32_t before)
+{
+    if (pio_pins == before) {
+        return;
+    }
+    for (uint gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+        gpios[gpio].out_level = (pio_pins >> gpio) & 1u;
+    }
+    if (pio_pins_cb) {
+        pio_pins_cb(at_ps / 1000, pio_pins);
+    }
+}
+
+// The DMA channel writing this state machine's FIFO, if one is busy.
+static dma_state_t *pio_feeder(pio_state_t *p, uint sm)
+{
+    const PIO pio = (p == &pios[1]) ? pio1 : pio0;
+    for (uint i = 0; i < NUM_DMA_CHANNELS; i++) {
+        dma_state_t *d = &dmas[i];
+        if (d->busy && d->pio_paced && d->write_addr == &pio->txf[sm]) {
+            return d;
+        }
+    }
+    return NULL;
+}
+
+static void pio_feed(pio_state_t *p, uint sm)
+{
+    pio_sm_state_t *s = &p->sm[sm];
+    dma_state_t *d = pio_feeder(p, sm);
+    const PIO pio = (p == &pios[1]) ? pio1 : pio0;
+    while (d && s->fifo_level < pio_fifo_depth(s)) {
+        dma_copy_next(d);
+        pio_fifo_push(s, pio->txf[sm]);
+        if (d->done == d->count) {
+            d->busy = false;
+            d->pio_done = true;
+            d = NULL;
+        }
+    }
+}
+
+static uint32_t pio_mov_source(const pio_sm_state_t *s, uint source)
+{
+    switch (source) {
+    case 1: return s->x;
+    case 2: return s->y;
+    case 3: return 0;
+    case 6: return s->isr;
+    case 7: return s->osr;
+    default:
+        fail("PIO MOV source not emulated");
+        return 0;
+    }
+}
+
+static void pio_write_dest(pio_sm_state_t *s, uint dest, uint32_t value, bool is_set)
+{
+    switch (dest) {
+    case 0:
+        if (is_set) {
+            pio_set_pins(s->config.set_base, s->config.set_count, value);
+        }
+        else {
+            pio_set_pins(s->config.out_base, s->config.out_count, value);
+        }
+        break;
+    case 1: s->x = value; break;
+    case 2: s->y = value; break;
+    case 3: break;
+    case 6: s->isr = value; break;
+    case 7: s->osr = value; break;
+    default:
+        fail("PIO destination not emulated");
+        break;
+    }
+}
+
+// One instruction. Returns false if it stalled, to be issued again on the next cycle.
+static bool pio_exec(pio_state_t *p, uint sm)
+{
+    pio_sm_state_t *s = &p->sm[sm];
+    const uint16_t instr = p->instr[s->pc];
+    const uint side_bits = s->config.sideset_bits;
+    const uint delay_bits = 5 - side_bits;
+    const uint field = (instr >> 8) & 0x1fu;
+    const uint arg1 = (instr >> 5) & 7u;
+    const uint arg2 = instr & 0x1fu;
+
+    // Side-set happens on issue, stalled or not.
+    if (side_bits) {
+        const uint side = field >> delay_bits;
+        if (!s->config.sideset_opt) {
+            pio_set_pins(s->config.sideset_base, side_bits, side);
+        }
+        else if (side >> (side_bits - 1)) {
+            pio_set_pins(s->config.sideset_base, side_bits - 1, side);
+        }
+    }
+
+    bool jumped = false;
+    switch (instr >> 13) {
+    case 0: {   // JMP
+        bool take;
+        switch (arg1) {
+        case 0: take = true; break;
+        case 1: take = (s->x == 0); break;
+        case 2: take = (s->x-- != 0); break;
+        case 3: take = (s->y == 0); break;
+        case 4: take = (s->y-- != 0); break;
+        case 5: take = (s->x != s->y); break;
+        default:
+            fail("PIO JMP condition not emulated");
+            take = false;
+            break;
+        }
+        if (take) {
+            s->pc = (uint8_t)arg2;
+            jumped = true;
+        }
+        break;
+    }
+    case 3: {   // OUT, no autopull
+        const uint bits = arg2 ? arg2 : 32;
+        uint32_t value;
+        if (s->config.out_shift_right) {
+            value = (bits == 32) ? s->osr : (s->osr & ((1u << bits) - 1));
+            s->osr = (bits == 32) ? 0 : (s->osr >> bits);
+        }
+        else {
+            value = s->osr >> (32 - bits);
+            s->osr = (bits == 32) ? 0 : (s->osr << bits);
+        }
+        pio_write_dest(s, arg1, value, false);
+        break;
+    }
+    case 4:     // PULL
+        if (!(instr & 0x80u)) {
+            fail("PIO PUSH not emulated");
+            break;
+        }
+        if (s->fifo_level == 0) {
+            if (instr & 0x20u) {
+                p->fdebug |= 1u << (PIO_FDEBUG_TXSTALL_LSB + sm);
+                return false;
+            }
+            s->osr = s->x;
+        }
+        else {
+            s->osr = pio_fifo_pop(s);
+        }
+        break;
+    case 5: {   // MOV
+        uint32_t value = pio_mov_source(s, instr & 7u);
+        const uint op = (instr >> 3) & 3u;
+        if (op == 1) {
+            value = ~value;
+        }
+        else if (op == 2) {
+            uint32_t reversed = 0;
+            for (uint i = 0; i < 32; i++) {
+                reversed |= ((value >> i) & 1u) << (31 - i);
+            }
+            value = reversed;
+        }
+        pio_write_dest(s, arg1, value, false);
+        break;
+    }
+    case 7:     // SET
+        pio_write_dest(s, arg1, arg2, true);
+        break;
+    default:
+        fail("PIO instruction not emulated");
+        break;
+    }
+
+    if (!jumped) {
+        s->pc = (s->pc == s->config.wrap) ? s->config.wrap_target : (uint8_t)((s->pc + 1) % PIO_INSTRUCTION_COUNT);
+    }
+    s->delay = field & ((1u << delay_bits) - 1);
+    return true;
+}
+
+static void pio_step(pio_state_t *p, uint sm, uint64_t until_ps)
+{
+    pio_sm_state_t *s = &p->sm[sm];
+    if (!s->enabled) {
+        return;
+    }
+    const uint64_t cycle_ps = pio_cycle_ps(s);
+    while (s->next_ps <= until_ps) {
+        const uint32_t pins = pio_pins;
+        const uint64_t at_ps = s->next_ps;
+        bool stalled = false;
+        if (s->delay) {
+            s->delay--;
+        }
+        else {
+            pio_feed(p, sm);
+            stalled = !pio_exec(p, sm);
+        }
+        pio_publish_pins(at_ps, pins);
+        s->next_ps += cycle_ps;
+        if (stalled) {
+            s->next_ps += (until_ps - at_ps) / cycle_ps * cycle_ps;
+        }
+    }
+}
+
+// A firmware write to FDEBUG since the last call, as the write-1-to-clear it is.
+static void pio_fdebug_written()
+{
+    for (uint i = 0; i < NUM_PIOS; i++) {
+        pio_hw_t *hw = i ? pio1 : pio0;
+        if (!(hw->fdebug & PIO_FDEBUG_WRITTEN)) {
+            pios[i].fdebug &= ~hw->fdebug;
+        }
+    }
+}
+
+static void pio_sync()
+{
+    if (pio_syncing) {
+        return;
+    }
+    pio_syncing = true;
+    pio_fdebug_written();
+    const uint64_t now_ps = now_ns() * 1000;
+    for (uint i = 0; i < NUM_PIOS; i++) {
+        for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+            pio_step(&pios[i], sm, now_ps);
+        }
+        (i ? pio1 : pio0)->fdebug = pios[i].fdebug | PIO_FDEBUG_WRITTEN;
+    }
+    pio_syncing = false;
+
+    // Handlers run once the state machines are up to date, they may queue more.
+    for (uint i = 0; i < NUM_DMA_CHANNELS; i++) {
+        if (dmas[i].pio_done) {
+            dmas[i].pio_done = false;
+            dma_complete(&dmas[i]);
+        }
+    }
+}
+
+static int64_t pio_poll_fire(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    pio_sync();
+    for (uint i = 0; i < NUM_DMA_CHANNELS; i++) {
+        if (dmas[i].busy && dmas[i].pio_paced) {
+            return -PIO_POLL_US;
+        }
+    }
+    pio_poll_alarm = 0;
+    return 0;
+}
+
+static void pio_dma_started()
+{
+    pio_sync();
+    if (!pio_poll_alarm) {
+        pio_poll_alarm = virtual_clock_add_alarm(virtual_clock_now_us() + PIO_POLL_US, pio_poll_fire, NULL);
+    }
+}
+
+// Register reads take a few cycles, so a loop polling the state machine sees it move.
+static pio_sm_state_t *pio_read(PIO pio, uint sm)
+{
+    sync();
+    host_cpu_cycles(HostCpuLcd, PIO_READ_CYCLES);
+    pio_sync();
+    return &pio_state(pio)->sm[sm];
+}
+
+int pio_claim_unused_sm(PIO pio, bool required)
+{
+    pio_state_t *p = pio_state(pio);
+    for (int sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+        if (!p->sm[sm].claimed) {
+            p->sm[sm].claimed = true;
+            return sm;
+        }
+    }
+    hard_assert(!required);
+    return -1;
+}
+
+void pio_sm_unclaim(PIO pio, uint sm)
+{
+    pio_state(pio)->sm[sm].claimed = false;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program)
+{
+    pio_state_t *p = pio_state(pio);
+    const uint32_t mask = (program->length < 32) ? ((1u << program->length) - 1) : 0xffffffffu;
+    int offset = -1;
+    if (program->origin >= 0) {
+        offset = !(p->used & (mask << program->origin)) ? program->origin : -1;
+    }
+    else {
+        for (int at = PIO_INSTRUCTION_COUNT - program->length; at >= 0 && offset < 0; at--) {
+            offset = !(p->used & (mask << at)) ? at : -1;
+        }
+    }
+    hard_assert(offset >= 0);
+    if (offset < 0) {
+        return 0;
+    }
+
+    for (uint i = 0; i < program->length; i++) {
+        const uint16_t instr = program->instructions[i];
+        p->instr[offset + i] = (instr >> 13) ? instr : (uint16_t)(instr + offset);
+    }
+    p->used |= mask << offset;
+    return (uint)offset;
+}
+
+void pio_gpio_init(PIO pio, uint pin)
+{
+    gpio_set_function(pin, pio == pio1 ? GPIO_FUNC_PIO1 : GPIO_FUNC_PIO0);
+}
+
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask)
+{
+    (void)pio;
+    (void)sm;
+    pio_sync();
+    const uint32_t before = pio_pins;
+    pio_pins = (pio_pins & ~pin_mask) | (pin_values & pin_mask);
+    pio_publish_pins(now_ns() * 1000, before);
+}
+
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out)
+{
+    for (uint i = 0; i < pin_count; i++) {
+        gpios[(pin_base + i) % NUM_BANK0_GPIOS].out = is_out;
+    }
+    (void)pio;
+    (void)sm;
+}
+
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config)
+{
+    pio_sync();
+    pio_state_t *p = pio_state(pio);
+    pio_sm_state_t *s = &p->sm[sm];
+    const bool claimed = s->claimed;
+    *s = (pio_sm_state_t){.claimed = claimed, .config = *config, .pc = (uint8_t)initial_pc};
+    p->fdebug &= ~(0x01010101u << sm);
+    pio->fdebug = p->fdebug | PIO_FDEBUG_WRITTEN;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled)
+{
+    pio_sync();
+    pio_sm_state_t *s = &pio_state(pio)->sm[sm];
+    if (enabled && !s->enabled) {
+        s->next_ps = now_ns() * 1000;
+    }
+    s->enabled = enabled;
+}
+
+void pio_sm_set_clkdiv_int_frac(PIO pio, uint sm, uint16_t div_int, uint8_t div_frac)
+{
+    pio_sync();
+    sm_config_set_clkdiv_int_frac(&pio_state(pio)->sm[sm].config, div_int, div_frac);
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data)
+{
+    pio_sm_state_t *s = pio_read(pio, sm);
+    while (s->fifo_level >= pio_fifo_depth(s)) {
+        if (!s->enabled) {
+            fail("put to the full FIFO of a stopped state machine");
+        }
+        s = pio_read(pio, sm);
+    }
+    pio_fifo_push(s, data);
+}
+
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm)
+{
+    return pio_read(pio, sm)->fifo_level == 0;
+}
+
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm)
+{
+    const pio_sm_state_t *s = pio_read(pio, sm);
+    return s->fifo_level >= pio_fifo_depth(s);
+}
+
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm)
+{
+    return pio_read(pio, sm)->fifo_level;
+}
+
+uint8_t pio_sm_get_pc(PIO pio, uint sm)
+{
+    return pio_read(pio, sm)->pc;
+}
+
+void host_pio_on_pins(void (*cb)(uint64_t at_ns, uint32_t pins))
+{
+    pio_pins_cb = cb;
+}
+
+// ---------------------------------------------------------------------------------------
+
+void host_hard_assert(bool condition, const char *expr, const char *file, int line)
+{
+    if (!condition) {
+        char what[160];
+        snprintf(what, sizeof(what), "hard_assert(%s) failed in %s:%d", expr, file, line);
+        stats.asserts++;
+        fail(what);
+    }
+}
+
+void host_sdk_reset()
+{
+    virtual_clock_reset();
+    memset(&stats, 0, sizeof(stats));
+    read_cycles = DEFAULT_READ_CYCLES;
+    cycle_rem = 0;
+    ns_rem = 0;
+    running = false;
+    stopping = false;
+    stopped = false;
+    run_ok = true;
+
+    memset(clk_hz, 0, sizeof(clk_hz));
+    clk_hz[clk_ref] = 12000000;
+    clk_hz[clk_sys] = 125000000;
+    clk_hz[clk_peri] = 125000000;
+    clk_hz[clk_usb] = 48000000;
+    clk_hz[clk_adc] = 48000000;
+    clk_hz[clk_rtc] = 46875;
+
+    memset(&host_clocks_hw, 0, sizeof(host_clocks_hw));
+    host_clocks_hw.sleep_en0 = 0xffffffffu;
+    host_clocks_hw.sleep_en1 = 0x7fffu;
+    memset(&host_systick_hw, 0, sizeof(host_systick_hw));
+    memset(&host_scb_hw, 0, sizeof(host_scb_hw));
+    memset(&host_pwm_hw, 0, sizeof(host_pwm_hw));
+    systick_alarm = 0;
+
+    memset(irq_handlers, 0, sizeof(irq_handlers));
+    memset(irq_enabled, 0, sizeof(irq_enabled));
+    memset(fw_alarms, 0, sizeof(fw_alarms));
+    memset(gpios, 0, sizeof(gpios));
+    gpio_change_cb = NULL;
+    memset(dmas, 0, sizeof(dmas));
+    memset(adc_mv, 0, sizeof(adc_mv));
+    adc_input = 0;
+    memset(pios, 0, sizeof(pios));
+    host_pio0_hw = (pio_hw_t){.fdebug = PIO_FDEBUG_WRITTEN};
+    host_pio1_hw = (pio_hw_t){.fdebug = PIO_FDEBUG_WRITTEN};
+    pio_pins = 0;
+    pio_syncing = false;
+    pio_poll_alarm = 0;
+    pio_pins_cb = NULL;
+
+    host_spi0 = (spi_inst_t){.category = HostCpuLcd};
+    host_spi1 = (spi_inst_t){.category = HostCpuTouch};
+    memset(&host_uart0, 0, sizeof(host_uart0));
+    uart_line_cb = NULL;
+    uart_echo = false;
+}
+
+static int64_t end_of_run(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    stopping = true;
+    return 0;
+}
+
+void host_sdk_stop()
+{
+    stopping = true;
+}
+
+bool host_sdk_run(void (*fn)(), uint64_t end_us)
+{
+    run_ok = true;
+    virtual_clock_add_alarm(end_us, end_of_run, NULL);
+    if (setjmp(run_exit) == 0) {
+        running = true;
+        fn();
+        running = false;
+        printf("host_sdk: the firmware returned from main()\n");
+        run_ok = false;
+    }
+    stopped = true;
+    return run_ok;
+}
+
+void host_sdk_get_stats(host_sdk_stats_t *out)
+{
+    virtual_clock_stats_t clock;
+    virtual_clock_get_stats(&clock);
+    *out = stats;
+    for (int i = 0; i < HostCpuCount; i++) {
+        out->cpu_us[i] = clock.category_us[i];
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef _HOST_SDK_H
+#define _HOST_SDK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "hardware/spi.h"
+
+// The simulator's side of the host SDK (sim/sdk/, implemented in host_sdk.c): where the CPU
+// time went, the device models behind the peripherals and the inputs a scenario drives.
+
+// Every microsecond of virtual time is charged to one of these.
+typedef enum {
+    HostCpuRun,      // Main loop and interrupt handlers, charged per time read
+    HostCpuRender,   // LVGL drawing
+    HostCpuLcd,      // Blocking transfers on SPI0, waiting on the LCD state machine
+    HostCpuTouch,    // Blocking transfers on SPI1
+    HostCpuUart,     // Waiting for room in the UART TX FIFO
+    HostCpuFlash,    // Flash program and erase
+    HostCpuWait,     // sleep_ms(), sleep_until(), WFI without SLEEPDEEP
+    HostCpuSleep,    // WFI with SLEEPDEEP
+    HostCpuCount
+} host_cpu_t;
+
+extern const char *const host_cpu_names[HostCpuCount];
+
+typedef struct {
+    uint64_t cpu_us[HostCpuCount];
+    uint32_t irqs;                // Interrupt handlers run: alarms, SysTick, GPIO, DMA
+    uint32_t systicks;
+    uint32_t wfi;
+    uint32_t sleep_gating_errors; // Deep sleep with the clock of a pending wake source gated
+    uint32_t uart_chars;
+    uint32_t uart_error_lines;    // Lines containing "ERROR"
+    uint32_t asserts;
+} host_sdk_stats_t;
+
+// Fresh virtual clock and peripherals at their reset state, clk_sys at 125 MHz.
+void host_sdk_reset();
+
+// Runs fn (the firmware's main()) until the virtual clock reaches end_us, then returns.
+// Returns false if the firmware returned, hit a hard_assert or waited for an interrupt that
+// could never come.
+bool host_sdk_run(void (*fn)(), uint64_t end_us);
+
+// Ends host_sdk_run() early, at the firmware's next SDK call. For callbacks that have seen
+// what they were waiting for.
+void host_sdk_stop();
+
+void host_sdk_get_stats(host_sdk_stats_t *stats);
+
+// CPU time at the current clk_sys. The fake LVGL charges its drawing with it.
+void host_cpu_cycles(host_cpu_t category, uint64_t cycles);
+void host_cpu_us(host_cpu_t category, uint64_t us);
+
+// Cycles a time read costs, with the loop around it. The main loop polls the time, so this
+// sets how many iterations it gets through per second.
+void host_set_read_cycles(uint32_t cycles);
+
+// SPI devices see every word with the DCX and CS levels on their GPIOs at that moment.
+typedef struct {
+    uint16_t (*transfer)(uint16_t tx, uint data_bits);
+} host_spi_device_t;
+
+void host_spi_attach(spi_inst_t *spi, const host_spi_device_t *device);
+
+// Drives an input pin. A falling edge with the interrupt enabled runs the raw handler.
+void host_gpio_set_input(uint gpio, bool level);
+
+// Output level, and a callback on every output change.
+bool host_gpio_out(uint gpio);
+void host_gpio_on_change(void (*cb)(uint gpio, bool level));
+
+// Every change of the pins the PIO state machines drive, at the state machine cycle it
+// happens on, with the levels of all of them in a mask by GPIO number.
+void host_pio_on_pins(void (*cb)(uint64_t at_ns, uint32_t pins));
+
+void host_adc_set_mv(uint input, uint32_t mv);
+
+// PWM duty of a pin in parts of 65536, DMA fades included.
+uint32_t host_pwm_duty(uint gpio);
+
+// Characters arriving on the UART RX pin, they wait in the RX FIFO.
+void host_uart_rx(const char *text);
+
+// Every complete line written to the UART, without the line ending. echo copies the output
+// to stdout as well.
+void host_uart_on_line(void (*cb)(const char *line));
+void host_uart_echo(bool echo);
+
+// Keeps the display refresh timer of the host LVGL at LV_DEF_REFR_PERIOD: the periods the
+// firmware sets and its lv_timer_ready() kicks are ignored. The baseline for the refresh policy.
+void host_lvgl_fixed_refresh(bool fixed);
+
+// Firmware printf(), built with -Dprintf=host_printf: out through the UART model.
+int host_printf(const char *fmt, ...);
+
+#endif   // _HOST_SDK_H
@@ -0,0 +1,1334 @@
+#include "lvgl_private.h"
+#include "host_sdk.h"
+#include "ui_font_metrics.h"
+
+#include <string.h>
+
+// Host LVGL: objects, invalidation, the refresh and input timers and a small renderer, with
+// the order of calls and events the firmware sees from LVGL 9.3. Rendering writes real RGB565
+// pixels into the firmware's draw buffers and charges its work to HostCpuRender.
+
+// Rough SW renderer costs on the M0+, in cycles.
+#define CYCLES_REFR         (5000)   // Refresh timer run, whether or not anything is drawn
+#define CYCLES_OBJ          (2000)   // Per object drawn: clipping, style lookups, events
+#define CYCLES_FILL_PX      (2)
+#define CYCLES_IMAGE_PX     (3)
+#define CYCLES_GLYPH_PX     (12)
+#define CYCLES_TIMER        (150)    // Per timer looked at by lv_timer_handler()
+#define CYCLES_FLUSH_POLL   (64)
+
+#define INV_BUF_SIZE        (32)     // LV_INV_BUF_SIZE
+#define DEFAULT_OBJ_SIZE    (LV_DPI_DEF)
+
+#define STYLE_BG_COLOR      (1u << LV_STYLE_BG_COLOR)
+#define STYLE_BG_OPA        (1u << LV_STYLE_BG_OPA)
+#define STYLE_TEXT_COLOR    (1u << LV_STYLE_TEXT_COLOR)
+#define STYLE_TEXT_FONT     (1u << LV_STYLE_TEXT_FONT)
+#define STYLE_LINE_WIDTH    (1u << LV_STYLE_LINE_WIDTH)
+#define STYLE_LINE_COLOR    (1u << LV_STYLE_LINE_COLOR)
+#define STYLE_LINE_ROUNDED  (1u << LV_STYLE_LINE_ROUNDED)
+
+struct lv_timer_t {
+    uint32_t period;
+    uint32_t last_run;
+    lv_timer_cb_t cb;
+    void *user_data;
+    lv_timer_t *next;
+};
+
+struct lv_display_t {
+    int32_t hor_res;
+    int32_t ver_res;
+    lv_obj_t *screen;
+    uint8_t *buf1;
+    uint8_t *buf2;
+    uint8_t *buf_act;
+    uint32_t buf_size;
+    volatile bool flushing;
+    bool flushing_last;
+    bool rendering;
+    lv_area_t inv_areas[INV_BUF_SIZE];
+    bool inv_joined[INV_BUF_SIZE];
+    uint32_t inv_cnt;
+    host_event_dsc_t *events;
+    uint32_t event_cnt;
+    lv_timer_t *refr_timer;
+    uint32_t last_activity;
+    lv_lcd_send_cmd_cb_t send_cmd;
+    lv_lcd_send_color_cb_t send_color;
+};
+
+struct lv_indev_t {
+    lv_indev_type_t type;
+    lv_indev_read_cb_t read_cb;
+    lv_timer_t *timer;
+    lv_obj_t *pressed_obj;
+    bool was_pressed;
+};
+
+struct lv_event_t {
+    lv_event_code_t code;
+    lv_obj_t *target;
+    void *user_data;
+    void *param;
+    lv_layer_t *layer;
+};
+
+struct lv_layer_t {
+    uint16_t *buf;
+    lv_area_t buf_area;
+    lv_area_t clip;
+};
+
+static lv_tick_get_cb_t tick_cb = NULL;
+static lv_delay_cb_t delay_cb = NULL;
+static lv_timer_t *timers = NULL;
+static lv_display_t *default_disp = NULL;
+static lv_indev_t *indev_act = NULL;
+static bool fixed_refresh = false;
+
+static void refr_timer_cb(lv_timer_t *t);
+
+// ---------------------------------------------------------------------------------------
+// Fonts: one 5x7 dot matrix, each dot scale x scale pixels, a 6 dot advance.
+
+typedef struct {
+    char letter;
+    uint8_t rows[7];   // Bit 4 is the leftmost dot
+} host_glyph_t;
+
+static const host_glyph_t glyphs[] = {
+    {' ', {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}},
+    {'0', {0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e}},
+    {'1', {0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e}},
+    {'2', {0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f}},
+    {'3', {0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e}},
+    {'4', {0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02}},
+    {'5', {0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e}},
+    {'6', {0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e}},
+    {'7', {0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}},
+    {'8', {0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e}},
+    {'9', {0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c}},
+    {':', {0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00}},
+    {'+', {0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00}},
+    {'-', {0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00}},
+    {'H', {0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11}},
+    {'M', {0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11}},
+    {'R', {0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11}},
+    {'S', {0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e}},
+    {'a', {0x00, 0x00, 0x0e, 0x01, 0x0f, 0x11, 0x0f}},
+    {'e', {0x00, 0x00, 0x0e, 0x11, 0x1f, 0x10, 0x0e}},
+    {'o', {0x00, 0x00, 0x0e, 0x11, 0x11, 0x11, 0x0e}},
+    {'p', {0x00, 0x00, 0x1e, 0x11, 0x1e, 0x10, 0x10}},
+    {'r', {0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10}},
+    {'s', {0x00, 0x00, 0x0e, 0x10, 0x0e, 0x01, 0x1e}},
+    {'t', {0x08, 0x08, 0x1c, 0x08, 0x08, 0x09, 0x06}},
+};
+
+#define GLYPH_COUNT   (sizeof(glyphs) / sizeof(glyphs[0]))
+
+const lv_font_t lv_font_montserrat_20 = {.line_height = UI_FONT_20_LINE_HEIGHT, .base_line = UI_FONT_20_BASE_LINE, .scale = 2};
+const lv_font_t lv_font_montserrat_28 = {.line_height = UI_FONT_28_LINE_HEIGHT, .base_line = UI_FONT_28_BASE_LINE, .scale = 3};
+const lv_font_t lv_font_montserrat_48 = {.line_height = UI_FONT_48_LINE_HEIGHT, .base_line = UI_FONT_48_BASE_LINE, .scale = 5};
+#ifdef UI_FONT_SUBSET
+const lv_font_t ui_font_20 = {.line_height = UI_FONT_20_LINE_HEIGHT, .base_line = UI_FONT_20_BASE_LINE, .scale = 2};
+const lv_font_t ui_font_28 = {.line_height = UI_FONT_28_LINE_HEIGHT, .base_line = UI_FONT_28_BASE_LINE, .scale = 3};
+const lv_font_t ui_font_48 = {.line_height = UI_FONT_48_LINE_HEIGHT, .base_line = UI_FONT_48_BASE_LINE, .scale = 5};
+#endif
+
+static int find_glyph(uint32_t letter)
+{
+    for (size_t i = 0; i < GLYPH_COUNT; i++) {
+        if ((uint32_t)(uint8_t)glyphs[i].letter == letter) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// A missing glyph gets the placeholder box, as with LV_USE_FONT_PLACEHOLDER.
+bool lv_font_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc_out, uint32_t letter, uint32_t letter_next)
+{
+    LV_UNUSED(letter_next);
+    const int idx = find_glyph(letter);
+    const uint16_t s = font->scale;
+    memset(dsc_out, 0, sizeof(*dsc_out));
+    dsc_out->resolved_font = font;
+    dsc_out->adv_w = 6 * s;
+    dsc_out->box_w = (letter == ' ') ? 0 : 5 * s;
+    dsc_out->box_h = (letter == ' ') ? 0 : 7 * s;
+    dsc_out->gid_index = (idx < 0) ? 0 : (uint32_t)idx;
+    return idx >= 0;
+}
+
+const void *lv_font_get_glyph_bitmap(lv_font_glyph_dsc_t *g_dsc, lv_draw_buf_t *draw_buf)
+{
+    const host_glyph_t *g = &glyphs[g_dsc->gid_index];
+    const uint32_t s = g_dsc->resolved_font->scale;
+    for (uint32_t y = 0; y < g_dsc->box_h; y++) {
+        uint8_t *row = draw_buf->data + y * draw_buf->header.stride;
+        for (uint32_t x = 0; x < g_dsc->box_w; x++) {
+            row[x] = (g->rows[y / s] & (0x10 >> (x / s))) ? 255 : 0;
+        }
+    }
+    return draw_buf;
+}
+
+int32_t lv_text_get_width(const char *txt, uint32_t length, const lv_font_t *font, int32_t letter_space)
+{
+    int32_t width = 0;
+    for (uint32_t i = 0; i < length && txt[i]; i++) {
+        width += 6 * font->scale + letter_space;
+    }
+    return length ? width - letter_space : 0;
+}
+
+lv_draw_buf_t *lv_draw_buf_create(uint32_t w, uint32_t h, lv_color_format_t cf, uint32_t stride)
+{
+    const uint32_t bpp = (cf == LV_COLOR_FORMAT_RGB565) ? 2 : 1;
+    if (stride == LV_STRIDE_AUTO) {
+        stride = w * bpp;
+    }
+
+    lv_draw_buf_t *buf = lv_malloc_zeroed(sizeof(lv_draw_buf_t));
+    if (!buf) {
+        return NULL;
+    }
+    buf->data = lv_malloc_zeroed(stride * h);
+    if (!buf->data) {
+        lv_free(buf);
+        return NULL;
+    }
+    buf->unaligned_data = buf->data;
+    buf->header.magic = LV_IMAGE_HEADER_MAGIC;
+    buf->header.cf = cf;
+    buf->header.w = w;
+    buf->header.h = h;
+    buf->header.stride = stride;
+    buf->data_size = stride * h;
+    return buf;
+}
+
+void lv_draw_buf_destroy(lv_draw_buf_t *draw_buf)
+{
+    if (draw_buf) {
+        lv_free(draw_buf->unaligned_data);
+        lv_free(draw_buf);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Ticks and timers
+
+void lv_tick_set_cb(lv_tick_get_cb_t cb)
+{
+    tick_cb = cb;
+}
+
+void lv_delay_set_cb(lv_delay_cb_t cb)
+{
+    delay_cb = cb;
+}
+
+uint32_t lv_tick_get(void)
+{
+    return tick_cb ? tick_cb() : 0;
+}
+
+uint32_t lv_tick_elaps(uint32_t prev_tick)
+{
+    return lv_tick_get() - prev_tick;
+}
+
+static void delay_ms(uint32_t ms)
+{
+    if (delay_cb) {
+        delay_cb(ms);
+    }
+    else {
+        const uint32_t start = lv_tick_get();
+        while (lv_tick_elaps(start) < ms) {
+            host_cpu_cycles(HostCpuRun, CYCLES_TIMER);
+        }
+    }
+}
+
+// New timers go to the head of the list, as in LVGL.
+static lv_timer_t *timer_create(lv_timer_cb_t cb, uint32_t period, void *user_data)
+{
+    lv_timer_t *t = lv_malloc_zeroed(sizeof(lv_timer_t));
+    t->period = period;
+    t->last_run = lv_tick_get();
+    t->cb = cb;
+    t->user_data = user_data;
+    t->next = timers;
+    timers = t;
+    return t;
+}
+
+uint32_t lv_timer_handler(void)
+{
+    uint32_t time_till_next = UINT32_MAX;
+    for (lv_timer_t *t = timers; t; t = t->next) {
+        host_cpu_cycles(HostCpuRun, CYCLES_TIMER);
+        if (lv_tick_elaps(t->last_run) >= t->period) {
+            t->last_run = lv_tick_get();
+            t->cb(t);
+        }
+        const uint32_t elapsed = lv_tick_elaps(t->last_run);
+        const uint32_t remaining = (elapsed < t->period) ? t->period - elapsed : 0;
+        time_till_next = LV_MIN(time_till_next, remaining);
+    }
+    return time_till_next;
+}
+
+void lv_timer_ready(lv_timer_t *timer)
+{
+    if (fixed_refresh && timer->cb == refr_timer_cb) {
+        return;
+    }
+    timer->last_run = lv_tick_get() - timer->period - 1;
+}
+
+void lv_timer_set_period(lv_timer_t *timer, uint32_t period)
+{
+    if (fixed_refresh && timer->cb == refr_timer_cb) {
+        return;
+    }
+    timer->period = period;
+}
+
+void host_lvgl_fixed_refresh(bool fixed)
+{
+    fixed_refresh = fixed;
+}
+
+// ---------------------------------------------------------------------------------------
+// Areas
+
+static bool area_intersect(lv_area_t *res, const lv_area_t *a, const lv_area_t *b)
+{
+    res->x1 = LV_MAX(a->x1, b->x1);
+    res->y1 = LV_MAX(a->y1, b->y1);
+    res->x2 = LV_MIN(a->x2, b->x2);
+    res->y2 = LV_MIN(a->y2, b->y2);
+    return res->x1 <= res->x2 && res->y1 <= res->y2;
+}
+
+static int32_t area_size(const lv_area_t *a)
+{
+    return (a->x2 - a->x1 + 1) * (a->y2 - a->y1 + 1);
+}
+
+static bool area_is_in(const lv_area_t *in, const lv_area_t *holder)
+{
+    return in->x1 >= holder->x1 && in->y1 >= holder->y1 && in->x2 <= holder->x2 && in->y2 <= holder->y2;
+}
+
+static bool area_is_on(const lv_area_t *a, const lv_area_t *b)
+{
+    return !(a->x1 > b->x2 + 1 || b->x1 > a->x2 + 1 || a->y1 > b->y2 + 1 || b->y1 > a->y2 + 1);
+}
+
+static bool point_in(const lv_area_t *a, const lv_point_t *p)
+{
+    return p->x >= a->x1 && p->x <= a->x2 && p->y >= a->y1 && p->y <= a->y2;
+}
+
+// ---------------------------------------------------------------------------------------
+// Events
+
+static void add_event(host_event_dsc_t **list, uint32_t *cnt, lv_event_cb_t cb, lv_event_code_t filter, void *user_data)
+{
+    host_event_dsc_t *events = lv_realloc(*list, (*cnt + 1) * sizeof(host_event_dsc_t));
+    if (!events) {
+        return;
+    }
+    events[*cnt] = (host_event_dsc_t){.cb = cb, .filter = filter, .user_data = user_data};
+    *list = events;
+    (*cnt)++;
+}
+
+static void send_event(const host_event_dsc_t *list, uint32_t cnt, lv_event_code_t code, lv_obj_t *target, void *param,
+                       lv_layer_t *layer)
+{
+    lv_event_t e = {.code = code, .target = target, .param = param, .layer = layer};
+    for (uint32_t i = 0; i < cnt; i++) {
+        if (list[i].filter == LV_EVENT_ALL || list[i].filter == code) {
+            e.user_data = list[i].user_data;
+            list[i].cb(&e);
+        }
+    }
+}
+
+static void send_obj_event(lv_obj_t *obj, lv_event_code_t code, void *param, lv_layer_t *layer)
+{
+    send_event(obj->events, obj->event_cnt, code, obj, param, layer);
+}
+
+static void send_display_event(lv_display_t *disp, lv_event_code_t code, void *param)
+{
+    send_event(disp->events, disp->event_cnt, code, NULL, param, NULL);
+}
+
+lv_event_code_t lv_event_get_code(lv_event_t *e)
+{
+    return e->code;
+}
+
+void *lv_event_get_user_data(lv_event_t *e)
+{
+    return e->user_data;
+}
+
+void *lv_event_get_param(lv_event_t *e)
+{
+    return e->param;
+}
+
+lv_obj_t *lv_event_get_target_obj(lv_event_t *e)
+{
+    return e->target;
+}
+
+lv_layer_t *lv_event_get_layer(lv_event_t *e)
+{
+    return e->layer;
+}
+
+void lv_obj_add_event_cb(lv_obj_t *obj, lv_event_cb_t event_cb, lv_event_code_t filter, void *user_data)
+{
+    add_event(&obj->events, &obj->event_cnt, event_cb, filter, user_data);
+}
+
+void lv_display_add_event_cb(lv_display_t *disp, lv_event_cb_t event_cb, lv_event_code_t filter, void *user_data)
+{
+    add_event(&disp->events, &disp->event_cnt, event_cb, filter, user_data);
+}
+
+// ---------------------------------------------------------------------------------------
+// Styles, the later added style wins
+
+void lv_style_init(lv_style_t *style)
+{
+    memset(style, 0, sizeof(*style));
+}
+
+void lv_style_set_bg_color(lv_style_t *style, lv_color_t value)
+{
+    style->bg_color = value;
+    style->set |= STYLE_BG_COLOR;
+}
+
+void lv_style_set_bg_opa(lv_style_t *style, lv_opa_t value)
+{
+    style->bg_opa = value;
+    style->set |= STYLE_BG_OPA;
+}
+
+void lv_style_set_text_color(lv_style_t *style, lv_color_t value)
+{
+    style->text_color = value;
+    style->set |= STYLE_TEXT_COLOR;
+}
+
+void lv_style_set_text_font(lv_style_t *style, const lv_font_t *value)
+{
+    style->text_font = value;
+    style->set |= STYLE_TEXT_FONT;
+}
+
+void lv_style_set_line_width(lv_style_t *style, int32_t value)
+{
+    style->line_width = value;
+    style->set |= STYLE_LINE_WIDTH;
+}
+
+void lv_style_set_line_color(lv_style_t *style, lv_color_t value)
+{
+    style->line_color = value;
+    style->set |= STYLE_LINE_COLOR;
+}
+
+void lv_style_set_line_rounded(lv_style_t *style, bool value)
+{
+    style->line_rounded = value;
+    style->set |= STYLE_LINE_ROUNDED;
+}
+
+lv_style_res_t lv_style_get_prop(const lv_style_t *style, lv_style_prop_t prop, lv_style_value_t *value)
+{
+    if (!(style->set & (1u << prop))) {
+        return LV_STYLE_RES_NOT_FOUND;
+    }
+    switch (prop) {
+    case LV_STYLE_BG_COLOR:
+        value->color = style->bg_color;
+        break;
+    case LV_STYLE_BG_OPA:
+        value->num = style->bg_opa;
+        break;
+    case LV_STYLE_TEXT_COLOR:
+        value->color = style->text_color;
+        break;
+    case LV_STYLE_TEXT_FONT:
+        value->ptr = style->text_font;
+        break;
+    case LV_STYLE_LINE_WIDTH:
+        value->num = style->line_width;
+        break;
+    case LV_STYLE_LINE_COLOR:
+        value->color = style->line_color;
+        break;
+    case LV_STYLE_LINE_ROUNDED:
+        value->num = style->line_rounded;
+        break;
+    }
+    return LV_STYLE_RES_FOUND;
+}
+
+static void style_set_prop(lv_style_t *style, lv_style_prop_t prop, lv_style_value_t value)
+{
+    switch (prop) {
+    case LV_STYLE_BG_COLOR:
+        lv_style_set_bg_color(style, value.color);
+        break;
+    case LV_STYLE_BG_OPA:
+        lv_style_set_bg_opa(style, (lv_opa_t)value.num);
+        break;
+    case LV_STYLE_TEXT_COLOR:
+        lv_style_set_text_color(style, value.color);
+        break;
+    case LV_STYLE_TEXT_FONT:
+        lv_style_set_text_font(style, value.ptr);
+        break;
+    case LV_STYLE_LINE_WIDTH:
+        lv_style_set_line_width(style, value.num);
+        break;
+    case LV_STYLE_LINE_COLOR:
+        lv_style_set_line_color(style, value.color);
+        break;
+    case LV_STYLE_LINE_ROUNDED:
+        lv_style_set_line_rounded(style, value.num != 0);
+        break;
+    }
+}
+
+// The local style wins over the added ones.
+static const lv_style_t *find_style(const lv_obj_t *obj, uint32_t prop)
+{
+    if (obj->local_style && (obj->local_style->set & prop)) {
+        return obj->local_style;
+    }
+    for (uint32_t i = obj->style_cnt; i > 0; i--) {
+        if (obj->styles[i - 1]->set & prop) {
+            return obj->styles[i - 1];
+        }
+    }
+    return NULL;
+}
+
+// The default theme: white objects and screens, blue buttons, dark text.
+static bool get_bg(const lv_obj_t *obj, uint16_t *colour)
+{
+    if (obj->no_theme && !find_style(obj, STYLE_BG_COLOR)) {
+        return false;
+    }
+    if (obj->cls != HostObjBase && obj->cls != HostObjButton) {
+        return false;
+    }
+    const lv_style_t *opa = find_style(obj, STYLE_BG_OPA);
+    if ((opa && opa->bg_opa == LV_OPA_TRANSP) || (obj->no_theme && !opa)) {
+        return false;
+    }
+    const lv_style_t *c = find_style(obj, STYLE_BG_COLOR);
+    *colour = lv_color_to_u16(c ? c->bg_color : lv_color_hex(obj->cls == HostObjButton ? 0x2196f3 : 0xffffff));
+    return true;
+}
+
+static const lv_font_t *get_font(const lv_obj_t *obj)
+{
+    const lv_style_t *s = find_style(obj, STYLE_TEXT_FONT);
+    return s ? s->text_font : LV_FONT_DEFAULT;
+}
+
+static int32_t get_line_width(const lv_obj_t *obj)
+{
+    const lv_style_t *s = find_style(obj, STYLE_LINE_WIDTH);
+    return s ? s->line_width : 1;
+}
+
+// ---------------------------------------------------------------------------------------
+// Objects
+
+static lv_obj_t *top_of(const lv_obj_t *obj)
+{
+    while (obj->parent) {
+        obj = obj->parent;
+    }
+    return (lv_obj_t *)obj;
+}
+
+static void content_size(const lv_obj_t *obj, int32_t *w, int32_t *h)
+{
+    *w = 0;
+    *h = 0;
+    if (obj->cls == HostObjLabel) {
+        const lv_label_t *label = (const lv_label_t *)obj;
+        const lv_font_t *font = get_font(obj);
+        *w = label->text ? lv_text_get_width(label->text, (uint32_t)strlen(label->text), font, 0) : 0;
+        *h = font->line_height;
+    }
+    else if (obj->cls == HostObjLine) {
+        const lv_line_t *line = (const lv_line_t *)obj;
+        const int32_t width = get_line_width(obj);
+        for (uint32_t i = 0; i < line->point_num; i++) {
+            *w = LV_MAX(*w, line->points[i].x + width);
+            *h = LV_MAX(*h, line->points[i].y + width);
+        }
+    }
+}
+
+static void refresh_coords(lv_obj_t *obj)
+{
+    int32_t cw;
+    int32_t ch;
+    content_size(obj, &cw, &ch);
+    const int32_t w = (obj->w < 0) ? cw : obj->w;
+    const int32_t h = (obj->h < 0) ? ch : obj->h;
+
+    int32_t x1 = obj->x;
+    int32_t y1 = obj->y;
+    if (obj->parent) {
+        const lv_area_t *p = &obj->parent->coords;
+        x1 += p->x1;
+        y1 += p->y1;
+        if (obj->align == LV_ALIGN_CENTER) {
+            x1 += ((p->x2 - p->x1 + 1) - w) / 2;
+            y1 += ((p->y2 - p->y1 + 1) - h) / 2;
+        }
+    }
+    obj->coords = (lv_area_t){x1, y1, x1 + w - 1, y1 + h - 1};
+
+    for (uint32_t i = 0; i < obj->child_cnt; i++) {
+        refresh_coords(obj->children[i]);
+    }
+}
+
+static void inv_area(lv_display_t *disp, const lv_area_t *area_p)
+{
+    if (disp->rendering) {
+        return;   // Changes made while drawing are not redrawn
+    }
+
+    const lv_area_t screen = {0, 0, disp->hor_res - 1, disp->ver_res - 1};
+    lv_area_t area;
+    if (!area_intersect(&area, area_p, &screen)) {
+        return;
+    }
+
+    send_display_event(disp, LV_EVENT_INVALIDATE_AREA, &area);
+
+    for (uint32_t i = 0; i < disp->inv_cnt; i++) {
+        if (area_is_in(&area, &disp->inv_areas[i])) {
+            return;
+        }
+    }
+    if (disp->inv_cnt < INV_BUF_SIZE) {
+        disp->inv_areas[disp->inv_cnt++] = area;
+    }
+    else {
+        disp->inv_areas[0] = screen;
+        disp->inv_cnt = 1;
+    }
+}
+
+void lv_obj_invalidate(const lv_obj_t *obj)
+{
+    lv_display_t *disp = default_disp;
+    if (!disp || top_of(obj) != disp->screen) {
+        return;
+    }
+
+    // Hidden, or clipped away by a parent: nothing on the screen changes.
+    lv_area_t area = obj->coords;
+    for (const lv_obj_t *o = obj; o; o = o->parent) {
+        if ((o->flags & LV_OBJ_FLAG_HIDDEN) || !area_intersect(&area, &area, &o->coords)) {
+            return;
+        }
+    }
+    inv_area(disp, &area);
+}
+
+static lv_obj_t *obj_create(lv_obj_t *parent, size_t size, host_obj_class_t cls)
+{
+    lv_obj_t *obj = lv_malloc_zeroed(size);
+    if (!obj) {
+        return NULL;
+    }
+    obj->cls = (uint8_t)cls;
+    obj->parent = parent;
+    obj->w = -1;
+    obj->h = -1;
+
+    if (cls == HostObjBase || cls == HostObjButton) {
+        obj->flags = LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE;
+    }
+    if (!parent) {
+        obj->w = default_disp ? default_disp->hor_res : 0;
+        obj->h = default_disp ? default_disp->ver_res : 0;
+    }
+    else if (cls == HostObjBase) {
+        obj->w = DEFAULT_OBJ_SIZE;
+        obj->h = DEFAULT_OBJ_SIZE;
+    }
+
+    if (parent) {
+        lv_obj_t **children = lv_realloc(parent->children, (parent->child_cnt + 1) * sizeof(lv_obj_t *));
+        if (!children) {
+            lv_free(obj);
+            return NULL;
+        }
+        children[parent->child_cnt++] = obj;
+        parent->children = children;
+    }
+
+    refresh_coords(obj);
+    lv_obj_invalidate(obj);
+    return obj;
+}
+
+lv_obj_t *lv_obj_create(lv_obj_t *parent)
+{
+    return obj_create(parent, sizeof(lv_obj_t), HostObjBase);
+}
+
+lv_obj_t *lv_button_create(lv_obj_t *parent)
+{
+    return obj_create(parent, sizeof(lv_obj_t), HostObjButton);
+}
+
+lv_obj_t *lv_label_create(lv_obj_t *parent)
+{
+    lv_obj_t *obj = obj_create(parent, sizeof(lv_label_t), HostObjLabel);
+    if (obj) {
+        lv_label_set_text_static(obj, "Text");
+    }
+    return obj;
+}
+
+lv_obj_t *lv_line_create(lv_obj_t *parent)
+{
+    return obj_create(parent, sizeof(lv_line_t), HostObjLine);
+}
+
+static void obj_free(lv_obj_t *obj)
+{
+    while (obj->child_cnt) {
+        obj_free(obj->children[--obj->child_cnt]);
+    }
+    if (indev_act && indev_act->pressed_obj == obj) {
+        indev_act->pressed_obj = NULL;
+    }
+    lv_free(obj->children);
+    lv_free(obj->styles);
+    lv_free(obj->local_style);
+    lv_free(obj->events);
+    lv_free(obj);
+}
+
+void lv_obj_delete(lv_obj_t *obj)
+{
+    lv_obj_invalidate(obj);
+    lv_obj_t *parent = obj->parent;
+    if (parent) {
+        for (uint32_t i = 0; i < parent->child_cnt; i++) {
+            if (parent->children[i] == obj) {
+                memmove(&parent->children[i], &parent->children[i + 1], (parent->child_cnt - i - 1) * sizeof(lv_obj_t *));
+                parent->child_cnt--;
+                break;
+            }
+        }
+    }
+    if (default_disp && default_disp->screen == obj) {
+        default_disp->screen = NULL;
+    }
+    obj_free(obj);
+}
+
+// Geometry and style changes redraw where the object was and where it is now.
+static void changed(lv_obj_t *obj)
+{
+    refresh_coords(obj);
+    lv_obj_invalidate(obj);
+}
+
+void lv_obj_add_style(lv_obj_t *obj, const lv_style_t *style, lv_style_selector_t selector)
+{
+    LV_UNUSED(selector);
+    const lv_style_t **styles = lv_realloc(obj->styles, (obj->style_cnt + 1) * sizeof(lv_style_t *));
+    if (!styles) {
+        return;
+    }
+    lv_obj_invalidate(obj);
+    styles[obj->style_cnt++] = style;
+    obj->styles = styles;
+    changed(obj);
+}
+
+// LVGL allocates the local style with the first property set on an object.
+void lv_obj_set_local_style_prop(lv_obj_t *obj, lv_style_prop_t prop, lv_style_value_t value, lv_style_selector_t selector)
+{
+    LV_UNUSED(selector);
+    if (!obj->local_style) {
+        obj->local_style = lv_malloc(sizeof(lv_style_t));
+        if (!obj->local_style) {
+            return;
+        }
+        lv_style_init(obj->local_style);
+    }
+    lv_obj_invalidate(obj);
+    style_set_prop(obj->local_style, prop, value);
+    changed(obj);
+}
+
+void lv_obj_remove_style_all(lv_obj_t *obj)
+{
+    lv_obj_invalidate(obj);
+    lv_free(obj->styles);
+    obj->styles = NULL;
+    obj->style_cnt = 0;
+    lv_free(obj->local_style);
+    obj->local_style = NULL;
+    obj->no_theme = true;
+    changed(obj);
+}
+
+void lv_obj_set_pos(lv_obj_t *obj, int32_t x, int32_t y)
+{
+    if (obj->x == x && obj->y == y) {
+        return;
+    }
+    lv_obj_invalidate(obj);
+    obj->x = x;
+    obj->y = y;
+    changed(obj);
+}
+
+void lv_obj_set_size(lv_obj_t *obj, int32_t w, int32_t h)
+{
+    if (obj->w == w && obj->h == h) {
+        return;
+    }
+    lv_obj_invalidate(obj);
+    obj->w = w;
+    obj->h = h;
+    changed(obj);
+}
+
+void lv_obj_set_width(lv_obj_t *obj, int32_t w)
+{
+    lv_obj_set_size(obj, w, obj->h);
+}
+
+void lv_obj_set_height(lv_obj_t *obj, int32_t h)
+{
+    lv_obj_set_size(obj, obj->w, h);
+}
+
+void lv_obj_set_align(lv_obj_t *obj, lv_align_t align)
+{
+    lv_obj_invalidate(obj);
+    obj->align = (uint8_t)align;
+    changed(obj);
+}
+
+void lv_obj_add_flag(lv_obj_t *obj, lv_obj_flag_t f)
+{
+    if ((f & LV_OBJ_FLAG_HIDDEN) && !(obj->flags & LV_OBJ_FLAG_HIDDEN)) {
+        lv_obj_invalidate(obj);
+    }
+    obj->flags |= f;
+}
+
+void lv_obj_remove_flag(lv_obj_t *obj, lv_obj_flag_t f)
+{
+    const bool was_hidden = (obj->flags & LV_OBJ_FLAG_HIDDEN) != 0;
+    obj->flags &= ~(uint32_t)f;
+    if ((f & LV_OBJ_FLAG_HIDDEN) && was_hidden) {
+        lv_obj_invalidate(obj);
+    }
+}
+
+void lv_obj_set_flag(lv_obj_t *obj, lv_obj_flag_t f, bool v)
+{
+    if (v) {
+        lv_obj_add_flag(obj, f);
+    }
+    else {
+        lv_obj_remove_flag(obj, f);
+    }
+}
+
+void lv_obj_get_content_coords(const lv_obj_t *obj, lv_area_t *area)
+{
+    *area = obj->coords;
+}
+
+void lv_label_set_text_static(lv_obj_t *obj, const char *text)
+{
+    lv_obj_invalidate(obj);
+    ((lv_label_t *)obj)->text = text;
+    changed(obj);
+}
+
+void lv_line_set_points(lv_obj_t *obj, const lv_point_precise_t points[], uint32_t point_num)
+{
+    lv_obj_invalidate(obj);
+    ((lv_line_t *)obj)->points = points;
+    ((lv_line_t *)obj)->point_num = point_num;
+    changed(obj);
+}
+
+// ---------------------------------------------------------------------------------------
+// Drawing into the layer, clipped to layer->clip
+
+static void fill(lv_layer_t *layer, const lv_area_t *area, uint16_t colour)
+{
+    lv_area_t a;
+    if (!area_intersect(&a, area, &layer->clip)) {
+        return;
+    }
+    const int32_t stride = layer->buf_area.x2 - layer->buf_area.x1 + 1;
+    for (int32_t y = a.y1; y <= a.y2; y++) {
+        uint16_t *row = layer->buf + (y - layer->buf_area.y1) * stride;
+        for (int32_t x = a.x1; x <= a.x2; x++) {
+            row[x - layer->buf_area.x1] = colour;
+        }
+    }
+    host_cpu_cycles(HostCpuRender, (uint64_t)area_size(&a) * CYCLES_FILL_PX);
+}
+
+static void draw_text(lv_layer_t *layer, const lv_font_t *font, lv_color_t color, const char *text, int32_t x, int32_t y)
+{
+    const uint16_t fg = lv_color_to_u16(color);
+    const int32_t stride = layer->buf_area.x2 - layer->buf_area.x1 + 1;
+    uint64_t pixels = 0;
+
+    for (const char *c = text; *c; c++) {
+        lv_font_glyph_dsc_t dsc;
+        lv_font_get_glyph_dsc(font, &dsc, (uint8_t)*c, 0);
+        const host_glyph_t *g = &glyphs[dsc.gid_index];
+        const int32_t top = y + (font->line_height - font->base_line) - dsc.box_h - dsc.ofs_y;
+        const lv_area_t box = {x + dsc.ofs_x, top, x + dsc.ofs_x + dsc.box_w - 1, top + dsc.box_h - 1};
+
+        lv_area_t a;
+        if (dsc.box_w && area_intersect(&a, &box, &layer->clip)) {
+            for (int32_t py = a.y1; py <= a.y2; py++) {
+                uint16_t *row = layer->buf + (py - layer->buf_area.y1) * stride;
+                for (int32_t px = a.x1; px <= a.x2; px++) {
+                    if (g->rows[(py - box.y1) / font->scale] & (0x10 >> ((px - box.x1) / font->scale))) {
+                        row[px - layer->buf_area.x1] = fg;
+                    }
+                }
+            }
+            pixels += (uint64_t)area_size(&a);
+        }
+        x += dsc.adv_w;
+    }
+    host_cpu_cycles(HostCpuRender, pixels * CYCLES_GLYPH_PX);
+}
+
+void lv_draw_image_dsc_init(lv_draw_image_dsc_t *dsc)
+{
+    memset(dsc, 0, sizeof(*dsc));
+    dsc->opa = LV_OPA_COVER;
+}
+
+// Opaque RGB565 sources only, which is all the glyph cache makes.
+void lv_draw_image(lv_layer_t *layer, const lv_draw_image_dsc_t *dsc, const lv_area_t *coords)
+{
+    const lv_image_dsc_t *img = dsc->src;
+    lv_area_t a;
+    if (!img || !area_intersect(&a, coords, &layer->clip)) {
+        return;
+    }
+
+    const int32_t stride = layer->buf_area.x2 - layer->buf_area.x1 + 1;
+    for (int32_t y = a.y1; y <= a.y2; y++) {
+        const uint16_t *src = (const uint16_t *)(img->data + (y - coords->y1) * img->header.stride) + (a.x1 - coords->x1);
+        uint16_t *dst = layer->buf + (y - layer->buf_area.y1) * stride + (a.x1 - layer->buf_area.x1);
+        memcpy(dst, src, (size_t)(a.x2 - a.x1 + 1) * sizeof(uint16_t));
+    }
+    host_cpu_cycles(HostCpuRender, (uint64_t)area_size(&a) * CYCLES_IMAGE_PX);
+}
+
+void lv_draw_label_dsc_init(lv_draw_label_dsc_t *dsc)
+{
+    memset(dsc, 0, sizeof(*dsc));
+    dsc->font = LV_FONT_DEFAULT;
+    dsc->opa = LV_OPA_COVER;
+}
+
+void lv_draw_label(lv_layer_t *layer, const lv_draw_label_dsc_t *dsc, const lv_area_t *coords)
+{
+    const lv_area_t saved = layer->clip;
+    if (dsc->text && area_intersect(&layer->clip, &saved, coords)) {
+        draw_text(layer, dsc->font, dsc->color, dsc->text, coords->x1, coords->y1);
+    }
+    layer->clip = saved;
+}
+
+// Horizontal and vertical segments, which is all the UI draws.
+static void draw_line(lv_layer_t *layer, const lv_obj_t *obj)
+{
+    const lv_line_t *line = (const lv_line_t *)obj;
+    const lv_style_t *c = find_style(obj, STYLE_LINE_COLOR);
+    const uint16_t colour = lv_color_to_u16(c ? c->line_color : lv_color_hex(0x000000));
+    const int32_t w = get_line_width(obj);
+
+    for (uint32_t i = 1; i < line->point_num; i++) {
+        const lv_point_t *p1 = &line->points[i - 1];
+        const lv_point_t *p2 = &line->points[i];
+        lv_area_t seg = {
+            obj->coords.x1 + LV_MIN(p1->x, p2->x), obj->coords.y1 + LV_MIN(p1->y, p2->y),
+            obj->coords.x1 + LV_MAX(p1->x, p2->x), obj->coords.y1 + LV_MAX(p1->y, p2->y),
+        };
+        if (p1->y == p2->y) {
+            seg.y1 -= (w - 1) / 2;
+            seg.y2 += w / 2;
+        }
+        else if (p1->x == p2->x) {
+            seg.x1 -= (w - 1) / 2;
+            seg.x2 += w / 2;
+        }
+        else {
+            continue;
+        }
+        fill(layer, &seg, colour);
+    }
+}
+
+// Background, the widget's own content, the DRAW_MAIN callbacks, then the children on top.
+static void draw_obj(lv_obj_t *obj, lv_layer_t *layer)
+{
+    lv_area_t clip;
+    if ((obj->flags & LV_OBJ_FLAG_HIDDEN) || !area_intersect(&clip, &obj->coords, &layer->clip)) {
+        return;
+    }
+    host_cpu_cycles(HostCpuRender, CYCLES_OBJ);
+
+    const lv_area_t saved = layer->clip;
+    layer->clip = clip;
+
+    uint16_t bg;
+    if (get_bg(obj, &bg)) {
+        fill(layer, &obj->coords, bg);
+    }
+    if (obj->cls == HostObjLabel && ((lv_label_t *)obj)->text) {
+        const lv_style_t *c = find_style(obj, STYLE_TEXT_COLOR);
+        draw_text(layer, get_font(obj), c ? c->text_color : lv_color_hex(0x212121), ((lv_label_t *)obj)->text,
+                  obj->coords.x1, obj->coords.y1);
+    }
+    else if (obj->cls == HostObjLine) {
+        draw_line(layer, obj);
+    }
+    send_obj_event(obj, LV_EVENT_DRAW_MAIN, NULL, layer);
+
+    for (uint32_t i = 0; i < obj->child_cnt; i++) {
+        draw_obj(obj->children[i], layer);
+    }
+    layer->clip = saved;
+}
+
+// ---------------------------------------------------------------------------------------
+// Display
+
+static void send_cmd(lv_display_t *disp, uint8_t cmd, const uint8_t *param, size_t param_size)
+{
+    disp->send_cmd(disp, &cmd, 1, param, param_size);
+}
+
+static void wait_for_flushing(lv_display_t *disp)
+{
+    while (disp->flushing) {
+        host_cpu_cycles(HostCpuLcd, CYCLES_FLUSH_POLL);
+    }
+}
+
+// The generic MIPI driver's flush: column and row window, then the pixels.
+static void flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+    const uint8_t caset[] = {(uint8_t)(area->x1 >> 8), (uint8_t)area->x1, (uint8_t)(area->x2 >> 8), (uint8_t)area->x2};
+    const uint8_t raset[] = {(uint8_t)(area->y1 >> 8), (uint8_t)area->y1, (uint8_t)(area->y2 >> 8), (uint8_t)area->y2};
+    static const uint8_t ramwr = 0x2c;
+    send_cmd(disp, 0x2a, caset, sizeof(caset));
+    send_cmd(disp, 0x2b, raset, sizeof(raset));
+    disp->send_color(disp, &ramwr, 1, px_map, (size_t)area_size(area) * 2);
+}
+
+// Overlapping or touching areas are merged when the union is smaller than the two apart.
+static void join_areas(lv_display_t *disp)
+{
+    memset(disp->inv_joined, 0, sizeof(disp->inv_joined));
+    for (uint32_t in = 0; in < disp->inv_cnt; in++) {
+        if (disp->inv_joined[in]) {
+            continue;
+        }
+        for (uint32_t from = 0; from < disp->inv_cnt; from++) {
+            if (disp->inv_joined[from] || from == in || !area_is_on(&disp->inv_areas[in], &disp->inv_areas[from])) {
+                continue;
+            }
+            const lv_area_t *a = &disp->inv_areas[in];
+            const lv_area_t *b = &disp->inv_areas[from];
+            const lv_area_t joined = {LV_MIN(a->x1, b->x1), LV_MIN(a->y1, b->y1), LV_MAX(a->x2, b->x2), LV_MAX(a->y2, b->y2)};
+            if (area_size(&joined) < area_size(a) + area_size(b)) {
+                disp->inv_areas[in] = joined;
+                disp->inv_joined[from] = true;
+            }
+        }
+    }
+}
+
+// Partial mode: as many full width rows of the area as fit the buffer, alternating buffers.
+static void render_area(lv_display_t *disp, const lv_area_t *area, bool last_area)
+{
+    const int32_t w = area->x2 - area->x1 + 1;
+    const int32_t max_rows = LV_MAX((int32_t)(disp->buf_size / (uint32_t)(w * 2)), 1);
+
+    for (int32_t y = area->y1; y <= area->y2; y += max_rows) {
+        const lv_area_t chunk = {area->x1, y, area->x2, LV_MIN(y + max_rows - 1, area->y2)};
+        lv_layer_t layer = {.buf = (uint16_t *)disp->buf_act, .buf_area = chunk, .clip = chunk};
+        if (disp->screen) {
+            draw_obj(disp->screen, &layer);
+        }
+
+        wait_for_flushing(disp);
+        disp->flushing = true;
+        disp->flushing_last = last_area && chunk.y2 == area->y2;
+        flush(disp, &chunk, disp->buf_act);
+        if (disp->buf2) {
+            disp->buf_act = (disp->buf_act == disp->buf1) ? disp->buf2 : disp->buf1;
+        }
+    }
+}
+
+static void refresh(lv_display_t *disp)
+{
+    send_display_event(disp, LV_EVENT_REFR_START, NULL);
+    host_cpu_cycles(HostCpuRender, CYCLES_REFR);
+    if (disp->inv_cnt == 0 || !disp->buf1) {
+        return;
+    }
+
+    disp->rendering = true;
+    send_display_event(disp, LV_EVENT_RENDER_START, NULL);
+    join_areas(disp);
+
+    uint32_t last = 0;
+    for (uint32_t i = 0; i < disp->inv_cnt; i++) {
+        if (!disp->inv_joined[i]) {
+            last = i;
+        }
+    }
+    for (uint32_t i = 0; i < disp->inv_cnt; i++) {
+        if (!disp->inv_joined[i]) {
+            render_area(disp, &disp->inv_areas[i], i == last);
+        }
+    }
+
+    disp->inv_cnt = 0;
+    disp->rendering = false;
+    send_display_event(disp, LV_EVENT_RENDER_READY, NULL);
+}
+
+static void refr_timer_cb(lv_timer_t *t)
+{
+    refresh(t->user_data);
+}
+
+// lv_display_create() followed by the generic MIPI driver's init sequence. The display is the
+// default and has its screen before the first delay, as the delays may run the UI build.
+lv_display_t *lv_st7789_create(uint32_t hor_res, uint32_t ver_res, uint32_t flags, lv_lcd_send_cmd_cb_t send_cmd_cb,
+                               lv_lcd_send_color_cb_t send_color_cb)
+{
+    LV_UNUSED(flags);
+    lv_display_t *disp = lv_malloc_zeroed(sizeof(lv_display_t));
+    if (!disp) {
+        return NULL;
+    }
+    disp->hor_res = (int32_t)hor_res;
+    disp->ver_res = (int32_t)ver_res;
+    disp->send_cmd = send_cmd_cb;
+    disp->send_color = send_color_cb;
+    disp->last_activity = lv_tick_get();
+    if (!default_disp) {
+        default_disp = disp;
+    }
+    disp->screen = lv_obj_create(NULL);
+    disp->refr_timer = timer_create(refr_timer_cb, LV_DEF_REFR_PERIOD, disp);
+    lv_obj_invalidate(disp->screen);
+
+    static const uint8_t colmod = 0x55;   // RGB565
+    static const uint8_t madctl = 0x00;
+    send_cmd(disp, 0x01, NULL, 0);        // SWRESET
+    delay_ms(120);
+    send_cmd(disp, 0x11, NULL, 0);        // SLPOUT
+    delay_ms(120);
+    send_cmd(disp, 0x3a, &colmod, 1);
+    send_cmd(disp, 0x36, &madctl, 1);
+    send_cmd(disp, 0x21, NULL, 0);        // INVON, the ST7789 panels are inverted
+    send_cmd(disp, 0x29, NULL, 0);        // DISPON
+    return disp;
+}
+
+void lv_display_set_rotation(lv_display_t *disp, lv_display_rotation_t rotation)
+{
+    LV_UNUSED(disp);
+    LV_UNUSED(rotation);
+}
+
+void lv_display_set_buffers(lv_display_t *disp, void *buf1, void *buf2, uint32_t buf_size, lv_display_render_mode_t render_mode)
+{
+    LV_UNUSED(render_mode);
+    disp->buf1 = buf1;
+    disp->buf2 = buf2;
+    disp->buf_act = buf1;
+    disp->buf_size = buf_size;
+}
+
+void lv_display_flush_ready(lv_display_t *disp)
+{
+    disp->flushing = false;
+}
+
+bool lv_display_flush_is_last(lv_display_t *disp)
+{
+    return disp->flushing_last;
+}
+
+lv_display_t *lv_display_get_default(void)
+{
+    return default_disp;
+}
+
+uint32_t lv_display_get_inactive_time(const lv_display_t *disp)
+{
+    disp = disp ? disp : default_disp;
+    return disp ? lv_tick_elaps(disp->last_activity) : 0;
+}
+
+void lv_display_trigger_activity(lv_display_t *disp)
+{
+    disp = disp ? disp : default_disp;
+    if (disp) {
+        disp->last_activity = lv_tick_get();
+    }
+}
+
+lv_timer_t *lv_display_get_refr_timer(lv_display_t *disp)
+{
+    return disp->refr_timer;
+}
+
+lv_obj_t *lv_screen_active(void)
+{
+    return default_disp ? default_disp->screen : NULL;
+}
+
+void lv_refr_now(lv_display_t *disp)
+{
+    disp = disp ? disp : default_disp;
+    if (disp) {
+        refresh(disp);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// Pointer input: read every LV_DEF_REFR_PERIOD, PRESSED to the topmost clickable object under
+// the point, RELEASED to the object that got PRESSED. Buttons redraw on both.
+
+static lv_obj_t *hit_test(lv_obj_t *obj, const lv_point_t *p)
+{
+    if ((obj->flags & LV_OBJ_FLAG_HIDDEN) || !point_in(&obj->coords, p)) {
+        return NULL;
+    }
+    for (uint32_t i = obj->child_cnt; i > 0; i--) {
+        lv_obj_t *found = hit_test(obj->children[i - 1], p);
+        if (found) {
+            return found;
+        }
+    }
+    return (obj->flags & LV_OBJ_FLAG_CLICKABLE) ? obj : NULL;
+}
+
+static void indev_timer_cb(lv_timer_t *t)
+{
+    lv_indev_t *indev = t->user_data;
+    if (!indev->read_cb) {
+        return;
+    }
+
+    lv_indev_data_t data = {0};
+    indev->read_cb(indev, &data);
+    const bool pressed = (data.state == LV_INDEV_STATE_PRESSED);
+
+    if (pressed) {
+        lv_display_trigger_activity(NULL);
+        if (!indev->was_pressed && default_disp && default_disp->screen) {
+            lv_obj_t *obj = hit_test(default_disp->screen, &data.point);
+            indev->pressed_obj = obj;
+            if (obj) {
+                obj->pressed = true;
+                if (obj->cls == HostObjButton) {
+                    lv_obj_invalidate(obj);
+                }
+                send_obj_event(obj, LV_EVENT_PRESSED, NULL, NULL);
+            }
+        }
+    }
+    else if (indev->was_pressed) {
+        lv_obj_t *obj = indev->pressed_obj;
+        indev->pressed_obj = NULL;
+        if (obj) {
+            obj->pressed = false;
+            if (obj->cls == HostObjButton) {
+                lv_obj_invalidate(obj);
+            }
+            send_obj_event(obj, LV_EVENT_RELEASED, NULL, NULL);
+        }
+    }
+    indev->was_pressed = pressed;
+}
+
+lv_indev_t *lv_indev_create(void)
+{
+    lv_indev_t *indev = lv_malloc_zeroed(sizeof(lv_indev_t));
+    if (indev) {
+        indev->timer = timer_create(indev_timer_cb, LV_DEF_REFR_PERIOD, indev);
+        indev_act = indev;
+    }
+    return indev;
+}
+
+void lv_indev_set_type(lv_indev_t *indev, lv_indev_type_t indev_type)
+{
+    indev->type = indev_type;
+}
+
+void lv_indev_set_read_cb(lv_indev_t *indev, lv_indev_read_cb_t read_cb)
+{
+    indev->read_cb = read_cb;
+}
+
+// ---------------------------------------------------------------------------------------
+
+void lv_init(void)
+{
+    timers = NULL;
+    default_disp = NULL;
+    indev_act = NULL;
+    tick_cb = NULL;
+    delay_cb = NULL;
+    lv_mem_init();
+}
@@ -0,0 +1,132 @@
+#include "lvgl.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// lv_mem.c of the host LVGL: the public allocation calls over the *_core functions. With
+// LVGL_SLAB_ALLOC the cores come from slab_alloc.c, as on the target; otherwise from the
+// counting C heap wrapper below, sized like the LV_MEM_SIZE pool.
+
+void *lv_malloc(size_t size)
+{
+    return size ? lv_malloc_core(size) : NULL;
+}
+
+void *lv_malloc_zeroed(size_t size)
+{
+    void *p = lv_malloc(size);
+    if (p) {
+        memset(p, 0, size);
+    }
+    return p;
+}
+
+void *lv_realloc(void *data_p, size_t new_size)
+{
+    if (new_size == 0) {
+        lv_free(data_p);
+        return NULL;
+    }
+    return lv_realloc_core(data_p, new_size);
+}
+
+void lv_free(void *data)
+{
+    if (data) {
+        lv_free_core(data);
+    }
+}
+
+void lv_mem_monitor(lv_mem_monitor_t *mon_p)
+{
+    memset(mon_p, 0, sizeof(*mon_p));
+    lv_mem_monitor_core(mon_p);
+}
+
+#if LV_USE_STDLIB_MALLOC != LV_STDLIB_CUSTOM
+
+typedef struct {
+    size_t size;
+    size_t pad;
+} block_header_t;
+
+static size_t used_bytes = 0;
+static size_t max_used = 0;
+static size_t used_cnt = 0;
+
+void lv_mem_init(void)
+{
+}
+
+void lv_mem_deinit(void)
+{
+}
+
+lv_mem_pool_t lv_mem_add_pool(void *mem, size_t bytes)
+{
+    LV_UNUSED(mem);
+    LV_UNUSED(bytes);
+    return NULL;
+}
+
+void lv_mem_remove_pool(lv_mem_pool_t pool)
+{
+    LV_UNUSED(pool);
+}
+
+void *lv_malloc_core(size_t size)
+{
+    if (used_bytes + size > LV_MEM_SIZE) {
+        return NULL;
+    }
+    block_header_t *hdr = malloc(sizeof(block_header_t) + size);
+    if (!hdr) {
+        return NULL;
+    }
+    hdr->size = size;
+    used_bytes += size;
+    used_cnt++;
+    max_used = LV_MAX(max_used, used_bytes);
+    return hdr + 1;
+}
+
+void lv_free_core(void *p)
+{
+    block_header_t *hdr = (block_header_t *)p - 1;
+    used_bytes -= hdr->size;
+    used_cnt--;
+    free(hdr);
+}
+
+void *lv_realloc_core(void *p, size_t new_size)
+{
+    if (!p) {
+        return lv_malloc_core(new_size);
+    }
+    const size_t old_size = ((block_header_t *)p - 1)->size;
+    void *new_p = lv_malloc_core(new_size);
+    if (new_p) {
+        memcpy(new_p, p, LV_MIN(old_size, new_size));
+        lv_free_core(p);
+    }
+    return new_p;
+}
+
+void lv_mem_monitor_core(lv_mem_monitor_t *mon_p)
+{
+    mon_p->total_size = LV_MEM_SIZE;
+    mon_p->free_size = LV_MEM_SIZE - used_bytes;
+    mon_p->free_cnt = 1;
+    mon_p->free_biggest_size = mon_p->free_size;
+    mon_p->used_cnt = used_cnt;
+    mon_p->max_used = max_used;
+    mon_p->used_pct = (uint8_t)((used_bytes * 100) / LV_MEM_SIZE);
+    mon_p->frag_pct = 0;
+}
+
+lv_result_t lv_mem_test_core(void)
+{
+    return LV_RESULT_OK;
+}
+
+#endif   // LV_USE_STDLIB_MALLOC != LV_STDLIB_CUSTOM
@@ -0,0 +1,407 @@
+#ifndef _HOST_LVGL_H
+#define _HOST_LVGL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Host stand-in for the slice of the LVGL 9.3 API the firmware uses, linked when lvgl/lvgl is
+// not checked out, so display_framework.c, glyph_cache.c and slab_alloc.c still build and run
+// unchanged in the simulator. Its times, heap figures and frames are modelled. Same names,
+// signatures and event order as LVGL; the renderer only knows filled rectangles, axis
+// aligned lines, a 5x7 bitmap font scaled to the three UI sizes and RGB565 images, and
+// charges its work to the virtual clock in cycles (host_lvgl.c).
+
+#define LV_STDLIB_BUILTIN   0
+#define LV_STDLIB_CLIB      1
+#define LV_STDLIB_CUSTOM    255
+#define LV_OS_NONE          0
+
+#include "lv_conf.h"
+
+#define LV_UNUSED(x)   ((void)(x))
+#define LV_MAX(a, b)   ((a) > (b) ? (a) : (b))
+#define LV_MIN(a, b)   ((a) < (b) ? (a) : (b))
+
+typedef enum {
+    LV_RESULT_INVALID = 0,
+    LV_RESULT_OK,
+} lv_result_t;
+
+// Colours
+
+typedef struct {
+    uint8_t blue;
+    uint8_t green;
+    uint8_t red;
+} lv_color_t;
+
+typedef uint8_t lv_opa_t;
+#define LV_OPA_TRANSP   0
+#define LV_OPA_100      255
+#define LV_OPA_COVER    255
+
+typedef enum {
+    LV_PALETTE_RED,
+} lv_palette_t;
+
+typedef enum {
+    LV_COLOR_FORMAT_A8 = 0x0e,
+    LV_COLOR_FORMAT_RGB565 = 0x12,
+} lv_color_format_t;
+
+static inline lv_color_t lv_color_hex(uint32_t c)
+{
+    const lv_color_t color = {.blue = (uint8_t)(c & 0xff), .green = (uint8_t)((c >> 8) & 0xff), .red = (uint8_t)((c >> 16) & 0xff)};
+    return color;
+}
+
+static inline uint16_t lv_color_to_u16(lv_color_t c)
+{
+    return (uint16_t)(((c.red & 0xf8) << 8) | ((c.green & 0xfc) << 3) | (c.blue >> 3));
+}
+
+// LVGL's RGB565 blend: mix is the share of c1, 0..255.
+static inline uint16_t lv_color_16_16_mix(uint16_t c1, uint16_t c2, uint8_t mix)
+{
+    if (mix == 255) {
+        return c1;
+    }
+    if (mix == 0) {
+        return c2;
+    }
+    const uint32_t m = ((uint32_t)mix + 4) >> 3;
+    const uint32_t bg = (uint32_t)(c2 | ((uint32_t)c2 << 16)) & 0x7e0f81f;
+    const uint32_t fg = (uint32_t)(c1 | ((uint32_t)c1 << 16)) & 0x7e0f81f;
+    const uint32_t result = ((((fg - bg) * m) >> 5) + bg) & 0x7e0f81f;
+    return (uint16_t)((result >> 16) | result);
+}
+
+static inline lv_color_t lv_palette_main(lv_palette_t p)
+{
+    LV_UNUSED(p);
+    return lv_color_hex(0xf44336);
+}
+
+// Geometry
+
+typedef struct {
+    int32_t x1;
+    int32_t y1;
+    int32_t x2;
+    int32_t y2;
+} lv_area_t;
+
+typedef struct {
+    int32_t x;
+    int32_t y;
+} lv_point_t;
+
+typedef lv_point_t lv_point_precise_t;   // LV_USE_FLOAT is 0
+
+typedef enum {
+    LV_ALIGN_DEFAULT = 0,
+    LV_ALIGN_CENTER = 9,
+} lv_align_t;
+
+// Draw buffers and images
+
+typedef struct {
+    uint32_t magic : 8;
+    uint32_t cf : 8;
+    uint32_t flags : 16;
+    uint32_t w : 16;
+    uint32_t h : 16;
+    uint32_t stride : 16;
+    uint32_t reserved_2 : 16;
+} lv_image_header_t;
+
+#define LV_IMAGE_HEADER_MAGIC   (0x19)
+#define LV_STRIDE_AUTO          (0)
+
+typedef struct {
+    lv_image_header_t header;
+    uint32_t data_size;
+    const uint8_t *data;
+    const void *reserved;
+} lv_image_dsc_t;
+
+typedef struct {
+    lv_image_header_t header;
+    uint32_t data_size;
+    uint8_t *data;
+    void *unaligned_data;
+} lv_draw_buf_t;
+
+lv_draw_buf_t *lv_draw_buf_create(uint32_t w, uint32_t h, lv_color_format_t cf, uint32_t stride);
+void lv_draw_buf_destroy(lv_draw_buf_t *draw_buf);
+
+// Fonts
+
+typedef struct lv_font_t lv_font_t;
+
+typedef struct {
+    const lv_font_t *resolved_font;
+    uint16_t adv_w;
+    uint16_t box_w;
+    uint16_t box_h;
+    int16_t ofs_x;
+    int16_t ofs_y;
+    uint8_t format;
+    uint32_t gid_index;
+} lv_font_glyph_dsc_t;
+
+struct lv_font_t {
+    int32_t line_height;
+    int32_t base_line;
+    uint8_t scale;   // Pixels per bitmap font dot
+};
+
+#define LV_FONT_DECLARE(font_name)   extern const lv_font_t font_name;
+
+LV_FONT_DECLARE(lv_font_montserrat_20)
+LV_FONT_DECLARE(lv_font_montserrat_28)
+LV_FONT_DECLARE(lv_font_montserrat_48)
+LV_FONT_CUSTOM_DECLARE
+
+bool lv_font_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc_out, uint32_t letter, uint32_t letter_next);
+
+// Decodes the glyph into draw_buf as A8 and returns it.
+const void *lv_font_get_glyph_bitmap(lv_font_glyph_dsc_t *g_dsc, lv_draw_buf_t *draw_buf);
+
+int32_t lv_text_get_width(const char *txt, uint32_t length, const lv_font_t *font, int32_t letter_space);
+
+// Memory, lv_mem.c over the *_core functions of slab_alloc.c or the built-in counter
+
+typedef void *lv_mem_pool_t;
+
+typedef struct {
+    size_t total_size;
+    size_t free_cnt;
+    size_t free_size;
+    size_t free_biggest_size;
+    size_t used_cnt;
+    size_t max_used;
+    uint8_t used_pct;
+    uint8_t frag_pct;
+} lv_mem_monitor_t;
+
+void lv_mem_init(void);
+void lv_mem_deinit(void);
+lv_mem_pool_t lv_mem_add_pool(void *mem, size_t bytes);
+void lv_mem_remove_pool(lv_mem_pool_t pool);
+void *lv_malloc_core(size_t size);
+void lv_free_core(void *p);
+void *lv_realloc_core(void *p, size_t new_size);
+void lv_mem_monitor_core(lv_mem_monitor_t *mon_p);
+lv_result_t lv_mem_test_core(void);
+
+void *lv_malloc(size_t size);
+void *lv_malloc_zeroed(size_t size);
+void *lv_realloc(void *data_p, size_t new_size);
+void lv_free(void *data);
+void lv_mem_monitor(lv_mem_monitor_t *mon_p);
+
+// Ticks, delays and timers
+
+typedef uint32_t (*lv_tick_get_cb_t)(void);
+typedef void (*lv_delay_cb_t)(uint32_t ms);
+
+void lv_tick_set_cb(lv_tick_get_cb_t cb);
+void lv_delay_set_cb(lv_delay_cb_t cb);
+uint32_t lv_tick_get(void);
+uint32_t lv_tick_elaps(uint32_t prev_tick);
+
+typedef struct lv_timer_t lv_timer_t;
+typedef void (*lv_timer_cb_t)(lv_timer_t *timer);
+
+uint32_t lv_timer_handler(void);
+void lv_timer_ready(lv_timer_t *timer);
+void lv_timer_set_period(lv_timer_t *timer, uint32_t period);
+
+static inline uint32_t lv_anim_count_running(void)
+{
+    return 0;
+}
+
+// Objects, styles and events
+
+typedef struct lv_obj_t lv_obj_t;
+typedef struct lv_display_t lv_display_t;
+typedef struct lv_indev_t lv_indev_t;
+typedef struct lv_event_t lv_event_t;
+typedef struct lv_layer_t lv_layer_t;
+
+typedef enum {
+    LV_EVENT_ALL = 0,
+    LV_EVENT_PRESSED,
+    LV_EVENT_RELEASED,
+    LV_EVENT_DRAW_MAIN,
+    LV_EVENT_INVALIDATE_AREA,
+    LV_EVENT_REFR_START,
+    LV_EVENT_RENDER_START,
+    LV_EVENT_RENDER_READY,
+} lv_event_code_t;
+
+typedef void (*lv_event_cb_t)(lv_event_t *e);
+
+typedef enum {
+    LV_OBJ_FLAG_HIDDEN = (1 << 0),
+    LV_OBJ_FLAG_CLICKABLE = (1 << 1),
+    LV_OBJ_FLAG_SCROLLABLE = (1 << 4),
+} lv_obj_flag_t;
+
+typedef uint32_t lv_style_selector_t;
+
+typedef struct {
+    uint32_t set;   // host_lvgl.c property bits
+    lv_color_t bg_color;
+    lv_opa_t bg_opa;
+    lv_color_t text_color;
+    const lv_font_t *text_font;
+    int32_t line_width;
+    lv_color_t line_color;
+    bool line_rounded;
+} lv_style_t;
+
+// Property ids, the bit of each in lv_style_t.set.
+typedef uint8_t lv_style_prop_t;
+enum {
+    LV_STYLE_BG_COLOR,
+    LV_STYLE_BG_OPA,
+    LV_STYLE_TEXT_COLOR,
+    LV_STYLE_TEXT_FONT,
+    LV_STYLE_LINE_WIDTH,
+    LV_STYLE_LINE_COLOR,
+    LV_STYLE_LINE_ROUNDED,
+};
+
+typedef union {
+    int32_t num;
+    const void *ptr;
+    lv_color_t color;
+} lv_style_value_t;
+
+typedef enum {
+    LV_STYLE_RES_NOT_FOUND,
+    LV_STYLE_RES_FOUND,
+} lv_style_res_t;
+
+void lv_style_init(lv_style_t *style);
+void lv_style_set_bg_color(lv_style_t *style, lv_color_t value);
+void lv_style_set_bg_opa(lv_style_t *style, lv_opa_t value);
+void lv_style_set_text_color(lv_style_t *style, lv_color_t value);
+void lv_style_set_text_font(lv_style_t *style, const lv_font_t *value);
+void lv_style_set_line_width(lv_style_t *style, int32_t value);
+void lv_style_set_line_color(lv_style_t *style, lv_color_t value);
+void lv_style_set_line_rounded(lv_style_t *style, bool value);
+lv_style_res_t lv_style_get_prop(const lv_style_t *style, lv_style_prop_t prop, lv_style_value_t *value);
+
+void lv_init(void);
+
+lv_obj_t *lv_obj_create(lv_obj_t *parent);
+lv_obj_t *lv_button_create(lv_obj_t *parent);
+lv_obj_t *lv_label_create(lv_obj_t *parent);
+lv_obj_t *lv_line_create(lv_obj_t *parent);
+void lv_obj_delete(lv_obj_t *obj);
+
+void lv_obj_add_style(lv_obj_t *obj, const lv_style_t *style, lv_style_selector_t selector);
+void lv_obj_remove_style_all(lv_obj_t *obj);
+void lv_obj_set_local_style_prop(lv_obj_t *obj, lv_style_prop_t prop, lv_style_value_t value, lv_style_selector_t selector);
+void lv_obj_set_pos(lv_obj_t *obj, int32_t x, int32_t y);
+void lv_obj_set_size(lv_obj_t *obj, int32_t w, int32_t h);
+void lv_obj_set_width(lv_obj_t *obj, int32_t w);
+void lv_obj_set_height(lv_obj_t *obj, int32_t h);
+void lv_obj_set_align(lv_obj_t *obj, lv_align_t align);
+void lv_obj_set_flag(lv_obj_t *obj, lv_obj_flag_t f, bool v);
+void lv_obj_add_flag(lv_obj_t *obj, lv_obj_flag_t f);
+void lv_obj_remove_flag(lv_obj_t *obj, lv_obj_flag_t f);
+void lv_obj_invalidate(const lv_obj_t *obj);
+void lv_obj_get_content_coords(const lv_obj_t *obj, lv_area_t *area);
+void lv_obj_add_event_cb(lv_obj_t *obj, lv_event_cb_t event_cb, lv_event_code_t filter, void *user_data);
+
+void lv_label_set_text_static(lv_obj_t *obj, const char *text);
+void lv_line_set_points(lv_obj_t *obj, const lv_point_precise_t points[], uint32_t point_num);
+
+lv_event_code_t lv_event_get_code(lv_event_t *e);
+void *lv_event_get_user_data(lv_event_t *e);
+void *lv_event_get_param(lv_event_t *e);
+lv_obj_t *lv_event_get_target_obj(lv_event_t *e);
+lv_layer_t *lv_event_get_layer(lv_event_t *e);
+
+// Drawing from DRAW_MAIN
+
+typedef struct {
+    const void *src;
+    lv_opa_t opa;
+} lv_draw_image_dsc_t;
+
+typedef struct {
+    const char *text;
+    const lv_font_t *font;
+    lv_color_t color;
+    lv_opa_t opa;
+} lv_draw_label_dsc_t;
+
+void lv_draw_image_dsc_init(lv_draw_image_dsc_t *dsc);
+void lv_draw_image(lv_layer_t *layer, const lv_draw_image_dsc_t *dsc, const lv_area_t *coords);
+void lv_draw_label_dsc_init(lv_draw_label_dsc_t *dsc);
+void lv_draw_label(lv_layer_t *layer, const lv_draw_label_dsc_t *dsc, const lv_area_t *coords);
+
+// Display: the generic MIPI driver's ST7789 flavour, partial rendering only
+
+typedef enum {
+    LV_DISPLAY_RENDER_MODE_PARTIAL,
+} lv_display_render_mode_t;
+
+typedef enum {
+    LV_DISPLAY_ROTATION_0 = 0,
+} lv_display_rotation_t;
+
+#define LV_DISP_ROTATION_0   LV_DISPLAY_ROTATION_0
+#define lv_disp_set_rotation lv_display_set_rotation
+
+#define LV_LCD_FLAG_NONE   (0)
+
+typedef void (*lv_lcd_send_cmd_cb_t)(lv_display_t *disp, const uint8_t *cmd, size_t cmd_size, const uint8_t *param, size_t param_size);
+typedef void (*lv_lcd_send_color_cb_t)(lv_display_t *disp, const uint8_t *cmd, size_t cmd_size, uint8_t *param, size_t param_size);
+
+lv_display_t *lv_st7789_create(uint32_t hor_res, uint32_t ver_res, uint32_t flags, lv_lcd_send_cmd_cb_t send_cmd_cb,
+                               lv_lcd_send_color_cb_t send_color_cb);
+void lv_display_set_rotation(lv_display_t *disp, lv_display_rotation_t rotation);
+void lv_display_set_buffers(lv_display_t *disp, void *buf1, void *buf2, uint32_t buf_size, lv_display_render_mode_t render_mode);
+void lv_display_add_event_cb(lv_display_t *disp, lv_event_cb_t event_cb, lv_event_code_t filter, void *user_data);
+void lv_display_flush_ready(lv_display_t *disp);
+bool lv_display_flush_is_last(lv_display_t *disp);
+lv_display_t *lv_display_get_default(void);
+uint32_t lv_display_get_inactive_time(const lv_display_t *disp);
+void lv_display_trigger_activity(lv_display_t *disp);
+lv_timer_t *lv_display_get_refr_timer(lv_display_t *disp);
+lv_obj_t *lv_screen_active(void);
+void lv_refr_now(lv_display_t *disp);
+
+// Pointer input
+
+typedef enum {
+    LV_INDEV_TYPE_NONE,
+    LV_INDEV_TYPE_POINTER,
+} lv_indev_type_t;
+
+typedef enum {
+    LV_INDEV_STATE_RELEASED = 0,
+    LV_INDEV_STATE_PRESSED,
+} lv_indev_state_t;
+
+typedef struct {
+    lv_point_t point;
+    lv_indev_state_t state;
+    bool continue_reading;
+} lv_indev_data_t;
+
+typedef void (*lv_indev_read_cb_t)(lv_indev_t *indev, lv_indev_data_t *data);
+
+lv_indev_t *lv_indev_create(void);
+void lv_indev_set_type(lv_indev_t *indev, lv_indev_type_t indev_type);
+void lv_indev_set_read_cb(lv_indev_t *indev, lv_indev_read_cb_t read_cb);
+
+#endif   // _HOST_LVGL_H
@@ -0,0 +1,54 @@
+#ifndef _HOST_LVGL_PRIVATE_H
+#define _HOST_LVGL_PRIVATE_H
+
+#include "lvgl.h"
+
+// Object layouts of the host LVGL. slab_alloc.c sizes its object and label classes from these,
+// as it does from LVGL's own on the target.
+
+typedef enum {
+    HostObjBase,
+    HostObjButton,
+    HostObjLabel,
+    HostObjLine,
+} host_obj_class_t;
+
+typedef struct {
+    lv_event_cb_t cb;
+    lv_event_code_t filter;
+    void *user_data;
+} host_event_dsc_t;
+
+struct lv_obj_t {
+    lv_obj_t *parent;
+    lv_obj_t **children;
+    uint32_t child_cnt;
+    const lv_style_t **styles;
+    uint32_t style_cnt;
+    lv_style_t *local_style;   // lv_obj_set_local_style_prop(), ahead of every other style
+    host_event_dsc_t *events;
+    uint32_t event_cnt;
+    lv_area_t coords;      // Absolute, inclusive
+    int32_t x;             // Relative to the parent
+    int32_t y;
+    int32_t w;             // < 0: size of the content
+    int32_t h;
+    uint32_t flags;
+    uint8_t cls;           // host_obj_class_t
+    uint8_t align;
+    bool no_theme;         // lv_obj_remove_style_all()
+    bool pressed;
+};
+
+typedef struct {
+    lv_obj_t obj;
+    const char *text;
+} lv_label_t;
+
+typedef struct {
+    lv_obj_t obj;
+    const lv_point_precise_t *points;
+    uint32_t point_num;
+} lv_line_t;
+
+#endif   // _HOST_LVGL_PRIVATE_H
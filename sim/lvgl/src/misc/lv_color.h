@@ -0,0 +1,2 @@
+// The host LVGL declares everything in lvgl.h.
+#include "../../lvgl.h"
@@ -0,0 +1,14 @@
+// Metrics of the host LVGL's fonts (sim/lvgl/host_lvgl.c), in the format tools/ui_fonts.py
+// writes for the linked fonts.
+#ifndef _UI_FONT_METRICS_H
+#define _UI_FONT_METRICS_H
+
+#define UI_FONT_20_LINE_HEIGHT           (22)
+#define UI_FONT_20_BASE_LINE             (4)
+#define UI_FONT_28_LINE_HEIGHT           (30)
+#define UI_FONT_28_BASE_LINE             (5)
+#define UI_FONT_48_LINE_HEIGHT           (49)
+#define UI_FONT_48_BASE_LINE             (9)
+#define UI_TEXT_WIDTH_RESET              (60)   // "Reset"
+
+#endif   // _UI_FONT_METRICS_H
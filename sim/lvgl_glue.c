@@ -0,0 +1,113 @@
+#include "host_sdk.h"
+#include "lvgl.h"
+#include "lvgl_private.h"
+
+#include <time.h>
+
+// What the board does around LVGL, linked with the real lvgl/lvgl only (--wrap, see
+// add_host_sdk() in CMakeLists.txt). LVGL itself runs unchanged.
+//  - The host CPU time LVGL spends rendering goes on the virtual clock as HostCpuRender, the
+//    flushes left out as the LCD models charge those. The times are the host's, not the M0+'s.
+//  - Flush waits poll the LCD models, where the target spins on a flag the DMA IRQ clears.
+//  - host_lvgl_fixed_refresh() keeps the refresh timer at LV_DEF_REFR_PERIOD.
+
+#define CYCLES_FLUSH_POLL   (64)
+
+lv_display_t *__real_lv_display_create(int32_t hor_res, int32_t ver_res);
+void __real_lv_timer_set_period(lv_timer_t *timer, uint32_t period);
+void __real_lv_timer_ready(lv_timer_t *timer);
+
+static bool fixed_refresh = false;
+
+static bool rendering = false;
+static uint64_t render_mark_ns = 0;   // Start of the render time not charged yet, 0 in a flush
+static uint64_t render_carry_ns = 0;  // Less than a microsecond left over
+
+static uint64_t host_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void charge_render()
+{
+    if (!rendering || !render_mark_ns) {
+        return;
+    }
+    render_carry_ns += host_ns() - render_mark_ns;
+    render_mark_ns = 0;
+    const uint64_t us = render_carry_ns / 1000;
+    render_carry_ns %= 1000;
+    if (us) {
+        host_cpu_us(HostCpuRender, us);
+    }
+}
+
+static void render_event_cb(lv_event_t *e)
+{
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_RENDER_START:
+        rendering = true;
+        render_mark_ns = host_ns();
+        break;
+    case LV_EVENT_FLUSH_START:
+    case LV_EVENT_FLUSH_WAIT_START:
+        charge_render();
+        break;
+    case LV_EVENT_FLUSH_FINISH:
+    case LV_EVENT_FLUSH_WAIT_FINISH:
+        if (rendering) {
+            render_mark_ns = host_ns();
+        }
+        break;
+    case LV_EVENT_RENDER_READY:
+        charge_render();
+        rendering = false;
+        break;
+    default:
+        break;
+    }
+}
+
+static void flush_wait_cb(lv_display_t *disp)
+{
+    while (disp->flushing) {
+        host_cpu_cycles(HostCpuLcd, CYCLES_FLUSH_POLL);
+    }
+}
+
+lv_display_t *__wrap_lv_display_create(int32_t hor_res, int32_t ver_res)
+{
+    lv_display_t *disp = __real_lv_display_create(hor_res, ver_res);
+    if (disp) {
+        lv_display_set_flush_wait_cb(disp, flush_wait_cb);
+        lv_display_add_event_cb(disp, render_event_cb, LV_EVENT_ALL, NULL);
+    }
+    return disp;
+}
+
+static bool is_fixed_refresh_timer(const lv_timer_t *timer)
+{
+    lv_display_t *disp = lv_display_get_default();
+    return fixed_refresh && disp && timer == lv_display_get_refr_timer(disp);
+}
+
+void __wrap_lv_timer_set_period(lv_timer_t *timer, uint32_t period)
+{
+    if (!is_fixed_refresh_timer(timer)) {
+        __real_lv_timer_set_period(timer, period);
+    }
+}
+
+void __wrap_lv_timer_ready(lv_timer_t *timer)
+{
+    if (!is_fixed_refresh_timer(timer)) {
+        __real_lv_timer_ready(timer);
+    }
+}
+
+void host_lvgl_fixed_refresh(bool fixed)
+{
+    fixed_refresh = fixed;
+}
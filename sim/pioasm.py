@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+"""Assemble a PIO program into the C header the SDK's pioasm would write.
+
+The host simulator has no pioasm, this covers what src/*.pio use: .program, .side_set,
+.wrap_target, .wrap, labels, JMP, OUT, PULL, MOV, SET and NOP with side-set and delay, and
+the % c-sdk block, which is copied as it is. The header has the same names as pioasm's:
+<name>_program_instructions, <name>_program, <name>_wrap_target, <name>_wrap and
+<name>_program_get_default_config().
+
+  pioasm.py src/lcd_pio.pio build/lcd_pio.pio.h
+"""
+
+import argparse
+import re
+import sys
+
+JMP_CONDITIONS = {'': 0, '!x': 1, 'x--': 2, '!y': 3, 'y--': 4, 'x!=y': 5, 'pin': 6, '!osre': 7}
+OUT_DESTINATIONS = {'pins': 0, 'x': 1, 'y': 2, 'null': 3, 'pindirs': 4, 'pc': 5, 'isr': 6, 'exec': 7}
+MOV_DESTINATIONS = {'pins': 0, 'x': 1, 'y': 2, 'exec': 4, 'pc': 5, 'isr': 6, 'osr': 7}
+MOV_SOURCES = {'pins': 0, 'x': 1, 'y': 2, 'null': 3, 'status': 5, 'isr': 6, 'osr': 7}
+SET_DESTINATIONS = {'pins': 0, 'x': 1, 'y': 2, 'pindirs': 4}
+
+
+class PioError(Exception):
+    pass
+
+
+def number(text):
+    try:
+        return int(text, 0)
+    except ValueError:
+        raise PioError(f"not a number: '{text}'")
+
+
+def lookup(table, key, what):
+    if key not in table:
+        raise PioError(f"unknown {what} '{key}'")
+    return table[key]
+
+
+class Program:
+    def __init__(self, name):
+        self.name = name
+        self.side_set = 0
+        self.side_opt = False
+        self.wrap_target = None
+        self.wrap = None
+        self.labels = {}
+        self.lines = []     # (line number, mnemonic, operands, side, delay)
+        self.c_sdk = []
+
+
+def split_side_delay(text):
+    """Instruction text without its 'side n' and '[n]', and the two values."""
+    delay = 0
+    m = re.search(r'\[([^\]]+)\]\s*$', text)
+    if m:
+        delay = number(m.group(1).strip())
+        text = text[:m.start()].strip()
+    side = None
+    m = re.search(r'\bside\s+(\S+)\s*$', text)
+    if m:
+        side = number(m.group(1))
+        text = text[:m.start()].strip()
+    return text, side, delay
+
+
+def parse(source):
+    program = None
+    in_c_sdk = False
+    for lineno, raw in enumerate(source.splitlines(), 1):
+        if in_c_sdk:
+            if raw.strip() == '%}':
+                in_c_sdk = False
+            else:
+                program.c_sdk.append(raw)
+            continue
+
+        line = re.split(r';|//', raw, 1)[0].strip()
+        if not line:
+            continue
+        if line.startswith('% c-sdk'):
+            if program is None:
+                raise PioError(f"line {lineno}: c-sdk block before .program")
+            in_c_sdk = True
+            continue
+
+        if line.startswith('.'):
+            words = line.split()
+            if words[0] == '.program':
+                if program is not None:
+                    raise PioError(f"line {lineno}: one program per file")
+                program = Program(words[1])
+            elif program is None:
+                raise PioError(f"line {lineno}: {words[0]} before .program")
+            elif words[0] == '.side_set':
+                program.side_set = number(words[1])
+                program.side_opt = 'opt' in words[2:]
+                if 'pindirs' in words[2:]:
+                    raise PioError(f"line {lineno}: side-set pindirs not supported")
+            elif words[0] == '.wrap_target':
+                program.wrap_target = len(program.lines)
+            elif words[0] == '.wrap':
+                program.wrap = len(program.lines) - 1
+            else:
+                raise PioError(f"line {lineno}: directive {words[0]} not supported")
+            continue
+
+        if program is None:
+            raise PioError(f"line {lineno}: instruction before .program")
+        m = re.match(r'^(\w+):\s*(.*)$', line)
+        if m:
+            program.labels[m.group(1)] = len(program.lines)
+            line = m.group(2)
+            if not line:
+                continue
+        text, side, delay = split_side_delay(line)
+        mnemonic, _, operands = text.partition(' ')
+        operands = [op.strip() for op in operands.split(',')] if operands.strip() else []
+        program.lines.append((lineno, mnemonic.lower(), operands, side, delay))
+
+    if program is None:
+        raise PioError("no .program")
+    if in_c_sdk:
+        raise PioError("c-sdk block not closed")
+    return program
+
+
+def encode(program, mnemonic, operands):
+    """The instruction without side-set and delay."""
+    if mnemonic == 'nop':
+        return encode(program, 'mov', ['y', 'y'])
+
+    if mnemonic == 'jmp':
+        condition, target = (operands[0].replace(' ', ''), operands[1]) if len(operands) == 2 else ('', operands[0])
+        address = program.labels[target] if target in program.labels else number(target)
+        return (lookup(JMP_CONDITIONS, condition, 'jmp condition') << 5) | address
+
+    if mnemonic == 'out':
+        bits = number(operands[1])
+        if not 1 <= bits <= 32:
+            raise PioError(f"out of {bits} bits")
+        return 0x6000 | (lookup(OUT_DESTINATIONS, operands[0], 'out destination') << 5) | (bits & 0x1f)
+
+    if mnemonic == 'pull':
+        words = ' '.join(operands).split()
+        block = 'noblock' not in words
+        return 0x8080 | (0x40 if 'iffull' in words else 0) | (0x20 if block else 0)
+
+    if mnemonic == 'mov':
+        source = operands[1].replace(' ', '')
+        op = 0
+        if source.startswith(('!', '~')):
+            op, source = 1, source[1:]
+        elif source.startswith('::'):
+            op, source = 2, source[2:]
+        return (0xa000 | (lookup(MOV_DESTINATIONS, operands[0], 'mov destination') << 5) | (op << 3)
+                | lookup(MOV_SOURCES, source, 'mov source'))
+
+    if mnemonic == 'set':
+        value = number(operands[1])
+        if not 0 <= value <= 31:
+            raise PioError(f"set value {value} out of range")
+        return 0xe000 | (lookup(SET_DESTINATIONS, operands[0], 'set destination') << 5) | value
+
+    raise PioError(f"instruction '{mnemonic}' not supported")
+
+
+def assemble(program):
+    side_bits = program.side_set + (1 if program.side_opt else 0)
+    delay_bits = 5 - side_bits
+    words = []
+    for lineno, mnemonic, operands, side, delay in program.lines:
+        try:
+            instr = encode(program, mnemonic, operands)
+        except (PioError, IndexError, KeyError) as e:
+            raise PioError(f"line {lineno}: {e}")
+        if delay >= (1 << delay_bits):
+            raise PioError(f"line {lineno}: delay {delay} needs more than {delay_bits} bits")
+        field = delay
+        if side is None:
+            if program.side_set and not program.side_opt:
+                raise PioError(f"line {lineno}: side-set is not optional")
+        else:
+            if side >= (1 << program.side_set):
+                raise PioError(f"line {lineno}: side {side} needs more than {program.side_set} bits")
+            if program.side_opt:
+                side |= 1 << program.side_set
+            field |= side << delay_bits
+        words.append(instr | (field << 8))
+    if len(words) > 32:
+        raise PioError(f"{len(words)} instructions, 32 fit")
+    return words
+
+
+def header(program, words, source_name):
+    name = program.name
+    wrap_target = program.wrap_target if program.wrap_target is not None else 0
+    wrap = program.wrap if program.wrap is not None else len(words) - 1
+    out = [
+        f"// Generated by sim/pioasm.py from {source_name}, do not edit.",
+        "",
+        "#pragma once",
+        "",
+        '#include "hardware/pio.h"',
+        "",
+        f"#define {name}_wrap_target {wrap_target}",
+        f"#define {name}_wrap {wrap}",
+        "",
+        f"static const uint16_t {name}_program_instructions[] = {{",
+    ]
+    out += [f"    0x{w:04x}, // {i}" for i, w in enumerate(words)]
+    out += [
+        "};",
+        "",
+        f"static const struct pio_program {name}_program = {{",
+        f"    .instructions = {name}_program_instructions,",
+        f"    .length = {len(words)},",
+        "    .origin = -1,",
+        "};",
+        "",
+        f"static inline pio_sm_config {name}_program_get_default_config(uint offset) {{",
+        "    pio_sm_config c = pio_get_default_sm_config();",
+        f"    sm_config_set_wrap(&c, offset + {name}_wrap_target, offset + {name}_wrap);",
+    ]
+    if program.side_set:
+        total = program.side_set + (1 if program.side_opt else 0)
+        out.append(f"    sm_config_set_sideset(&c, {total}, {'true' if program.side_opt else 'false'}, false);")
+    out += ["    return c;", "}", ""]
+    out += program.c_sdk
+    return '\n'.join(out) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('source', help='.pio file')
+    parser.add_argument('output', help='header to write')
+    args = parser.parse_args()
+
+    try:
+        with open(args.source) as f:
+            program = parse(f.read())
+        words = assemble(program)
+    except (OSError, PioError) as e:
+        print(f"pioasm: {args.source}: {e}", file=sys.stderr)
+        return 1
+
+    with open(args.output, 'w') as f:
+        f.write(header(program, words, args.source.replace('\\', '/').split('/')[-1]))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
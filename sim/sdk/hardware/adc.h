@@ -0,0 +1,13 @@
+#ifndef _HARDWARE_ADC_H
+#define _HARDWARE_ADC_H
+
+#include "pico.h"
+
+void adc_init(void);
+void adc_gpio_init(uint gpio);
+void adc_select_input(uint input);
+
+// A conversion takes 96 cycles of the 48 MHz ADC clock.
+uint16_t adc_read(void);
+
+#endif   // _HARDWARE_ADC_H
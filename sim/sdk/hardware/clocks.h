@@ -0,0 +1,76 @@
+#ifndef _HARDWARE_CLOCKS_H
+#define _HARDWARE_CLOCKS_H
+
+#include "pico.h"
+
+// Clock frequencies as clock_configure() recorded them, the SDK's boot setup to start with:
+// clk_sys and clk_peri at 125 MHz. Everything that takes time on the host scales with them.
+
+typedef enum {
+    clk_gpout0 = 0,
+    clk_gpout1 = 1,
+    clk_gpout2 = 2,
+    clk_gpout3 = 3,
+    clk_ref = 4,
+    clk_sys = 5,
+    clk_peri = 6,
+    clk_usb = 7,
+    clk_adc = 8,
+    clk_rtc = 9,
+    CLK_COUNT
+} clock_num_t;
+
+typedef clock_num_t clock_handle_t;
+
+#define CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLK_REF              (0x0u)
+#define CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX   (0x1u)
+#define CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS    (0x0u)
+#define CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLK_SYS          (0x0u)
+
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM3_BITS                (1u << 31)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM2_BITS                (1u << 30)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM1_BITS                (1u << 29)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM0_BITS                (1u << 28)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SPI1_BITS                 (1u << 27)
+#define CLOCKS_SLEEP_EN0_CLK_PERI_SPI1_BITS                (1u << 26)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SPI0_BITS                 (1u << 25)
+#define CLOCKS_SLEEP_EN0_CLK_PERI_SPI0_BITS                (1u << 24)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SIO_BITS                  (1u << 23)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_ROM_BITS                  (1u << 19)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_PWM_BITS                  (1u << 17)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_PLL_SYS_BITS              (1u << 14)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_PIO0_BITS                 (1u << 12)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_PADS_BITS                 (1u << 11)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_IO_BITS                   (1u << 8)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_DMA_BITS                  (1u << 5)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_BUSFABRIC_BITS            (1u << 4)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_BUSCTRL_BITS              (1u << 3)
+#define CLOCKS_SLEEP_EN0_CLK_SYS_CLOCKS_BITS               (1u << 0)
+
+#define CLOCKS_SLEEP_EN1_CLK_SYS_XOSC_BITS                 (1u << 14)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_XIP_BITS                  (1u << 13)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_WATCHDOG_BITS             (1u << 12)
+#define CLOCKS_SLEEP_EN1_CLK_USB_USBCTRL_BITS              (1u << 11)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_USBCTRL_BITS              (1u << 10)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_UART0_BITS                (1u << 7)
+#define CLOCKS_SLEEP_EN1_CLK_PERI_UART0_BITS               (1u << 6)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS                (1u << 5)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_SRAM5_BITS                (1u << 1)
+#define CLOCKS_SLEEP_EN1_CLK_SYS_SRAM4_BITS                (1u << 0)
+
+typedef struct {
+    io_rw_32 wake_en0;
+    io_rw_32 wake_en1;
+    io_rw_32 sleep_en0;
+    io_rw_32 sleep_en1;
+    io_ro_32 enabled0;
+    io_ro_32 enabled1;
+} clocks_hw_t;
+
+extern clocks_hw_t host_clocks_hw;
+#define clocks_hw   (&host_clocks_hw)
+
+uint32_t clock_get_hz(clock_handle_t clock);
+bool clock_configure(clock_handle_t clock, uint32_t src, uint32_t auxsrc, uint32_t src_freq, uint32_t freq);
+
+#endif   // _HARDWARE_CLOCKS_H
@@ -0,0 +1,24 @@
+#ifndef _HARDWARE_IRQ_H
+#define _HARDWARE_IRQ_H
+
+#include "pico.h"
+
+typedef void (*irq_handler_t)(void);
+
+#define TIMER_IRQ_0     (0)
+#define PIO0_IRQ_0      (7)
+#define PIO0_IRQ_1      (8)
+#define DMA_IRQ_0       (11)
+#define DMA_IRQ_1       (12)
+#define IO_IRQ_BANK0    (13)
+#define NUM_IRQS        (32)
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY   (0x80)
+
+void irq_set_enabled(uint num, bool enabled);
+bool irq_is_enabled(uint num);
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+void irq_remove_handler(uint num, irq_handler_t handler);
+
+#endif   // _HARDWARE_IRQ_H
@@ -0,0 +1,148 @@
+#ifndef _HARDWARE_PIO_H
+#define _HARDWARE_PIO_H
+
+#include "pico.h"
+#include "hardware/dma.h"
+
+// State machines run their program cycle by cycle at clk_sys / clkdiv, caught up with the
+// virtual clock on every call here and while a DMA channel feeds them. The instructions
+// lcd_pio.pio uses are implemented: JMP, OUT, PULL, MOV and SET with side-set and delay.
+// TX FIFOs drain as the program pulls, FDEBUG.TXSTALL sets while a PULL waits on an empty
+// FIFO and clears on a write of 1, as on the device.
+
+#define NUM_PIOS                  (2)
+#define NUM_PIO_STATE_MACHINES    (4)
+#define PIO_INSTRUCTION_COUNT     (32)
+#define PIO_FDEBUG_TXSTALL_LSB    (24)
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE = 0,
+    PIO_FIFO_JOIN_TX = 1,
+    PIO_FIFO_JOIN_RX = 2,
+};
+
+typedef struct {
+    io_rw_32 fdebug;
+    io_rw_32 txf[NUM_PIO_STATE_MACHINES];   // DMA writes here
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t host_pio0_hw;
+extern pio_hw_t host_pio1_hw;
+#define pio0   (&host_pio0_hw)
+#define pio1   (&host_pio1_hw)
+
+typedef struct pio_program {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;   // -1 for anywhere
+} pio_program_t;
+
+typedef struct {
+    uint16_t clkdiv_int;
+    uint8_t clkdiv_frac;
+    uint8_t out_base;
+    uint8_t out_count;
+    uint8_t set_base;
+    uint8_t set_count;
+    uint8_t sideset_base;
+    uint8_t sideset_bits;     // Including the enable bit with sideset_opt
+    bool sideset_opt;
+    uint8_t wrap_target;
+    uint8_t wrap;
+    enum pio_fifo_join fifo_join;
+    bool out_shift_right;
+    bool autopull;
+    uint8_t pull_threshold;
+} pio_sm_config;
+
+static inline pio_sm_config pio_get_default_sm_config(void)
+{
+    const pio_sm_config c = {.clkdiv_int = 1, .out_count = 32, .wrap = PIO_INSTRUCTION_COUNT - 1, .out_shift_right = true, .pull_threshold = 32};
+    return c;
+}
+
+static inline void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count)
+{
+    c->out_base = (uint8_t)out_base;
+    c->out_count = (uint8_t)out_count;
+}
+
+static inline void sm_config_set_set_pins(pio_sm_config *c, uint set_base, uint set_count)
+{
+    c->set_base = (uint8_t)set_base;
+    c->set_count = (uint8_t)set_count;
+}
+
+static inline void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base)
+{
+    c->sideset_base = (uint8_t)sideset_base;
+}
+
+static inline void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs)
+{
+    (void)pindirs;
+    c->sideset_bits = (uint8_t)bit_count;
+    c->sideset_opt = optional;
+}
+
+static inline void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap)
+{
+    c->wrap_target = (uint8_t)wrap_target;
+    c->wrap = (uint8_t)wrap;
+}
+
+static inline void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join)
+{
+    c->fifo_join = join;
+}
+
+static inline void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold)
+{
+    c->out_shift_right = shift_right;
+    c->autopull = autopull;
+    c->pull_threshold = (uint8_t)pull_threshold;
+}
+
+static inline void sm_config_set_clkdiv_int_frac(pio_sm_config *c, uint16_t div_int, uint8_t div_frac)
+{
+    c->clkdiv_int = div_int;
+    c->clkdiv_frac = div_frac;
+}
+
+static inline void sm_config_set_clkdiv(pio_sm_config *c, float div)
+{
+    const uint16_t div_int = (uint16_t)div;
+    sm_config_set_clkdiv_int_frac(c, div_int, (uint8_t)((div - (float)div_int) * (1u << 8u)));
+}
+
+static inline uint pio_get_dreq(PIO pio, uint sm, bool is_tx)
+{
+    return (pio == pio1 ? DREQ_PIO1_TX0 : DREQ_PIO0_TX0) + (is_tx ? 0u : 4u) + sm;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_unclaim(PIO pio, uint sm);
+
+// Loads at the highest free offset, as the SDK does, with the JMP targets relocated.
+uint pio_add_program(PIO pio, const pio_program_t *program);
+
+void pio_gpio_init(PIO pio, uint pin);
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask);
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out);
+
+// Clears the FIFOs and the state machine's FDEBUG flags, the state machine starts at
+// initial_pc once enabled.
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_set_clkdiv_int_frac(PIO pio, uint sm, uint16_t div_int, uint8_t div_frac);
+
+// Waiting for room in the FIFO is charged to the LCD, the only PIO user.
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm);
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm);
+uint8_t pio_sm_get_pc(PIO pio, uint sm);
+
+#endif   // _HARDWARE_PIO_H
@@ -0,0 +1,66 @@
+#ifndef _HARDWARE_PWM_H
+#define _HARDWARE_PWM_H
+
+#include "pico.h"
+
+#define NUM_PWM_SLICES   (8)
+#define DREQ_PWM_WRAP0   (24)
+
+typedef struct {
+    uint32_t csr;
+    uint32_t div;   // 8.4 fixed point
+    uint32_t top;
+} pwm_config;
+
+typedef struct {
+    io_rw_32 csr;
+    io_rw_32 div;
+    io_rw_32 ctr;
+    io_rw_32 cc;    // Channel A in the low half, B in the high half
+    io_rw_32 top;
+} pwm_slice_hw_t;
+
+typedef struct {
+    pwm_slice_hw_t slice[NUM_PWM_SLICES];
+} pwm_hw_t;
+
+extern pwm_hw_t host_pwm_hw;
+#define pwm_hw   (&host_pwm_hw)
+
+static inline uint pwm_gpio_to_slice_num(uint gpio)
+{
+    return (gpio >> 1u) & 7u;
+}
+
+static inline uint pwm_gpio_to_channel(uint gpio)
+{
+    return gpio & 1u;
+}
+
+static inline uint pwm_get_dreq(uint slice_num)
+{
+    return DREQ_PWM_WRAP0 + slice_num;
+}
+
+static inline pwm_config pwm_get_default_config(void)
+{
+    const pwm_config c = {.csr = 0, .div = 1u << 4, .top = 0xffff};
+    return c;
+}
+
+static inline void pwm_config_set_wrap(pwm_config *c, uint16_t wrap)
+{
+    c->top = wrap;
+}
+
+static inline void pwm_config_set_clkdiv(pwm_config *c, float div)
+{
+    c->div = (uint32_t)(div * (float)(1u << 4));
+}
+
+void pwm_init(uint slice_num, pwm_config *c, bool start);
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level);
+void pwm_set_enabled(uint slice_num, bool enabled);
+void pwm_set_clkdiv_int_frac(uint slice_num, uint8_t integer, uint8_t fract);
+
+#endif   // _HARDWARE_PWM_H
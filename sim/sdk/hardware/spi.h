@@ -0,0 +1,49 @@
+#ifndef _HARDWARE_SPI_H
+#define _HARDWARE_SPI_H
+
+#include "pico.h"
+
+// Transfers go word by word to the device attached with host_spi_attach() and take their
+// time on the wire at the baud rate the dividers give at the current clk_peri. A divider
+// left as it was after a clock change shows as a slower or faster bus, as on the device.
+
+typedef struct spi_inst spi_inst_t;
+
+extern spi_inst_t host_spi0;
+extern spi_inst_t host_spi1;
+#define spi0   (&host_spi0)
+#define spi1   (&host_spi1)
+
+typedef enum {
+    SPI_CPOL_0 = 0,
+    SPI_CPOL_1 = 1,
+} spi_cpol_t;
+
+typedef enum {
+    SPI_CPHA_0 = 0,
+    SPI_CPHA_1 = 1,
+} spi_cpha_t;
+
+typedef enum {
+    SPI_LSB_FIRST = 0,
+    SPI_MSB_FIRST = 1,
+} spi_order_t;
+
+uint spi_init(spi_inst_t *spi, uint baudrate);
+void spi_deinit(spi_inst_t *spi);
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate);
+uint spi_get_baudrate(const spi_inst_t *spi);
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order);
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int spi_write16_blocking(spi_inst_t *spi, const uint16_t *src, size_t len);
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len);
+
+// The blocking calls return once the last word is out.
+static inline bool spi_is_busy(const spi_inst_t *spi)
+{
+    (void)spi;
+    return false;
+}
+
+#endif   // _HARDWARE_SPI_H
@@ -0,0 +1,23 @@
+#ifndef _HARDWARE_STRUCTS_SYSTICK_H
+#define _HARDWARE_STRUCTS_SYSTICK_H
+
+#include "pico.h"
+
+// With ENABLE and TICKINT set in csr the host calls isr_systick() every rvr + 1 cycles of
+// clk_sys. cvr is not modelled.
+
+#define M0PLUS_SYST_CSR_ENABLE_BITS      (0x1u)
+#define M0PLUS_SYST_CSR_TICKINT_BITS     (0x2u)
+#define M0PLUS_SYST_CSR_CLKSOURCE_BITS   (0x4u)
+
+typedef struct {
+    io_rw_32 csr;
+    io_rw_32 rvr;
+    io_rw_32 cvr;
+    io_ro_32 calib;
+} systick_hw_t;
+
+extern systick_hw_t host_systick_hw;
+#define systick_hw   (&host_systick_hw)
+
+#endif   // _HARDWARE_STRUCTS_SYSTICK_H
@@ -0,0 +1,25 @@
+#ifndef _HARDWARE_SYNC_H
+#define _HARDWARE_SYNC_H
+
+#include "pico.h"
+
+// Interrupts are alarm callbacks on the host, masking them is not modelled.
+static inline uint32_t save_and_disable_interrupts(void)
+{
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t status)
+{
+    (void)status;
+}
+
+static inline void __dmb(void) {}
+static inline void __sev(void) {}
+
+// Idles until the next interrupt. With SLEEPDEEP set the time counts as sleep, and the
+// clocks kept by SLEEP_EN0/1 are checked against what has to wake the core.
+void __wfi(void);
+void __wfe(void);
+
+#endif   // _HARDWARE_SYNC_H
@@ -0,0 +1,26 @@
+#ifndef _HARDWARE_UART_H
+#define _HARDWARE_UART_H
+
+#include "pico.h"
+
+// UART0 with its 32 character TX FIFO, draining at the baud rate the divider gives at the
+// current clk_peri. Writers that wait for room spend the time in the Uart category.
+
+typedef struct uart_inst uart_inst_t;
+
+extern uart_inst_t host_uart0;
+#define uart0          (&host_uart0)
+#define uart_default   uart0
+
+uint uart_init(uart_inst_t *uart, uint baudrate);
+uint uart_set_baudrate(uart_inst_t *uart, uint baudrate);
+
+bool uart_is_writable(uart_inst_t *uart);
+bool uart_is_readable(uart_inst_t *uart);
+void uart_putc_raw(uart_inst_t *uart, char c);
+void uart_putc(uart_inst_t *uart, char c);
+void uart_puts(uart_inst_t *uart, const char *s);
+char uart_getc(uart_inst_t *uart);
+void uart_tx_wait_blocking(uart_inst_t *uart);
+
+#endif   // _HARDWARE_UART_H
@@ -0,0 +1,36 @@
+#ifndef _PICO_H
+#define _PICO_H
+
+// Host stand-in for the Pico SDK headers the firmware includes. Only what the firmware uses
+// is declared, with the SDK's names and types; sim/host_sdk.c implements it on the virtual
+// clock and the device models.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PICO_ON_DEVICE   (0)
+
+typedef unsigned int uint;
+
+typedef volatile uint32_t io_rw_32;
+typedef const volatile uint32_t io_ro_32;
+
+// Everything runs from host memory, the placement attributes have nothing to do.
+#define __not_in_flash(group)
+#define __not_in_flash_func(func_name)   func_name
+#define __time_critical_func(func_name)  func_name
+#define __uninitialized_ram(group)       group   // .bss: every run is a cold boot
+
+#define PICO_OK               (0)
+#define PICO_ERROR_TIMEOUT    (-1)
+#define PICO_ERROR_GENERIC    (-2)
+
+// Stops the run with the condition in the report, where the SDK would panic.
+void host_hard_assert(bool condition, const char *expr, const char *file, int line);
+#define hard_assert(cond)   host_hard_assert((cond), #cond, __FILE__, __LINE__)
+
+// A few cycles of CPU time, so a loop spinning on a flag an interrupt sets lets time pass.
+void tight_loop_contents(void);
+
+#endif   // _PICO_H
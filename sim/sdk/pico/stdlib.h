@@ -0,0 +1,13 @@
+#ifndef _PICO_STDLIB_H
+#define _PICO_STDLIB_H
+
+#include <stdio.h>
+#include "pico.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+#include "hardware/uart.h"
+
+// stdout goes to the UART model, see host_printf().
+bool stdio_init_all(void);
+
+#endif   // _PICO_STDLIB_H
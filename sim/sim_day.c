@@ -0,0 +1,543 @@
+// Runs the firmware in virtual time on a host, an hour in a few seconds.
+//
+// Everything from water_reminder.c's main() down is the firmware's own code, built against
+// the host SDK (sdk/, host_sdk.c) and the host LVGL (lvgl/). The board around it is modelled
+// in host_board.c: the ST7789 checks the command timing, the XPT2046 answers the touch
+// reads and the flash programs and erases at the chip's speed. The firmware's printf() goes
+// out through the UART model.
+//
+// The user taps the buttons at their centres from ui_layout.h and holds each tap 150 ms.
+// Without a script the countdown preset is written to the KV store before boot and Start is
+// tapped 2 s in. An expired reminder is acknowledged --ack-after seconds after it went off:
+// Stop, Reset and Start, 1 s apart. A script adds events, one per line:
+//   <seconds> tap start|reset|clock|h+|h-|m+|m-|set
+//   <seconds> adc <mV>               battery voltage from then on
+//   <seconds> uart <text>            a line typed into the shell
+// --interact taps the clock twice, into the set screen and back, every so many seconds.
+//
+// Fails (exit 1) when a countdown started from the preset ends more than --tolerance-ms away
+// from the time it was started for, when the CPU time does not add up to the simulated time
+// or the power state time to the time since boot, when the display refresh timer ran more than
+// --max-refresh-runs times per hour, when the core slept with the clock of a
+// wake source gated, when the panel saw a command its datasheet does not allow, on ERROR
+// lines on the UART and when the firmware asserts or stops.
+//
+//   sim_day --hours 24 --preset 720
+//   sim_day --script taps.txt --uart 1
+//   sim_day_awake --interact 5 --fixed-refresh 1
+
+#include "host_board.h"
+#include "host_sdk.h"
+#include "virtual_clock.h"
+
+#include "display_framework.h"
+#include "kv_store.h"
+#include "metrics.h"
+#include "power_manager.h"
+#include "ui_layout.h"
+#include "hardware/uart.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define US_PER_S              (1000000ull)
+#define TAP_HOLD_US           (150 * 1000)
+#define FIRST_START_US        (2 * US_PER_S)
+#define ACK_STEP_US           (US_PER_S)
+#define INTERACT_STEP_US      (500 * 1000)
+#define SAMPLE_US             (100 * 1000)
+#define BOOT_MAX_US           (2 * US_PER_S)   // Power on to the power manager running
+#define PIN_BACKLIGHT         (2)
+#define ADC_BATTERY           (0)
+#define MAX_SCRIPT_EVENTS     (256)
+#define SCRIPT_TEXT_SIZE      (64)
+
+int firmware_main();
+
+typedef enum {
+    TapStartStop,
+    TapReset,
+    TapClock,
+    TapHourUp,
+    TapHourDown,
+    TapMinuteUp,
+    TapMinuteDown,
+    TapSet,
+    TapCount
+} tap_target_t;
+
+typedef struct {
+    const char *name;
+    uint16_t x;
+    uint16_t y;
+} tap_point_t;
+
+static const tap_point_t tap_points[TapCount] = {
+    {"start", UI_LAYOUT_MID_X + UI_LAYOUT_BTN_WIDTH / 2, UI_LAYOUT_ROW_TOP_Y + UI_LAYOUT_BTN_HEIGHT / 2},
+    {"reset", UI_LAYOUT_MID_X + UI_LAYOUT_BTN_WIDTH / 2, UI_LAYOUT_ROW_BOTTOM_Y + UI_LAYOUT_BTN_HEIGHT / 2},
+    {"clock", UI_PROP_SCREEN_WIDTH_PX / 2, UI_LAYOUT_CLOCK_Y + UI_LAYOUT_CLOCK_HEIGHT / 2},
+    {"h+", UI_LAYOUT_LEFT_X + UI_LAYOUT_THIRD_WIDTH / 2, UI_LAYOUT_ROW_TOP_Y + UI_LAYOUT_BTN_HEIGHT / 2},
+    {"h-", UI_LAYOUT_LEFT_X + UI_LAYOUT_THIRD_WIDTH / 2, UI_LAYOUT_ROW_BOTTOM_Y + UI_LAYOUT_BTN_HEIGHT / 2},
+    {"m+", UI_LAYOUT_RIGHT_X + UI_LAYOUT_THIRD_WIDTH / 2, UI_LAYOUT_ROW_TOP_Y + UI_LAYOUT_BTN_HEIGHT / 2},
+    {"m-", UI_LAYOUT_RIGHT_X + UI_LAYOUT_THIRD_WIDTH / 2, UI_LAYOUT_ROW_BOTTOM_Y + UI_LAYOUT_BTN_HEIGHT / 2},
+    {"set", UI_LAYOUT_SET_X + UI_LAYOUT_THIRD_WIDTH / 2, UI_LAYOUT_SET_Y + UI_LAYOUT_BTN_HEIGHT / 2},
+};
+
+typedef enum {
+    EventTap,
+    EventAdc,
+    EventUart,
+} script_kind_t;
+
+typedef struct {
+    uint64_t at_us;
+    script_kind_t kind;
+    uint32_t value;   // tap_target_t or mV
+    char text[SCRIPT_TEXT_SIZE];
+} script_event_t;
+
+typedef struct {
+    double hours;
+    uint32_t preset_s;
+    uint32_t ack_after_s;    // 0: expired reminders are left flashing
+    uint32_t adc_mv;
+    uint32_t tolerance_ms;
+    uint32_t read_cycles;
+    bool uart;
+    const char *script;
+    uint32_t interact_s;         // 0: no taps beyond the script or the first start
+    bool fixed_refresh;
+    uint32_t max_refresh_runs;   // Per hour, 0: not checked
+} sim_config_t;
+
+static sim_config_t config = {
+    .hours = 1,
+    .preset_s = 720,
+    .ack_after_s = 20,
+    .adc_mv = 3100,
+    .tolerance_ms = 1000,
+    .read_cycles = 0,
+    .uart = false,
+    .script = NULL,
+    .interact_s = 0,
+    .fixed_refresh = false,
+    .max_refresh_runs = 0,
+};
+
+static script_event_t script[MAX_SCRIPT_EVENTS];
+static size_t script_count = 0;
+static size_t script_next = 0;
+
+// The user's side: taps, and what the countdown should be doing.
+static bool pen_down = false;
+static uint32_t taps = 0;
+static uint32_t taps_dropped = 0;   // Came while the previous one was still held
+static bool from_preset = true;     // The next start counts the preset down from the top
+static bool was_started = false;
+static bool was_alarm = false;
+static uint64_t expected_end_us = 0;   // 0: not known
+static uint32_t reminders = 0;
+static int64_t end_error_us_max = 0;   // Signed, largest magnitude
+static uint32_t ack_step = 0;
+static bool interact_back = false;
+
+// Backlight duty, sampled.
+static uint64_t duty_sum = 0;       // Parts of 65536 per sample
+static uint32_t samples = 0;
+static uint32_t samples_off = 0;
+static uint32_t samples_full = 0;
+
+static int64_t release_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    pen_down = false;
+    host_board_touch(false, 0, 0);
+    return 0;
+}
+
+static void tap(tap_target_t target)
+{
+    if (pen_down) {
+        taps_dropped++;
+        return;
+    }
+    pen_down = true;
+    taps++;
+    if (target == TapReset) {
+        from_preset = true;
+    }
+    host_board_touch(true, tap_points[target].x, tap_points[target].y);
+    virtual_clock_add_alarm(virtual_clock_now_us() + TAP_HOLD_US, release_cb, NULL);
+}
+
+// Stop the reminder, Reset, Start.
+static int64_t ack_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    static const tap_target_t sequence[] = {TapStartStop, TapReset, TapStartStop};
+    tap(sequence[ack_step++]);
+    return (ack_step < sizeof(sequence) / sizeof(sequence[0])) ? (int64_t)ACK_STEP_US : 0;
+}
+
+static void reminder_went_off(uint64_t now_us)
+{
+    reminders++;
+    if (expected_end_us) {
+        const int64_t error_us = (int64_t)(now_us - expected_end_us);
+        if (llabs(error_us) > llabs(end_error_us_max)) {
+            end_error_us_max = error_us;
+        }
+    }
+    if (config.ack_after_s) {
+        ack_step = 0;
+        virtual_clock_add_alarm(now_us + (uint64_t)config.ack_after_s * US_PER_S, ack_cb, NULL);
+    }
+}
+
+// Watches the countdown through the firmware's own accessors, which only read state, and
+// samples the backlight PWM.
+static int64_t sample_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    const uint64_t now_us = virtual_clock_now_us();
+
+    const bool started = ui_next_deadline_us() != 0 || ui_alarm_active();
+    if (started && !was_started) {
+        expected_end_us = from_preset ? now_us + (uint64_t)config.preset_s * US_PER_S : 0;
+    }
+    else if (!started && was_started) {
+        from_preset = false;
+    }
+    was_started = started;
+
+    const bool alarm = ui_alarm_active();
+    if (alarm && !was_alarm) {
+        reminder_went_off(now_us);
+    }
+    was_alarm = alarm;
+
+    const uint32_t duty = host_pwm_duty(PIN_BACKLIGHT);
+    duty_sum += duty;
+    samples++;
+    samples_off += (duty == 0);
+    samples_full += (duty >= 65536 * 99 / 100);
+    return -(int64_t)SAMPLE_US;
+}
+
+static int64_t start_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    tap(TapStartStop);
+    return 0;
+}
+
+// Into the set screen, half a second there, and back.
+static int64_t interact_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    tap(TapClock);
+    interact_back = !interact_back;
+    return interact_back ? (int64_t)INTERACT_STEP_US : (int64_t)config.interact_s * US_PER_S - INTERACT_STEP_US;
+}
+
+static int64_t script_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    const script_event_t *event = &script[script_next++];
+    switch (event->kind) {
+    case EventTap:
+        tap((tap_target_t)event->value);
+        break;
+    case EventAdc:
+        host_adc_set_mv(ADC_BATTERY, event->value);
+        break;
+    case EventUart:
+        host_uart_rx(event->text);
+        host_uart_rx("\r");
+        break;
+    }
+    if (script_next == script_count) {
+        return 0;
+    }
+    const uint64_t now_us = virtual_clock_now_us();
+    return (script[script_next].at_us > now_us) ? (int64_t)(script[script_next].at_us - now_us) : 1;
+}
+
+static void run_firmware()
+{
+    firmware_main();
+}
+
+static bool load_script(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("sim_day: cannot open %s\n", path);
+        return false;
+    }
+
+    char line[128];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        line[strcspn(line, "\r\n")] = '\0';
+        double at_s;
+        char kind[16];
+        int arg_at = 0;
+        if (line[0] == '#' || sscanf(line, "%lf %15s %n", &at_s, kind, &arg_at) != 2 || arg_at == 0) {
+            continue;
+        }
+        if (script_count == MAX_SCRIPT_EVENTS) {
+            printf("sim_day: %s: more than %d events\n", path, MAX_SCRIPT_EVENTS);
+            break;
+        }
+
+        const char *arg = line + arg_at;
+        script_event_t *event = &script[script_count];
+        event->at_us = (uint64_t)(at_s * US_PER_S);
+        if (script_count && event->at_us < script[script_count - 1].at_us) {
+            printf("sim_day: %s:%d: events must be in time order\n", path, line_no);
+            fclose(f);
+            return false;
+        }
+
+        bool known = false;
+        if (strcmp(kind, "tap") == 0) {
+            for (uint32_t t = 0; t < TapCount; t++) {
+                if (strcmp(arg, tap_points[t].name) == 0) {
+                    event->kind = EventTap;
+                    event->value = t;
+                    known = true;
+                }
+            }
+        }
+        else if (strcmp(kind, "adc") == 0) {
+            event->kind = EventAdc;
+            event->value = (uint32_t)strtoul(arg, NULL, 10);
+            known = true;
+        }
+        else if (strcmp(kind, "uart") == 0) {
+            event->kind = EventUart;
+            snprintf(event->text, sizeof(event->text), "%s", arg);
+            known = true;
+        }
+        if (!known) {
+            printf("sim_day: %s:%d: unknown event '%s %s'\n", path, line_no, kind, arg);
+            continue;
+        }
+        script_count++;
+    }
+    fclose(f);
+    return true;
+}
+
+static bool parse_args(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!val) {
+            printf("sim_day: %s needs a value\n", opt);
+            return false;
+        }
+        i++;
+        if (strcmp(opt, "--hours") == 0) {
+            config.hours = atof(val);
+        }
+        else if (strcmp(opt, "--preset") == 0) {
+            config.preset_s = (uint32_t)strtoul(val, NULL, 10);
+        }
+        else if (strcmp(opt, "--ack-after") == 0) {
+            config.ack_after_s = (uint32_t)strtoul(val, NULL, 10);
+        }
+        else if (strcmp(opt, "--adc-mv") == 0) {
+            config.adc_mv = (uint32_t)strtoul(val, NULL, 10);
+        }
+        else if (strcmp(opt, "--tolerance-ms") == 0) {
+            config.tolerance_ms = (uint32_t)strtoul(val, NULL, 10);
+        }
+        else if (strcmp(opt, "--read-cycles") == 0) {
+            config.read_cycles = (uint32_t)strtoul(val, NULL, 10);
+        }
+        else if (strcmp(opt, "--uart") == 0) {
+            config.uart = atoi(val) != 0;
+        }
+        else if (strcmp(opt, "--script") == 0) {
+            config.script = val;
+        }
+        else if (strcmp(opt, "--interact") == 0) {
+            config.interact_s = (uint32_t)strtoul(val, NULL, 10);
+        }
+        else if (strcmp(opt, "--fixed-refresh") == 0) {
+            config.fixed_refresh = atoi(val) != 0;
+        }
+        else if (strcmp(opt, "--max-refresh-runs") == 0) {
+            config.max_refresh_runs = (uint32_t)strtoul(val, NULL, 10);
+        }
+        else {
+            printf("sim_day: unknown option %s\n", opt);
+            return false;
+        }
+    }
+    return true;
+}
+
+// The preset the user set on an earlier day, in the flash before power on.
+static void write_preset()
+{
+    host_sdk_reset();
+    uart_init(uart0, 115200);
+    kv_store_init(kv_flash_ram_port());
+    kv_set(KvKeyCountdownPreset, &config.preset_s, sizeof(config.preset_s));
+    kv_store_flush();
+}
+
+static void start()
+{
+    write_preset();
+    host_sdk_reset();
+    host_board_reset();
+    if (config.read_cycles) {
+        host_set_read_cycles(config.read_cycles);
+    }
+    host_uart_echo(config.uart);
+    host_lvgl_fixed_refresh(config.fixed_refresh);
+    host_adc_set_mv(ADC_BATTERY, config.adc_mv);
+
+    virtual_clock_add_alarm(SAMPLE_US, sample_cb, NULL);
+    if (config.script) {
+        if (script_count) {
+            virtual_clock_add_alarm(script[0].at_us, script_cb, NULL);
+        }
+    }
+    else {
+        virtual_clock_add_alarm(FIRST_START_US, start_cb, NULL);
+    }
+    if (config.interact_s) {
+        virtual_clock_add_alarm(FIRST_START_US + (uint64_t)config.interact_s * US_PER_S, interact_cb, NULL);
+    }
+}
+
+static int report(bool run_ok)
+{
+    int failures = run_ok ? 0 : 1;
+    const uint64_t elapsed_us = virtual_clock_now_us();
+
+    host_sdk_stats_t sdk;
+    host_sdk_get_stats(&sdk);
+    power_stats_t power;
+    power_manager_get_stats(&power);
+    host_panel_stats_t panel;
+    host_board_get_panel_stats(&panel);
+    metrics_snapshot_t metrics;
+    metrics_get_snapshot(elapsed_us, &metrics);
+    ui_refresh_stats_t refresh;
+    ui_get_refresh_stats(&refresh);
+    timer_checkpoint_stats_t checkpoint;
+    ui_get_checkpoint_stats(&checkpoint);
+
+    printf("sim_day: %.2f h simulated, %" PRIu32 " interrupts, %" PRIu32 " WFI\n", elapsed_us / 3600e6, sdk.irqs, sdk.wfi);
+
+    uint64_t cpu_sum_us = 0;
+    for (int i = 0; i < HostCpuCount; i++) {
+        cpu_sum_us += sdk.cpu_us[i];
+        printf("sim_day: cpu %-7s %10.1f s %6.2f %%\n", host_cpu_names[i], sdk.cpu_us[i] / 1e6,
+               100.0 * sdk.cpu_us[i] / elapsed_us);
+    }
+    uint64_t power_sum_us = 0;
+    for (int i = 0; i < PowerStateCount; i++) {
+        power_sum_us += power.state_us[i];
+        printf("sim_day: power %-10s %10.1f s\n", power_state_name((power_state_t)i), power.state_us[i] / 1e6);
+    }
+    printf("sim_day: power manager started %.3f s after power on\n", (elapsed_us - power_sum_us) / 1e6);
+    printf("sim_day: %" PRIu32 " sleeps, wakes: %" PRIu32 " touch, %" PRIu32 " deadline, %" PRIu32 " service, %" PRIu32 " other, longest wake %" PRIu32 " us\n",
+           power.sleeps, power.wakes_touch, power.wakes_deadline, power.wakes_service, power.wakes_other, power.wake_us_max);
+    printf("sim_day: backlight average %.1f %%, off %.1f %% of the time, full %.1f %%\n",
+           samples ? 100.0 * duty_sum / samples / 65536 : 0.0, samples ? 100.0 * samples_off / samples : 0.0,
+           samples ? 100.0 * samples_full / samples : 0.0);
+    printf("sim_day: panel %" PRIu32 " commands, %" PRIu32 " flushes, %" PRIu64 " pixels, %" PRIu32 " sleep ins, %" PRIu32 " violations\n",
+           panel.commands, panel.flushes, panel.pixels, panel.sleep_ins, panel.violations);
+    uint32_t refresh_runs = 0;
+    uint32_t refresh_renders = 0;
+    for (int i = 0; i < RefreshModeCount; i++) {
+        refresh_runs += refresh.timer_runs[i];
+        refresh_renders += refresh.renders[i];
+        printf("sim_day: refresh %-12s %8" PRIu32 " timer runs, %6" PRIu32 " renders, %8.3f s rendering\n",
+               refresh_mode_name((refresh_mode_t)i), refresh.timer_runs[i], refresh.renders[i], refresh.render_us[i] / 1e6);
+    }
+    // Render CPU is what the host LVGL charges to drawing, empty timer runs included.
+    const double hours = elapsed_us / 3600e6;
+    const double refresh_runs_per_hour = refresh_runs / hours;
+    printf("sim_day: refresh per hour%s %8.0f timer runs, %6.0f renders, render cpu %.1f s (%.2f %%)\n",
+           config.fixed_refresh ? " (fixed)" : "", refresh_runs_per_hour, refresh_renders / hours,
+           sdk.cpu_us[HostCpuRender] / 1e6 / hours, 100.0 * sdk.cpu_us[HostCpuRender] / elapsed_us);
+    printf("sim_day: %" PRIu32 " frames, %" PRIu32 " checkpoint rewrites for drift, %" PRIu32 " for changes\n", metrics.frames,
+           checkpoint.drifts, checkpoint.changes);
+    printf("sim_day: %" PRIu32 " taps, %" PRIu32 " dropped, touch read latency max %" PRIu32 " us\n", taps, taps_dropped,
+           metrics.touch_latency_us_max);
+    printf("sim_day: battery %" PRIu32 " mV, UART %" PRIu32 " characters, %" PRIu32 " ERROR lines\n", metrics.battery_mv,
+           sdk.uart_chars, sdk.uart_error_lines);
+    printf("sim_day: %" PRIu32 " reminders, end error max %+.3f s\n", reminders, end_error_us_max / 1e6);
+
+    if ((uint64_t)llabs(end_error_us_max) > (uint64_t)config.tolerance_ms * 1000) {
+        printf("sim_day: FAIL a countdown ended %+.3f s off, tolerance %" PRIu32 " ms\n", end_error_us_max / 1e6,
+               config.tolerance_ms);
+        failures++;
+    }
+    if (cpu_sum_us != elapsed_us) {
+        printf("sim_day: FAIL cpu time adds up to %" PRIu64 " us of %" PRIu64 " us\n", cpu_sum_us, elapsed_us);
+        failures++;
+    }
+    // The power manager starts once the boot is done.
+    if (power_sum_us > elapsed_us || elapsed_us - power_sum_us > BOOT_MAX_US) {
+        printf("sim_day: FAIL power state time adds up to %" PRIu64 " us of %" PRIu64 " us\n", power_sum_us, elapsed_us);
+        failures++;
+    }
+    // Deep sleep only happens in the sleep state, which also covers the service wakes.
+    if (sdk.cpu_us[HostCpuSleep] > power.state_us[PowerSleep]) {
+        printf("sim_day: FAIL %" PRIu64 " us in deep sleep, but only %" PRIu64 " us in the sleep state\n",
+               sdk.cpu_us[HostCpuSleep], power.state_us[PowerSleep]);
+        failures++;
+    }
+    if (sdk.sleep_gating_errors) {
+        printf("sim_day: FAIL %" PRIu32 " deep sleeps with the clock of a wake source gated\n", sdk.sleep_gating_errors);
+        failures++;
+    }
+    if (panel.violations) {
+        printf("sim_day: FAIL %" PRIu32 " panel commands out of the datasheet's timing\n", panel.violations);
+        failures++;
+    }
+    if (config.max_refresh_runs && refresh_runs_per_hour > config.max_refresh_runs) {
+        printf("sim_day: FAIL %.0f refresh timer runs per hour, limit %" PRIu32 "\n", refresh_runs_per_hour,
+               config.max_refresh_runs);
+        failures++;
+    }
+    if (sdk.uart_error_lines) {
+        printf("sim_day: FAIL %" PRIu32 " ERROR lines on the UART\n", sdk.uart_error_lines);
+        failures++;
+    }
+    if (config.ack_after_s && !config.script && reminders == 0 && elapsed_us > (uint64_t)(config.preset_s + 2) * US_PER_S) {
+        printf("sim_day: FAIL the countdown never went off\n");
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (!parse_args(argc, argv) || (config.script && !load_script(config.script))) {
+        return 2;
+    }
+
+    start();
+    const bool run_ok = host_sdk_run(run_firmware, (uint64_t)(config.hours * 3600 * US_PER_S));
+    return report(run_ok);
+}
@@ -0,0 +1,36 @@
+#ifndef _TEST_H
+#define _TEST_H
+
+#include <stdio.h>
+
+// Checks for the host tests. A failed check prints its location and the test carries on,
+// main() returns test_result() so ctest sees the failure.
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            printf("%s:%d: FAIL %s\n", __FILE__, __LINE__, #cond);                  \
+            test_failures++;                                                        \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                  \
+    do {                                                                            \
+        const long long a_ = (long long)(actual);                                   \
+        const long long e_ = (long long)(expected);                                 \
+        if (a_ != e_) {                                                             \
+            printf("%s:%d: FAIL %s is %lld, expected %lld\n", __FILE__, __LINE__,   \
+                   #actual, a_, e_);                                                \
+            test_failures++;                                                        \
+        }                                                                           \
+    } while (0)
+
+static inline int test_result(const char *name)
+{
+    printf("%s: %s\n", name, test_failures ? "FAIL" : "ok");
+    return test_failures ? 1 : 0;
+}
+
+#endif   // _TEST_H
@@ -0,0 +1,157 @@
+// backlight_policy.c and backlight.c: the idle thresholds, the ramp entries a fade plan
+// selects, and fades on the host PWM and DMA, run to the end or cut short by a touch.
+
+#include "backlight.h"
+#include "host_sdk.h"
+#include "test.h"
+#include "pico/time.h"
+
+#define PIN_BACKLIGHT   (2)   // As wired in pins.h
+
+static const backlight_config_t config = {
+    .bright = 255,
+    .dim = 48,
+    .dim_after_ms = 10000,
+    .off_after_ms = 60000,
+};
+
+// PWM duty for a level, in the parts of 65536 host_pwm_duty() reports.
+static uint32_t duty(uint8_t level)
+{
+    return ((uint32_t)backlight_gamma(level) << 16) / (BACKLIGHT_PWM_WRAP + 1);
+}
+
+static void test_policy()
+{
+    CHECK_EQ(backlight_policy_level(&config, 0), 255);
+    CHECK_EQ(backlight_policy_level(&config, 9999), 255);
+    CHECK_EQ(backlight_policy_level(&config, 10000), 48);
+    CHECK_EQ(backlight_policy_level(&config, 59999), 48);
+    CHECK_EQ(backlight_policy_level(&config, 60000), 0);
+    CHECK_EQ(backlight_policy_level(&config, UINT32_MAX), 0);
+
+    // 0 disables a threshold.
+    backlight_config_t never = config;
+    never.off_after_ms = 0;
+    CHECK_EQ(backlight_policy_level(&never, UINT32_MAX), 48);
+    never.dim_after_ms = 0;
+    CHECK_EQ(backlight_policy_level(&never, UINT32_MAX), 255);
+
+    // Off before dim goes straight to off.
+    backlight_config_t off_first = config;
+    off_first.off_after_ms = 5000;
+    CHECK_EQ(backlight_policy_level(&off_first, 5000), 0);
+}
+
+static void test_gamma()
+{
+    CHECK_EQ(backlight_gamma(0), 0);
+    CHECK_EQ(backlight_gamma(BACKLIGHT_LEVEL_MAX), BACKLIGHT_PWM_WRAP);
+    for (uint32_t i = 1; i <= BACKLIGHT_LEVEL_MAX; i++) {
+        CHECK(backlight_gamma((uint8_t)i) >= backlight_gamma((uint8_t)(i - 1)));
+    }
+}
+
+// A plan walks the ramp one level at a time from next to the current level to the target.
+static void check_plan(uint8_t from, uint8_t to)
+{
+    bool up;
+    uint32_t first;
+    uint32_t count;
+    CHECK(backlight_fade_plan(from, to, &up, &first, &count));
+    CHECK_EQ(up, to > from);
+    CHECK_EQ(count, up ? to - from : from - to);
+    CHECK(first + count <= BACKLIGHT_LEVEL_MAX + 1);
+
+    // Entry i of the falling ramp is level BACKLIGHT_LEVEL_MAX - i.
+    const uint32_t first_level = up ? first : BACKLIGHT_LEVEL_MAX - first;
+    const uint32_t last_level = up ? first + count - 1 : BACKLIGHT_LEVEL_MAX - (first + count - 1);
+    CHECK_EQ(first_level, up ? from + 1 : from - 1);
+    CHECK_EQ(last_level, to);
+}
+
+static void test_fade_plan()
+{
+    check_plan(0, 255);
+    check_plan(48, 255);
+    check_plan(255, 48);
+    check_plan(255, 0);
+    check_plan(1, 0);
+    check_plan(0, 1);
+
+    bool up;
+    uint32_t first;
+    uint32_t count;
+    CHECK(!backlight_fade_plan(48, 48, &up, &first, &count));
+}
+
+// One step per PWM period, 1 ms.
+static void test_fades()
+{
+    host_sdk_reset();
+    backlight_init(PIN_BACKLIGHT, &config);
+    backlight_set(255, false);
+    CHECK_EQ(backlight_level(), 255);
+    CHECK_EQ(host_pwm_duty(PIN_BACKLIGHT), duty(255));
+
+    // Dim: 207 steps down, the level and duty follow the DMA.
+    backlight_set(48, true);
+    sleep_ms(100);
+    const uint8_t mid = backlight_level();
+    CHECK(mid >= 154 && mid <= 156);
+    CHECK_EQ(host_pwm_duty(PIN_BACKLIGHT), duty(mid));
+    sleep_ms(200);
+    CHECK_EQ(backlight_level(), 48);
+    CHECK_EQ(host_pwm_duty(PIN_BACKLIGHT), duty(48));
+
+    // A touch mid fade: straight back to bright, the rest of the fade never lands.
+    backlight_set(0, true);
+    sleep_ms(20);
+    CHECK(backlight_level() > 0 && backlight_level() < 48);
+    backlight_set(255, false);
+    CHECK_EQ(backlight_level(), 255);
+    sleep_ms(100);
+    CHECK_EQ(backlight_level(), 255);
+    CHECK_EQ(host_pwm_duty(PIN_BACKLIGHT), duty(255));
+
+    // A fade up from part way through a fade down starts where the first one got to.
+    backlight_set(0, true);
+    sleep_ms(55);
+    const uint8_t turned = backlight_level();
+    CHECK(turned >= 199 && turned <= 201);
+    backlight_set(255, true);
+    sleep_ms(20);
+    CHECK_EQ(backlight_level(), turned + 20 > 255 ? 255 : turned + 20);
+    sleep_ms(100);
+    CHECK_EQ(backlight_level(), 255);
+    CHECK_EQ(host_pwm_duty(PIN_BACKLIGHT), duty(255));
+}
+
+// The policy through tick_backlight(): dims with a fade, off with a fade, a touch is instant.
+static void test_tick()
+{
+    host_sdk_reset();
+    backlight_init(PIN_BACKLIGHT, &config);
+    backlight_set(255, false);
+
+    tick_backlight(10000);
+    sleep_ms(300);
+    CHECK_EQ(backlight_level(), 48);
+    tick_backlight(60000);
+    CHECK(backlight_level() > 0);
+    sleep_ms(100);
+    CHECK_EQ(backlight_level(), 0);
+    CHECK_EQ(host_pwm_duty(PIN_BACKLIGHT), 0);
+    tick_backlight(0);
+    CHECK_EQ(backlight_level(), 255);
+}
+
+int main()
+{
+    test_policy();
+    test_gamma();
+    test_fade_plan();
+    test_fades();
+    test_tick();
+    return test_result("test_backlight");
+}
@@ -0,0 +1,86 @@
+// clock_plan.c for the four governor steps: every clk_sys derived rate the governor sets
+// when it switches, against the datasheet arithmetic and the limits the peripherals have.
+
+#include "clock_plan.h"
+#include "test.h"
+
+// Within 2 % of the rate asked for, and not above it for the SPI ones.
+static bool within_2_percent(uint32_t actual, uint32_t asked)
+{
+    const uint32_t error = (actual > asked) ? actual - asked : asked - actual;
+    return error * 50 <= asked;
+}
+
+static void test_steps()
+{
+    CHECK_EQ(clock_step_hz(0), 125000000);
+    CHECK_EQ(clock_step_hz(1), 62500000);
+    CHECK_EQ(clock_step_hz(2), 31250000);
+    CHECK_EQ(clock_step_hz(3), 15625000);
+    CHECK_EQ(clock_step_hz(CLOCK_STEP_COUNT), 0);
+}
+
+static void test_plans()
+{
+    // SPI0 cannot reach the 50 MHz asked for: clk_peri / 4 at the top step, clk_peri / 2
+    // (the smallest prescaler and no post divider) below it.
+    static const uint32_t lcd_spi_hz[CLOCK_STEP_COUNT] = {31250000, 31250000, 15625000, 7812500};
+    static const uint32_t backlight_div16[CLOCK_STEP_COUNT] = {488, 244, 122, 61};
+
+    for (size_t step = 0; step < CLOCK_STEP_COUNT; step++) {
+        const uint32_t sys_hz = clock_step_hz(step);
+        clock_plan_t plan;
+        CHECK(clock_plan_make(sys_hz, &plan));
+        CHECK_EQ(plan.sys_hz, sys_hz);
+
+        // The LVGL tick stays at 1 ms: reload + 1 cycles per tick.
+        CHECK_EQ(plan.systick_reload, sys_hz / 1000 - 1);
+        CHECK(plan.systick_reload <= 0xffffff);
+
+        CHECK_EQ(plan.lcd_spi_hz, lcd_spi_hz[step]);
+        CHECK(plan.touch_spi_hz <= CLOCK_TOUCH_SPI_HZ);
+        CHECK(within_2_percent(plan.touch_spi_hz, CLOCK_TOUCH_SPI_HZ));
+        CHECK(within_2_percent(plan.uart_baud, CLOCK_UART_BAUD));
+
+        // clk_sys never goes above twice the SCK limit, the state machine always runs undivided.
+        CHECK_EQ(plan.lcd_pio_div, 1);
+        CHECK_EQ(plan.lcd_pio_sck_hz, sys_hz / 2);
+        CHECK(plan.lcd_pio_sck_hz <= CLOCK_LCD_PIO_MAX_SCK_HZ);
+
+        // The backlight PWM stays at about 1 kHz: clk_sys / (div16 / 16) / TOP.
+        CHECK_EQ(plan.backlight_div16, backlight_div16[step]);
+        const uint32_t pwm_hz = (uint32_t)(16ull * sys_hz / plan.backlight_div16 / CLOCK_BACKLIGHT_PWM_TOP);
+        CHECK(within_2_percent(pwm_hz, CLOCK_BACKLIGHT_PWM_HZ));
+    }
+}
+
+// The dividers the SDK functions pick for rates with a known answer.
+static void test_rates()
+{
+    CHECK_EQ(clock_spi_rate(125000000, 100000), 125000000 / (6 * 209));
+    CHECK_EQ(clock_spi_rate(125000000, 1000000000), 125000000 / 2);
+    CHECK_EQ(clock_uart_rate(125000000, 115200), 115207);
+    CHECK_EQ(clock_uart_rate(15625000, 115200), 115101);
+}
+
+// A PIO divider above one for a clk_sys over 125 MHz, and clk_sys values the SysTick
+// reload (1 kHz) or the UART divider (1 MHz) cannot follow.
+static void test_limits()
+{
+    clock_plan_t plan;
+    CHECK(clock_plan_make(250000000, &plan));
+    CHECK_EQ(plan.lcd_pio_div, 2);
+    CHECK_EQ(plan.lcd_pio_sck_hz, 62500000);
+
+    CHECK(!clock_plan_make(1000, &plan));
+    CHECK(!clock_plan_make(1000000, &plan));
+}
+
+int main()
+{
+    test_steps();
+    test_plans();
+    test_rates();
+    test_limits();
+    return test_result("test_clock_plan");
+}
@@ -0,0 +1,62 @@
+// glyph_cache_init() with the C heap failing at every allocation in turn: each failed init
+// gives back all it took, so the label renderer the firmware falls back to has the heap.
+// malloc() and free() are wrapped (--wrap) to fail on cue and count what is live.
+
+#include "glyph_cache.h"
+#include "host_sdk.h"
+#include "test.h"
+#include "ui_properties.h"
+
+#include <stdlib.h>
+
+#define MAX_ALLOCS   (256)
+
+void *__real_malloc(size_t size);
+void __real_free(void *p);
+
+static int fail_at = 0;   // 1-based count of the allocation to fail, 0: none
+static int allocs = 0;
+static int live = 0;
+
+void *__wrap_malloc(size_t size)
+{
+    if (++allocs == fail_at) {
+        return NULL;
+    }
+    void *p = __real_malloc(size);
+    live += (p != NULL);
+    return p;
+}
+
+void __wrap_free(void *p)
+{
+    live -= (p != NULL);
+    __real_free(p);
+}
+
+int main()
+{
+    host_sdk_reset();
+    lv_init();
+
+    const lv_color_t colours[] = {lv_color_hex(0xE0E0E0), lv_color_hex(0xF44336)};
+    int result = -1;
+    int failed = 0;
+    for (fail_at = 1; fail_at < MAX_ALLOCS && result != 0; fail_at++) {
+        allocs = 0;
+        live = 0;
+        result = glyph_cache_init(UI_PROP_FONT_CLOCK, lv_color_hex(0x1A1A1A), colours, 2);
+        if (result != 0) {
+            failed++;
+            CHECK_EQ(live, 0);
+            CHECK(!glyph_cache_ready());
+        }
+    }
+
+    // One tile per glyph and colour, at least, could fail.
+    CHECK_EQ(result, 0);
+    CHECK(failed >= (int)(sizeof(GLYPH_CACHE_CHARS) - 1) * 2);
+    CHECK(glyph_cache_ready());
+    printf("test_glyph_cache: %d failed inits\n", failed);
+    return test_result("test_glyph_cache");
+}
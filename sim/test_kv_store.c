@@ -0,0 +1,197 @@
+// kv_store.c on the RAM flash image: the checks of the KV_STORE_BENCHMARK boot benchmark,
+// run on every change. Values round trip through flash across compactions and reloads,
+// sectors are used round robin, and a power cut after any program or erase loses at most
+// the write in progress, never a value written before it or another key.
+
+#include "kv_store.h"
+#include "host_sdk.h"
+#include "test.h"
+#include "pico/stdlib.h"
+
+#include <string.h>
+
+#define WRITES   (2500)   // Enough for a compaction into every sector
+
+// The RAM port, counting the programs and erases that reach it.
+static const kv_flash_port_t *ram;
+static kv_flash_port_t port;
+static uint32_t ops = 0;
+
+static bool counted_program(uint32_t offset, const uint8_t *page)
+{
+    ops++;
+    return ram->program(offset, page);
+}
+
+static bool counted_erase(uint32_t offset)
+{
+    ops++;
+    return ram->erase(offset);
+}
+
+static void blank_flash()
+{
+    kv_flash_ram_restore_power();
+    for (uint32_t s = 0; s < ram->sector_count; s++) {
+        ram->erase(s * ram->sector_size);
+    }
+    ops = 0;
+}
+
+static const uint8_t calibration[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+
+// The calibration once, then the preset 0 to n - 1, each flushed.
+static void write_sequence(uint32_t n, uint32_t *ops_after)
+{
+    kv_store_init(&port);
+    kv_set(KvKeyTouchCalibration, calibration, sizeof(calibration));
+    kv_store_flush();
+    for (uint32_t i = 0; i < n; i++) {
+        kv_set(KvKeyCountdownPreset, &i, sizeof(i));
+        kv_store_flush();
+        if (ops_after) {
+            ops_after[i] = ops;
+        }
+    }
+}
+
+static void test_round_trip()
+{
+    blank_flash();
+    uint32_t value = 0;
+    CHECK_EQ(kv_store_init(&port), 0);
+    CHECK_EQ(kv_get(KvKeyCountdownPreset, &value, sizeof(value)), -1);
+
+    CHECK_EQ(kv_set(0, &value, sizeof(value)), -1);
+    CHECK_EQ(kv_set(KvKeyCount, &value, sizeof(value)), -1);
+    uint8_t big[KV_MAX_VALUE_SIZE + 1] = {0};
+    CHECK_EQ(kv_set(KvKeyTimerState, big, sizeof(big)), -1);
+
+    write_sequence(WRITES, NULL);
+    kv_stats_t stats;
+    kv_store_get_stats(&stats);
+    CHECK(stats.compactions >= ram->sector_count);
+    CHECK_EQ(stats.generation, stats.compactions);
+    CHECK(!kv_store_pending());
+
+    // An unchanged value is not written again.
+    const uint32_t before = ops;
+    value = WRITES - 1;
+    kv_set(KvKeyCountdownPreset, &value, sizeof(value));
+    CHECK(!kv_store_pending());
+    kv_store_flush();
+    CHECK_EQ(ops, before);
+
+    // Reload from flash.
+    CHECK_EQ(kv_store_init(&port), 0);
+    value = 0;
+    CHECK_EQ(kv_get(KvKeyCountdownPreset, &value, sizeof(value)), sizeof(value));
+    CHECK_EQ(value, WRITES - 1);
+    uint8_t cal[sizeof(calibration)] = {0};
+    CHECK_EQ(kv_get(KvKeyTouchCalibration, cal, sizeof(cal)), sizeof(cal));
+    CHECK(memcmp(cal, calibration, sizeof(cal)) == 0);
+
+    kv_stats_t loaded;
+    kv_store_get_stats(&loaded);
+    CHECK_EQ(loaded.generation, stats.generation);
+    CHECK_EQ(loaded.active_sector, stats.active_sector);
+    CHECK_EQ(loaded.used_bytes, stats.used_bytes);
+    // Formatting took sector 0, every compaction since moved on by one.
+    CHECK_EQ(loaded.active_sector, (stats.compactions - 1) % ram->sector_count);
+}
+
+// Writes go out one record per tick, only when idle.
+static void test_tick()
+{
+    blank_flash();
+    kv_store_init(&port);
+    const uint32_t preset = 30;
+    const uint32_t timer[3] = {1, 2, 3};
+    kv_set(KvKeyCountdownPreset, &preset, sizeof(preset));
+    kv_set(KvKeyTimerState, timer, sizeof(timer));
+
+    tick_kv_store(false);
+    CHECK_EQ(ops, 0);
+    CHECK(kv_store_pending());
+    for (int i = 0; i < 4 && kv_store_pending(); i++) {
+        tick_kv_store(true);
+    }
+    CHECK(!kv_store_pending());
+
+    kv_store_init(&port);
+    uint32_t value = 0;
+    CHECK_EQ(kv_get(KvKeyCountdownPreset, &value, sizeof(value)), sizeof(value));
+    CHECK_EQ(value, preset);
+}
+
+// The power goes at every point of the sequence in turn.
+static void test_power_cuts()
+{
+    static uint32_t ops_after[WRITES];
+    const uint32_t sweep = 600;   // Past the first compaction of a full sector
+    blank_flash();
+    write_sequence(sweep, ops_after);
+    const uint32_t total = ops;
+    kv_stats_t stats;
+    kv_store_get_stats(&stats);
+    CHECK(stats.compactions >= 2);
+
+    host_sdk_stats_t before;
+    host_sdk_get_stats(&before);
+    uint32_t failures = 0;
+    for (uint32_t cut = ops_after[0]; cut < total; cut++) {
+        blank_flash();
+        kv_flash_ram_cut_power(cut);
+        write_sequence(sweep, NULL);
+        kv_flash_ram_restore_power();
+
+        // Complete writes survive, the one in progress may or may not have made it.
+        uint32_t complete = 0;
+        while (complete + 1 < sweep && ops_after[complete + 1] <= cut) {
+            complete++;
+        }
+        kv_store_init(&port);
+        uint32_t value = UINT32_MAX;
+        uint8_t cal[sizeof(calibration)] = {0};
+        const bool ok = kv_get(KvKeyCountdownPreset, &value, sizeof(value)) == sizeof(value) &&
+                        (value == complete || value == complete + 1) &&
+                        kv_get(KvKeyTouchCalibration, cal, sizeof(cal)) == sizeof(cal) &&
+                        memcmp(cal, calibration, sizeof(cal)) == 0;
+        if (!ok && failures++ < 5) {
+            printf("power cut after %d ops: preset %d, expected %d or %d\n", (int)cut, (int)value, (int)complete,
+                   (int)complete + 1);
+        }
+
+        // And the store carries on from there.
+        const uint32_t next = 1000;
+        kv_set(KvKeyCountdownPreset, &next, sizeof(next));
+        kv_store_flush();
+        kv_store_init(&port);
+        value = 0;
+        kv_get(KvKeyCountdownPreset, &value, sizeof(value));
+        if (value != next && failures++ < 5) {
+            printf("power cut after %d ops: no write after recovery\n", (int)cut);
+        }
+    }
+    CHECK_EQ(failures, 0);
+
+    // Torn records are reported on the UART, never as an error.
+    host_sdk_stats_t after;
+    host_sdk_get_stats(&after);
+    CHECK_EQ(after.uart_error_lines, before.uart_error_lines);
+}
+
+int main()
+{
+    host_sdk_reset();
+    stdio_init_all();
+    ram = kv_flash_ram_port();
+    port = *ram;
+    port.program = counted_program;
+    port.erase = counted_erase;
+
+    test_round_trip();
+    test_tick();
+    test_power_cuts();
+    return test_result("test_kv_store");
+}
@@ -0,0 +1,195 @@
+// lcd_pio.c on the host PIO: the bytes and DCX levels the ST7789 would latch, decoded from
+// the pin waveform on the SCK rising edges while CSn is low, the SCK rate per divider, and
+// when the driver reports the transfer done against when the last bit is out.
+
+#include "lcd_pio.h"
+#include "host_sdk.h"
+#include "test.h"
+#include "hardware/pio.h"
+#include "pico/time.h"
+
+#include <string.h>
+
+// As wired in pins.h
+#define PIN_LCD_DCX    (3)
+#define PIN_LCD_CSn    (17)
+#define PIN_LCD_SCK    (18)
+#define PIN_LCD_TX     (19)
+
+#define WIRE_MAX_BYTES (128)
+
+// What the panel sees.
+static struct {
+    uint32_t pins;
+    uint32_t shift;
+    uint32_t bits;
+    uint8_t bytes[WIRE_MAX_BYTES];
+    bool dcx[WIRE_MAX_BYTES];
+    uint32_t count;
+    uint32_t packets;            // CSn rising edges
+    uint64_t last_rise_ns;
+    uint64_t min_sck_ns;         // Shortest SCK period
+    uint64_t csn_high_ns;
+    uint64_t min_csn_high_ns;    // Shortest CSn high time between packets
+    uint64_t last_bit_ns;        // Last SCK rising edge
+} wire;
+
+static uint32_t done_calls = 0;
+
+static bool pin(uint32_t pins, uint gpio)
+{
+    return (pins >> gpio) & 1u;
+}
+
+static void on_pins(uint64_t at_ns, uint32_t pins)
+{
+    const uint32_t before = wire.pins;
+    wire.pins = pins;
+
+    if (pin(pins, PIN_LCD_CSn) && !pin(before, PIN_LCD_CSn)) {
+        wire.packets++;
+        wire.csn_high_ns = at_ns;
+    }
+    if (!pin(pins, PIN_LCD_CSn) && pin(before, PIN_LCD_CSn) && wire.packets) {
+        const uint64_t high_ns = at_ns - wire.csn_high_ns;
+        wire.min_csn_high_ns = (!wire.min_csn_high_ns || high_ns < wire.min_csn_high_ns) ? high_ns : wire.min_csn_high_ns;
+    }
+
+    if (!pin(pins, PIN_LCD_SCK) || pin(before, PIN_LCD_SCK) || pin(pins, PIN_LCD_CSn)) {
+        return;
+    }
+    if (wire.bits) {
+        const uint64_t period_ns = at_ns - wire.last_rise_ns;
+        wire.min_sck_ns = (!wire.min_sck_ns || period_ns < wire.min_sck_ns) ? period_ns : wire.min_sck_ns;
+    }
+    wire.last_rise_ns = at_ns;
+    wire.last_bit_ns = at_ns;
+    wire.shift = (wire.shift << 1) | pin(pins, PIN_LCD_TX);
+    if (++wire.bits % 8 == 0 && wire.count < WIRE_MAX_BYTES) {
+        wire.dcx[wire.count] = pin(pins, PIN_LCD_DCX);
+        wire.bytes[wire.count++] = (uint8_t)wire.shift;
+    }
+}
+
+static void wire_reset()
+{
+    const uint32_t pins = wire.pins;
+    memset(&wire, 0, sizeof(wire));
+    wire.pins = pins;
+}
+
+static void on_done(void *ctx)
+{
+    (void)ctx;
+    done_calls++;
+}
+
+static uint64_t now_ns()
+{
+    return time_us_64() * 1000;
+}
+
+static void test_command()
+{
+    wire_reset();
+    const uint8_t cmd = 0x2a;
+    const uint8_t params[] = {0x00, 0x00, 0x00, 0xef};
+    lcd_pio_write_cmd(&cmd, 1, params, sizeof(params));
+
+    // Out and CSn high by the time it returns, without asking lcd_pio_busy().
+    CHECK_EQ(wire.count, 5);
+    CHECK(wire.last_bit_ns <= now_ns());
+    CHECK(pin(wire.pins, PIN_LCD_CSn));
+    CHECK_EQ(wire.packets, 2);
+    CHECK(!lcd_pio_busy());
+
+    const uint8_t expected[] = {0x2a, 0x00, 0x00, 0x00, 0xef};
+    for (uint32_t i = 0; i < sizeof(expected); i++) {
+        CHECK_EQ(wire.bytes[i], expected[i]);
+        CHECK_EQ(wire.dcx[i], i > 0);
+    }
+
+    // Two state machine cycles per bit at clk_sys / 1, CSn high for five between packets.
+    CHECK_EQ(lcd_pio_get_sck_hz(), 62500000);
+    CHECK_EQ(wire.min_sck_ns, 16);
+    CHECK(wire.min_csn_high_ns >= 40);
+}
+
+static void test_pixels()
+{
+    wire_reset();
+    done_calls = 0;
+    const uint8_t cmd = 0x2c;
+    static const uint16_t pixels[] = {0x1234, 0xabcd, 0xf800, 0x07e0, 0x001f, 0xffff, 0x0000, 0x8001,
+                                      0x5a5a, 0xa5a5, 0x0f0f, 0xf0f0};
+    const uint32_t n = sizeof(pixels) / sizeof(pixels[0]);
+    lcd_pio_write_pixels(&cmd, 1, pixels, n, on_done, NULL);
+    CHECK(lcd_pio_busy());
+
+    // The DMA is done and the FIFO empty while the last pixel is still on the wire.
+    while (!pio_sm_is_tx_fifo_empty(pio0, 0) || !done_calls) {
+    }
+    CHECK_EQ(done_calls, 1);
+    CHECK(wire.count < 1 + 2 * n);
+    CHECK(lcd_pio_busy());
+
+    while (lcd_pio_busy()) {
+    }
+    CHECK_EQ(wire.count, 1 + 2 * n);
+    CHECK(pin(wire.pins, PIN_LCD_CSn));
+    CHECK_EQ(wire.bytes[0], 0x2c);
+    CHECK_EQ(wire.dcx[0], false);
+    for (uint32_t i = 0; i < n; i++) {
+        CHECK_EQ((wire.bytes[1 + 2 * i] << 8) | wire.bytes[2 + 2 * i], pixels[i]);
+        CHECK_EQ(wire.dcx[1 + 2 * i] && wire.dcx[2 + 2 * i], true);
+    }
+}
+
+// A command queued behind pixels waits for the DMA and goes out after them.
+static void test_command_after_pixels()
+{
+    wire_reset();
+    done_calls = 0;
+    const uint8_t ramwr = 0x2c;
+    static const uint16_t pixels[32] = {0};
+    lcd_pio_write_pixels(&ramwr, 1, pixels, 32, on_done, NULL);
+    const uint8_t dispoff = 0x28;
+    lcd_pio_write_cmd(&dispoff, 1, NULL, 0);
+
+    CHECK_EQ(done_calls, 1);
+    CHECK_EQ(wire.count, 1 + 2 * 32 + 1);
+    CHECK_EQ(wire.bytes[wire.count - 1], 0x28);
+    CHECK_EQ(wire.dcx[wire.count - 1], false);
+    CHECK(!lcd_pio_busy());
+}
+
+static void test_clkdiv()
+{
+    lcd_pio_set_clkdiv(2);
+    CHECK_EQ(lcd_pio_get_sck_hz(), 31250000);
+
+    wire_reset();
+    const uint8_t cmd = 0x29;
+    lcd_pio_write_cmd(&cmd, 1, NULL, 0);
+    CHECK_EQ(wire.count, 1);
+    CHECK_EQ(wire.bytes[0], 0x29);
+    CHECK_EQ(wire.min_sck_ns, 32);
+    lcd_pio_set_clkdiv(1);
+}
+
+int main()
+{
+    host_sdk_reset();
+    host_pio_on_pins(on_pins);
+    lcd_pio_init(PIN_LCD_TX, PIN_LCD_CSn, PIN_LCD_SCK, PIN_LCD_DCX);
+
+    test_command();
+    test_pixels();
+    test_command_after_pixels();
+    test_clkdiv();
+
+    host_sdk_stats_t stats;
+    host_sdk_get_stats(&stats);
+    CHECK_EQ(stats.asserts, 0);
+    return test_result("lcd_pio");
+}
@@ -0,0 +1,292 @@
+// power_manager.c against a scripted port: when it sleeps, what it sleeps until, how each
+// wake is counted and what the wake up is measured against.
+
+#include "power_manager.h"
+#include "test.h"
+
+#include <string.h>
+
+#define MS   (1000ull)
+#define S    (1000ull * 1000ull)
+
+// The port: a clock, the UI's answers and the wakes sleep_until() returns, in order.
+static uint64_t now_us;
+static uint32_t idle_ms;
+static bool busy;
+static uint64_t deadline_us;
+static uint64_t service_us;
+static uint32_t resume_cost_us;
+
+static power_wake_t wake_script[8];
+static size_t wake_count;
+static uint64_t slept_until[8];
+static size_t sleeps;
+
+static uint32_t suspends;
+static uint32_t resumes;
+static uint32_t services;
+static power_wake_t resumed_by;
+
+static uint64_t port_now_us()
+{
+    return now_us;
+}
+
+static uint32_t port_idle_ms()
+{
+    return idle_ms;
+}
+
+static bool port_busy()
+{
+    return busy;
+}
+
+static uint64_t port_next_deadline_us()
+{
+    return deadline_us;
+}
+
+static uint64_t port_next_service_us()
+{
+    return service_us;
+}
+
+static void port_service()
+{
+    services++;
+    service_us += 60 * S;
+}
+
+static void port_suspend_ui()
+{
+    suspends++;
+    now_us += 2 * MS;
+}
+
+static void port_resume_ui(power_wake_t wake)
+{
+    resumes++;
+    resumed_by = wake;
+    now_us += resume_cost_us;
+}
+
+// Deadline wakes happen at the time asked for, the others a second into the sleep.
+static power_wake_t port_sleep_until(uint64_t wake_us)
+{
+    slept_until[sleeps] = wake_us;
+    const power_wake_t wake = (sleeps < wake_count) ? wake_script[sleeps] : PowerWakeTouch;
+    sleeps++;
+    now_us = (wake == PowerWakeDeadline && wake_us) ? wake_us : now_us + 1 * S;
+    return wake;
+}
+
+static const power_port_t port = {
+    .now_us = port_now_us,
+    .idle_ms = port_idle_ms,
+    .busy = port_busy,
+    .next_deadline_us = port_next_deadline_us,
+    .suspend_ui = port_suspend_ui,
+    .resume_ui = port_resume_ui,
+    .next_service_us = port_next_service_us,
+    .service = port_service,
+    .sleep_until = port_sleep_until,
+};
+
+static const power_config_t config = {.idle_timeout_ms = 30000, .wake_budget_us = 20000};
+
+static void start(const power_wake_t *wakes, size_t count)
+{
+    now_us = 1000 * S;
+    idle_ms = 0;
+    busy = false;
+    deadline_us = 0;
+    service_us = 0;
+    resume_cost_us = 5 * MS;
+    if (count) {
+        memcpy(wake_script, wakes, count * sizeof(wakes[0]));
+    }
+    wake_count = count;
+    sleeps = 0;
+    suspends = 0;
+    resumes = 0;
+    services = 0;
+    power_manager_init(&port, &config);
+}
+
+static void test_idle_timeout()
+{
+    const power_wake_t wakes[] = {PowerWakeTouch};
+    start(wakes, 1);
+
+    idle_ms = config.idle_timeout_ms - 1;
+    tick_power_manager();
+    CHECK_EQ(suspends, 0);
+    CHECK_EQ(power_manager_state(), PowerActive);
+
+    idle_ms = config.idle_timeout_ms;
+    tick_power_manager();
+    CHECK_EQ(suspends, 1);
+    CHECK_EQ(resumes, 1);
+    CHECK_EQ(resumed_by, PowerWakeTouch);
+    CHECK_EQ(slept_until[0], 0);
+    CHECK_EQ(power_manager_state(), PowerActive);
+
+    power_stats_t stats;
+    power_manager_get_stats(&stats);
+    CHECK_EQ(stats.sleeps, 1);
+    CHECK_EQ(stats.wakes_touch, 1);
+}
+
+static void test_never_sleeps_without_timeout()
+{
+    const power_config_t never = {.idle_timeout_ms = 0, .wake_budget_us = 20000};
+    start(NULL, 0);
+    power_manager_init(&port, &never);
+    idle_ms = UINT32_MAX;
+    tick_power_manager();
+    CHECK_EQ(suspends, 0);
+}
+
+static void test_busy_veto()
+{
+    start(NULL, 0);
+    idle_ms = config.idle_timeout_ms;
+    busy = true;
+    tick_power_manager();
+    CHECK_EQ(suspends, 0);
+
+    busy = false;
+    tick_power_manager();
+    CHECK_EQ(suspends, 1);
+}
+
+// A deadline 100 ms away or closer is not worth the display going off and on.
+static void test_deadline_guard()
+{
+    const power_wake_t wakes[] = {PowerWakeDeadline};
+    start(wakes, 1);
+    idle_ms = config.idle_timeout_ms;
+
+    deadline_us = now_us + 100 * MS;
+    tick_power_manager();
+    CHECK_EQ(suspends, 0);
+
+    deadline_us = now_us + 100 * MS + 1;
+    const uint64_t expected_us = deadline_us;
+    tick_power_manager();
+    CHECK_EQ(suspends, 1);
+    CHECK_EQ(slept_until[0], expected_us);
+    CHECK_EQ(resumed_by, PowerWakeDeadline);
+}
+
+static void test_wake_sources()
+{
+    const power_wake_t wakes[] = {PowerWakeOther, PowerWakeOther, PowerWakeDeadline};
+    start(wakes, 3);
+    idle_ms = config.idle_timeout_ms;
+    deadline_us = now_us + 10 * S;
+    tick_power_manager();
+
+    power_stats_t stats;
+    power_manager_get_stats(&stats);
+    CHECK_EQ(sleeps, 3);
+    CHECK_EQ(stats.sleeps, 1);
+    CHECK_EQ(stats.wakes_other, 2);
+    CHECK_EQ(stats.wakes_deadline, 1);
+    CHECK_EQ(stats.wakes_touch, 0);
+    CHECK_EQ(resumes, 1);
+    CHECK_EQ(resumed_by, PowerWakeDeadline);
+}
+
+// Background work before the deadline gets its own wakes, without the UI.
+static void test_service_wakes()
+{
+    const power_wake_t wakes[] = {PowerWakeDeadline, PowerWakeDeadline, PowerWakeTouch};
+    start(wakes, 3);
+    idle_ms = config.idle_timeout_ms;
+    deadline_us = now_us + 150 * S;
+    service_us = now_us + 60 * S;
+    const uint64_t first_service_us = service_us;
+    tick_power_manager();
+
+    power_stats_t stats;
+    power_manager_get_stats(&stats);
+    CHECK_EQ(services, 2);
+    CHECK_EQ(stats.wakes_service, 2);
+    CHECK_EQ(stats.wakes_touch, 1);
+    CHECK_EQ(stats.wakes_deadline, 0);
+    CHECK_EQ(slept_until[0], first_service_us);
+    CHECK_EQ(slept_until[1], first_service_us + 60 * S);
+    CHECK_EQ(slept_until[2], deadline_us);   // The next service is past the deadline
+    CHECK_EQ(resumes, 1);
+    CHECK_EQ(resumed_by, PowerWakeTouch);
+
+    // With the countdown stopped the service is the only thing to wake for.
+    const power_wake_t stopped[] = {PowerWakeDeadline, PowerWakeTouch};
+    start(stopped, 2);
+    idle_ms = config.idle_timeout_ms;
+    service_us = now_us + 60 * S;
+    const uint64_t stopped_service_us = service_us;
+    tick_power_manager();
+    CHECK_EQ(slept_until[0], stopped_service_us);
+    CHECK_EQ(services, 1);
+}
+
+// The wake up runs from the wake to the UI being back, budget misses are counted.
+static void test_wake_budget()
+{
+    const power_wake_t wakes[] = {PowerWakeTouch, PowerWakeTouch};
+    start(wakes, 2);
+    idle_ms = config.idle_timeout_ms;
+
+    resume_cost_us = config.wake_budget_us;
+    tick_power_manager();
+    power_stats_t stats;
+    power_manager_get_stats(&stats);
+    CHECK_EQ(stats.wake_us_max, config.wake_budget_us);
+    CHECK_EQ(stats.wake_over_budget, 0);
+
+    resume_cost_us = config.wake_budget_us + 1;
+    tick_power_manager();
+    power_manager_get_stats(&stats);
+    CHECK_EQ(stats.wake_us_max, config.wake_budget_us + 1);
+    CHECK_EQ(stats.wake_over_budget, 1);
+}
+
+// Every microsecond is in exactly one state.
+static void test_state_times()
+{
+    const power_wake_t wakes[] = {PowerWakeOther, PowerWakeDeadline};
+    start(wakes, 2);
+    const uint64_t start_us = now_us;
+    idle_ms = config.idle_timeout_ms;
+    deadline_us = now_us + 5 * S;
+    now_us += 3 * S;
+    tick_power_manager();
+    now_us += 1 * S;
+
+    power_stats_t stats;
+    power_manager_get_stats(&stats);
+    uint64_t sum_us = 0;
+    for (int i = 0; i < PowerStateCount; i++) {
+        sum_us += stats.state_us[i];
+    }
+    CHECK_EQ(sum_us, now_us - start_us);
+    CHECK_EQ(stats.state_us[PowerSuspending], 2 * MS);
+    CHECK_EQ(stats.state_us[PowerWaking], resume_cost_us);
+    CHECK_EQ(stats.state_us[PowerSleep], deadline_us - (start_us + 3 * S + 2 * MS));
+}
+
+int main()
+{
+    test_idle_timeout();
+    test_never_sleeps_without_timeout();
+    test_busy_veto();
+    test_deadline_guard();
+    test_wake_sources();
+    test_service_wakes();
+    test_wake_budget();
+    test_state_times();
+    return test_result("test_power_manager");
+}
@@ -0,0 +1,215 @@
+// shell.c on a fake UART port: line editing, unknown commands, help printed a line at a time
+// as the transmit ring drains, and the ring full with input left waiting and shell_write()
+// all or nothing. The fake TX FIFO takes a set number of bytes per write, none while stalled.
+
+#include "shell.h"
+#include "host_sdk.h"
+#include "test.h"
+#include "pico/stdlib.h"
+
+#include <string.h>
+
+#define OUT_SIZE        (8192)
+#define HELP_COMMANDS   (9)   // The default build's commands
+#define TICKS_MAX       (1000)
+
+static const char *input = "";
+static uint32_t reads = 0;
+
+static char out[OUT_SIZE];
+static size_t out_len = 0;
+static size_t fifo_room = SIZE_MAX;   // Bytes the TX FIFO takes per write
+
+static int fake_read_char()
+{
+    reads++;
+    return *input ? (unsigned char)*input++ : -1;
+}
+
+static size_t fake_write(const char *data, size_t len)
+{
+    const size_t n = len < fifo_room ? len : fifo_room;
+    memcpy(&out[out_len], data, n);
+    out_len += n;
+    return n;
+}
+
+static uint64_t fake_now_us()
+{
+    return 0;
+}
+
+static const shell_port_t fake_port = {
+    .read_char = fake_read_char,
+    .write = fake_write,
+    .now_us = fake_now_us,
+};
+
+static void clear_out()
+{
+    out_len = 0;
+    memset(out, 0, sizeof(out));
+}
+
+// Ticks until the input is read and the output has stopped changing.
+static void run(const char *text)
+{
+    input = text;
+    size_t last_len = SIZE_MAX;
+    for (int i = 0; i < TICKS_MAX && (*input || out_len != last_len); i++) {
+        last_len = out_len;
+        shell_tick();
+    }
+}
+
+static bool out_is(const char *expected)
+{
+    const bool same = out_len == strlen(expected) && memcmp(out, expected, out_len) == 0;
+    if (!same) {
+        printf("output '%.*s', expected '%s'\n", (int)out_len, out, expected);
+    }
+    clear_out();
+    return same;
+}
+
+static int count(const char *s)
+{
+    int n = 0;
+    for (const char *p = out; (p = strstr(p, s)) != NULL; p++) {
+        n++;
+    }
+    return n;
+}
+
+static void test_line_editing()
+{
+    run("resez\b\x7f" "et\r");
+    CHECK(out_is("resez\b \b\b \bet\r\ncounters reset\r\n> "));
+
+    // Backspace on an empty line, control characters and DEL's neighbours do nothing.
+    run("\b\x01\x1b\xff\r");
+    CHECK(out_is("\r\n> "));
+
+    // The line keeps SHELL_LINE_SIZE - 1 characters, the rest is not echoed.
+    char long_line[SHELL_LINE_SIZE + 10];
+    memset(long_line, 'x', SHELL_LINE_SIZE + 8);
+    long_line[SHELL_LINE_SIZE + 8] = '\r';
+    long_line[SHELL_LINE_SIZE + 9] = '\0';
+    run(long_line);
+    CHECK_EQ(out_len, (SHELL_LINE_SIZE - 1) + strlen("\r\nunknown command, try help\r\n> "));
+    clear_out();
+
+    // A line ends at CR or LF, each on its own.
+    run("\n");
+    CHECK(out_is("\r\n> "));
+}
+
+static void test_unknown()
+{
+    run("helpme\r");
+    CHECK(out_is("helpme\r\nunknown command, try help\r\n> "));
+    run("HELP\r");
+    CHECK(out_is("HELP\r\nunknown command, try help\r\n> "));
+    run(" help\r");
+    CHECK(out_is(" help\r\nunknown command, try help\r\n> "));
+}
+
+// Help goes out a line per tick, only once a whole line fits the ring. Stalled, the ring
+// fills and input waits; drained, the rest follows with nothing lost or repeated.
+static void test_help_pagination()
+{
+    run("help\r");
+    CHECK_EQ(count("\r\n"), 1 + HELP_COMMANDS);
+    static const char first[] = "help\r\nhelp     list commands\r\n";
+    CHECK(strncmp(out, first, sizeof(first) - 1) == 0);
+    CHECK(out_len >= 2 && strcmp(&out[out_len - 2], "> ") == 0);
+    const size_t help_len = out_len;
+    char help_out[OUT_SIZE];
+    memcpy(help_out, out, out_len);
+    clear_out();
+
+    // A line of output per tick.
+    input = "help\r";
+    for (int i = 0; i < 4; i++) {
+        shell_tick();
+    }
+    CHECK_EQ(count("\r\n"), 1 + 4);
+    run("");
+    CHECK_EQ(out_len, help_len);
+    CHECK(memcmp(out, help_out, help_len) == 0);
+    clear_out();
+
+    // Three times over with the FIFO stalled: the second help stops where a line no longer
+    // fits the ring, the third waits in the FIFO.
+    fifo_room = 0;
+    input = "help\rhelp\rhelp\r";
+    for (int i = 0; i < 50; i++) {
+        shell_tick();
+    }
+    CHECK_EQ(out_len, 0);
+    CHECK(strcmp(input, "help\r") == 0);
+
+    // Drained a few bytes at a time, the ring wraps.
+    fifo_room = 7;
+    run(input);
+    fifo_room = SIZE_MAX;
+    CHECK_EQ(*input, '\0');
+    CHECK_EQ(out_len, 3 * help_len);
+    for (int i = 0; i < 3; i++) {
+        CHECK(memcmp(&out[i * help_len], help_out, help_len) == 0);
+    }
+    clear_out();
+}
+
+// shell_write() takes everything or nothing, and a full ring leaves input in the FIFO.
+static void test_full_ring()
+{
+    fifo_room = 0;
+    uint8_t frame[100];
+    for (size_t i = 0; i < sizeof(frame); i++) {
+        frame[i] = (uint8_t)i;
+    }
+    int frames = 0;
+    while (shell_write(frame, sizeof(frame))) {
+        frames++;
+    }
+    CHECK_EQ(frames, SHELL_TX_BUFFER_SIZE / sizeof(frame));
+    CHECK(shell_write(frame, SHELL_TX_BUFFER_SIZE % sizeof(frame)));
+    CHECK(!shell_write(frame, 1));
+
+    const uint32_t reads_before = reads;
+    input = "help\r";
+    for (int i = 0; i < 10; i++) {
+        shell_tick();
+    }
+    CHECK_EQ(reads, reads_before);
+    CHECK_EQ(out_len, 0);
+
+    fifo_room = 3;
+    run(input);
+    fifo_room = SIZE_MAX;
+    for (int f = 0; f < frames; f++) {
+        CHECK(memcmp(&out[f * sizeof(frame)], frame, sizeof(frame)) == 0);
+    }
+    const size_t frames_len = SHELL_TX_BUFFER_SIZE;
+    CHECK(memcmp(&out[frames_len - SHELL_TX_BUFFER_SIZE % sizeof(frame)], frame, SHELL_TX_BUFFER_SIZE % sizeof(frame)) == 0);
+    CHECK(strncmp(&out[frames_len], "help\r\nhelp ", 11) == 0);
+    clear_out();
+}
+
+int main()
+{
+    host_sdk_reset();
+    stdio_init_all();
+
+    CHECK(!shell_write("x", 1));   // No port yet
+    shell_init(&fake_port);
+    shell_tick();
+    CHECK(out_is("\r\n> "));
+
+    test_line_editing();
+    test_unknown();
+    test_help_pagination();
+    test_full_ring();
+    return test_result("test_shell");
+}
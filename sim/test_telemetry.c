@@ -0,0 +1,226 @@
+// telemetry.c's framing: the CRC against the CRC-16/CCITT-FALSE check value, COBS round trips
+// through zeros and runs of 254 bytes and more, and records whose CRC no longer matches after
+// a flipped bit.
+//
+// With file names, also writes what test_telemetry_decode.py reads back through
+// tools/telemetry_decode.py:
+//   capture   records seq 0 to 9 as the firmware sends them, seq 10 with its CRC corrupted,
+//             seq 11 with a byte flipped on the wire, shell text run into seq 12, then a long
+//             run frame that is no record
+//   vectors   <u16 payload length> <payload> <u16 frame length> <frame> for each COBS payload
+//
+//   test_telemetry [capture vectors]
+
+#include "crc16.h"
+#include "telemetry.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define PAYLOAD_MAX   (1024)
+#define FRAME_MAX     (PAYLOAD_MAX + PAYLOAD_MAX / 254 + 2)
+
+// Reference decoder, as telemetry_decode.py's. Returns the length, or -1 on a bad code.
+static int cobs_decode(const uint8_t *frame, size_t len, uint8_t *out)
+{
+    size_t n = 0;
+    size_t i = 0;
+    while (i < len) {
+        const uint8_t code = frame[i];
+        if (code == 0 || i + code > len) {
+            return -1;
+        }
+        memcpy(&out[n], &frame[i + 1], code - 1);
+        n += code - 1;
+        i += code;
+        if (code < 0xFF && i < len) {
+            out[n++] = 0;
+        }
+    }
+    return (int)n;
+}
+
+typedef enum {
+    PatternZeros,
+    PatternNonZero,   // 1 to 255, no zeros
+    PatternMixed,     // 0 to 255
+} pattern_t;
+
+typedef struct {
+    pattern_t pattern;
+    size_t len;
+} payload_t;
+
+static const payload_t payloads[] = {
+    {PatternZeros, 0},
+    {PatternZeros, 1},
+    {PatternZeros, 2},
+    {PatternZeros, 300},
+    {PatternNonZero, 253},
+    {PatternNonZero, 254},
+    {PatternNonZero, 255},
+    {PatternNonZero, 508},
+    {PatternNonZero, 509},
+    {PatternMixed, 1000},
+};
+
+#define PAYLOAD_COUNT   (sizeof(payloads) / sizeof(payloads[0]))
+
+static size_t make_payload(const payload_t *p, uint8_t *out)
+{
+    for (size_t i = 0; i < p->len; i++) {
+        out[i] = (p->pattern == PatternZeros) ? 0 : (p->pattern == PatternNonZero) ? (uint8_t)(i % 255 + 1) : (uint8_t)i;
+    }
+    return p->len;
+}
+
+static void write_u16(FILE *f, size_t value)
+{
+    fputc((int)(value & 0xFF), f);
+    fputc((int)(value >> 8), f);
+}
+
+static void test_crc()
+{
+    CHECK_EQ(crc16(CRC16_INIT, "123456789", 9), 0x29B1);
+    CHECK_EQ(crc16(CRC16_INIT, NULL, 0), 0xFFFF);
+}
+
+static void test_cobs(FILE *vectors)
+{
+    static uint8_t payload[PAYLOAD_MAX];
+    static uint8_t frame[FRAME_MAX];
+    static uint8_t decoded[PAYLOAD_MAX];
+
+    for (size_t p = 0; p < PAYLOAD_COUNT; p++) {
+        const size_t len = make_payload(&payloads[p], payload);
+        const size_t frame_len = telemetry_cobs_encode(payload, len, frame);
+
+        // One code byte per 254 bytes, at most, and the delimiter.
+        CHECK(frame_len <= len + len / 254 + 2);
+        CHECK_EQ(frame[frame_len - 1], 0);
+        CHECK(memchr(frame, 0, frame_len - 1) == NULL);
+        CHECK_EQ(cobs_decode(frame, frame_len - 1, decoded), (int)len);
+        CHECK(memcmp(decoded, payload, len) == 0);
+
+        if (vectors) {
+            write_u16(vectors, len);
+            fwrite(payload, 1, len, vectors);
+            write_u16(vectors, frame_len);
+            fwrite(frame, 1, frame_len, vectors);
+        }
+    }
+}
+
+// Even records are mostly zero bytes, odd ones have none in the fields.
+static void make_record(uint16_t seq, telemetry_record_t *r)
+{
+    memset(r, (seq & 1) ? 0xA5 : 0, sizeof(*r));
+    r->version = TELEMETRY_VERSION;
+    r->seq = seq;
+}
+
+static bool record_valid(const uint8_t *frame, size_t frame_len, telemetry_record_t *r)
+{
+    uint8_t raw[FRAME_MAX];
+    if (frame_len < 1 || cobs_decode(frame, frame_len - 1, raw) != (int)sizeof(*r) + 2) {
+        return false;
+    }
+    const uint16_t crc = raw[sizeof(*r)] | (raw[sizeof(*r) + 1] << 8);
+    memcpy(r, raw, sizeof(*r));
+    return crc16(CRC16_INIT, raw, sizeof(*r)) == crc;
+}
+
+static void test_records()
+{
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    for (uint16_t seq = 0; seq < 4; seq++) {
+        telemetry_record_t sent;
+        telemetry_record_t received;
+        make_record(seq, &sent);
+        const size_t frame_len = telemetry_encode(&sent, frame);
+        CHECK(frame_len <= TELEMETRY_FRAME_MAX);
+        CHECK(record_valid(frame, frame_len, &received));
+        CHECK(memcmp(&sent, &received, sizeof(sent)) == 0);
+    }
+
+    // The CRC catches every single bit error in the record or in itself.
+    telemetry_record_t r;
+    make_record(1, &r);
+    uint8_t raw[sizeof(r) + 2];
+    memcpy(raw, &r, sizeof(r));
+    const uint16_t crc = crc16(CRC16_INIT, raw, sizeof(r));
+    raw[sizeof(r)] = crc & 0xFF;
+    raw[sizeof(r) + 1] = crc >> 8;
+    int undetected = 0;
+    for (size_t bit = 0; bit < sizeof(raw) * 8; bit++) {
+        raw[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        const size_t frame_len = telemetry_cobs_encode(raw, sizeof(raw), frame);
+        telemetry_record_t received;
+        undetected += record_valid(frame, frame_len, &received);
+        raw[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+    }
+    CHECK_EQ(undetected, 0);
+}
+
+static void write_capture(FILE *f)
+{
+    uint8_t frame[FRAME_MAX];
+    telemetry_record_t r;
+
+    fputs("Boot to first frame: 517 ms\r\n", f);
+    for (uint16_t seq = 0; seq < 10; seq++) {
+        make_record(seq, &r);
+        fwrite(frame, 1, telemetry_encode(&r, frame), f);
+    }
+
+    // The CRC of seq 10 is off by one.
+    make_record(10, &r);
+    uint8_t raw[sizeof(r) + 2];
+    memcpy(raw, &r, sizeof(r));
+    const uint16_t crc = crc16(CRC16_INIT, raw, sizeof(r)) ^ 1;
+    raw[sizeof(r)] = crc & 0xFF;
+    raw[sizeof(r) + 1] = crc >> 8;
+    fwrite(frame, 1, telemetry_cobs_encode(raw, sizeof(raw), frame), f);
+
+    // A byte of seq 11 flipped on the line, never to zero.
+    make_record(11, &r);
+    const size_t len = telemetry_encode(&r, frame);
+    frame[len / 2] ^= (frame[len / 2] == 0x80) ? 0x40 : 0x80;
+    fwrite(frame, 1, len, f);
+
+    // Shell output with no zero byte runs into seq 12.
+    fputs("> stats\r\nloops 1234/s\r\n", f);
+    make_record(12, &r);
+    fwrite(frame, 1, telemetry_encode(&r, frame), f);
+
+    // A valid COBS frame, but of 300 bytes.
+    static uint8_t run[300];
+    memset(run, 0x55, sizeof(run));
+    fwrite(frame, 1, telemetry_cobs_encode(run, sizeof(run), frame), f);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *capture = NULL;
+    FILE *vectors = NULL;
+    if (argc == 3) {
+        capture = fopen(argv[1], "wb");
+        vectors = fopen(argv[2], "wb");
+        if (!capture || !vectors) {
+            printf("test_telemetry: cannot write %s or %s\n", argv[1], argv[2]);
+            return 2;
+        }
+    }
+
+    test_crc();
+    test_cobs(vectors);
+    test_records();
+    if (capture) {
+        write_capture(capture);
+        fclose(capture);
+        fclose(vectors);
+    }
+    return test_result("test_telemetry");
+}
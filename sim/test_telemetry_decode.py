@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""Check tools/telemetry_decode.py against the frames src/telemetry.c encodes.
+
+Reads the two files test_telemetry writes: the COBS vectors, each decoded back to
+its payload, and the capture, which must give records seq 0 to 9 and 12 and skip
+the three frames that are not valid records.
+
+  test_telemetry_decode.py capture.bin vectors.bin
+"""
+
+import argparse
+import csv
+import io
+import os
+import struct
+import subprocess
+import sys
+
+TOOLS = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'tools')
+sys.path.insert(0, TOOLS)
+import telemetry_decode  # noqa: E402
+
+EXPECTED_SEQ = list(range(10)) + [12]
+EXPECTED_SKIPPED = 3
+
+
+def read_vectors(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    i = 0
+    while i < len(data):
+        (n,) = struct.unpack_from('<H', data, i)
+        payload = data[i + 2:i + 2 + n]
+        i += 2 + n
+        (n,) = struct.unpack_from('<H', data, i)
+        frame = data[i + 2:i + 2 + n]
+        i += 2 + n
+        yield payload, frame
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('capture')
+    parser.add_argument('vectors')
+    args = parser.parse_args()
+
+    failures = 0
+    vectors = 0
+    for payload, frame in read_vectors(args.vectors):
+        vectors += 1
+        if frame[-1:] != b'\x00' or b'\x00' in frame[:-1]:
+            print('test_telemetry_decode: FAIL the %d byte payload has a zero inside its frame' % len(payload))
+            failures += 1
+            continue
+        try:
+            decoded = telemetry_decode.cobs_decode(frame[:-1])
+        except ValueError as e:
+            print('test_telemetry_decode: FAIL the %d byte payload: %s' % (len(payload), e))
+            failures += 1
+            continue
+        if decoded != payload:
+            at = next((i for i, (a, b) in enumerate(zip(decoded, payload)) if a != b), min(len(decoded), len(payload)))
+            print('test_telemetry_decode: FAIL the %d byte payload decodes to %d bytes, different from byte %d'
+                  % (len(payload), len(decoded), at))
+            failures += 1
+    if vectors == 0:
+        print('test_telemetry_decode: FAIL no vectors in %s' % args.vectors)
+        failures += 1
+
+    result = subprocess.run([sys.executable, os.path.join(TOOLS, 'telemetry_decode.py'), args.capture],
+                            capture_output=True, text=True)
+    rows = list(csv.DictReader(io.StringIO(result.stdout)))
+    seqs = [int(row['seq']) for row in rows]
+    if result.returncode != 0 or seqs != EXPECTED_SEQ:
+        print('test_telemetry_decode: FAIL records %s, expected %s' % (seqs, EXPECTED_SEQ))
+        failures += 1
+    summary = 'telemetry_decode: %d records, %d frames skipped' % (len(EXPECTED_SEQ), EXPECTED_SKIPPED)
+    if summary not in result.stderr:
+        print('test_telemetry_decode: FAIL "%s", expected "%s"' % (result.stderr.strip(), summary))
+        failures += 1
+
+    print('test_telemetry_decode: %d vectors, %d records: %s' % (vectors, len(rows), 'FAIL' if failures else 'ok'))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
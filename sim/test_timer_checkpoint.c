@@ -0,0 +1,168 @@
+// timer_checkpoint.c with the KV store on the RAM flash image, driven as checkpoint_timer()
+// in display_framework.c drives it: a running countdown costs no checkpoint writes, drift
+// rewrites the RAM copy only, start, stop and set reach the flash, and the countdown comes
+// back from either copy.
+
+#include "timer_checkpoint.h"
+#include "kv_store.h"
+#include "host_sdk.h"
+#include "test.h"
+#include "pico/stdlib.h"
+
+#include <string.h>
+
+#define S    (1000000ull)
+
+static const kv_flash_port_t *ram;
+static kv_flash_port_t port;
+static uint32_t programs = 0;
+
+static bool counted_program(uint32_t offset, const uint8_t *page)
+{
+    programs++;
+    return ram->program(offset, page);
+}
+
+// The UI side: the RAM checkpoint, and the flash copy on a change.
+static timer_checkpoint_t cp;
+static timer_checkpoint_stats_t stats;
+
+static timer_checkpoint_result_t checkpoint(bool started, uint32_t remaining_s, uint64_t now_us)
+{
+    const timer_checkpoint_result_t result = timer_checkpoint_update(&cp, started, remaining_s, now_us, &stats);
+    if (result == TimerCheckpointChanged) {
+        kv_set(KvKeyTimerState, &cp, sizeof(cp));
+    }
+    kv_store_flush();
+    return result;
+}
+
+static void reset_store()
+{
+    for (uint32_t s = 0; s < ram->sector_count; s++) {
+        ram->erase(s * ram->sector_size);
+    }
+    kv_store_init(&port);
+    memset(&cp, 0, sizeof(cp));
+    memset(&stats, 0, sizeof(stats));
+    programs = 0;
+}
+
+static void test_valid()
+{
+    timer_checkpoint_t zero;
+    memset(&zero, 0, sizeof(zero));
+    CHECK(!timer_checkpoint_valid(&zero));
+
+    timer_checkpoint_t c;
+    timer_checkpoint_make(&c, true, 600, 5 * S);
+    CHECK(timer_checkpoint_valid(&c));
+    CHECK_EQ(c.deadline_us, 605 * S);
+    CHECK_EQ(timer_checkpoint_remaining_s(&c, 5 * S), 600);
+    CHECK_EQ(timer_checkpoint_remaining_s(&c, 5 * S + 1), 600);   // Rounded up
+    CHECK_EQ(timer_checkpoint_remaining_s(&c, 6 * S), 599);
+    CHECK_EQ(timer_checkpoint_remaining_s(&c, 700 * S), 0);
+
+    c.deadline_us += 1;
+    CHECK(!timer_checkpoint_valid(&c));
+}
+
+// An hour counting down one second per tick, ticks up to half a second late.
+static void test_steady_state()
+{
+    reset_store();
+    uint64_t now = 10 * S;
+    uint32_t remaining = 3600;
+    CHECK_EQ(checkpoint(true, remaining, now), TimerCheckpointChanged);
+    CHECK_EQ(stats.changes, 1);
+    const uint32_t programs_at_start = programs;
+    CHECK(programs_at_start > 0);
+
+    for (uint32_t tick = 1; tick <= 3600; tick++) {
+        now = 10 * S + tick * S + (tick % 5) * (S / 10);
+        remaining--;
+        CHECK_EQ(checkpoint(true, remaining, now), TimerCheckpointCurrent);
+    }
+    CHECK_EQ(remaining, 0);
+    CHECK_EQ(stats.updates, 3601);
+    CHECK_EQ(stats.changes, 1);
+    CHECK_EQ(stats.drifts, 0);
+    CHECK_EQ(programs, programs_at_start);
+
+    // Stopped, the display holds: no writes either.
+    CHECK_EQ(checkpoint(false, 42, now), TimerCheckpointChanged);
+    const uint32_t programs_stopped = programs;
+    for (uint32_t tick = 1; tick <= 600; tick++) {
+        CHECK_EQ(checkpoint(false, 42, now + tick * S), TimerCheckpointCurrent);
+    }
+    CHECK_EQ(programs, programs_stopped);
+}
+
+// Two seconds between the countdown and its deadline: the RAM checkpoint follows the
+// countdown, the flash copy stays as it is.
+static void test_drift()
+{
+    reset_store();
+    CHECK_EQ(checkpoint(true, 300, 0), TimerCheckpointChanged);
+    const uint32_t programs_at_start = programs;
+
+    CHECK_EQ(checkpoint(true, 299, 1 * S), TimerCheckpointCurrent);
+    CHECK_EQ(checkpoint(true, 299, 2 * S), TimerCheckpointCurrent);   // One second behind
+    CHECK_EQ(checkpoint(true, 299, 3 * S), TimerCheckpointDrift);     // Two
+    CHECK_EQ(cp.deadline_us, 3 * S + 299 * S);
+    CHECK_EQ(checkpoint(true, 298, 4 * S), TimerCheckpointCurrent);
+    CHECK_EQ(stats.drifts, 1);
+    CHECK_EQ(stats.changes, 1);
+    CHECK_EQ(programs, programs_at_start);
+
+    // A jump that is not drift, setting the time while running, is a change.
+    CHECK_EQ(checkpoint(true, 120, 5 * S), TimerCheckpointChanged);
+    CHECK(programs > programs_at_start);
+}
+
+// Warm reset: the RAM copy and the epoch carry on. Power loss: the flash copy gives what was
+// left when it was written.
+static void test_restore()
+{
+    reset_store();
+    CHECK_EQ(checkpoint(true, 900, 100 * S), TimerCheckpointChanged);
+    for (uint32_t tick = 1; tick <= 60; tick++) {
+        checkpoint(true, 900 - tick, 100 * S + tick * S);
+    }
+
+    // Warm: 30 s after the last tick the countdown has gone on.
+    CHECK(timer_checkpoint_valid(&cp));
+    CHECK_EQ(timer_checkpoint_remaining_s(&cp, 190 * S), 810);
+
+    // Power loss: RAM is gone, the store is read back.
+    memset(&cp, 0, sizeof(cp));
+    kv_store_init(&port);
+    timer_checkpoint_t restored;
+    CHECK_EQ(kv_get(KvKeyTimerState, &restored, sizeof(restored)), sizeof(restored));
+    CHECK(timer_checkpoint_valid(&restored));
+    CHECK(restored.started);
+    CHECK_EQ(timer_checkpoint_remaining_s(&restored, restored.saved_us), 900);
+
+    // Stopped with time left.
+    checkpoint(false, 555, 200 * S);
+    kv_store_init(&port);
+    CHECK_EQ(kv_get(KvKeyTimerState, &restored, sizeof(restored)), sizeof(restored));
+    CHECK(timer_checkpoint_valid(&restored));
+    CHECK(!restored.started);
+    CHECK_EQ(timer_checkpoint_remaining_s(&restored, 0), 555);
+}
+
+int main()
+{
+    host_sdk_reset();
+    stdio_init_all();
+    ram = kv_flash_ram_port();
+    port = *ram;
+    port.program = counted_program;
+
+    test_valid();
+    test_steady_state();
+    test_drift();
+    test_restore();
+    return test_result("test_timer_checkpoint");
+}
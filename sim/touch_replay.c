@@ -0,0 +1,378 @@
+// Records and replays touch traces on the host, through the firmware built with TOUCH_TRACE and
+// its debug shell, as tools/touch_trace.py does with the device.
+//
+// record: boots, turns recording on with 'rec on' and taps "set the time to 01:30 and start"
+// on the XPT2046 model: the clock, h+, m+ thirty times, Set and Start, each held 150 ms. The
+// readings read_touch_point() recorded come back with 'dump' and go to a trace file in the
+// format of touch_trace.py.
+//
+// replay: boots, loads a trace with 'tt' lines, plays it with 'play' and reads the touch to
+// event and touch to frame percentiles with 'lat'. Everything runs in virtual time, so a
+// trace gives the same latencies on every run. Fails when a press or release of the trace
+// found no event, when no edge found a frame, or a p99 is over the limit given. An edge that
+// changes nothing on the screen, or comes before the frame of the one before it, has no frame
+// of its own.
+//
+//   touch_replay record set_time.ttr
+//   touch_replay replay set_time.ttr --max-event-us 50000 --max-frame-us 100000
+
+#include "host_board.h"
+#include "host_sdk.h"
+#include "virtual_clock.h"
+
+#include "touch_trace.h"
+#include "ui_layout.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define US_PER_S         (1000000ull)
+#define RUN_MAX_US       (120 * US_PER_S)
+#define SETTLE_US        (US_PER_S)          // After boot, and after the last tap or sample
+#define TAP_HOLD_US      (150 * 1000)
+#define TAP_GAP_US       (600 * 1000)
+#define LAT_RETRY_US     (500 * 1000)
+#define TRACE_HEADER     (8)                 // 'TTR1', the sample count
+#define SAMPLE_BYTES     (8)
+
+int firmware_main();
+
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+} tap_point_t;
+
+static const tap_point_t clock_point = {UI_PROP_SCREEN_WIDTH_PX / 2, UI_LAYOUT_CLOCK_Y + UI_LAYOUT_CLOCK_HEIGHT / 2};
+static const tap_point_t hour_up = {UI_LAYOUT_LEFT_X + UI_LAYOUT_THIRD_WIDTH / 2, UI_LAYOUT_ROW_TOP_Y + UI_LAYOUT_BTN_HEIGHT / 2};
+static const tap_point_t minute_up = {UI_LAYOUT_RIGHT_X + UI_LAYOUT_THIRD_WIDTH / 2, UI_LAYOUT_ROW_TOP_Y + UI_LAYOUT_BTN_HEIGHT / 2};
+static const tap_point_t set_point = {UI_LAYOUT_SET_X + UI_LAYOUT_THIRD_WIDTH / 2, UI_LAYOUT_SET_Y + UI_LAYOUT_BTN_HEIGHT / 2};
+static const tap_point_t start_point = {UI_LAYOUT_MID_X + UI_LAYOUT_BTN_WIDTH / 2, UI_LAYOUT_ROW_TOP_Y + UI_LAYOUT_BTN_HEIGHT / 2};
+
+#define MINUTE_TAPS   (30)
+#define TAP_COUNT     (MINUTE_TAPS + 4)
+
+static bool recording = false;   // record, or replay
+static const char *trace_path = NULL;
+static uint32_t max_event_us = 0;   // 0: not checked
+static uint32_t max_frame_us = 0;
+
+static touch_trace_sample_t samples[TOUCH_TRACE_MAX_SAMPLES];
+static size_t sample_count = 0;   // Recorded, or in the trace file
+static size_t samples_dumped = 0;
+static size_t samples_loaded = 0;
+static size_t tap_next = 0;
+static bool finished = false;
+static touch_latency_t latency[2];   // To event, to frame
+static int latency_lines = 0;
+
+static void send(const char *command)
+{
+    host_uart_rx(command);
+    host_uart_rx("\r");
+}
+
+static int64_t release_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    host_board_touch(false, 0, 0);
+    return 0;
+}
+
+static int64_t rec_off_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    send("rec off");
+    return 0;
+}
+
+static const tap_point_t *tap_at(size_t i)
+{
+    if (i == 0) {
+        return &clock_point;
+    }
+    if (i == 1) {
+        return &hour_up;
+    }
+    if (i < 2 + MINUTE_TAPS) {
+        return &minute_up;
+    }
+    return (i == 2 + MINUTE_TAPS) ? &set_point : &start_point;
+}
+
+static int64_t tap_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    (void)user_data;
+    const tap_point_t *p = tap_at(tap_next++);
+    host_board_touch(true, p->x, p->y);
+    virtual_clock_add_alarm(virtual_clock_now_us() + TAP_HOLD_US, release_cb, NULL);
+    if (tap_next == TAP_COUNT) {
+        virtual_clock_add_alarm(virtual_clock_now_us() + SETTLE_US, rec_off_cb, NULL);
+        return 0;
+    }
+    return (int64_t)TAP_GAP_US;
+}
+
+static int64_t command_cb(virtual_alarm_id_t id, void *user_data)
+{
+    (void)id;
+    send(user_data);
+    return 0;
+}
+
+static void send_sample(size_t i)
+{
+    const touch_trace_sample_t *s = &samples[i];
+    char command[32];
+    snprintf(command, sizeof(command), "tt %02x%02x%02x%02x%02x%02x%02x%02x", (unsigned)(s->t_us & 0xff),
+             (unsigned)(s->t_us >> 8 & 0xff), (unsigned)(s->t_us >> 16 & 0xff), (unsigned)(s->t_us >> 24),
+             (unsigned)(s->raw_x & 0xff), (unsigned)(s->raw_x >> 8), (unsigned)(s->raw_y & 0xff), (unsigned)(s->raw_y >> 8));
+    send(command);
+}
+
+static bool parse_sample(const char *hex, touch_trace_sample_t *s)
+{
+    uint8_t b[SAMPLE_BYTES];
+    for (size_t i = 0; i < SAMPLE_BYTES; i++) {
+        unsigned v;
+        if (sscanf(hex + 2 * i, "%2x", &v) != 1) {
+            return false;
+        }
+        b[i] = (uint8_t)v;
+    }
+    s->t_us = b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+    s->raw_x = (uint16_t)(b[4] | b[5] << 8);
+    s->raw_y = (uint16_t)(b[6] | b[7] << 8);
+    return true;
+}
+
+// Shell output, one line at a time. An echo of a command comes after the prompt, "> ".
+static void record_line(const char *line)
+{
+    unsigned count;
+    if (strcmp(line, "touch recording on, 0 samples") == 0) {
+        virtual_clock_add_alarm(virtual_clock_now_us() + TAP_GAP_US, tap_cb, NULL);
+    }
+    else if (sscanf(line, "touch recording off, %u samples", &count) == 1) {
+        sample_count = count;
+        send("dump");
+    }
+    else if (strncmp(line, "tt ", 3) == 0 && strlen(line) == 3 + 2 * SAMPLE_BYTES && samples_dumped < sample_count) {
+        if (parse_sample(line + 3, &samples[samples_dumped])) {
+            samples_dumped++;
+        }
+        if (samples_dumped == sample_count) {
+            finished = true;
+            host_sdk_stop();
+        }
+    }
+}
+
+// One sample per command, each once the one before is in.
+static void load_next()
+{
+    if (samples_loaded < sample_count) {
+        send_sample(samples_loaded);
+    }
+    else {
+        send("play");
+    }
+}
+
+static void replay_line(const char *line)
+{
+    unsigned loaded;
+    int end = 0;
+    if (strcmp(line, "touch trace cleared") == 0) {
+        load_next();
+    }
+    else if (sscanf(line, "tt %u%n", &loaded, &end) == 1 && line[end] == '\0' && loaded == samples_loaded + 1) {
+        samples_loaded++;
+        load_next();
+    }
+    else if (strstr(line, "touch replay of") == line) {
+        virtual_clock_add_alarm(virtual_clock_now_us() + samples[sample_count - 1].t_us + SETTLE_US, command_cb, "lat");
+    }
+    else if (strcmp(line, "replay still running") == 0) {
+        virtual_clock_add_alarm(virtual_clock_now_us() + LAT_RETRY_US, command_cb, "lat");
+    }
+    else if (strncmp(line, "touch to ", 9) == 0) {
+        touch_latency_t *lat = &latency[strncmp(line + 9, "frame", 5) == 0];
+        if (sscanf(line + 15, " n %u, p50 %u us, p90 %u us, p99 %u us, max %u us", &lat->count, &lat->p50_us,
+                   &lat->p90_us, &lat->p99_us, &lat->max_us) == 5) {
+            printf("touch_replay: %s\n", line);
+            if (++latency_lines == 2) {
+                finished = true;
+                host_sdk_stop();
+            }
+        }
+    }
+}
+
+static void shell_line(const char *line)
+{
+    if (strncmp(line, "Boot to touch ready", 19) == 0) {
+        virtual_clock_add_alarm(virtual_clock_now_us() + SETTLE_US, command_cb, recording ? "rec on" : "tt");
+        return;
+    }
+    if (recording) {
+        record_line(line);
+    }
+    else {
+        replay_line(line);
+    }
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static bool write_trace()
+{
+    FILE *f = fopen(trace_path, "wb");
+    if (!f) {
+        printf("touch_replay: cannot write %s\n", trace_path);
+        return false;
+    }
+    uint8_t header[TRACE_HEADER] = {'T', 'T', 'R', '1'};
+    put_u32(header + 4, (uint32_t)sample_count);
+    fwrite(header, 1, sizeof(header), f);
+    for (size_t i = 0; i < sample_count; i++) {
+        uint8_t b[SAMPLE_BYTES];
+        put_u32(b, samples[i].t_us);
+        b[4] = (uint8_t)samples[i].raw_x;
+        b[5] = (uint8_t)(samples[i].raw_x >> 8);
+        b[6] = (uint8_t)samples[i].raw_y;
+        b[7] = (uint8_t)(samples[i].raw_y >> 8);
+        fwrite(b, 1, sizeof(b), f);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool read_trace()
+{
+    FILE *f = fopen(trace_path, "rb");
+    if (!f) {
+        printf("touch_replay: cannot open %s\n", trace_path);
+        return false;
+    }
+    uint8_t header[TRACE_HEADER];
+    const bool ok = fread(header, 1, sizeof(header), f) == sizeof(header) && memcmp(header, "TTR1", 4) == 0;
+    sample_count = ok ? (header[4] | (uint32_t)header[5] << 8 | (uint32_t)header[6] << 16 | (uint32_t)header[7] << 24) : 0;
+    if (!ok || sample_count == 0 || sample_count > TOUCH_TRACE_MAX_SAMPLES) {
+        printf("touch_replay: %s: not a touch trace of 1 to %d samples\n", trace_path, TOUCH_TRACE_MAX_SAMPLES);
+        fclose(f);
+        return false;
+    }
+    for (size_t i = 0; i < sample_count; i++) {
+        uint8_t b[SAMPLE_BYTES];
+        if (fread(b, 1, sizeof(b), f) != sizeof(b)) {
+            printf("touch_replay: %s: truncated, %d samples expected\n", trace_path, (int)sample_count);
+            fclose(f);
+            return false;
+        }
+        samples[i].t_us = b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+        samples[i].raw_x = (uint16_t)(b[4] | b[5] << 8);
+        samples[i].raw_y = (uint16_t)(b[6] | b[7] << 8);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool parse_args(int argc, char **argv)
+{
+    if (argc < 3 || (strcmp(argv[1], "record") != 0 && strcmp(argv[1], "replay") != 0)) {
+        return false;
+    }
+    recording = strcmp(argv[1], "record") == 0;
+    trace_path = argv[2];
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--max-event-us") == 0) {
+            max_event_us = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--max-frame-us") == 0) {
+            max_frame_us = (uint32_t)strtoul(argv[i + 1], NULL, 10);
+        }
+        else {
+            return false;
+        }
+    }
+    return (argc % 2) == 1;
+}
+
+static void run_firmware()
+{
+    firmware_main();
+}
+
+int main(int argc, char **argv)
+{
+    if (!parse_args(argc, argv)) {
+        printf("usage: touch_replay record|replay <trace> [--max-event-us N] [--max-frame-us N]\n");
+        return 2;
+    }
+    if (!recording && !read_trace()) {
+        return 2;
+    }
+
+    host_sdk_reset();
+    host_board_reset();
+    host_uart_on_line(shell_line);
+    host_sdk_run(run_firmware, RUN_MAX_US);
+
+    int failures = 0;
+    if (!finished) {
+        printf("touch_replay: FAIL no %s after %d s\n", recording ? "complete dump" : "latencies",
+               (int)(RUN_MAX_US / US_PER_S));
+        failures++;
+    }
+    else if (recording) {
+        // A press and at least one pen up reading per tap.
+        printf("touch_replay: %d samples over %.1f s\n", (int)sample_count, samples[sample_count - 1].t_us / 1e6);
+        if (sample_count < 2 * TAP_COUNT) {
+            printf("touch_replay: FAIL %d samples for %d taps\n", (int)sample_count, TAP_COUNT);
+            failures++;
+        }
+        else if (!write_trace()) {
+            failures++;
+        }
+    }
+    else {
+        // The XPT2046 reads 0 with the pen up.
+        uint32_t edges = 0;
+        for (size_t i = 0; i < sample_count; i++) {
+            const bool down = samples[i].raw_x || samples[i].raw_y;
+            const bool was_down = i > 0 && (samples[i - 1].raw_x || samples[i - 1].raw_y);
+            edges += down != was_down;
+        }
+        if (latency[0].count != edges || latency[1].count == 0) {
+            printf("touch_replay: FAIL %d edges, %d reached an event, %d a frame\n", (int)edges, (int)latency[0].count,
+                   (int)latency[1].count);
+            failures++;
+        }
+        if (max_event_us && latency[0].p99_us > max_event_us) {
+            printf("touch_replay: FAIL touch to event p99 %d us, limit %d us\n", (int)latency[0].p99_us, (int)max_event_us);
+            failures++;
+        }
+        if (max_frame_us && latency[1].p99_us > max_frame_us) {
+            printf("touch_replay: FAIL touch to frame p99 %d us, limit %d us\n", (int)latency[1].p99_us, (int)max_frame_us);
+            failures++;
+        }
+    }
+
+    host_sdk_stats_t stats;
+    host_sdk_get_stats(&stats);
+    if (stats.uart_error_lines || stats.asserts) {
+        printf("touch_replay: FAIL %d ERROR lines, %d asserts\n", (int)stats.uart_error_lines, (int)stats.asserts);
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
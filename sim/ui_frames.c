@@ -0,0 +1,70 @@
+// Boots the firmware built with UI_FRAME_CAPTURE on the host and writes its frame capture,
+// the 'fc' lines of src/frame_capture.c, to a file for tools/frame_check.py. display_framework.c
+// renders every UI state (idle, running, expired, set_time) in its boot step, the flushes go
+// through LVGL to the ST7789 model. Stops once the capture is done.
+//
+//   ui_frames capture.txt && tools/frame_check.py capture.txt --golden sim/golden/lvgl
+
+#include "host_board.h"
+#include "host_sdk.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define US_PER_S          (1000000ull)
+#define CAPTURE_MAX_US    (300 * US_PER_S)   // The capture goes out at 115200 baud
+
+int firmware_main();
+
+static FILE *out = NULL;
+static uint32_t lines = 0;
+static int scenes = -1;   // From 'fc done'
+
+static void capture_line(const char *line)
+{
+    if (strncmp(line, "fc ", 3) != 0) {
+        return;
+    }
+    fprintf(out, "%s\n", line);
+    lines++;
+    if (sscanf(line, "fc done %d", &scenes) == 1) {
+        host_sdk_stop();
+    }
+}
+
+static void run_firmware()
+{
+    firmware_main();
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        printf("usage: ui_frames <capture file>\n");
+        return 2;
+    }
+    out = fopen(argv[1], "w");
+    if (!out) {
+        printf("ui_frames: cannot write %s\n", argv[1]);
+        return 2;
+    }
+
+    host_sdk_reset();
+    host_board_reset();
+    host_uart_on_line(capture_line);
+    host_sdk_run(run_firmware, CAPTURE_MAX_US);
+    fclose(out);
+
+    host_sdk_stats_t stats;
+    host_sdk_get_stats(&stats);
+    if (scenes < 0) {
+        printf("ui_frames: FAIL no complete capture after %d s\n", (int)(CAPTURE_MAX_US / US_PER_S));
+        return 1;
+    }
+    printf("ui_frames: %d scenes, %d lines written to %s\n", scenes, (int)lines, argv[1]);
+    if (stats.uart_error_lines || stats.asserts) {
+        printf("ui_frames: FAIL %d ERROR lines, %d asserts\n", (int)stats.uart_error_lines, (int)stats.asserts);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "virtual_clock.h"
+
+#include <stddef.h>
+#include <string.h>
+
+typedef struct {
+    virtual_alarm_id_t id;   // 0 while the slot is free
+    uint64_t at_us;
+    virtual_alarm_cb_t cb;
+    void *user_data;
+} alarm_slot_t;
+
+static alarm_slot_t alarms[VIRTUAL_CLOCK_MAX_ALARMS];
+static virtual_alarm_id_t next_id = 1;
+static uint64_t now_us = 0;
+static virtual_clock_stats_t stats;
+static bool firing = false;   // Inside an alarm callback
+
+void virtual_clock_reset()
+{
+    memset(alarms, 0, sizeof(alarms));
+    memset(&stats, 0, sizeof(stats));
+    next_id = 1;
+    now_us = 0;
+    firing = false;
+}
+
+uint64_t virtual_clock_now_us()
+{
+    return now_us;
+}
+
+virtual_alarm_id_t virtual_clock_add_alarm(uint64_t at_us, virtual_alarm_cb_t cb, void *user_data)
+{
+    for (size_t i = 0; i < VIRTUAL_CLOCK_MAX_ALARMS; i++) {
+        if (alarms[i].id == 0) {
+            alarms[i] = (alarm_slot_t){.id = next_id, .at_us = at_us, .cb = cb, .user_data = user_data};
+            next_id = (next_id == INT32_MAX) ? 1 : next_id + 1;
+            return alarms[i].id;
+        }
+    }
+    return 0;
+}
+
+bool virtual_clock_cancel(virtual_alarm_id_t id)
+{
+    for (size_t i = 0; id > 0 && i < VIRTUAL_CLOCK_MAX_ALARMS; i++) {
+        if (alarms[i].id == id) {
+            alarms[i].id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+static alarm_slot_t *earliest()
+{
+    alarm_slot_t *first = NULL;
+    for (size_t i = 0; i < VIRTUAL_CLOCK_MAX_ALARMS; i++) {
+        if (alarms[i].id != 0 && (!first || alarms[i].at_us < first->at_us)) {
+            first = &alarms[i];
+        }
+    }
+    return first;
+}
+
+uint64_t virtual_clock_next_alarm_us()
+{
+    const alarm_slot_t *first = earliest();
+    return first ? first->at_us : UINT64_MAX;
+}
+
+static void move_to(uint64_t t_us, uint32_t category)
+{
+    if (t_us > now_us) {
+        stats.category_us[category % VIRTUAL_CLOCK_MAX_CATEGORIES] += t_us - now_us;
+        now_us = t_us;
+    }
+}
+
+// Fires every alarm due by now, including ones a callback schedules for now.
+static bool fire_due()
+{
+    bool fired = false;
+    alarm_slot_t *slot;
+    if (firing) {
+        return false;
+    }
+    while ((slot = earliest()) && slot->at_us <= now_us) {
+        const virtual_alarm_id_t id = slot->id;
+        const uint64_t due_us = slot->at_us;
+        firing = true;
+        const int64_t again = slot->cb(id, slot->user_data);
+        firing = false;
+        stats.alarms_fired++;
+        fired = true;
+
+        // The callback may have cancelled its own alarm and the slot been reused.
+        if (slot->id != id) {
+            continue;
+        }
+        if (again > 0) {
+            slot->at_us = now_us + (uint64_t)again;
+        }
+        else if (again < 0) {
+            slot->at_us = due_us + (uint64_t)(-again);
+        }
+        else {
+            slot->id = 0;
+        }
+    }
+    return fired;
+}
+
+void virtual_clock_run(uint64_t us, uint32_t category)
+{
+    const uint64_t end_us = now_us + us;
+    while (!firing && virtual_clock_next_alarm_us() <= end_us) {
+        move_to(virtual_clock_next_alarm_us(), category);
+        fire_due();
+    }
+    move_to(end_us, category);
+}
+
+bool virtual_clock_wait(uint64_t until_us, uint32_t category)
+{
+    if (fire_due()) {
+        return true;
+    }
+    const uint64_t next_us = virtual_clock_next_alarm_us();
+    if (next_us > until_us) {
+        if (until_us != UINT64_MAX) {
+            move_to(until_us, category);
+        }
+        return false;
+    }
+    move_to(next_us, category);
+    return fire_due();
+}
+
+void virtual_clock_get_stats(virtual_clock_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,47 @@
+#ifndef _VIRTUAL_CLOCK_H
+#define _VIRTUAL_CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Discrete event clock for the host simulator. Time only moves when the simulated firmware
+// spends it: CPU work is charged with virtual_clock_run(), and a sleeping or idle loop jumps
+// straight to the next pending alarm. Alarms follow the SDK's alarm callback convention and
+// fire at their exact time, like the timer interrupt preempting the main loop would.
+
+#define VIRTUAL_CLOCK_MAX_ALARMS       (32)
+#define VIRTUAL_CLOCK_MAX_CATEGORIES   (8)
+
+typedef int32_t virtual_alarm_id_t;   // > 0, or 0 when no slot is free
+
+// As for add_alarm_at(): return 0 for a one shot alarm, > 0 to fire again that many us after
+// now, < 0 to fire again that many us after the time it was due (a repeating timer).
+typedef int64_t (*virtual_alarm_cb_t)(virtual_alarm_id_t id, void *user_data);
+
+typedef struct {
+    uint64_t category_us[VIRTUAL_CLOCK_MAX_CATEGORIES];   // Where the time went
+    uint32_t alarms_fired;
+} virtual_clock_stats_t;
+
+void virtual_clock_reset();
+uint64_t virtual_clock_now_us();
+
+virtual_alarm_id_t virtual_clock_add_alarm(uint64_t at_us, virtual_alarm_cb_t cb, void *user_data);
+bool virtual_clock_cancel(virtual_alarm_id_t id);
+
+// Due time of the earliest alarm, UINT64_MAX if none is pending.
+uint64_t virtual_clock_next_alarm_us();
+
+// Spends us of CPU time in category. Alarms falling due meanwhile fire on time. Called from
+// inside an alarm callback the time only moves, alarms due by then fire once the callback has
+// returned, as a lower priority interrupt waits for the running one.
+void virtual_clock_run(uint64_t us, uint32_t category);
+
+// Idles in category until until_us or until an alarm has fired, whichever is first. Returns
+// true if an alarm fired. With no alarm pending and until_us UINT64_MAX nothing would ever
+// wake the core, the clock does not move and false is returned.
+bool virtual_clock_wait(uint64_t until_us, uint32_t category);
+
+void virtual_clock_get_stats(virtual_clock_stats_t *stats);
+
+#endif   // _VIRTUAL_CLOCK_H
@@ -0,0 +1,105 @@
+#include "backlight.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+
+#include <stdio.h>
+
+// The DMA writes 16 bit entries to the 32 bit compare register. The bus replicates them into
+// both halves, which sets channel B as well; only channel A drives a pin.
+
+static uint16_t ramp_up[BACKLIGHT_LEVEL_MAX + 1];
+static uint16_t ramp_down[BACKLIGHT_LEVEL_MAX + 1];
+
+static backlight_config_t config;
+static uint32_t slice = 0;
+static uint32_t channel = 0;
+static int dma_chan = -1;
+
+static uint8_t level = 0;        // Level set, or the end of the fade in progress
+static bool fade_up = false;
+
+static uint8_t current_level()
+{
+    if (dma_chan < 0 || !dma_channel_is_busy(dma_chan)) {
+        return level;
+    }
+
+    // Part way through a fade: the remaining transfers are the steps not taken yet.
+    const uint32_t left = dma_channel_hw_addr(dma_chan)->transfer_count;
+    return fade_up ? (uint8_t)(level - left) : (uint8_t)(level + left);
+}
+
+void backlight_init(uint32_t gpio, const backlight_config_t *cfg)
+{
+    config = *cfg;
+
+    for (uint32_t i = 0; i <= BACKLIGHT_LEVEL_MAX; i++) {
+        ramp_up[i] = backlight_gamma((uint8_t)i);
+        ramp_down[i] = backlight_gamma((uint8_t)(BACKLIGHT_LEVEL_MAX - i));
+    }
+
+    gpio_set_function(gpio, GPIO_FUNC_PWM);
+    slice = pwm_gpio_to_slice_num(gpio);
+    channel = pwm_gpio_to_channel(gpio);
+
+    pwm_config pwm = pwm_get_default_config();
+    pwm_config_set_wrap(&pwm, BACKLIGHT_PWM_WRAP);
+    pwm_config_set_clkdiv(&pwm, (float)clock_get_hz(clk_sys) / ((BACKLIGHT_PWM_WRAP + 1) * BACKLIGHT_PWM_HZ));
+    pwm_init(slice, &pwm, false);
+    pwm_set_chan_level(slice, channel, 0);
+    pwm_set_enabled(slice, true);
+
+    dma_chan = dma_claim_unused_channel(false);
+    if (dma_chan < 0) {
+        printf("Backlight: no DMA channel, fades are immediate.\n\r");
+        return;
+    }
+
+    dma_channel_config dma = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&dma, DMA_SIZE_16);
+    channel_config_set_read_increment(&dma, true);
+    channel_config_set_write_increment(&dma, false);
+    channel_config_set_dreq(&dma, pwm_get_dreq(slice));
+    dma_channel_configure(dma_chan, &dma, &pwm_hw->slice[slice].cc, ramp_up, 0, false);
+}
+
+void backlight_set_clkdiv16(uint32_t div16)
+{
+    pwm_set_clkdiv_int_frac(slice, (uint8_t)(div16 >> 4), (uint8_t)(div16 & 0xf));
+}
+
+void backlight_set(uint8_t target, bool fade)
+{
+    const uint8_t from = current_level();
+    if (dma_chan >= 0) {
+        dma_channel_abort(dma_chan);
+    }
+
+    bool up;
+    uint32_t first;
+    uint32_t count;
+    if (fade && dma_chan >= 0 && backlight_fade_plan(from, target, &up, &first, &count)) {
+        level = target;
+        fade_up = up;
+        dma_channel_transfer_from_buffer_now(dma_chan, up ? &ramp_up[first] : &ramp_down[first], count);
+    }
+    else {
+        level = target;
+        pwm_set_chan_level(slice, channel, ramp_up[target]);
+    }
+}
+
+uint8_t backlight_level()
+{
+    return current_level();
+}
+
+void tick_backlight(uint32_t idle_ms)
+{
+    const uint8_t target = backlight_policy_level(&config, idle_ms);
+    if (target != level) {
+        backlight_set(target, target < level);
+    }
+}
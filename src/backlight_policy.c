@@ -0,0 +1,44 @@
+#include "backlight.h"
+
+#include <math.h>
+
+// The policy and the ramp arithmetic, without hardware access, so they can be checked on
+// a host against the PWM side in backlight.c.
+
+uint8_t backlight_policy_level(const backlight_config_t *config, uint32_t idle_ms)
+{
+    if (config->off_after_ms && idle_ms >= config->off_after_ms) {
+        return 0;
+    }
+    if (config->dim_after_ms && idle_ms >= config->dim_after_ms) {
+        return config->dim;
+    }
+    return config->bright;
+}
+
+uint16_t backlight_gamma(uint8_t level)
+{
+    const float x = (float)level / BACKLIGHT_LEVEL_MAX;
+    return (uint16_t)(powf(x, 2.2f) * BACKLIGHT_PWM_WRAP + 0.5f);
+}
+
+// The rising ramp holds every level in order, the falling ramp the same backwards, so entry
+// i of the falling ramp is level BACKLIGHT_LEVEL_MAX - i. A fade starts one step away from
+// the current level and ends on the target.
+bool backlight_fade_plan(uint8_t from, uint8_t to, bool *up, uint32_t *first, uint32_t *count)
+{
+    if (from == to) {
+        return false;
+    }
+
+    *up = (to > from);
+    if (*up) {
+        *first = from + 1u;
+        *count = to - from;
+    }
+    else {
+        *first = BACKLIGHT_LEVEL_MAX - from + 1u;
+        *count = from - to;
+    }
+    return true;
+}
@@ -1,8 +1,15 @@
 #include "battery_monitor.h"
 #include "hardware/adc.h"
+#include "metrics.h"
 
 #include <stdio.h>
 
+// 12 bit ADC against the 3.3 V rail. The battery is read straight on GPIO26, adjust the
+// divider if one is fitted.
+#define ADC_REF_MV          (3300)
+#define ADC_MAX_READING     (4096)
+#define BATTERY_DIVIDER     (1)
+
 int battery_monitor_cnt = 0;
 static int prev_cnt = 0;
 
@@ -18,8 +25,13 @@ void tick_battery_monitor()
     if (prev_cnt != battery_monitor_cnt)
     {
         prev_cnt = battery_monitor_cnt;
-        // Sample the ADC to check the battery health.
-        const uint16_t result = adc_read();
-        printf("ADC reading: %d\n", result);
+        battery_monitor_sample();
     }
+}
+
+void battery_monitor_sample()
+{
+    // Sample the ADC to check the battery health.
+    const uint16_t result = adc_read();
+    metrics_battery(result, ((uint32_t)result * ADC_REF_MV * BATTERY_DIVIDER) / ADC_MAX_READING);
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "bench.h"
+#include "hardware/clocks.h"
+#include "pico/time.h"
+
+#include <stdio.h>
+
+#ifdef HOT_PATHS_IN_SRAM
+#define BENCH_HOT_PATHS   "true"
+#else
+#define BENCH_HOT_PATHS   "false"
+#endif
+
+#ifdef LCD_TRANSPORT_PIO
+#define BENCH_LCD_TRANSPORT   "pio"
+#else
+#define BENCH_LCD_TRANSPORT   "spi"
+#endif
+
+static uint64_t (*cpu_clock)() = NULL;
+
+void bench_header()
+{
+    printf("bench {\"build\": {\"clk_sys_hz\": %d, \"hot_paths_in_sram\": %s, \"lcd_transport\": \"%s\", "
+           "\"draw_buf_lines\": %d}}\n\r", (int)clock_get_hz(clk_sys), BENCH_HOT_PATHS, BENCH_LCD_TRANSPORT,
+           (int)LCD_DRAW_BUF_LINES);
+}
+
+void bench_report(const char *name, uint32_t iterations, uint64_t total_us, uint64_t bytes)
+{
+    const uint32_t ns_per_op = iterations ? (uint32_t)(total_us * 1000 / iterations) : 0;
+    const uint32_t bytes_per_s = total_us ? (uint32_t)(bytes * 1000000 / total_us) : 0;
+    printf("bench {\"name\": \"%s\", \"iterations\": %d, \"total_us\": %d, \"ns_per_op\": %d, \"bytes_per_s\": %d}\n\r",
+           name, (int)iterations, (int)total_us, (int)ns_per_op, (int)bytes_per_s);
+}
+
+void bench_done()
+{
+    printf("bench {\"done\": true}\n\r");
+}
+
+void bench_set_cpu_clock(uint64_t (*now_us)())
+{
+    cpu_clock = now_us;
+}
+
+uint64_t bench_cpu_us()
+{
+    return cpu_clock ? cpu_clock() : time_us_64();
+}
@@ -0,0 +1,135 @@
+#include "boot_sequencer.h"
+#include "pico/time.h"
+
+#include <stdio.h>
+
+// Cooperative boot scheduler. Each subsystem declares its init steps as a track, with the
+// delay it needs after each step (e.g. the LCD reset pulse and the 120 ms wake-up time).
+// Instead of sleeping through those delays, the sequencer runs steps of the other tracks.
+
+#define BOOT_MAX_TRACKS      (4)
+#define BOOT_MILESTONE_CNT   (8)
+
+typedef struct {
+    const boot_step_t *steps;
+    size_t count;
+    size_t next;
+    uint64_t not_before_us;
+    bool running;
+} boot_track_t;
+
+static boot_track_t tracks[BOOT_MAX_TRACKS];
+static size_t track_count = 0;
+static uint32_t milestones = 0;
+static uint32_t milestone_ms[BOOT_MILESTONE_CNT];
+
+void boot_sequencer_add_track(const boot_step_t *steps, size_t count)
+{
+    if (track_count >= BOOT_MAX_TRACKS) {
+        printf("ERROR: Too many boot tracks.\n\r");
+        return;
+    }
+
+    tracks[track_count++] = (boot_track_t){.steps = steps, .count = count};
+}
+
+void boot_sequencer_reach(uint32_t reached)
+{
+    const uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    for (int i = 0; i < BOOT_MILESTONE_CNT; i++) {
+        if ((reached & (1u << i)) && !(milestones & (1u << i))) {
+            milestone_ms[i] = now_ms;
+        }
+    }
+    milestones |= reached;
+}
+
+bool boot_sequencer_reached(uint32_t wanted)
+{
+    return (milestones & wanted) == wanted;
+}
+
+uint32_t boot_sequencer_reached_at_ms(uint32_t wanted)
+{
+    if (!boot_sequencer_reached(wanted)) {
+        return 0;
+    }
+
+    uint32_t at_ms = 0;
+    for (int i = 0; i < BOOT_MILESTONE_CNT; i++) {
+        if ((wanted & (1u << i)) && milestone_ms[i] > at_ms) {
+            at_ms = milestone_ms[i];
+        }
+    }
+    return at_ms;
+}
+
+static bool is_ready(const boot_track_t *track, const uint64_t now_us)
+{
+    return !track->running && track->next < track->count && now_us >= track->not_before_us &&
+           boot_sequencer_reached(track->steps[track->next].requires);
+}
+
+// Runs one ready step. Returns false if no step could run.
+static bool run_one()
+{
+    const uint64_t now_us = time_us_64();
+
+    for (size_t i = 0; i < track_count; i++) {
+        boot_track_t *track = &tracks[i];
+        if (!is_ready(track, now_us)) {
+            continue;
+        }
+
+        const boot_step_t *step = &track->steps[track->next];
+        track->running = true;
+        step->fn();
+        track->running = false;
+        track->next++;
+        track->not_before_us = time_us_64() + step->delay_after_us;
+        boot_sequencer_reach(step->provides);
+        printf("Boot: %s done at %d us\n\r", step->name, (int)time_us_32());
+        return true;
+    }
+
+    return false;
+}
+
+static bool all_done()
+{
+    for (size_t i = 0; i < track_count; i++) {
+        if (tracks[i].next < tracks[i].count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void boot_sequencer_run()
+{
+    while (!all_done()) {
+        if (!run_one()) {
+            // Check for a step that can never run, otherwise just wait for a delay to expire.
+            bool waiting = false;
+            for (size_t i = 0; i < track_count; i++) {
+                const boot_track_t *track = &tracks[i];
+                if (track->next < track->count && boot_sequencer_reached(track->steps[track->next].requires)) {
+                    waiting = true;
+                }
+            }
+
+            if (!waiting) {
+                printf("ERROR: Boot sequence is stuck, milestones: 0x%02x\n\r", milestones);
+                return;
+            }
+        }
+    }
+}
+
+void boot_sequencer_wait_us(uint32_t us)
+{
+    const uint64_t deadline_us = time_us_64() + us;
+    while (time_us_64() < deadline_us) {
+        run_one();
+    }
+}
@@ -0,0 +1,134 @@
+#include "clock_governor.h"
+
+#ifdef CLOCK_GOVERNOR
+
+#include "backlight.h"
+#include "hardware/clocks.h"
+#include "hardware/spi.h"
+#include "hardware/structs/systick.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "pico/time.h"
+
+#ifdef LCD_TRANSPORT_PIO
+#include "lcd_pio.h"
+#endif
+
+#include <stdio.h>
+
+// A render burst is a few ms; holding the boost a little longer avoids stepping down and up
+// again between the flushes of one frame.
+#define CLOCK_BOOST_HOLD_US   (50 * 1000)
+
+static clock_plan_t plans[CLOCK_STEP_COUNT];
+static bool enabled = false;
+static size_t idle_step = 0;
+static size_t step = 0;
+static uint64_t step_since_us = 0;
+static uint64_t boost_until_us = 0;
+static clock_governor_stats_t stats;
+
+void clock_governor_init(uint32_t idle_hz)
+{
+    if (clock_get_hz(clk_sys) != CLOCK_PLL_SYS_HZ) {
+        printf("Clock governor: clk_sys is %d Hz, not %d, disabled.\n\r", (int)clock_get_hz(clk_sys), (int)CLOCK_PLL_SYS_HZ);
+        return;
+    }
+
+    for (size_t i = 0; i < CLOCK_STEP_COUNT; i++) {
+        const bool ok = clock_plan_make(clock_step_hz(i), &plans[i]);
+        if (ok && plans[i].sys_hz >= idle_hz) {
+            idle_step = i;
+        }
+        if (!ok) {
+            printf("Clock governor: %d Hz cannot keep the peripherals in spec.\n\r", (int)plans[i].sys_hz);
+            break;
+        }
+    }
+
+    enabled = (idle_step > 0);
+    step_since_us = time_us_64();
+    printf("Clock governor: %d Hz idle, %d Hz busy\n\r", (int)plans[idle_step].sys_hz, (int)plans[0].sys_hz);
+}
+
+static bool transfers_in_flight()
+{
+#ifdef LCD_TRANSPORT_PIO
+    if (lcd_pio_busy()) {
+        return true;
+    }
+#endif
+    return spi_is_busy(spi0) || spi_is_busy(spi1);
+}
+
+static void set_step(const size_t next)
+{
+    // Characters still in the FIFO would go out at the wrong baud rate.
+    uart_tx_wait_blocking(uart_default);
+    while (transfers_in_flight());
+
+    const uint32_t start_us = time_us_32();
+    const clock_plan_t *plan = &plans[next];
+
+    // clk_sys only changes its divider, the PLL keeps running. clk_peri has no divider and
+    // follows; clock_configure() records the new rate for the baud rate calculations.
+    const uint32_t irq_state = save_and_disable_interrupts();
+    clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX,
+                    CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS, CLOCK_PLL_SYS_HZ, plan->sys_hz);
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLK_SYS, plan->sys_hz, plan->sys_hz);
+    systick_hw->rvr = plan->systick_reload;
+    restore_interrupts(irq_state);
+
+#ifdef LCD_TRANSPORT_PIO
+    lcd_pio_set_clkdiv(plan->lcd_pio_div);
+#else
+    spi_set_baudrate(spi0, CLOCK_LCD_SPI_HZ);
+#endif
+    spi_set_baudrate(spi1, CLOCK_TOUCH_SPI_HZ);
+    uart_set_baudrate(uart_default, CLOCK_UART_BAUD);
+    backlight_set_clkdiv16(plan->backlight_div16);
+
+    const uint32_t took_us = time_us_32() - start_us;
+    const uint64_t now_us = time_us_64();
+    stats.step_us[step] += now_us - step_since_us;
+    step_since_us = now_us;
+    step = next;
+
+    stats.transitions++;
+    stats.latency_us_sum += took_us;
+    stats.latency_us_max = (took_us > stats.latency_us_max) ? took_us : stats.latency_us_max;
+}
+
+void clock_governor_boost()
+{
+    if (!enabled) {
+        return;
+    }
+
+    boost_until_us = time_us_64() + CLOCK_BOOST_HOLD_US;
+    if (step != 0) {
+        set_step(0);
+    }
+}
+
+void tick_clock_governor(bool interactive)
+{
+    if (!enabled) {
+        return;
+    }
+
+    if (interactive) {
+        clock_governor_boost();
+    }
+    else if (step != idle_step && time_us_64() >= boost_until_us && !transfers_in_flight()) {
+        set_step(idle_step);
+    }
+}
+
+void clock_governor_get_stats(clock_governor_stats_t *out)
+{
+    *out = stats;
+    out->step_us[step] += time_us_64() - step_since_us;
+}
+
+#endif   // CLOCK_GOVERNOR
@@ -0,0 +1,72 @@
+#include "clock_plan.h"
+
+uint32_t clock_step_hz(size_t step)
+{
+    return (step < CLOCK_STEP_COUNT) ? CLOCK_PLL_SYS_HZ >> step : 0;
+}
+
+// Same search as spi_set_baudrate(): smallest even prescaler, then the largest rate not
+// above the one asked for.
+uint32_t clock_spi_rate(uint32_t peri_hz, uint32_t baud)
+{
+    uint32_t prescale;
+    for (prescale = 2; prescale <= 254; prescale += 2) {
+        if (peri_hz < (uint64_t)prescale * 256 * baud) {
+            break;
+        }
+    }
+    if (prescale > 254) {
+        return 0;
+    }
+
+    uint32_t postdiv;
+    for (postdiv = 256; postdiv > 1; --postdiv) {
+        if (peri_hz / (prescale * (postdiv - 1)) > baud) {
+            break;
+        }
+    }
+    return peri_hz / (prescale * postdiv);
+}
+
+// Same divider as uart_set_baudrate(): 16.6 fixed point, rounded.
+uint32_t clock_uart_rate(uint32_t peri_hz, uint32_t baud)
+{
+    const uint32_t div = (uint32_t)((8ull * peri_hz / baud) + 1);
+    uint32_t ibrd = div >> 7;
+    uint32_t fbrd;
+    if (ibrd == 0) {
+        ibrd = 1;
+        fbrd = 0;
+    }
+    else if (ibrd >= 65535) {
+        ibrd = 65535;
+        fbrd = 0;
+    }
+    else {
+        fbrd = (div & 0x7f) >> 1;
+    }
+    return (uint32_t)((4ull * peri_hz) / (64 * ibrd + fbrd));
+}
+
+bool clock_plan_make(uint32_t sys_hz, clock_plan_t *plan)
+{
+    plan->sys_hz = sys_hz;
+    plan->systick_reload = sys_hz / CLOCK_TICK_HZ - 1;
+    plan->lcd_spi_hz = clock_spi_rate(sys_hz, CLOCK_LCD_SPI_HZ);
+    plan->touch_spi_hz = clock_spi_rate(sys_hz, CLOCK_TOUCH_SPI_HZ);
+    plan->uart_baud = clock_uart_rate(sys_hz, CLOCK_UART_BAUD);
+
+    plan->lcd_pio_div = (sys_hz + 2 * CLOCK_LCD_PIO_MAX_SCK_HZ - 1) / (2 * CLOCK_LCD_PIO_MAX_SCK_HZ);
+    plan->lcd_pio_div = plan->lcd_pio_div ? plan->lcd_pio_div : 1;
+    plan->lcd_pio_sck_hz = sys_hz / (2 * plan->lcd_pio_div);
+
+    plan->backlight_div16 = (uint32_t)((16ull * sys_hz) / (CLOCK_BACKLIGHT_PWM_TOP * CLOCK_BACKLIGHT_PWM_HZ));
+
+    const uint32_t uart_error = (plan->uart_baud > CLOCK_UART_BAUD) ? plan->uart_baud - CLOCK_UART_BAUD
+                                                                    : CLOCK_UART_BAUD - plan->uart_baud;
+    return plan->systick_reload > 0 && plan->systick_reload <= 0xffffff &&
+           uart_error * 50 <= CLOCK_UART_BAUD &&
+           plan->lcd_spi_hz > 0 && plan->lcd_spi_hz <= CLOCK_LCD_SPI_HZ &&
+           plan->touch_spi_hz <= CLOCK_TOUCH_SPI_HZ && plan->touch_spi_hz * 2 >= CLOCK_TOUCH_SPI_HZ &&
+           plan->backlight_div16 >= 16 && plan->backlight_div16 < 256 * 16;
+}
@@ -1,4 +1,6 @@
 #include "tick_count.h"
+#include "hot_path.h"
+#include "perf_counters.h"
 #include "hardware/structs/systick.h"
 
 static uint32_t tick_count = 0;
@@ -16,7 +18,8 @@ void setup_isr()
     systick->rvr = 124999;
 }
 
-extern void isr_systick()
+extern void HOT_PATH_FUNC(isr_systick)()
 {
-    tick_count++; 
-}
\ No newline at end of file
+    perf_counters_isr_entry();
+    tick_count++;
+}
@@ -1,13 +1,44 @@
 #include "debug_messages.h"
+#include "hardware/uart.h"
+#include "pico/time.h"
+#include "shell.h"
 #include <stdio.h>
 
 int32_t debug_msg_flush_count;
-static int32_t prev_debug_msg_flush_count = 0;
+
+// The shell shares the stdio UART. Writes only go out while the TX FIFO has room.
+static int uart_read_char()
+{
+    return uart_is_readable(uart_default) ? (int)uart_getc(uart_default) : -1;
+}
+
+static size_t uart_write(const char *data, size_t len)
+{
+    size_t sent = 0;
+    while (sent < len && uart_is_writable(uart_default)) {
+        uart_putc_raw(uart_default, data[sent++]);
+    }
+    return sent;
+}
+
+static uint64_t uart_now_us()
+{
+    return time_us_64();
+}
+
+static const shell_port_t uart_port = {
+    .read_char = uart_read_char,
+    .write = uart_write,
+    .now_us = uart_now_us,
+};
 
 void check_for_messages()
 {
-    if (prev_debug_msg_flush_count != debug_msg_flush_count) {
-        prev_debug_msg_flush_count = debug_msg_flush_count;
-        printf("Hello!\n\r");
+    static bool started = false;
+    if (!started) {
+        started = true;
+        shell_init(&uart_port);
     }
-}
\ No newline at end of file
+
+    shell_tick();
+}
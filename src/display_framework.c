@@ -1,15 +1,34 @@
 #include <src/misc/lv_color.h>
 #include <src/misc/lv_palette.h>
 #include <stdio.h>
+#include <string.h>
+#include "backlight.h"
+#include "bench.h"
+#include "boot_sequencer.h"
+#include "clock_governor.h"
 #include "display_framework.h"
+#include "frame_capture.h"
+#include "glyph_cache.h"
+#include "hot_path.h"
+#include "kv_store.h"
+#include "metrics.h"
+#include "slab_alloc.h"
 #include "lvgl.h"
 #include "hardware/gpio.h"
 #include "hardware/spi.h"
 #include "pico/time.h"
 #include "pins.h"
+#include "refresh_policy.h"
 #include "tick_count.h"
+#include "ui_layout.h"
 #include "ui_properties.h"
+#include "timer_checkpoint.h"
 #include "touch_screen.h"
+#include "touch_trace.h"
+
+#ifdef LCD_TRANSPORT_PIO
+#include "lcd_pio.h"
+#endif
 
 
 // IMPROVEMENTS:
@@ -21,6 +40,11 @@
 static const bool LCD_CMD = false;
 static const bool LCD_DATA = true;
 
+static const uint8_t ST7789_SLPIN = 0x10;
+static const uint8_t ST7789_SLPOUT = 0x11;
+static const uint8_t ST7789_DISPOFF = 0x28;
+static const uint8_t ST7789_DISPON = 0x29;
+
 static const int HR_INCR = 1;
 static const int HR_DECR = 2;
 static const int MIN_INCR = 3;
@@ -34,13 +58,47 @@ static int min_decr_event = MIN_DECR;
 static int set_time_event = SET_TIME;
 
 // Pending DMA transfer on SPI bus
-static bool pending_xfer = false;
+static volatile bool pending_xfer = false;
 
 static lv_display_t *lcd_disp = NULL;
 static lv_indev_t *touch_panel = NULL;
 
-static const uint32_t LCD_H_RES = 240;
-static const uint32_t LCD_V_RES = 320;
+static const uint32_t LCD_H_RES = UI_PROP_SCREEN_WIDTH_PX;
+static const uint32_t LCD_V_RES = UI_PROP_SCREEN_HEIGHT_PX;
+
+// No touch for this long and no flush in flight counts as idle.
+#define UI_IDLE_MS   (1000)
+
+// Display refresh timer: LV_DEF_REFR_PERIOD while touched or animating, falling back to one
+// run a second. A touch within the last REFRESH_ACTIVE_MS counts as interaction.
+#define REFRESH_ACTIVE_MS        (100)
+#define REFRESH_HOLD_MS          (500)
+#define REFRESH_STEP_MS          (250)
+#define REFRESH_IDLE_PERIOD_MS   (1000)
+
+static refresh_policy_t refresh_policy;
+static uint32_t refresh_period_ms = LV_DEF_REFR_PERIOD;
+static ui_refresh_stats_t refresh_stats;
+static uint64_t refresh_stats_us = 0;
+static uint32_t render_start_us = 0;
+
+// Draw buffers are static so they do not take 30 KB of the LVGL heap. The section names are
+// placed by memmap_draw_buf.ld.in for LCD_DRAW_BUF_PLACEMENT split and same (see CMakeLists.txt).
+#define DRAW_BUF_BYTES   (UI_PROP_SCREEN_WIDTH_PX * LCD_DRAW_BUF_LINES * 2)
+
+#if defined(LCD_DRAW_BUF_SPLIT)
+#define DRAW_BUF1_SECTION   __attribute__((section(".draw_buf_bank0")))
+#define DRAW_BUF2_SECTION   __attribute__((section(".draw_buf_top")))
+#elif defined(LCD_DRAW_BUF_SAME)
+#define DRAW_BUF1_SECTION   __attribute__((section(".draw_buf_bank0")))
+#define DRAW_BUF2_SECTION   __attribute__((section(".draw_buf_bank0")))
+#else
+#define DRAW_BUF1_SECTION
+#define DRAW_BUF2_SECTION
+#endif
+
+static uint8_t draw_buf1[DRAW_BUF_BYTES] __attribute__((aligned(4))) DRAW_BUF1_SECTION;
+static uint8_t draw_buf2[DRAW_BUF_BYTES] __attribute__((aligned(4))) DRAW_BUF2_SECTION;
 
 static absolute_time_t prev_tick = 0;
 static uint32_t active_time_min = 0;
@@ -48,6 +106,7 @@ static uint32_t set_time_min = 0;
 static uint32_t display_set_time = 0;
 
 static lv_obj_t *label_clock;
+static char clock_text[10] = "00:00";
 
 static bool started = false;
 static bool reset = false;
@@ -55,6 +114,21 @@ static bool refresh = false;
 
 static bool red = false;
 
+static bool first_frame_reported = false;
+
+// Countdown checkpoint kept in RAM the C runtime does not clear, so it survives the RUN pin,
+// the watchdog and software reboots. The epoch heartbeat carries the time across those
+// resets. After a power loss both fail their checks and the flash copy is used instead.
+typedef struct {
+    timer_checkpoint_t cp;
+    uint64_t epoch_us;       // Epoch time at the last tick_ui()
+    uint64_t epoch_us_inv;
+} retained_timer_t;
+
+static retained_timer_t __uninitialized_ram(retained_timer);
+static uint64_t epoch_base_us = 0;
+static timer_checkpoint_stats_t checkpoint_stats;
+
 typedef enum {
     StartStopTime,
     SetTime
@@ -69,6 +143,39 @@ static lv_obj_t *decr_hr_btn = NULL;
 static lv_obj_t *incr_min_btn = NULL;
 static lv_obj_t *decr_min_btn = NULL;
 static lv_obj_t *set_time_btn = NULL;
+static lv_obj_t *start_stop_label = NULL;
+
+static void label_clock_cb(lv_event_t *e);
+static void set_time_cb(lv_event_t *e);
+static void start_stop_button_event_cb(lv_event_t *e);
+static void reset_button_event_cb(lv_event_t *e);
+void show_time(const uint32_t time_in_min);
+
+typedef struct {
+    lv_obj_t **btn;
+    lv_obj_t **label;
+    const char *text;
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+    ui_state_t screen;
+    lv_event_cb_t event_cb;
+    void *user_data;
+} ui_button_desc_t;
+
+// Geometry comes from ui_layout.h, so every button is placed in a single pass.
+static const ui_button_desc_t ui_buttons[] = {
+    {&reset_btn,      NULL,              "Reset", UI_LAYOUT_MID_X,   UI_LAYOUT_ROW_BOTTOM_Y, UI_LAYOUT_BTN_WIDTH,   UI_LAYOUT_BTN_HEIGHT, StartStopTime, reset_button_event_cb,      NULL},
+    {&start_stop_btn, &start_stop_label, "Start", UI_LAYOUT_MID_X,   UI_LAYOUT_ROW_TOP_Y,    UI_LAYOUT_BTN_WIDTH,   UI_LAYOUT_BTN_HEIGHT, StartStopTime, start_stop_button_event_cb, NULL},
+    {&incr_hr_btn,    NULL,              "H+",    UI_LAYOUT_LEFT_X,  UI_LAYOUT_ROW_TOP_Y,    UI_LAYOUT_THIRD_WIDTH, UI_LAYOUT_BTN_HEIGHT, SetTime,       set_time_cb,                &hr_incr_event},
+    {&decr_hr_btn,    NULL,              "H-",    UI_LAYOUT_LEFT_X,  UI_LAYOUT_ROW_BOTTOM_Y, UI_LAYOUT_THIRD_WIDTH, UI_LAYOUT_BTN_HEIGHT, SetTime,       set_time_cb,                &hr_decr_event},
+    {&incr_min_btn,   NULL,              "M+",    UI_LAYOUT_RIGHT_X, UI_LAYOUT_ROW_TOP_Y,    UI_LAYOUT_THIRD_WIDTH, UI_LAYOUT_BTN_HEIGHT, SetTime,       set_time_cb,                &min_incr_event},
+    {&decr_min_btn,   NULL,              "M-",    UI_LAYOUT_RIGHT_X, UI_LAYOUT_ROW_BOTTOM_Y, UI_LAYOUT_THIRD_WIDTH, UI_LAYOUT_BTN_HEIGHT, SetTime,       set_time_cb,                &min_decr_event},
+    {&set_time_btn,   NULL,              "Set",   UI_LAYOUT_SET_X,   UI_LAYOUT_SET_Y,        UI_LAYOUT_THIRD_WIDTH, UI_LAYOUT_BTN_HEIGHT, SetTime,       set_time_cb,                &set_time_event},
+};
+
+#define UI_BUTTON_COUNT   (sizeof(ui_buttons) / sizeof(ui_buttons[0]))
 
 #ifdef ENABLE_REG_READ_FUNC
 // Can use this function to read register values for debugging.
@@ -89,18 +196,58 @@ void read_register(void)
 }
 #endif
 
-static void show_screen()
+static void set_clock_red(const bool is_red)
+{
+    if (red != is_red) {
+        red = is_red;
+        lv_obj_invalidate(label_clock);
+    }
+}
+
+static void set_clock_text(const char *text)
+{
+    if (strcmp(clock_text, text) == 0) {
+        return;
+    }
+
+    snprintf(clock_text, sizeof(clock_text), "%s", text);
+    const int32_t width = glyph_cache_ready() ? glyph_cache_text_width(clock_text)
+                                              : lv_text_get_width(clock_text, strlen(clock_text), UI_PROP_FONT_CLOCK, 0);
+    // Centred in the top half of the display
+    lv_obj_set_pos(label_clock, ((int32_t)LCD_H_RES - width) / 2, UI_LAYOUT_CLOCK_Y);
+    lv_obj_set_width(label_clock, width);
+    lv_obj_invalidate(label_clock);
+}
+
+// The clock is drawn from pre-blended glyph tiles. The label renderer is only the fallback
+// when the cache could not be built.
+static void clock_draw_cb(lv_event_t *e)
 {
-    lv_obj_set_flag(incr_hr_btn, LV_OBJ_FLAG_HIDDEN, (ui_state == StartStopTime));
-    lv_obj_set_flag(incr_min_btn, LV_OBJ_FLAG_HIDDEN, (ui_state == StartStopTime));
-    lv_obj_set_flag(decr_hr_btn, LV_OBJ_FLAG_HIDDEN, (ui_state == StartStopTime));
-    lv_obj_set_flag(decr_min_btn, LV_OBJ_FLAG_HIDDEN, (ui_state == StartStopTime));
-    lv_obj_set_flag(set_time_btn, LV_OBJ_FLAG_HIDDEN, (ui_state == StartStopTime));
+    lv_obj_t *obj = lv_event_get_target_obj(e);
+    lv_layer_t *layer = lv_event_get_layer(e);
+    lv_area_t coords;
+    lv_obj_get_content_coords(obj, &coords);
 
-    lv_obj_set_flag(start_stop_btn, LV_OBJ_FLAG_HIDDEN, (ui_state == SetTime));
-    lv_obj_set_flag(reset_btn, LV_OBJ_FLAG_HIDDEN, (ui_state == SetTime));
+    if (glyph_cache_ready() && glyph_cache_covers(clock_text)) {
+        glyph_cache_draw(layer, clock_text, coords.x1, coords.y1, red ? 1 : 0);
+    }
+    else {
+        lv_draw_label_dsc_t dsc;
+        lv_draw_label_dsc_init(&dsc);
+        dsc.font = UI_PROP_FONT_CLOCK;
+        dsc.color = red ? lv_palette_main(LV_PALETTE_RED) : lv_color_hex(0xE0E0E0);
+        dsc.text = clock_text;
+        lv_draw_label(layer, &dsc, &coords);
+    }
+}
 
+static void show_screen()
+{
+    for (size_t i = 0; i < UI_BUTTON_COUNT; i++) {
+        lv_obj_set_flag(*ui_buttons[i].btn, LV_OBJ_FLAG_HIDDEN, (ui_buttons[i].screen != ui_state));
+    }
 }
+
 static void label_clock_cb(lv_event_t *e)
 {
     lv_event_code_t code = lv_event_get_code(e);
@@ -138,6 +285,7 @@ static void set_time_cb(lv_event_t *e)
                 break;
                 case SET_TIME:
                     set_time_min = display_set_time;
+                    kv_set(KvKeyCountdownPreset, &set_time_min, sizeof(set_time_min));
                     ui_state = StartStopTime;
                     show_screen();
                 break;
@@ -154,11 +302,9 @@ static void start_stop_button_event_cb(lv_event_t *e)
 {
     lv_event_code_t code = lv_event_get_code(e);
     if (code == LV_EVENT_RELEASED) {
-        lv_obj_t *label = lv_event_get_user_data(e);
         started = !started;
-        lv_label_set_text(label, started ? "Stop" : "Start");
-        lv_obj_set_style_text_color(label_clock, lv_color_hex(0xE0E0E0), 0);
-        red = false;
+        lv_label_set_text_static(start_stop_label, started ? "Stop" : "Start");
+        set_clock_red(false);
     }
 }
 
@@ -184,11 +330,17 @@ static void read_touch(lv_indev_t *indev, lv_indev_data_t *data)
     }
 }
 
-static void initialise_lcd_hw()
+// Boot step: pins, SPI and the start of the reset pulse.
+static void lcd_reset_assert_step()
 {
-	// Backlight
-    gpio_init(GPIO_LCD_BACKLIGHT_PIN);
-    gpio_set_dir(GPIO_LCD_BACKLIGHT_PIN, GPIO_OUT);
+    // Backlight, dark until the reset pulse
+    const backlight_config_t backlight_config = {
+        .bright = BACKLIGHT_BRIGHT,
+        .dim = BACKLIGHT_DIM,
+        .dim_after_ms = BACKLIGHT_DIM_AFTER_MS,
+        .off_after_ms = BACKLIGHT_OFF_AFTER_MS,
+    };
+    backlight_init(GPIO_LCD_BACKLIGHT_PIN, &backlight_config);
 
     // LCD reset pin
     gpio_init(GPIO_LCD_RESETn);
@@ -202,27 +354,49 @@ static void initialise_lcd_hw()
     gpio_init(GPIO_SPI0_CSn);  // Software controlled
     gpio_set_dir(GPIO_SPI0_CSn, GPIO_OUT);
 
+#ifndef LCD_TRANSPORT_PIO
     gpio_init(GPIO_SPI0_RX);
     gpio_init(GPIO_SPI0_SCK);
     gpio_init(GPIO_SPI0_TX);
     gpio_set_function(GPIO_SPI0_RX, GPIO_FUNC_SPI);
     gpio_set_function(GPIO_SPI0_SCK, GPIO_FUNC_SPI);
     gpio_set_function(GPIO_SPI0_TX, GPIO_FUNC_SPI);
-    const uint baud = spi_init(spi0, 50000000);   // Maximum supported is 62.5 MHz
+    const uint baud = spi_init(spi0, CLOCK_LCD_SPI_HZ);   // Maximum supported is 62.5 MHz
     printf("SPI initialised with: %d baudrate\n\r", baud);
+#endif
 
     // Switch on backlight
-    gpio_put(GPIO_LCD_BACKLIGHT_PIN, 1);
+    backlight_set(BACKLIGHT_BRIGHT, false);
 
-    // Reset the LCD
+    // Reset the LCD, the pulse needs to be more than 10 us
     gpio_put(GPIO_LCD_RESETn, false);
-    sleep_ms(25);   // This needs to be more than 10 us
+}
+
+// Boot step: end of the reset pulse. The panel needs up to 120 ms before it takes commands.
+static void lcd_reset_release_step()
+{
     gpio_put(GPIO_LCD_RESETn, true);
-    sleep_ms(125);   // The worst case time is 120 ms
 
     gpio_put(GPIO_LCD_DCX, LCD_DATA);
     gpio_put(GPIO_SPI0_CSn, true);
+
+#ifdef LCD_TRANSPORT_PIO
+    // From here on the state machine owns CSn, SCK, TX and DCX.
+    lcd_pio_init(GPIO_SPI0_TX, GPIO_SPI0_CSn, GPIO_SPI0_SCK, GPIO_LCD_DCX);
+#endif
+}
+
+// Start of the flush in progress and its size, for the metrics.
+static uint32_t flush_start_us = 0;
+static uint32_t flush_bytes = 0;
+
+#ifdef LCD_TRANSPORT_PIO
+static void HOT_PATH_FUNC(lcd_flush_done)(void *ctx)
+{
+    metrics_flush(flush_bytes, time_us_32() - flush_start_us);
+    lv_display_flush_ready((lv_display_t *)ctx);
 }
+#endif
 
 static void send_lcd_cmd(lv_display_t *disp, const uint8_t *cmd, size_t cmd_size, const uint8_t *param, size_t param_size)
 {
@@ -230,6 +404,11 @@ static void send_lcd_cmd(lv_display_t *disp, const uint8_t *cmd, size_t cmd_size
         return;
     }
 
+    frame_capture_cmd(cmd[0], param, param_size);
+
+#ifdef LCD_TRANSPORT_PIO
+    lcd_pio_write_cmd(cmd, cmd_size, param, param_size);
+#else
     while (pending_xfer);
 
     gpio_put(GPIO_LCD_DCX, LCD_CMD);
@@ -243,14 +422,28 @@ static void send_lcd_cmd(lv_display_t *disp, const uint8_t *cmd, size_t cmd_size
     }
 
     gpio_put(GPIO_SPI0_CSn, true);
+#endif
 }
 
-static void send_lcd_data(lv_display_t *disp, const uint8_t *cmd, size_t cmd_size, uint8_t *param, size_t param_size)
+static void HOT_PATH_FUNC(send_lcd_data)(lv_display_t *disp, const uint8_t *cmd, size_t cmd_size, uint8_t *param, size_t param_size)
 {
     if (!disp || !cmd) {
         return;
     }
 
+    const bool last = lv_display_flush_is_last(disp);
+    if (last) {
+        metrics_frame_done();
+    }
+
+    flush_start_us = time_us_32();
+    flush_bytes = cmd_size + param_size;
+    frame_capture_data(cmd[0], (const uint16_t *)param, param_size / 2, last);
+
+#ifdef LCD_TRANSPORT_PIO
+    // The data write is always 16 bits, the DMA interrupt signals LVGL once the buffer is free.
+    lcd_pio_write_pixels(cmd, cmd_size, (const uint16_t *)param, param_size / 2, lcd_flush_done, disp);
+#else
     while (pending_xfer);
 
     gpio_put(GPIO_LCD_DCX, LCD_CMD);
@@ -271,38 +464,96 @@ static void send_lcd_data(lv_display_t *disp, const uint8_t *cmd, size_t cmd_siz
 
     gpio_put(GPIO_SPI0_CSn, true);
     pending_xfer = false;
+    metrics_flush(flush_bytes, time_us_32() - flush_start_us);
     lv_display_flush_ready(disp);
+#endif
 }
 
-static void initialise_lvgl_framework()
+// LVGL's own waits (the ST7789 init sequence sleeps after the reset and sleep out commands)
+// go through the boot sequencer, so the UI is built while the panel wakes up.
+static void lvgl_delay_cb(uint32_t ms)
+{
+    if (lv_display_get_default()) {
+        boot_sequencer_reach(BootDisplayCreated);
+    }
+    boot_sequencer_wait_us(ms * 1000);
+}
+
+// Boot step: LVGL core, nothing here touches the display.
+static void lvgl_init_step()
 {
 	lv_init();
     lv_tick_set_cb(get_tick_count);
-    lcd_disp = lv_st7789_create(LCD_H_RES, LCD_V_RES, LV_LCD_FLAG_NONE, send_lcd_cmd, send_lcd_data);
+    lv_delay_set_cb(lvgl_delay_cb);
+}
 
-    // Colour setting is governed by LV_COLOR_DEPTH. It's set to 16 which leads to RGB565 color format
-    // being native.
-    lv_disp_set_rotation(lcd_disp, LV_DISP_ROTATION_0);
+// The refresh timer runs whether or not anything is invalid, rendering only when it is.
+static void refresh_start_cb(lv_event_t *e)
+{
+    refresh_stats.timer_runs[refresh_policy_mode(&refresh_policy)]++;
+}
 
-    lv_color_t *buf1 = NULL;
-    lv_color_t *buf2 = NULL;
+static void render_start_cb(lv_event_t *e)
+{
+    clock_governor_boost();
+    render_start_us = time_us_32();
+}
 
-    // For partial rendering the buffer is set to 1/10th of display size
-    const uint32_t buf_size = LCD_H_RES * LCD_V_RES * lv_color_format_get_size(lv_display_get_color_format(lcd_disp)) / 10;
-    buf1 = lv_malloc(buf_size);
-    if (buf1 == NULL) {
-        printf("Buffer1 allocation failed!\n\r");
-        return;
+static void render_ready_cb(lv_event_t *e)
+{
+    const refresh_mode_t mode = refresh_policy_mode(&refresh_policy);
+    refresh_stats.renders[mode]++;
+    refresh_stats.render_us[mode] += time_us_32() - render_start_us;
+    touch_trace_frame(time_us_32());
+
+    // Reported here rather than from send_lcd_data(), which runs from SRAM on every flush.
+    if (!first_frame_reported) {
+        first_frame_reported = true;
+        printf("Boot to first frame: %d ms\n\r", (int)to_ms_since_boot(get_absolute_time()));
     }
+}
 
-    buf2 = lv_malloc(buf_size);
-    if (buf2 == NULL) {
-        printf("Buffer2 allocation failed!\n\r");
-        lv_free(buf1);
-        return;
+// With the timer slowed down, a change is drawn at the next lv_timer_handler() instead of up
+// to a second later. At full rate the period already bounds the latency.
+static void invalidate_cb(lv_event_t *e)
+{
+    const lv_area_t *area = lv_event_get_param(e);
+    if (area) {
+        frame_capture_invalidate(area->x1, area->y1, area->x2, area->y2);
     }
 
-    lv_display_set_buffers(lcd_disp, buf1, buf2, buf_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
+    if (refresh_policy_mode(&refresh_policy) != RefreshInteractive) {
+        lv_timer_ready(lv_display_get_refr_timer(lcd_disp));
+    }
+}
+
+// Boot step: panel init sequence, draw buffers and the touch input device.
+static void lcd_panel_step()
+{
+    lcd_disp = lv_st7789_create(LCD_H_RES, LCD_V_RES, LV_LCD_FLAG_NONE, send_lcd_cmd, send_lcd_data);
+
+    // Colour setting is governed by LV_COLOR_DEPTH. It's set to 16 which leads to RGB565 color format
+    // being native.
+    lv_disp_set_rotation(lcd_disp, LV_DISP_ROTATION_0);
+
+    // Partial rendering, LCD_DRAW_BUF_LINES lines at a time (32 = 1/10th of the display)
+    lv_display_set_buffers(lcd_disp, draw_buf1, draw_buf2, sizeof(draw_buf1), LV_DISPLAY_RENDER_MODE_PARTIAL);
+    printf("Draw buffers: 2 x %d bytes at %p and %p\n\r", (int)sizeof(draw_buf1), draw_buf1, draw_buf2);
+
+    // Rendering runs at full clock speed. Timer runs with nothing to draw stay at the idle clock.
+    lv_display_add_event_cb(lcd_disp, refresh_start_cb, LV_EVENT_REFR_START, NULL);
+    lv_display_add_event_cb(lcd_disp, render_start_cb, LV_EVENT_RENDER_START, NULL);
+    lv_display_add_event_cb(lcd_disp, render_ready_cb, LV_EVENT_RENDER_READY, NULL);
+    lv_display_add_event_cb(lcd_disp, invalidate_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+
+    const refresh_config_t refresh_config = {
+        .min_period_ms = LV_DEF_REFR_PERIOD,
+        .idle_period_ms = REFRESH_IDLE_PERIOD_MS,
+        .hold_ms = REFRESH_HOLD_MS,
+        .step_ms = REFRESH_STEP_MS,
+    };
+    refresh_policy_init(&refresh_policy, &refresh_config, lv_tick_get());
+    refresh_stats_us = time_us_64();
 
     // Initialise touch screen connection
     touch_panel = lv_indev_create();
@@ -310,152 +561,500 @@ static void initialise_lvgl_framework()
     lv_indev_set_read_cb(touch_panel, read_touch);
 }
 
-static void ui_init(lv_display_t *disp)
+// Shared styles. Every object references these instead of carrying local style properties.
+static lv_style_t style_screen;
+static lv_style_t style_btn;
+static lv_style_t style_btn_label;
+static lv_style_t style_line;
+
+static void init_styles()
+{
+    lv_style_init(&style_screen);
+    lv_style_set_bg_color(&style_screen, lv_color_hex(0x1A1A1A));
+    lv_style_set_bg_opa(&style_screen, LV_OPA_100);
+
+    lv_style_init(&style_btn);
+    lv_style_set_bg_color(&style_btn, lv_color_hex(0x333333));
+
+    lv_style_init(&style_btn_label);
+    lv_style_set_text_color(&style_btn_label, lv_color_hex(0xE0E0E0));
+    lv_style_set_text_font(&style_btn_label, UI_PROP_FONT_BUTTON);
+
+    lv_style_init(&style_line);
+    lv_style_set_line_width(&style_line, 3);
+    lv_style_set_line_color(&style_line, lv_color_hex(0xE0E0E0));
+    lv_style_set_line_rounded(&style_line, true);
+}
+
+// UI_LOCAL_STYLES copies a shared style's properties into the object's local style instead,
+// as ui_init() set them before the shared styles: the baseline for the heap after init and
+// the ui.render_button benchmark.
+static void add_style(lv_obj_t *obj, const lv_style_t *style)
+{
+#ifdef UI_LOCAL_STYLES
+    static const lv_style_prop_t props[] = {
+        LV_STYLE_BG_COLOR, LV_STYLE_BG_OPA, LV_STYLE_TEXT_COLOR, LV_STYLE_TEXT_FONT,
+        LV_STYLE_LINE_WIDTH, LV_STYLE_LINE_COLOR, LV_STYLE_LINE_ROUNDED,
+    };
+    for (size_t i = 0; i < sizeof(props) / sizeof(props[0]); i++) {
+        lv_style_value_t value;
+        if (lv_style_get_prop(style, props[i], &value) == LV_STYLE_RES_FOUND) {
+            lv_obj_set_local_style_prop(obj, props[i], value, 0);
+        }
+    }
+#else
+    lv_obj_add_style(obj, style, 0);
+#endif
+}
+
+#ifdef TOUCH_TRACE
+static void input_event_cb(lv_event_t *e)
+{
+    touch_trace_event(time_us_32());
+}
+#endif
+
+// Press and release as LVGL delivers them, for the touch trace latencies.
+static void trace_input_events(lv_obj_t *obj)
+{
+#ifdef TOUCH_TRACE
+    lv_obj_add_event_cb(obj, input_event_cb, LV_EVENT_PRESSED, NULL);
+    lv_obj_add_event_cb(obj, input_event_cb, LV_EVENT_RELEASED, NULL);
+#endif
+}
+
+static void build_buttons(lv_obj_t *scr)
+{
+    for (size_t i = 0; i < UI_BUTTON_COUNT; i++) {
+        const ui_button_desc_t *desc = &ui_buttons[i];
+
+        lv_obj_t *btn = lv_button_create(scr);
+        add_style(btn, &style_btn);
+        lv_obj_set_pos(btn, desc->x, desc->y);
+        lv_obj_set_size(btn, desc->width, desc->height);
+        lv_obj_add_event_cb(btn, desc->event_cb, LV_EVENT_RELEASED, desc->user_data);
+        trace_input_events(btn);
+        lv_obj_set_flag(btn, LV_OBJ_FLAG_HIDDEN, (desc->screen != ui_state));
+
+        lv_obj_t *label = lv_label_create(btn);
+        add_style(label, &style_btn_label);
+        lv_label_set_text_static(label, desc->text);
+        lv_obj_set_align(label, LV_ALIGN_CENTER);
+
+        *desc->btn = btn;
+        if (desc->label) {
+            *desc->label = label;
+        }
+    }
+}
+
+// Boot step: styles and clock glyph tiles. Only needs LVGL, so it runs during the LCD reset.
+static void ui_assets_step()
+{
+    init_styles();
+
+    /* white and red clock digits are pre-blended against the background */
+    const lv_color_t clock_colours[] = {lv_color_hex(0xE0E0E0), lv_palette_main(LV_PALETTE_RED)};
+    if (glyph_cache_init(UI_PROP_FONT_CLOCK, lv_color_hex(0x1A1A1A), clock_colours, 2) != 0) {
+        printf("Glyph cache disabled, drawing the clock with the label renderer.\n\r");
+    }
+}
+
+// Boot step: widgets. Needs the display object, but not the panel itself.
+static void ui_build_step()
 {
     /* set screen background to dark gray */
     lv_obj_t *scr = lv_screen_active();
-    lv_obj_set_style_bg_color(scr, lv_color_hex(0x1A1A1A), 0);
-    lv_obj_set_style_bg_opa(scr, LV_OPA_100, 0);
-
-    /* create Clock label */
-    label_clock = lv_label_create(scr);
-    lv_label_set_text(label_clock, "00:00");
-    lv_obj_set_style_text_color(label_clock, lv_color_hex(0xE0E0E0), 0);
-    lv_obj_set_style_text_font(label_clock, &lv_font_montserrat_48, 0);
-    lv_obj_set_height(label_clock, LV_SIZE_CONTENT);
-    lv_obj_set_width(label_clock, LV_SIZE_CONTENT);
-    lv_obj_update_layout(label_clock);
-    const int clock_height = lv_obj_get_height(label_clock);
-    // Center of the top half of the display
-    const int32_t timer_y_off = (LCD_V_RES / 4) - (clock_height / 2);
-    lv_obj_align(label_clock, LV_ALIGN_TOP_MID, 0, timer_y_off);
+    add_style(scr, &style_screen);
+    trace_input_events(scr);
+
+    /* create Clock */
+    label_clock = lv_obj_create(scr);
+    lv_obj_remove_style_all(label_clock);
+    lv_obj_remove_flag(label_clock, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_event_cb(label_clock, clock_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_set_height(label_clock, UI_LAYOUT_CLOCK_HEIGHT);
+    clock_text[0] = '\0';
+    set_clock_text("00:00");
     lv_obj_set_flag(label_clock, LV_OBJ_FLAG_CLICKABLE, true);
     lv_obj_add_event_cb(label_clock, label_clock_cb, LV_EVENT_RELEASED, NULL);
+    trace_input_events(label_clock);
 
     /* Draw a line in the center */
-    static lv_style_t line_style;
-    lv_style_init(&line_style);
-    lv_style_set_line_width(&line_style, 3);
-    // TODO: Set line color
-    lv_style_set_line_color(&line_style, lv_color_hex(0xE0E0E0));
-    lv_style_set_line_rounded(&line_style, true);
-
     lv_obj_t *center_line = lv_line_create(scr);
-    static lv_point_precise_t points[] = {{UI_PROP_BORDER_PADDING_PX, LCD_V_RES / 2}, {LCD_H_RES - UI_PROP_BORDER_PADDING_PX, LCD_V_RES / 2}};
+    static lv_point_precise_t points[] = {{UI_PROP_BORDER_PADDING_PX, UI_LAYOUT_LINE_Y}, {LCD_H_RES - UI_PROP_BORDER_PADDING_PX, UI_LAYOUT_LINE_Y}};
     lv_line_set_points(center_line, points, 2);
-    lv_obj_add_style(center_line, &line_style, 0);
-
-    // Reset button is the standard button for the start-stop screen
-    reset_btn = lv_button_create(scr);
-    lv_obj_align(reset_btn, LV_ALIGN_BOTTOM_MID, 0, -26);
-    lv_obj_set_style_bg_color(reset_btn, lv_color_hex(0x333333), 0);
-    lv_obj_set_style_pad_top(reset_btn, UI_PROP_INTERNAL_PADDING_PX, 0);
-    lv_obj_set_style_pad_bottom(reset_btn, UI_PROP_INTERNAL_PADDING_PX, 0);
-    lv_obj_set_style_pad_left(reset_btn, UI_PROP_INTERNAL_PADDING_PX * 2, 0);
-    lv_obj_set_style_pad_right(reset_btn, UI_PROP_INTERNAL_PADDING_PX * 2, 0);
-
-    lv_obj_t *reset_label = lv_label_create(reset_btn);
-    lv_label_set_text(reset_label, "Reset");
-    lv_obj_set_style_text_color(reset_label, lv_color_hex(0xE0E0E0), 0);
-    lv_obj_set_style_text_font(reset_label, &lv_font_montserrat_20, 0);
-
-    lv_obj_update_layout(reset_label);
-    lv_obj_update_layout(reset_btn);
-    const int reset_btn_height = lv_obj_get_height(reset_btn);
-    const int reset_btn_width = lv_obj_get_width(reset_btn);
-    lv_obj_add_event_cb(reset_btn, reset_button_event_cb, LV_EVENT_RELEASED, NULL);
-
-    // TODO: Fix offset
-    start_stop_btn = lv_button_create(scr);
-    lv_obj_align(start_stop_btn, LV_ALIGN_BOTTOM_MID, 0, -78);
-    lv_obj_set_style_bg_color(start_stop_btn, lv_color_hex(0x333333), 0);
-    lv_obj_set_height(start_stop_btn, reset_btn_height);
-    lv_obj_set_width(start_stop_btn, reset_btn_width);
-
-    lv_obj_t *start_stop_label = lv_label_create(start_stop_btn);
-    lv_label_set_text(start_stop_label, "Start");
-    lv_obj_set_style_text_color(start_stop_label, lv_color_hex(0xE0E0E0), 0);
-    lv_obj_set_style_text_font(start_stop_label, &lv_font_montserrat_20, 0);
-    lv_obj_set_align(start_stop_label, LV_ALIGN_CENTER);
-    lv_obj_add_event_cb(start_stop_btn, start_stop_button_event_cb, LV_EVENT_RELEASED, start_stop_label);
-
-    int set_time_btn_width = (LCD_H_RES - UI_PROP_BORDER_PADDING_PX * 2 - UI_PROP_INTERNAL_PADDING_PX * 2);
-    set_time_btn_width = set_time_btn_width / 3;
-
-    incr_hr_btn = lv_button_create(scr);
-    lv_obj_t *incr_hr_label = lv_label_create(incr_hr_btn);
-    lv_label_set_text(incr_hr_label, "H+");
-    lv_obj_set_style_text_color(incr_hr_label, lv_color_hex(0xE0E0E0), 0);
-    lv_obj_set_style_text_font(incr_hr_label, &lv_font_montserrat_20, 0);
-    lv_obj_set_style_bg_color(incr_hr_btn, lv_color_hex(0x333333), 0);
-    lv_obj_set_align(incr_hr_label, LV_ALIGN_CENTER);
-    lv_obj_set_width(incr_hr_btn, set_time_btn_width);
-    lv_obj_set_height(incr_hr_btn, reset_btn_height);
-    lv_obj_align(incr_hr_btn, LV_ALIGN_BOTTOM_LEFT, UI_PROP_BORDER_PADDING_PX, -78);
-    lv_obj_add_event_cb(incr_hr_btn, set_time_cb, LV_EVENT_RELEASED, &hr_incr_event);
-
-    decr_hr_btn = lv_button_create(scr);
-    lv_obj_set_style_bg_color(decr_hr_btn, lv_color_hex(0x333333), 0);
-    lv_obj_t *decr_hr_label = lv_label_create(decr_hr_btn);
-    lv_label_set_text(decr_hr_label, "H-");
-    lv_obj_set_align(decr_hr_label, LV_ALIGN_CENTER);
-    lv_obj_set_style_text_color(decr_hr_label, lv_color_hex(0xE0E0E0), 0);
-    lv_obj_set_style_text_font(decr_hr_label, &lv_font_montserrat_20, 0);
-    lv_obj_align(decr_hr_btn, LV_ALIGN_BOTTOM_LEFT, UI_PROP_BORDER_PADDING_PX, -26);
-    lv_obj_set_width(decr_hr_btn, set_time_btn_width);
-    lv_obj_set_height(decr_hr_btn, reset_btn_height);
-    lv_obj_add_event_cb(decr_hr_btn, set_time_cb, LV_EVENT_RELEASED, &hr_decr_event);
-
-    incr_min_btn = lv_button_create(scr);
-    lv_obj_set_style_bg_color(incr_min_btn, lv_color_hex(0x333333), 0);
-    lv_obj_set_width(incr_min_btn, set_time_btn_width);
-    lv_obj_set_height(incr_min_btn, reset_btn_height);
-    lv_obj_t *incr_min_label = lv_label_create(incr_min_btn);
-    lv_label_set_text(incr_min_label, "M+");
-    lv_obj_set_style_text_color(incr_min_label, lv_color_hex(0xE0E0E0), 0);
-    lv_obj_set_style_text_font(incr_min_label, &lv_font_montserrat_20, 0);
-    lv_obj_set_align(incr_min_label, LV_ALIGN_CENTER);
-    lv_obj_align(incr_min_btn, LV_ALIGN_BOTTOM_RIGHT, -UI_PROP_BORDER_PADDING_PX, -78);
-    lv_obj_add_event_cb(incr_min_btn, set_time_cb, LV_EVENT_RELEASED, &min_incr_event);
-
-    decr_min_btn = lv_button_create(scr);
-    lv_obj_set_style_bg_color(decr_min_btn, lv_color_hex(0x333333), 0);
-    lv_obj_set_width(decr_min_btn, set_time_btn_width);
-    lv_obj_set_height(decr_min_btn, reset_btn_height);
-    lv_obj_t *decr_min_label = lv_label_create(decr_min_btn);
-    lv_label_set_text(decr_min_label, "M-");
-    lv_obj_set_align(decr_min_label, LV_ALIGN_CENTER);
-    lv_obj_set_style_text_color(decr_min_label, lv_color_hex(0xE0E0E0), 0);
-    lv_obj_set_style_text_font(decr_min_label, &lv_font_montserrat_20, 0);
-    lv_obj_align(decr_min_btn, LV_ALIGN_BOTTOM_RIGHT, -UI_PROP_BORDER_PADDING_PX, -26);
-    lv_obj_add_event_cb(decr_min_btn, set_time_cb, LV_EVENT_RELEASED, &min_decr_event);
-
-    set_time_btn = lv_button_create(scr);
-    lv_obj_set_style_bg_color(set_time_btn, lv_color_hex(0x333333), 0);
-    lv_obj_set_width(set_time_btn, set_time_btn_width);
-    lv_obj_set_height(set_time_btn, reset_btn_height);
-
-    lv_obj_t *set_time_label = lv_label_create(set_time_btn);
-    lv_label_set_text(set_time_label, "Set");
-    lv_obj_set_align(set_time_label, LV_ALIGN_CENTER);
-    lv_obj_set_style_text_color(set_time_label, lv_color_hex(0xE0E0E0), 0);
-    lv_obj_set_style_text_font(set_time_label, &lv_font_montserrat_20, 0);
-    lv_obj_align(set_time_btn, LV_ALIGN_CENTER, 0, LCD_V_RES / 4);
-    lv_obj_add_event_cb(set_time_btn, set_time_cb, LV_EVENT_RELEASED, &set_time_event);
-
-    lv_obj_set_flag(incr_hr_btn, LV_OBJ_FLAG_HIDDEN, true);
-    lv_obj_set_flag(incr_min_btn, LV_OBJ_FLAG_HIDDEN, true);
-    lv_obj_set_flag(decr_hr_btn, LV_OBJ_FLAG_HIDDEN, true);
-    lv_obj_set_flag(decr_min_btn, LV_OBJ_FLAG_HIDDEN, true);
-    lv_obj_set_flag(set_time_btn, LV_OBJ_FLAG_HIDDEN, true);
+    add_style(center_line, &style_line);
+
+    build_buttons(scr);
+
+    if (kv_get(KvKeyCountdownPreset, &set_time_min, sizeof(set_time_min)) != sizeof(set_time_min)) {
+        set_time_min = 0;
+    }
+}
+
+static uint64_t epoch_now_us(const absolute_time_t t)
+{
+    return epoch_base_us + to_us_since_boot(t);
 }
 
+// Sets the countdown from the checkpoint, with the next decrement in phase with the deadline.
+// tick_ui() only ever counts one second per call, so this catches up after a reset or sleep.
+static void sync_timer_to_checkpoint(const timer_checkpoint_t *cp, const absolute_time_t now)
+{
+    const uint64_t epoch_us = epoch_now_us(now);
+    started = cp->started;
+    active_time_min = timer_checkpoint_remaining_s(cp, epoch_us);
+    prev_tick = now;
+    if (started && active_time_min > 0) {
+        const uint64_t to_next_us = (cp->deadline_us - epoch_us) - (uint64_t)(active_time_min - 1) * 1000 * 1000;
+        prev_tick = delayed_by_us(now, to_next_us) - 1000 * 1000;
+    }
+}
+
+// Brings the countdown back after a reset, before the first frame. tick_ui() counts
+// active_time_min down once a second.
+static void restore_timer()
+{
+    const absolute_time_t now = get_absolute_time();
+    timer_checkpoint_t cp;
+    prev_tick = now;
+
+    const bool warm = (retained_timer.epoch_us == ~retained_timer.epoch_us_inv) && timer_checkpoint_valid(&retained_timer.cp);
+    if (warm) {
+        // Warm reset: the epoch goes on from the last heartbeat, so a running countdown
+        // continues. Only the time between that heartbeat and the reset is lost.
+        epoch_base_us = retained_timer.epoch_us;
+        sync_timer_to_checkpoint(&retained_timer.cp, now);
+        printf("Timer restored from RAM: %d left, %s\n\r", (int)active_time_min, started ? "running" : "stopped");
+    }
+    else if (kv_get(KvKeyTimerState, &cp, sizeof(cp)) == sizeof(cp) && timer_checkpoint_valid(&cp)) {
+        // Power was lost and there is no telling for how long: show what was left when the
+        // checkpoint was written, stopped.
+        started = false;
+        active_time_min = timer_checkpoint_remaining_s(&cp, cp.saved_us);
+        printf("Timer restored from flash: %d left\n\r", (int)active_time_min);
+    }
+    else {
+        started = false;
+        active_time_min = set_time_min;
+    }
+
+    if (!warm) {
+        timer_checkpoint_make(&retained_timer.cp, started, active_time_min, epoch_now_us(now));
+    }
+    retained_timer.epoch_us = epoch_now_us(now);
+    retained_timer.epoch_us_inv = ~retained_timer.epoch_us;
+    lv_label_set_text_static(start_stop_label, started ? "Stop" : "Start");
+    show_time(active_time_min);
+}
+
+// Runs every tick. While the countdown runs the deadline stays the same, so this is a couple
+// of RAM stores; only start, stop, reset and setting the time reach the flash.
+static void checkpoint_timer(const absolute_time_t now)
+{
+    const uint64_t epoch_us = epoch_now_us(now);
+    retained_timer.epoch_us = epoch_us;
+    retained_timer.epoch_us_inv = ~epoch_us;
+
+    if (timer_checkpoint_update(&retained_timer.cp, started, active_time_min, epoch_us, &checkpoint_stats) ==
+        TimerCheckpointChanged) {
+        kv_set(KvKeyTimerState, &retained_timer.cp, sizeof(retained_timer.cp));
+    }
+}
+
+void ui_get_checkpoint_stats(timer_checkpoint_stats_t *stats)
+{
+    *stats = checkpoint_stats;
+}
+
+uint32_t ui_idle_ms()
+{
+    return lcd_disp ? lv_display_get_inactive_time(lcd_disp) : 0;
+}
+
+bool ui_alarm_active()
+{
+    return started && active_time_min == 0;
+}
+
+uint64_t ui_next_deadline_us()
+{
+    if (!started || !timer_checkpoint_valid(&retained_timer.cp)) {
+        return 0;
+    }
+    return retained_timer.cp.deadline_us - epoch_base_us;
+}
+
+static void wait_for_flush()
+{
+#ifdef LCD_TRANSPORT_PIO
+    while (lcd_pio_busy());
+#else
+    while (pending_xfer);
+#endif
+}
+
+// The panel keeps its frame memory in sleep mode, so nothing has to be redrawn on resume.
+static absolute_time_t panel_sleep_time = 0;
+
+void ui_suspend()
+{
+    wait_for_flush();
+    backlight_set(0, false);
+    send_lcd_cmd(lcd_disp, &ST7789_DISPOFF, 1, NULL, 0);
+    send_lcd_cmd(lcd_disp, &ST7789_SLPIN, 1, NULL, 0);
+    panel_sleep_time = get_absolute_time();
+}
+
+void ui_resume(power_wake_t wake)
+{
+    // Sleep out may only follow sleep in after 120 ms, display on 5 ms after sleep out.
+    sleep_until(delayed_by_ms(panel_sleep_time, 120));
+    send_lcd_cmd(lcd_disp, &ST7789_SLPOUT, 1, NULL, 0);
+    sleep_ms(5);
+    send_lcd_cmd(lcd_disp, &ST7789_DISPON, 1, NULL, 0);
+    backlight_set(BACKLIGHT_BRIGHT, false);
+
+    sync_timer_to_checkpoint(&retained_timer.cp, get_absolute_time());
+    lv_display_trigger_activity(lcd_disp);
+
+    // The touch that woke the display only wakes it. After a deadline wake the next touch is
+    // meant for the UI, the reminder is already showing.
+    if (wake == PowerWakeTouch) {
+        touch_screen_ignore_until_release();
+    }
+}
+
+#ifdef LCD_DRAW_BUF_BENCHMARK
+// Full screen render and flush. Compare builds with LCD_DRAW_BUF_PLACEMENT striped, split and
+// same; the difference only shows with LCD_TRANSPORT_PIO, the SPI flush blocks the CPU.
+static void draw_buffer_benchmark()
+{
+    const int frames = 20;
+    const uint64_t start_us = time_us_64();
+    for (int i = 0; i < frames; i++) {
+        lv_obj_invalidate(lv_screen_active());
+        lv_refr_now(lcd_disp);
+    }
+    const uint32_t frame_us = (uint32_t)((time_us_64() - start_us) / frames);
+    printf("Draw buffer benchmark: %d us per full screen render and flush\n\r", (int)frame_us);
+}
+#endif
+
+#if defined(UI_FRAME_CAPTURE) || defined(BENCHMARK_SUITE)
+// One screen per state of the UI, for the golden images of tools/frame_check.py and the
+// render benchmarks.
+typedef struct {
+    const char *name;
+    ui_state_t state;
+    uint32_t time_min;
+    bool started;
+    bool red;
+} capture_scene_t;
+
+static const capture_scene_t capture_scenes[] = {
+    {"idle",     StartStopTime, 45, false, false},
+    {"running",  StartStopTime, 44, true,  false},
+    {"expired",  StartStopTime, 0,  true,  true},
+    {"set_time", SetTime,       90, false, false},
+};
+
+static void show_scene(const capture_scene_t *scene)
+{
+    ui_state = scene->state;
+    show_screen();
+    lv_label_set_text_static(start_stop_label, scene->started ? "Stop" : "Start");
+    set_clock_red(scene->red);
+    show_time(scene->time_min);
+}
+
+// Back to what the countdown shows.
+static void leave_scenes()
+{
+    ui_state = StartStopTime;
+    show_screen();
+    set_clock_red(false);
+    lv_label_set_text_static(start_stop_label, started ? "Stop" : "Start");
+    show_time(active_time_min);
+}
+#endif
+
+#ifdef UI_FRAME_CAPTURE
+// Each scene is rendered three times: once to settle, once timed and once captured, as
+// printing the pixels takes far longer than drawing them.
+static void capture_frames()
+{
+    for (size_t i = 0; i < sizeof(capture_scenes) / sizeof(capture_scenes[0]); i++) {
+        const capture_scene_t *scene = &capture_scenes[i];
+        show_scene(scene);
+        lv_refr_now(lcd_disp);
+
+        // Untraced, the trace would time the UART instead.
+        frame_capture_set_trace(false);
+        lv_obj_invalidate(lv_screen_active());
+        const uint32_t start_us = time_us_32();
+        lv_refr_now(lcd_disp);
+        wait_for_flush();
+        const uint32_t render_us = time_us_32() - start_us;
+        frame_capture_set_trace(true);
+
+        frame_capture_begin(scene->name, LCD_H_RES, LCD_V_RES);
+        lv_obj_invalidate(lv_screen_active());
+        lv_refr_now(lcd_disp);
+        wait_for_flush();
+        frame_capture_end(render_us);
+    }
+    frame_capture_done();
+    leave_scenes();
+}
+#endif
+
+#ifdef BENCHMARK_SUITE
+static uint32_t time_renders(lv_obj_t *obj, uint32_t frames)
+{
+    const uint32_t start_us = time_us_32();
+    for (uint32_t i = 0; i < frames; i++) {
+        lv_obj_invalidate(obj);
+        lv_refr_now(lcd_disp);
+        wait_for_flush();
+    }
+    return time_us_32() - start_us;
+}
+
+void ui_benchmark()
+{
+    const uint32_t updates = 1000;
+    const uint32_t frames = 10;
+    char name[40];
+
+    // Every call changes the text, so each one lays the label out again.
+    const uint64_t show_us = bench_cpu_us();
+    for (uint32_t i = 0; i < updates; i++) {
+        show_time(i % 2 ? 61 : 754);
+    }
+    bench_report("ui.show_time", updates, bench_cpu_us() - show_us, 0);
+
+    // What the label renderer looks up for the clock and the Start button, in the linked fonts:
+    // the subsets with UI_FONT_SUBSET, the stock Montserrat fonts without.
+    static const char button_text[] = "Start";
+    lv_font_glyph_dsc_t dsc;
+    volatile uint32_t sink = 0;
+    uint64_t lookup_us = bench_cpu_us();
+    for (uint32_t i = 0; i < updates; i++) {
+        for (const char *c = GLYPH_CACHE_CHARS; *c; c++) {
+            sink += lv_font_get_glyph_dsc(UI_PROP_FONT_CLOCK, &dsc, (uint8_t)*c, 0);
+        }
+        for (const char *c = button_text; *c; c++) {
+            sink += lv_font_get_glyph_dsc(UI_PROP_FONT_BUTTON, &dsc, (uint8_t)*c, 0);
+        }
+    }
+    const uint32_t lookups = updates * (uint32_t)(strlen(GLYPH_CACHE_CHARS) + strlen(button_text));
+    bench_report("ui.glyph_lookup", lookups, bench_cpu_us() - lookup_us, 0);
+
+    // What a press of Start redraws.
+    bench_report("ui.render_button", frames, time_renders(start_stop_btn, frames), 0);
+
+    for (size_t i = 0; i < sizeof(capture_scenes) / sizeof(capture_scenes[0]); i++) {
+        const capture_scene_t *scene = &capture_scenes[i];
+        show_scene(scene);
+        lv_refr_now(lcd_disp);
+
+        snprintf(name, sizeof(name), "ui.render_full.%s", scene->name);
+        bench_report(name, frames, time_renders(lv_screen_active(), frames), (uint64_t)frames * LCD_H_RES * LCD_V_RES * 2);
+        snprintf(name, sizeof(name), "ui.render_clock.%s", scene->name);
+        bench_report(name, frames, time_renders(label_clock, frames), 0);
+    }
+
+    // The flush path on its own, a full draw buffer per call. This scribbles over the
+    // panel, the screen is redrawn below.
+    static const uint8_t ST7789_RAMWR = 0x2c;
+    const uint32_t start_us = time_us_32();
+    for (uint32_t i = 0; i < frames; i++) {
+        send_lcd_data(lcd_disp, &ST7789_RAMWR, 1, draw_buf1, sizeof(draw_buf1));
+        wait_for_flush();
+    }
+    bench_report("lcd.send_lcd_data", frames, time_us_32() - start_us, (uint64_t)frames * sizeof(draw_buf1));
+
+    leave_scenes();
+    lv_obj_invalidate(lv_screen_active());
+    lv_refr_now(lcd_disp);
+}
+#endif
+
+#ifdef LVGL_ALLOC_BENCHMARK
+// Creates and deletes a screen with the same widgets as the UI. Compare builds with
+// LVGL_SLAB_ALLOC on and off: objects created and deleted a second, and the allocator's peak.
+static void alloc_benchmark()
+{
+    const int rounds = 50;
+    const int objects = 3 + 2 * UI_BUTTON_COUNT;   // Screen, clock, line, buttons and labels
+    const uint64_t start_us = bench_cpu_us();
+    for (int r = 0; r < rounds; r++) {
+        lv_obj_t *scr = lv_obj_create(NULL);
+        lv_obj_t *clock = lv_obj_create(scr);
+        lv_obj_add_event_cb(clock, clock_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+        lv_line_create(scr);
+
+        for (size_t i = 0; i < UI_BUTTON_COUNT; i++) {
+            lv_obj_t *btn = lv_button_create(scr);
+            lv_obj_add_style(btn, &style_btn, 0);
+            lv_obj_add_event_cb(btn, ui_buttons[i].event_cb, LV_EVENT_RELEASED, ui_buttons[i].user_data);
+
+            lv_obj_t *label = lv_label_create(btn);
+            lv_obj_add_style(label, &style_btn_label, 0);
+            lv_label_set_text_static(label, ui_buttons[i].text);
+        }
+
+        lv_obj_delete(scr);
+    }
+    const uint64_t total_us = LV_MAX(bench_cpu_us() - start_us, 1);
+
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    printf("Alloc benchmark: %d us per UI create and delete, %d objects/s, peak %d bytes\n\r",
+           (int)(total_us / rounds), (int)((uint64_t)rounds * objects * 1000000 / total_us), (int)mon.max_used);
+}
+#endif
+
+static void gui_ready_step()
+{
+#ifdef LCD_DRAW_BUF_BENCHMARK
+    draw_buffer_benchmark();
+#endif
+#ifdef LVGL_ALLOC_BENCHMARK
+    alloc_benchmark();
+#endif
+#ifdef UI_FRAME_CAPTURE
+    capture_frames();
+#endif
+    restore_timer();
+
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    printf("LVGL heap after init: %d of %d bytes used, largest free block %d\n\r",
+           (int)(mon.total_size - mon.free_size), (int)mon.total_size, (int)mon.free_biggest_size);
+    slab_alloc_print_stats();
+}
+
+// The LCD track spends most of its time waiting on the panel. The LVGL track fills those waits.
+static const boot_step_t lcd_boot_steps[] = {
+    {"lcd reset",   lcd_reset_assert_step,  0,                0,                                     25 * 1000},
+    {"lcd release", lcd_reset_release_step, 0,                0,                                     125 * 1000},   // Worst case is 120 ms
+    {"lcd panel",   lcd_panel_step,         BootLvglReady,    BootDisplayCreated | BootDisplayReady, 0},
+};
+
+static const boot_step_t lvgl_boot_steps[] = {
+    {"lvgl init",   lvgl_init_step,         0,                  BootLvglReady, 0},
+    {"ui assets",   ui_assets_step,         0,                  0,             0},
+    {"ui build",    ui_build_step,          BootDisplayCreated, BootGuiReady,  0},
+    {"gui ready",   gui_ready_step,         BootDisplayReady,   0,             0},
+};
+
 int initialise_gui()
 {
-	initialise_lcd_hw();
-    initialise_lvgl_framework();
-    ui_init(lcd_disp);
-    prev_tick = get_absolute_time();
+    boot_sequencer_add_track(lcd_boot_steps, sizeof(lcd_boot_steps) / sizeof(lcd_boot_steps[0]));
+    boot_sequencer_add_track(lvgl_boot_steps, sizeof(lvgl_boot_steps) / sizeof(lvgl_boot_steps[0]));
 	return 0;
 }
 
@@ -463,7 +1062,40 @@ void show_time(const uint32_t time_in_min)
 {
     char time[10] = "";
     snprintf(time, sizeof(time), "%02d:%02d", time_in_min / 60, time_in_min % 60);
-    lv_label_set_text(label_clock, time);
+    set_clock_text(time);
+}
+
+// Sets the refresh timer period for this loop iteration and charges the time since the
+// last one to the mode the timer was in.
+static void tick_refresh_policy()
+{
+    const uint64_t now_us = time_us_64();
+    refresh_stats.time_us[refresh_policy_mode(&refresh_policy)] += now_us - refresh_stats_us;
+    refresh_stats_us = now_us;
+
+    const bool active = ui_idle_ms() < REFRESH_ACTIVE_MS || touch_screen_read_pending() || lv_anim_count_running() > 0;
+    const uint32_t period_ms = refresh_policy_update(&refresh_policy, lv_tick_get(), active);
+    if (period_ms != refresh_period_ms) {
+        lv_timer_set_period(lv_display_get_refr_timer(lcd_disp), period_ms);
+        refresh_period_ms = period_ms;
+    }
+}
+
+void ui_get_refresh_stats(ui_refresh_stats_t *stats)
+{
+    *stats = refresh_stats;
+}
+
+bool ui_is_idle()
+{
+    if (!lcd_disp || ui_idle_ms() < UI_IDLE_MS) {
+        return false;
+    }
+#ifdef LCD_TRANSPORT_PIO
+    return !lcd_pio_busy();
+#else
+    return !pending_xfer;
+#endif
 }
 
 void tick_ui()
@@ -477,9 +1109,7 @@ void tick_ui()
             active_time_min = (active_time_min > 0) ? (active_time_min - 1) : 0;
 
             if (active_time_min == 0) {
-                red = !red;
-                lv_color_t color = red ? lv_palette_main(LV_PALETTE_RED) : lv_color_hex(0xE0E0E0);
-                lv_obj_set_style_text_color(label_clock, color, 0);
+                set_clock_red(!red);
             }
         }
     }
@@ -492,8 +1122,7 @@ void tick_ui()
             prev_tick = curr_time;
             active_time_min = set_time_min;
             reset = false;
-            lv_color_t color = lv_color_hex(0xE0E0E0);
-            lv_obj_set_style_text_color(label_clock, color, 0);
+            set_clock_red(false);
             show_time(active_time_min);
         }
 
@@ -513,5 +1142,8 @@ void tick_ui()
         show_time(display_set_time);
     }
 
+    checkpoint_timer(curr_time);
+    tick_backlight(ui_idle_ms());
+    tick_refresh_policy();
     lv_timer_handler();
 }
@@ -0,0 +1,117 @@
+#include "frame_capture.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef UI_FRAME_CAPTURE
+
+#define CAPTURE_LINE_SIZE   (80)
+
+// From boot, so the panel init sequence is in the trace too.
+static bool tracing = true;
+static bool in_scene = false;
+static uint32_t frames = 0;
+static char scene_name[24];
+static uint32_t flushed_bytes = 0;
+
+static char line[CAPTURE_LINE_SIZE + 16];
+static size_t line_len = 0;
+
+static void line_flush()
+{
+    if (line_len) {
+        printf("fc px%s\n\r", line);
+        line_len = 0;
+    }
+}
+
+static void line_add(const char *text, int len)
+{
+    if (line_len + len > CAPTURE_LINE_SIZE) {
+        line_flush();
+    }
+    memcpy(&line[line_len], text, len + 1);
+    line_len += len;
+}
+
+void frame_capture_begin(const char *scene, uint32_t width, uint32_t height)
+{
+    snprintf(scene_name, sizeof(scene_name), "%s", scene);
+    flushed_bytes = 0;
+    in_scene = true;
+    printf("fc begin %s %d %d\n\r", scene_name, (int)width, (int)height);
+}
+
+void frame_capture_cmd(uint8_t cmd, const uint8_t *param, size_t size)
+{
+    if (!tracing) {
+        return;
+    }
+    printf("fc cmd %02x", cmd);
+    for (size_t i = 0; param && i < size; i++) {
+        printf(" %02x", param[i]);
+    }
+    printf("\n\r");
+}
+
+void frame_capture_data(uint8_t cmd, const uint16_t *px, size_t count, bool last)
+{
+    if (!tracing) {
+        return;
+    }
+
+    frame_capture_cmd(cmd, NULL, 0);
+    if (in_scene) {
+        flushed_bytes += count * 2;
+    }
+
+    size_t run = 1;
+    for (size_t i = 1; px && i <= count; i++) {
+        if (i < count && px[i] == px[i - 1]) {
+            run++;
+            continue;
+        }
+        char text[24];
+        const int len = (run == 1) ? snprintf(text, sizeof(text), " %04x", px[i - 1])
+                                   : snprintf(text, sizeof(text), " %d*%04x", (int)run, px[i - 1]);
+        line_add(text, len);
+        run = 1;
+    }
+    line_flush();
+
+    if (last) {
+        printf("fc frame\n\r");
+    }
+}
+
+void frame_capture_invalidate(int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    if (tracing) {
+        printf("fc inv %d %d %d %d\n\r", (int)x1, (int)y1, (int)x2, (int)y2);
+    }
+}
+
+void frame_capture_end(uint32_t render_us)
+{
+    in_scene = false;
+    frames++;
+    printf("fc end %s %d %d\n\r", scene_name, (int)render_us, (int)flushed_bytes);
+}
+
+void frame_capture_done()
+{
+    printf("fc done %d\n\r", (int)frames);
+    tracing = false;
+}
+
+void frame_capture_set_trace(bool on)
+{
+    tracing = on;
+}
+
+bool frame_capture_tracing()
+{
+    return tracing;
+}
+
+#endif   // UI_FRAME_CAPTURE
@@ -0,0 +1,219 @@
+#include "glyph_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The clock only ever shows 0-9 and ':' in two colours on a plain background. Instead of
+// letting LVGL look up, decode and alpha blend every glyph on every redraw, each glyph is
+// blended once at start-up into an RGB565 tile. A tile is an opaque image, so drawing it is
+// a straight row copy into the draw buffer.
+//
+// Tiles are cropped vertically to the rows any cached glyph touches, which keeps the
+// cache at roughly 40 KB for the 48 px font. They live on the C heap in SRAM, not the LVGL
+// heap and not in flash: every clock redraw reads every pixel of the tiles it shows, and
+// 40 KB of tiles would not stay in the 16 KB XIP cache, so from flash most redraws would
+// stall on cache misses. RAM_BUDGET_MIN_HEAP_BYTES in CMakeLists.txt keeps the heap room for
+// them.
+
+#define GLYPH_COUNT   (sizeof(GLYPH_CACHE_CHARS) - 1)
+
+typedef struct {
+    int32_t width;
+    lv_image_dsc_t image[GLYPH_CACHE_MAX_COLOURS];
+} glyph_tile_t;
+
+static glyph_tile_t tiles[GLYPH_COUNT];
+static int32_t tile_y_ofs = 0;      // First tile row relative to the top of the line
+static int32_t tile_height = 0;
+static size_t tile_colours = 0;
+static bool ready = false;
+
+static int glyph_index(const char c)
+{
+    const char *p = strchr(GLYPH_CACHE_CHARS, c);
+    return (p && c != '\0') ? (int)(p - GLYPH_CACHE_CHARS) : -1;
+}
+
+// Row of the line where the glyph box starts. Same placement as the label renderer.
+static int32_t glyph_top(const lv_font_t *font, const lv_font_glyph_dsc_t *dsc)
+{
+    return (font->line_height - font->base_line) - dsc->box_h - dsc->ofs_y;
+}
+
+static void blend_glyph(uint16_t *tile, const int32_t width, const lv_font_glyph_dsc_t *dsc,
+                        const lv_draw_buf_t *mask, const int32_t top, const uint16_t fg, const uint16_t bg)
+{
+    for (int32_t y = 0; y < (int32_t)dsc->box_h; y++) {
+        const int32_t ty = top + y - tile_y_ofs;
+        if (ty < 0 || ty >= tile_height) {
+            continue;
+        }
+
+        const uint8_t *mask_row = mask->data + (y * mask->header.stride);
+        for (int32_t x = 0; x < (int32_t)dsc->box_w; x++) {
+            const int32_t tx = dsc->ofs_x + x;
+            if (tx < 0 || tx >= width) {
+                continue;
+            }
+
+            // Same mix as the SW renderer uses for RGB565 targets.
+            tile[ty * width + tx] = lv_color_16_16_mix(fg, bg, mask_row[x]);
+        }
+    }
+}
+
+// Frees the tiles of a failed init, so the C heap is whole again for the label renderer.
+static void free_tiles(size_t colour_count)
+{
+    for (size_t i = 0; i < GLYPH_COUNT; i++) {
+        for (size_t c = 0; c < colour_count; c++) {
+            free((void *)tiles[i].image[c].data);
+            tiles[i].image[c].data = NULL;
+        }
+    }
+}
+
+int glyph_cache_init(const lv_font_t *font, lv_color_t bg, const lv_color_t *colours, size_t colour_count)
+{
+    if (!font || !colours || colour_count == 0 || colour_count > GLYPH_CACHE_MAX_COLOURS) {
+        return -1;
+    }
+
+    // First pass: find the rows touched by any glyph.
+    lv_font_glyph_dsc_t dscs[GLYPH_COUNT];
+    int32_t top_min = font->line_height;
+    int32_t bottom_max = 0;
+    for (size_t i = 0; i < GLYPH_COUNT; i++) {
+        if (!lv_font_get_glyph_dsc(font, &dscs[i], GLYPH_CACHE_CHARS[i], 0)) {
+            printf("Glyph cache: missing glyph '%c'\n\r", GLYPH_CACHE_CHARS[i]);
+            return -1;
+        }
+
+        const int32_t top = glyph_top(font, &dscs[i]);
+        top_min = LV_MIN(top_min, top);
+        bottom_max = LV_MAX(bottom_max, top + (int32_t)dscs[i].box_h);
+    }
+
+    tile_y_ofs = LV_MAX(top_min, 0);
+    tile_height = LV_MIN(bottom_max, font->line_height) - tile_y_ofs;
+
+    const uint16_t bg16 = lv_color_to_u16(bg);
+    size_t total_bytes = 0;
+
+    // Second pass: render the tiles.
+    for (size_t i = 0; i < GLYPH_COUNT; i++) {
+        lv_font_glyph_dsc_t *dsc = &dscs[i];
+        const int32_t width = dsc->adv_w;
+        const size_t tile_bytes = width * tile_height * sizeof(uint16_t);
+
+        // The font decodes the glyph into an A8 buffer, whatever its bpp.
+        lv_draw_buf_t *mask_buf = NULL;
+        const lv_draw_buf_t *mask = NULL;
+        if (dsc->box_w > 0 && dsc->box_h > 0) {
+            mask_buf = lv_draw_buf_create(dsc->box_w, dsc->box_h, LV_COLOR_FORMAT_A8, LV_STRIDE_AUTO);
+            if (!mask_buf) {
+                free_tiles(colour_count);
+                return -1;
+            }
+            mask = lv_font_get_glyph_bitmap(dsc, mask_buf);
+        }
+
+        tiles[i].width = width;
+        for (size_t c = 0; c < colour_count; c++) {
+            uint16_t *tile = malloc(tile_bytes);
+            if (!tile) {
+                printf("Glyph cache: tile allocation failed!\n\r");
+                if (mask_buf) {
+                    lv_draw_buf_destroy(mask_buf);
+                }
+                free_tiles(colour_count);
+                return -1;
+            }
+
+            for (int32_t p = 0; p < width * tile_height; p++) {
+                tile[p] = bg16;
+            }
+
+            if (mask) {
+                blend_glyph(tile, width, dsc, mask, glyph_top(font, dsc), lv_color_to_u16(colours[c]), bg16);
+            }
+
+            lv_image_dsc_t *img = &tiles[i].image[c];
+            memset(img, 0, sizeof(*img));
+            img->header.magic = LV_IMAGE_HEADER_MAGIC;
+            img->header.cf = LV_COLOR_FORMAT_RGB565;
+            img->header.w = width;
+            img->header.h = tile_height;
+            img->header.stride = width * sizeof(uint16_t);
+            img->data_size = tile_bytes;
+            img->data = (const uint8_t *)tile;
+            total_bytes += tile_bytes;
+        }
+
+        if (mask_buf) {
+            lv_draw_buf_destroy(mask_buf);
+        }
+    }
+
+    printf("Glyph cache: %d tiles, %d bytes\n\r", (int)(GLYPH_COUNT * colour_count), (int)total_bytes);
+    tile_colours = colour_count;
+    ready = true;
+    return 0;
+}
+
+bool glyph_cache_ready()
+{
+    return ready;
+}
+
+bool glyph_cache_covers(const char *text)
+{
+    for (const char *c = text; *c; c++) {
+        if (glyph_index(*c) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int32_t glyph_cache_text_width(const char *text)
+{
+    int32_t width = 0;
+    for (const char *c = text; *c; c++) {
+        const int idx = glyph_index(*c);
+        if (idx >= 0) {
+            width += tiles[idx].width;
+        }
+    }
+    return width;
+}
+
+void glyph_cache_draw(lv_layer_t *layer, const char *text, int32_t x, int32_t y, size_t colour_idx)
+{
+    if (!ready || colour_idx >= tile_colours) {
+        return;
+    }
+
+    lv_draw_image_dsc_t img_dsc;
+    lv_draw_image_dsc_init(&img_dsc);
+
+    for (const char *c = text; *c; c++) {
+        const int idx = glyph_index(*c);
+        if (idx < 0) {
+            continue;
+        }
+
+        const glyph_tile_t *tile = &tiles[idx];
+        const lv_area_t area = {
+            .x1 = x,
+            .y1 = y + tile_y_ofs,
+            .x2 = x + tile->width - 1,
+            .y2 = y + tile_y_ofs + tile_height - 1,
+        };
+
+        img_dsc.src = &tile->image[colour_idx];
+        lv_draw_image(layer, &img_dsc, &area);
+        x += tile->width;
+    }
+}
@@ -0,0 +1,195 @@
+#include "heap_profiler.h"
+#include "lvgl.h"
+#ifdef LVGL_SLAB_ALLOC
+#include "slab_alloc.h"
+#endif
+
+#include <stdio.h>
+
+// The wrappers sit between every LVGL module and lv_mem.c, so each allocation is seen with
+// the address it was called from. Calls inside lv_mem.c itself (lv_malloc_zeroed's internal
+// lv_malloc) are not wrapped, which is why lv_malloc_zeroed has its own wrapper.
+//
+// The site is the caller of lv_malloc(), not the code behind it. Blocks LVGL allocates in its
+// own helpers, lv_ll_ins_head() for a timer or an event, lv_array_push_back() for a style
+// list, all land on the one site in lv_ll.c or lv_array.c whoever asked for them.
+//
+// Live blocks are kept in a small table, scanned linearly on free. Call sites aggregate the
+// counts, bytes and lifetimes, so the report stays compact however long the soak runs.
+
+typedef struct {
+    void *ptr;
+    uint32_t size;
+    uint32_t alloc_ms;
+    uint8_t site;
+} live_block_t;
+
+void *__real_lv_malloc(size_t size);
+void *__real_lv_malloc_zeroed(size_t size);
+void *__real_lv_realloc(void *data_p, size_t new_size);
+void __real_lv_free(void *data);
+
+static live_block_t live[HEAP_PROFILER_MAX_LIVE];
+static heap_site_stats_t sites[HEAP_PROFILER_MAX_SITES];
+static size_t site_count = 0;
+static heap_profile_totals_t totals;
+
+static int site_index(const uintptr_t site)
+{
+    for (size_t i = 0; i < site_count; i++) {
+        if (sites[i].site == site) {
+            return (int)i;
+        }
+    }
+
+    if (site_count < HEAP_PROFILER_MAX_SITES) {
+        sites[site_count].site = site;
+        return (int)site_count++;
+    }
+
+    // Out of sites, the last slot collects the rest.
+    sites[HEAP_PROFILER_MAX_SITES - 1].site = 0;
+    return HEAP_PROFILER_MAX_SITES - 1;
+}
+
+static void record_alloc(void *ptr, const size_t size, const uintptr_t site)
+{
+    if (!ptr) {
+        if (size) {
+            totals.failed++;
+        }
+        return;
+    }
+
+    totals.allocs++;
+    totals.live++;
+    totals.live_bytes += size;
+    if (totals.live_bytes > totals.peak_bytes) {
+        totals.peak_bytes = totals.live_bytes;
+    }
+
+    const int idx = site_index(site);
+    heap_site_stats_t *s = &sites[idx];
+    s->allocs++;
+    s->live++;
+    s->live_bytes += size;
+    if (s->live_bytes > s->peak_bytes) {
+        s->peak_bytes = s->live_bytes;
+    }
+
+    for (size_t i = 0; i < HEAP_PROFILER_MAX_LIVE; i++) {
+        if (!live[i].ptr) {
+            live[i] = (live_block_t){.ptr = ptr, .size = size, .alloc_ms = lv_tick_get(), .site = idx};
+            return;
+        }
+    }
+    totals.untracked++;
+}
+
+static void record_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    totals.frees++;
+    for (size_t i = 0; i < HEAP_PROFILER_MAX_LIVE; i++) {
+        if (live[i].ptr == ptr) {
+            heap_site_stats_t *s = &sites[live[i].site];
+            const uint32_t lifetime_ms = lv_tick_elaps(live[i].alloc_ms);
+            s->live--;
+            s->live_bytes -= live[i].size;
+            s->freed++;
+            s->lifetime_ms_sum += lifetime_ms;
+            if (lifetime_ms > s->lifetime_ms_max) {
+                s->lifetime_ms_max = lifetime_ms;
+            }
+
+            totals.live--;
+            totals.live_bytes -= live[i].size;
+            live[i].ptr = NULL;
+            return;
+        }
+    }
+}
+
+void *__wrap_lv_malloc(size_t size)
+{
+    void *p = __real_lv_malloc(size);
+    record_alloc(p, size, (uintptr_t)__builtin_return_address(0));
+    return p;
+}
+
+void *__wrap_lv_malloc_zeroed(size_t size)
+{
+    void *p = __real_lv_malloc_zeroed(size);
+    record_alloc(p, size, (uintptr_t)__builtin_return_address(0));
+    return p;
+}
+
+void *__wrap_lv_realloc(void *data_p, size_t new_size)
+{
+    void *p = __real_lv_realloc(data_p, new_size);
+    if (p || new_size == 0) {
+        record_free(data_p);
+    }
+    record_alloc(p, new_size, (uintptr_t)__builtin_return_address(0));
+    return p;
+}
+
+void __wrap_lv_free(void *data)
+{
+    record_free(data);
+    __real_lv_free(data);
+}
+
+void heap_profiler_get_totals(heap_profile_totals_t *out)
+{
+    *out = totals;
+}
+
+size_t heap_profiler_site_count()
+{
+    return site_count;
+}
+
+const heap_site_stats_t *heap_profiler_get_site(size_t idx)
+{
+    return (idx < site_count) ? &sites[idx] : NULL;
+}
+
+void heap_profiler_report()
+{
+    printf("Heap profile at %d ms: %d live blocks, %d bytes, peak %d bytes\n\r",
+           (int)lv_tick_get(), (int)totals.live, (int)totals.live_bytes, (int)totals.peak_bytes);
+    printf("  allocs %d, frees %d, failed %d, untracked %d\n\r",
+           (int)totals.allocs, (int)totals.frees, (int)totals.failed, (int)totals.untracked);
+#ifdef LVGL_SLAB_ALLOC
+    // Fixed size blocks do not fragment, what counts is how full each class is and what
+    // spilled over to the C heap.
+    for (size_t i = 0; i < slab_alloc_class_count(); i++) {
+        slab_class_stats_t c;
+        slab_alloc_get_class_stats(i, &c);
+        printf("  slab %s: %d of %d blocks used, peak %d, %d overflows\n\r", c.name, (int)c.used, (int)c.capacity,
+               (int)c.peak, (int)c.overflows);
+    }
+    slab_heap_stats_t heap;
+    slab_alloc_get_heap_stats(&heap);
+    printf("  slab heap: %d blocks, %d bytes, peak %d bytes\n\r", (int)heap.live, (int)heap.live_bytes,
+           (int)heap.peak_bytes);
+#else
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    printf("  LVGL heap %d bytes, %d free in %d blocks, largest free block %d, fragmentation %d %%\n\r",
+           (int)mon.total_size, (int)mon.free_size, (int)mon.free_cnt, (int)mon.free_biggest_size, (int)mon.frag_pct);
+#endif
+
+    // Resolve sites with: arm-none-eabi-addr2line -f -e water_reminder.elf <site>
+    printf("  site        allocs  live   bytes    peak  avg life ms  max life ms\n\r");
+    for (size_t i = 0; i < site_count; i++) {
+        const heap_site_stats_t *s = &sites[i];
+        printf("  0x%08x %7d %5d %7d %7d %12d %12d\n\r", (unsigned int)s->site, (int)s->allocs, (int)s->live,
+               (int)s->live_bytes, (int)s->peak_bytes, s->freed ? (int)(s->lifetime_ms_sum / s->freed) : 0,
+               (int)s->lifetime_ms_max);
+    }
+}
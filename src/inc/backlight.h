@@ -0,0 +1,44 @@
+#ifndef _BACKLIGHT_H
+#define _BACKLIGHT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// PWM backlight. Levels are perceptual, 0 (off) to BACKLIGHT_LEVEL_MAX, and go through a
+// gamma table to the PWM duty. Fades are DMA transfers from the table into the compare
+// register, paced by the PWM wrap, so they take no CPU time.
+
+#define BACKLIGHT_LEVEL_MAX     (255)
+#define BACKLIGHT_PWM_WRAP      (4095)
+#define BACKLIGHT_PWM_HZ        (1000)   // One fade step per PWM period
+
+typedef struct {
+    uint8_t bright;
+    uint8_t dim;
+    uint32_t dim_after_ms;   // 0 never dims
+    uint32_t off_after_ms;   // 0 never switches off
+} backlight_config_t;
+
+// Level the backlight should be at after idle_ms without a touch.
+uint8_t backlight_policy_level(const backlight_config_t *config, uint32_t idle_ms);
+
+// PWM compare value for a level, gamma 2.2.
+uint16_t backlight_gamma(uint8_t level);
+
+// The fade from one level to another: count entries of the rising (up = true) or falling
+// ramp starting at first. Returns false if there is nothing to fade.
+bool backlight_fade_plan(uint8_t from, uint8_t to, bool *up, uint32_t *first, uint32_t *count);
+
+void backlight_init(uint32_t gpio, const backlight_config_t *config);
+
+// PWM clock divider in 8.4 fixed point, for a new clk_sys.
+void backlight_set_clkdiv16(uint32_t div16);
+
+// Fades take a step per PWM period, BACKLIGHT_LEVEL_MAX steps are 255 ms.
+void backlight_set(uint8_t level, bool fade);
+uint8_t backlight_level();
+
+// Applies the idle policy. Dimming fades, brightening on a touch is immediate.
+void tick_backlight(uint32_t idle_ms);
+
+#endif   // _BACKLIGHT_H
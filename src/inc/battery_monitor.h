@@ -1,9 +1,16 @@
 #ifndef _BATTERY_MONITOR_H
 #define _BATTERY_MONITOR_H
 
+// Interval between samples while the core sleeps. Otherwise the once a second loop timer
+// bumps battery_monitor_cnt and tick_battery_monitor() takes the sample.
+#define BATTERY_SLEEP_SAMPLE_MS   (60 * 1000)
+
 extern int battery_monitor_cnt;
 
 void battery_monitor_init();
 void tick_battery_monitor();
 
+// Samples the ADC now.
+void battery_monitor_sample();
+
 #endif   //  _BATTERY_MONITOR_H
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <stdint.h>
+
+// Benchmark results, one JSON object per line prefixed with "bench ", for
+// tools/bench_compare.py. Only built with BENCHMARK_SUITE, see run_benchmarks() in
+// water_reminder.c.
+
+// The build options that change the numbers, so results of two builds can be told apart.
+void bench_header();
+
+// iterations runs took total_us. bytes is what they moved, 0 if nothing.
+void bench_report(const char *name, uint32_t iterations, uint64_t total_us, uint64_t bytes);
+
+void bench_done();
+
+// Clock for the benchmarks of code that never waits on the hardware. time_us_64() unless a
+// host, where only SDK calls move the time, sets its own.
+void bench_set_cpu_clock(uint64_t (*now_us)());
+uint64_t bench_cpu_us();
+
+#endif   // _BENCH_H
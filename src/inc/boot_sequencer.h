@@ -0,0 +1,46 @@
+#ifndef _BOOT_SEQUENCER_H
+#define _BOOT_SEQUENCER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Milestones steps can wait for. A step provides its milestones once it has run.
+typedef enum {
+    BootLvglReady        = (1 << 0),   // lv_init() done
+    BootDisplayCreated   = (1 << 1),   // The LVGL display exists, the panel may still be initialising
+    BootDisplayReady     = (1 << 2),   // Panel initialised, draw buffers and input device set up
+    BootGuiReady         = (1 << 3),   // Widgets created
+    BootTouchReady       = (1 << 4),   // Touch controller set up
+} boot_milestone_t;
+
+typedef void (*boot_step_fn_t)();
+
+typedef struct {
+    const char *name;
+    boot_step_fn_t fn;
+    uint32_t requires;         // Milestones that must be reached before the step runs
+    uint32_t provides;         // Milestones reached once the step has run
+    uint32_t delay_after_us;   // Minimum time before the next step of the same track
+} boot_step_t;
+
+// A track is an ordered list of steps. Steps of different tracks run in whatever order their
+// delays and milestones allow, so one track's wait is spent on the others.
+void boot_sequencer_add_track(const boot_step_t *steps, size_t count);
+
+// Runs every track to completion.
+void boot_sequencer_run();
+
+// Waits for at least us microseconds, running steps of other tracks in the meantime.
+// Can be called from inside a step.
+void boot_sequencer_wait_us(uint32_t us);
+
+// Marks milestones as reached from inside a step that has not finished yet.
+void boot_sequencer_reach(uint32_t milestones);
+
+bool boot_sequencer_reached(uint32_t milestones);
+
+// Time since boot at which all the milestones were reached, 0 if not yet.
+uint32_t boot_sequencer_reached_at_ms(uint32_t milestones);
+
+#endif   // _BOOT_SEQUENCER_H
@@ -0,0 +1,42 @@
+#ifndef _CLOCK_GOVERNOR_H
+#define _CLOCK_GOVERNOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "clock_plan.h"
+
+// Runs clk_sys at the idle step between bursts of work and at full speed while LVGL renders
+// or the screen is being touched. Only built with CLOCK_GOVERNOR, otherwise the calls
+// compile to nothing and clk_sys stays at its boot frequency.
+
+typedef struct {
+    uint32_t transitions;
+    uint32_t latency_us_max;   // Divider change and peripheral reconfiguration
+    uint32_t latency_us_sum;
+    uint64_t step_us[CLOCK_STEP_COUNT];
+} clock_governor_stats_t;
+
+#ifdef CLOCK_GOVERNOR
+
+// Call once every peripheral is set up. Steps below idle_hz are not used.
+void clock_governor_init(uint32_t idle_hz);
+
+// Full speed now and for a little while after.
+void clock_governor_boost();
+
+// Drops to the idle step once the boost has expired, unless interactive.
+void tick_clock_governor(bool interactive);
+
+void clock_governor_get_stats(clock_governor_stats_t *stats);
+
+#else
+
+static inline void clock_governor_init(uint32_t idle_hz) {}
+static inline void clock_governor_boost() {}
+static inline void tick_clock_governor(bool interactive) {}
+static inline void clock_governor_get_stats(clock_governor_stats_t *stats) { memset(stats, 0, sizeof(*stats)); }
+
+#endif   // CLOCK_GOVERNOR
+
+#endif   // _CLOCK_GOVERNOR_H
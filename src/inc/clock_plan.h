@@ -0,0 +1,47 @@
+#ifndef _CLOCK_PLAN_H
+#define _CLOCK_PLAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Clock steps of the governor and what every clk_sys derived peripheral needs at each of
+// them. clk_sys is PLL_SYS divided by 1, 2, 4 or 8, so a step change is a divider write and
+// the PLL never relocks. clk_peri follows clk_sys, so the SPI and UART dividers are worked
+// out again. The arithmetic mirrors the SDK's, nothing here touches hardware, so the table
+// can be checked on a host.
+
+#define CLOCK_PLL_SYS_HZ     (125000000u)
+#define CLOCK_STEP_COUNT     (4)
+
+#define CLOCK_LCD_SPI_HZ     (50000000u)   // Asked for, SPI0 rounds down
+#define CLOCK_TOUCH_SPI_HZ   (100000u)
+#define CLOCK_UART_BAUD      (115200u)
+#define CLOCK_TICK_HZ        (1000u)       // SysTick, the LVGL tick
+#define CLOCK_LCD_PIO_MAX_SCK_HZ   (62500000u)
+#define CLOCK_BACKLIGHT_PWM_HZ     (1000u)
+#define CLOCK_BACKLIGHT_PWM_TOP    (4096u)
+
+typedef struct {
+    uint32_t sys_hz;
+    uint32_t systick_reload;
+    uint32_t lcd_spi_hz;        // Achieved
+    uint32_t touch_spi_hz;      // Achieved
+    uint32_t uart_baud;         // Achieved
+    uint32_t lcd_pio_div;       // Integer PIO clock divider, two cycles per SCK
+    uint32_t lcd_pio_sck_hz;
+    uint32_t backlight_div16;   // PWM clock divider, 8.4 fixed point
+} clock_plan_t;
+
+// clk_sys of a step, step 0 is the fastest.
+uint32_t clock_step_hz(size_t step);
+
+// Fills the plan for a clk_sys frequency. Returns false if a peripheral cannot be kept
+// within its limits: UART baud off by more than 2 %, an SPI rate above what was asked or
+// below half of it (touch) or a divider out of range.
+bool clock_plan_make(uint32_t sys_hz, clock_plan_t *plan);
+
+uint32_t clock_spi_rate(uint32_t peri_hz, uint32_t baud);
+uint32_t clock_uart_rate(uint32_t peri_hz, uint32_t baud);
+
+#endif   // _CLOCK_PLAN_H
@@ -0,0 +1,14 @@
+#ifndef _CRC16_H
+#define _CRC16_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CRC16_INIT   (0xffff)
+
+// CRC-16/CCITT-FALSE (polynomial 0x1021, no reflection, no final xor), start with CRC16_INIT
+// and chain calls to cover data in pieces. The KV store records, the timer checkpoint and the
+// telemetry frames use it; tools/telemetry_decode.py has the same.
+uint16_t crc16(uint16_t crc, const void *data, size_t len);
+
+#endif   // _CRC16_H
@@ -5,6 +5,7 @@
 
 extern int32_t debug_msg_flush_count;
 
+// Serves the UART command shell, call from the main loop.
 void check_for_messages();
 
 #endif   // _DEBUG_MESSAGES
\ No newline at end of file
@@ -1,7 +1,42 @@
 #ifndef _DISPLAY_FRAMEWORK_H
 #define _DISPLAY_FRAMEWORK_H
 
+#include <stdbool.h>
+#include "power_manager.h"
+#include "refresh_policy.h"
+#include "timer_checkpoint.h"
+
+// Registers the LCD and LVGL boot tracks, boot_sequencer_run() does the work.
 int initialise_gui();
 void tick_ui();
 
+// Nothing to draw and nobody touching the screen, so slow work (flash writes) will not show.
+bool ui_is_idle();
+
+// Countdown checkpoints: one rewrite per start, stop or reset, drift aside.
+void ui_get_checkpoint_stats(timer_checkpoint_stats_t *stats);
+
+// Display refresh timer activity per refresh_mode_t. Timer runs include the ones that found
+// nothing to draw; render time covers drawing and waiting for the flush.
+typedef struct {
+    uint32_t timer_runs[RefreshModeCount];
+    uint32_t renders[RefreshModeCount];
+    uint64_t render_us[RefreshModeCount];
+    uint64_t time_us[RefreshModeCount];
+} ui_refresh_stats_t;
+
+void ui_get_refresh_stats(ui_refresh_stats_t *stats);
+
+// For the power manager.
+uint32_t ui_idle_ms();             // Since the last touch
+bool ui_alarm_active();            // The countdown has run out and the clock is flashing
+uint64_t ui_next_deadline_us();    // Time since boot the running countdown ends, 0 if stopped
+void ui_suspend();                 // Backlight and panel off, tick_ui() must not run until resumed
+void ui_resume(power_wake_t wake);   // The touch behind a PowerWakeTouch is not passed on
+
+#ifdef BENCHMARK_SUITE
+// show_time(), full screen and clock only renders of every UI state and the flush path.
+void ui_benchmark();
+#endif
+
 #endif   // _DISPLAY_FRAMEWORK_H
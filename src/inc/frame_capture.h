@@ -0,0 +1,48 @@
+#ifndef _FRAME_CAPTURE_H
+#define _FRAME_CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Traces what goes to the panel as text on stdout: every command with its parameters and
+// the pixel data of every flush. tools/st7789_model.py replays a trace on a model of the
+// panel, tools/frame_check.py compares the boot scenes with the golden images. Only built
+// with UI_FRAME_CAPTURE, otherwise the calls compile to nothing.
+//
+//   fc cmd <cmd> <param> ...                      hex bytes
+//   fc px <rgb565> <count>*<rgb565> ...           pixel data after a RAMWR, run length encoded
+//   fc inv <x1> <y1> <x2> <y2>                    an area LVGL invalidated
+//   fc frame                                      after the last flush of a refresh
+//   fc begin <scene> <width> <height>
+//   fc end <scene> <render_us> <flushed_bytes>
+//   fc done <frames>                              after the last scene
+//
+// Tracing runs from boot to the end of the scenes, the shell 'trace' command turns it on
+// again.
+
+#ifdef UI_FRAME_CAPTURE
+
+void frame_capture_begin(const char *scene, uint32_t width, uint32_t height);
+
+// Panel commands and pixel data as they are flushed.
+void frame_capture_cmd(uint8_t cmd, const uint8_t *param, size_t size);
+void frame_capture_data(uint8_t cmd, const uint16_t *px, size_t count, bool last);
+void frame_capture_invalidate(int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+// render_us comes from a separate, untraced render of the same frame.
+void frame_capture_end(uint32_t render_us);
+void frame_capture_done();
+
+void frame_capture_set_trace(bool on);
+bool frame_capture_tracing();
+
+#else
+
+static inline void frame_capture_cmd(uint8_t cmd, const uint8_t *param, size_t size) {}
+static inline void frame_capture_data(uint8_t cmd, const uint16_t *px, size_t count, bool last) {}
+static inline void frame_capture_invalidate(int32_t x1, int32_t y1, int32_t x2, int32_t y2) {}
+
+#endif   // UI_FRAME_CAPTURE
+
+#endif   // _FRAME_CAPTURE_H
@@ -0,0 +1,28 @@
+#ifndef _GLYPH_CACHE_H
+#define _GLYPH_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "lvgl.h"
+
+// Glyphs held by the cache. Everything the clock can show.
+#define GLYPH_CACHE_CHARS         "0123456789:"
+#define GLYPH_CACHE_MAX_COLOURS   (2)
+
+// Pre-blends every cached glyph of the font against the background, once per colour,
+// into ready to copy RGB565 tiles. Returns 0 on success.
+int glyph_cache_init(const lv_font_t *font, lv_color_t bg, const lv_color_t *colours, size_t colour_count);
+
+bool glyph_cache_ready();
+
+// True when every character of text has a tile.
+bool glyph_cache_covers(const char *text);
+
+// Width of text in pixels: the sum of the advances without kerning, which is what the cache
+// draws.
+int32_t glyph_cache_text_width(const char *text);
+
+// Queues tile blits for text with the top left corner of the line at (x, y).
+void glyph_cache_draw(lv_layer_t *layer, const char *text, int32_t x, int32_t y, size_t colour_idx);
+
+#endif   // _GLYPH_CACHE_H
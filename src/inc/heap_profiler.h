@@ -0,0 +1,43 @@
+#ifndef _HEAP_PROFILER_H
+#define _HEAP_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Records every lv_malloc/lv_realloc/lv_free by call site. Linked in with LVGL_HEAP_PROFILER,
+// which wraps the LVGL allocation functions with -Wl,--wrap. Only LVGL's tick, printf and the
+// slab counters are used, so the same code runs in a host build.
+
+#define HEAP_PROFILER_MAX_LIVE    (256)   // Tracked live allocations
+#define HEAP_PROFILER_MAX_SITES   (48)    // Distinct call sites
+
+typedef struct {
+    uintptr_t site;            // Return address of the lv_malloc() call
+    uint32_t allocs;
+    uint32_t live;
+    uint32_t live_bytes;
+    uint32_t peak_bytes;
+    uint32_t freed;
+    uint64_t lifetime_ms_sum;  // Over the freed blocks
+    uint32_t lifetime_ms_max;
+} heap_site_stats_t;
+
+typedef struct {
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failed;
+    uint32_t untracked;        // Allocations that did not fit the live table
+    uint32_t live;
+    uint32_t live_bytes;
+    uint32_t peak_bytes;       // High watermark of live_bytes
+} heap_profile_totals_t;
+
+void heap_profiler_get_totals(heap_profile_totals_t *totals);
+size_t heap_profiler_site_count();
+const heap_site_stats_t *heap_profiler_get_site(size_t idx);
+
+// Prints the totals, the slab occupancy with LVGL_SLAB_ALLOC or else LVGL's own free and
+// fragmentation figures, and the per site table.
+void heap_profiler_report();
+
+#endif   // _HEAP_PROFILER_H
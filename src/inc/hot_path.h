@@ -0,0 +1,24 @@
+#ifndef _HOT_PATH_H
+#define _HOT_PATH_H
+
+#include "pico.h"
+
+// Functions on the flush and interrupt paths are copied to SRAM at boot (the SDK linker
+// script collects every .time_critical.* section into .data). A QSPI cache miss inside them
+// would otherwise stall the core for the whole XIP refill. They read no const tables, only
+// variables that are in SRAM already; a table added to these paths needs __not_in_flash().
+// What they call has to be in SRAM too: their own callees are marked, the SDK's SPI transfers
+// are in SRAM already, LVGL's flush calls go there through LV_ATTRIBUTE_FLUSH_READY and the
+// touch IRQ writes the GPIO registers itself. 'map_report.py hot' fails the build on a call
+// from them into flash. The UI_FRAME_CAPTURE and TOUCH_TRACE hooks are left in flash, they
+// are debug builds and compile to nothing otherwise.
+//
+// Build with HOT_PATHS_IN_SRAM=OFF to compare against execute in place, and with
+// PERF_COUNTERS=ON to measure the XIP cache hit rate and the ISR entry latency.
+#ifdef HOT_PATHS_IN_SRAM
+#define HOT_PATH_FUNC(name)   __not_in_flash_func(name)
+#else
+#define HOT_PATH_FUNC(name)   name
+#endif
+
+#endif   // _HOT_PATH_H
@@ -0,0 +1,83 @@
+#ifndef _KV_STORE_H
+#define _KV_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Log structured key-value store for settings. Records are appended to the active sector;
+// when it fills up the latest value of every key is copied into the next sector (round robin,
+// so erases are spread over all sectors) and that sector becomes active once its header is
+// written. A power cut at any point leaves either the old or the new sector valid.
+
+typedef enum {
+    KvKeyCountdownPreset = 1,   // uint32_t minutes
+    KvKeyTimerState      = 2,   // timer_checkpoint_t
+    KvKeyTouchCalibration = 3,  // touch_calibration_t
+    KvKeyCount
+} kv_key_t;
+
+#define KV_MAX_VALUE_SIZE       (32)
+#define KV_FLASH_SECTOR_COUNT   (4)
+
+// Flash access. Offsets are relative to the start of the store, sizes follow the device:
+// erase whole sectors, program whole pages (bits can only be cleared, 0xFF leaves them as is).
+typedef struct {
+    uint32_t sector_size;
+    uint32_t sector_count;
+    uint32_t page_size;
+    const uint8_t *(*read)(uint32_t offset);   // Memory mapped, stays valid until the next write
+    bool (*program)(uint32_t offset, const uint8_t *page);
+    bool (*erase)(uint32_t offset);
+    uint32_t (*now_us)();
+} kv_flash_port_t;
+
+typedef struct {
+    uint32_t records_written;
+    uint32_t compactions;
+    uint32_t generation;        // Header sequence of the active sector
+    uint32_t active_sector;
+    uint32_t used_bytes;        // In the active sector
+    uint32_t write_us_max;      // Longest single record write
+    uint32_t compact_us_max;    // Longest compaction, including the erase
+} kv_stats_t;
+
+// Loads the latest values from flash. Returns 0 on success; an empty or unreadable store
+// is formatted and is not an error.
+int kv_store_init(const kv_flash_port_t *port);
+
+// Returns the value length, or -1 if the key has never been set.
+int kv_get(uint8_t key, void *value, size_t size);
+
+// Updates the value in RAM. It reaches flash from tick_kv_store() or kv_store_flush().
+// Returns -1 for a bad key or size.
+int kv_set(uint8_t key, const void *value, size_t len);
+
+// Writes pending values. Programming and erasing stall the bus and mask interrupts, so only
+// pass idle = true when the UI has nothing to draw. At most one record or one compaction
+// happens per call.
+void tick_kv_store(bool idle);
+
+// Writes everything pending now, e.g. before power goes away.
+void kv_store_flush();
+
+bool kv_store_pending();
+void kv_store_get_stats(kv_stats_t *stats);
+
+// Port for the last sectors of the on-board flash.
+const kv_flash_port_t *kv_flash_pico_port();
+
+// Flash image in RAM with the same geometry and NOR semantics, for host builds and benchmarks.
+// After kv_flash_ram_cut_power(n) the n+1th program or erase and everything after it is
+// lost, as if power went away; kv_flash_ram_restore_power() ends that.
+const kv_flash_port_t *kv_flash_ram_port();
+void kv_flash_ram_cut_power(uint32_t ops);
+void kv_flash_ram_restore_power();
+
+#ifdef KV_STORE_BENCHMARK
+// Times writes, reads and compaction on the RAM image and checks a power cut in the middle
+// of a compaction. Call before kv_store_init(), it uses the store itself.
+void kv_store_benchmark();
+#endif
+
+#endif   // _KV_STORE_H
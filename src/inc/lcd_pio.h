@@ -0,0 +1,32 @@
+#ifndef _LCD_PIO_H
+#define _LCD_PIO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef void (*lcd_pio_done_cb_t)(void *ctx);
+
+// CSn and SCK are side-set pins and must be adjacent (SCK = CSn + 1).
+void lcd_pio_init(uint32_t tx_pin, uint32_t csn_pin, uint32_t sck_pin, uint32_t dcx_pin);
+
+// Returns the SCK frequency the state machine runs at.
+uint32_t lcd_pio_get_sck_hz();
+
+// Send a command byte followed by optional 8 bit parameters.
+// Waits for any pending pixel transfer before touching the FIFO, and returns once the last
+// bit is out and CSn is high.
+void lcd_pio_write_cmd(const uint8_t *cmd, size_t cmd_size, const uint8_t *param, size_t param_size);
+
+// Queue a command followed by 16 bit pixels. The pixels are sent by DMA and
+// done_cb is called from the DMA interrupt once the buffer can be reused.
+void lcd_pio_write_pixels(const uint8_t *cmd, size_t cmd_size, const uint16_t *pixels, size_t pixel_count,
+                          lcd_pio_done_cb_t done_cb, void *ctx);
+
+// Until the last bit of everything queued is out, not only until the FIFO is empty.
+bool lcd_pio_busy();
+
+// New state machine clock divider after a clk_sys change. Only while not busy.
+void lcd_pio_set_clkdiv(uint32_t div);
+
+#endif   // _LCD_PIO_H
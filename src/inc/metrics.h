@@ -0,0 +1,41 @@
+#ifndef _METRICS_H
+#define _METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Runtime counters fed by the display, touch, battery and main loop code. Rates are
+// averaged over the window since the last reset. Nothing here depends on the SDK, the
+// caller passes the time in.
+
+typedef struct {
+    uint64_t window_us;           // Time since the last reset
+    uint32_t loops;
+    uint32_t frames;
+    uint32_t flushes;
+    uint32_t flush_us_sum;
+    uint32_t flush_us_max;
+    uint32_t lcd_bytes;
+    uint32_t touch_samples;
+    uint32_t touch_latency_us_sum;
+    uint32_t touch_latency_us_max;
+    uint16_t battery_raw;
+    uint32_t battery_mv;
+} metrics_snapshot_t;
+
+void metrics_reset(uint64_t now_us);
+void metrics_get_snapshot(uint64_t now_us, metrics_snapshot_t *snap);
+
+void metrics_loop_tick();
+void metrics_frame_done();
+void metrics_flush(uint32_t bytes, uint32_t flush_us);
+// latency_us: from the pen down interrupt to the sample being read.
+void metrics_touch_sample(uint32_t latency_us);
+void metrics_battery(uint16_t raw, uint32_t mv);
+
+// Formats metric line idx (no line ending) into buf. Returns false past the last line, so
+// callers can emit one line at a time.
+bool metrics_format_line(size_t idx, uint64_t now_us, char *buf, size_t size);
+
+#endif   // _METRICS_H
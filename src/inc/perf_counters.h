@@ -0,0 +1,44 @@
+#ifndef _PERF_COUNTERS_H
+#define _PERF_COUNTERS_H
+
+#include <stdint.h>
+#include "hardware/structs/systick.h"
+
+// XIP cache hit rate and SysTick ISR entry latency, reported from the main loop.
+// Only built with PERF_COUNTERS, otherwise every call compiles to nothing.
+
+#ifdef PERF_COUNTERS
+
+extern volatile uint32_t perf_isr_latency_min;
+extern volatile uint32_t perf_isr_latency_max;
+extern volatile uint32_t perf_isr_latency_sum;
+extern volatile uint32_t perf_isr_count;
+
+// Called first thing in isr_systick(). The counter reloads from RVR when it wraps, so the
+// cycles it has counted down since then are the time from the exception to this point.
+// Inline, so it sits in whatever memory the ISR was placed in.
+static inline void perf_counters_isr_entry()
+{
+    const uint32_t latency = systick_hw->rvr - systick_hw->cvr;
+    if (latency < perf_isr_latency_min) {
+        perf_isr_latency_min = latency;
+    }
+    if (latency > perf_isr_latency_max) {
+        perf_isr_latency_max = latency;
+    }
+    perf_isr_latency_sum += latency;
+    perf_isr_count++;
+}
+
+void perf_counters_reset();
+void tick_perf_counters();
+
+#else
+
+static inline void perf_counters_isr_entry() {}
+static inline void perf_counters_reset() {}
+static inline void tick_perf_counters() {}
+
+#endif   // PERF_COUNTERS
+
+#endif   // _PERF_COUNTERS_H
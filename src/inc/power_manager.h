@@ -0,0 +1,78 @@
+#ifndef _POWER_MANAGER_H
+#define _POWER_MANAGER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Low power state machine. After the idle timeout the UI is suspended (display off, LVGL
+// not run) and the core sleeps until the pen down interrupt or the next countdown deadline.
+// Background work falling due meanwhile, the battery sample, wakes the core without the UI.
+// Nothing here depends on the SDK, the port does the sleeping, so the state machine and the
+// wake latency accounting run on a host with a stubbed port.
+
+typedef enum {
+    PowerActive,
+    PowerSuspending,   // Display going off
+    PowerSleep,
+    PowerWaking,       // From the wake up to the UI being back
+    PowerStateCount
+} power_state_t;
+
+typedef enum {
+    PowerWakeTouch,
+    PowerWakeDeadline,
+    PowerWakeOther,    // Any other interrupt, the manager goes back to sleep
+} power_wake_t;
+
+struct repeating_timer;
+
+typedef struct {
+    uint64_t (*now_us)();
+    uint32_t (*idle_ms)();            // Since the last user input
+    bool (*busy)();                   // Something needs the UI awake, e.g. a reminder showing
+    uint64_t (*next_deadline_us)();   // When the UI next has to run, 0 for never
+    void (*suspend_ui)();
+    void (*resume_ui)(power_wake_t wake);            // PowerWakeTouch or PowerWakeDeadline
+    uint64_t (*next_service_us)();                   // Background work due while asleep, 0 for none
+    void (*service)();                               // Does it, the UI stays suspended
+    power_wake_t (*sleep_until)(uint64_t wake_us);   // 0: no deadline
+} power_port_t;
+
+typedef struct {
+    uint32_t idle_timeout_ms;   // 0 never sleeps
+    uint32_t wake_budget_us;    // Wake up to UI restored
+} power_config_t;
+
+typedef struct {
+    uint64_t state_us[PowerStateCount];
+    uint32_t sleeps;
+    uint32_t wakes_touch;
+    uint32_t wakes_deadline;
+    uint32_t wakes_service;     // Background work, back to sleep without the UI
+    uint32_t wakes_other;
+    uint32_t wake_us_max;
+    uint32_t wake_over_budget;
+} power_stats_t;
+
+void power_manager_init(const power_port_t *port, const power_config_t *config);
+
+// Goes to sleep when the UI has been idle long enough, and returns once it is awake again.
+void tick_power_manager();
+
+power_state_t power_manager_state();
+
+// Time in the current state is included.
+void power_manager_get_stats(power_stats_t *stats);
+
+const char *power_state_name(power_state_t state);
+
+// Port for the RP2040, sleeping with most clocks gated.
+const power_port_t *power_pico_port();
+
+// Adds a repeating timer that only serves the main loop. The RP2040 port cancels it while the
+// core sleeps, so it does not wake the core, and arms it again on wake. false if it could not
+// be added.
+bool power_pico_add_loop_timer(struct repeating_timer *timer, int32_t period_ms,
+                               bool (*cb)(struct repeating_timer *timer));
+
+#endif   // _POWER_MANAGER_H
@@ -0,0 +1,40 @@
+#ifndef _REFRESH_POLICY_H
+#define _REFRESH_POLICY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Period of the LVGL display refresh timer. Full rate while the screen is touched or an
+// animation runs, then the period doubles every step_ms until it reaches idle_period_ms.
+// While idle the timer is also kicked when something is invalidated, so the countdown
+// still redraws the moment its text changes.
+
+typedef enum {
+    RefreshInteractive,
+    RefreshFallback,
+    RefreshIdle,
+    RefreshModeCount
+} refresh_mode_t;
+
+typedef struct {
+    uint32_t min_period_ms;    // While touched or animating
+    uint32_t idle_period_ms;
+    uint32_t hold_ms;          // Full rate kept this long after the last activity
+    uint32_t step_ms;          // Then the period doubles every step_ms
+} refresh_config_t;
+
+typedef struct {
+    refresh_config_t config;
+    uint32_t last_active_ms;
+    uint32_t period_ms;
+} refresh_policy_t;
+
+void refresh_policy_init(refresh_policy_t *policy, const refresh_config_t *config, uint32_t now_ms);
+
+// Returns the period for now, active is a touch or a running animation.
+uint32_t refresh_policy_update(refresh_policy_t *policy, uint32_t now_ms, bool active);
+
+refresh_mode_t refresh_policy_mode(const refresh_policy_t *policy);
+const char *refresh_mode_name(refresh_mode_t mode);
+
+#endif   // _REFRESH_POLICY_H
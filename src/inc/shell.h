@@ -0,0 +1,27 @@
+#ifndef _SHELL_H
+#define _SHELL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Line based command shell. Never blocks: every shell_tick() reads what has arrived, formats
+// at most one line of output and writes as much as the port accepts.
+
+typedef struct {
+    int (*read_char)();                              // Next received character, or -1
+    size_t (*write)(const char *data, size_t len);   // Bytes accepted without blocking
+    uint64_t (*now_us)();
+} shell_port_t;
+
+#define SHELL_TX_BUFFER_SIZE   (512)
+#define SHELL_LINE_SIZE        (32)
+
+void shell_init(const shell_port_t *port);
+void shell_tick();
+
+// Queues raw bytes behind the shell output, all or nothing, so other streams sharing the
+// UART (telemetry frames) are never split by shell text. Returns false if they do not fit.
+bool shell_write(const void *data, size_t len);
+
+#endif   // _SHELL_H
@@ -0,0 +1,33 @@
+#ifndef _SLAB_ALLOC_H
+#define _SLAB_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// LVGL allocator backend (LV_STDLIB_CUSTOM): fixed size blocks for the few object sizes the
+// UI creates, with the C heap for anything that does not fit a size class.
+
+typedef struct {
+    const char *name;
+    size_t block_size;
+    uint32_t capacity;
+    uint32_t used;
+    uint32_t peak;
+    uint32_t allocs;
+    uint32_t overflows;   // Allocations that fell back to the heap because the class was full
+} slab_class_stats_t;
+
+typedef struct {
+    uint32_t allocs;
+    uint32_t live;
+    uint32_t peak_live;
+    size_t live_bytes;
+    size_t peak_bytes;
+} slab_heap_stats_t;
+
+size_t slab_alloc_class_count();
+void slab_alloc_get_class_stats(size_t idx, slab_class_stats_t *stats);
+void slab_alloc_get_heap_stats(slab_heap_stats_t *stats);
+void slab_alloc_print_stats();
+
+#endif   // _SLAB_ALLOC_H
@@ -0,0 +1,25 @@
+#ifndef _STACK_MONITOR_H
+#define _STACK_MONITOR_H
+
+#include <stdint.h>
+
+typedef enum {
+    StackCore0,
+    StackCore1,
+} stack_id_t;
+
+typedef struct {
+    uint32_t size;        // Bytes reserved by the linker script
+    uint32_t high_water;  // Most bytes ever used since painting
+} stack_usage_t;
+
+// Fills the unused part of the core 0 stack, and the whole core 1 stack, with a pattern.
+// Call first thing in main(), before anything deep has run.
+void stack_monitor_paint();
+
+// Measures how much of the stack the pattern no longer covers.
+stack_usage_t stack_monitor_usage(stack_id_t stack);
+
+void stack_monitor_report();
+
+#endif   // _STACK_MONITOR_H
@@ -0,0 +1,50 @@
+#ifndef _TELEMETRY_H
+#define _TELEMETRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Periodic binary telemetry. Each record is followed by a CRC-16/CCITT-FALSE over the record,
+// the pair is COBS encoded and terminated by a zero byte. tools/telemetry_decode.py turns a
+// capture into CSV. All fields are little endian.
+
+#define TELEMETRY_VERSION     (1)
+#define TELEMETRY_PERIOD_MS   (1000)
+
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint16_t seq;
+    uint32_t timestamp_ms;
+    uint16_t battery_mv;
+    uint32_t loops_per_s;
+    uint16_t fps_x10;
+    uint16_t flush_avg_us;
+    uint16_t flush_max_us;
+    uint32_t lcd_bytes_per_s;
+    uint16_t touch_samples;
+    uint16_t touch_latency_avg_us;
+    uint16_t touch_latency_max_us;
+    uint32_t heap_used;
+    uint32_t heap_biggest_free;
+    uint8_t heap_frag_pct;
+    uint16_t encode_us;           // Cost of building and encoding the previous record
+    uint16_t dropped;             // Records that did not fit the transmit buffer so far
+} telemetry_record_t;
+
+// Worst case COBS output: one overhead byte per 254 bytes, plus the terminating zero.
+#define TELEMETRY_FRAME_MAX   (sizeof(telemetry_record_t) + 2 + 1 + 1)
+
+// COBS encodes len bytes into out and appends the zero delimiter. Returns the frame size.
+size_t telemetry_cobs_encode(const uint8_t *in, size_t len, uint8_t *out);
+
+// Builds the CRC protected frame for a record. Returns the frame size.
+size_t telemetry_encode(const telemetry_record_t *record, uint8_t *frame);
+
+#ifdef TELEMETRY
+void tick_telemetry();
+#else
+static inline void tick_telemetry() {}
+#endif
+
+#endif   // _TELEMETRY_H
@@ -0,0 +1,45 @@
+#ifndef _TIMER_CHECKPOINT_H
+#define _TIMER_CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Countdown state that survives a reset. A running countdown is saved as the time it reaches
+// zero, so the checkpoint stays true while it counts down and only start, stop, reset and
+// drift need a new one. Times are on an epoch that keeps counting across warm resets.
+// Nothing here depends on the SDK, the caller passes the time in.
+
+typedef struct {
+    uint8_t started;
+    uint8_t pad[3];
+    uint32_t remaining_s;   // While stopped
+    uint64_t deadline_us;   // While started: epoch time the countdown reaches zero
+    uint64_t saved_us;      // Epoch time of the checkpoint
+    uint32_t crc;
+} timer_checkpoint_t;
+
+typedef enum {
+    TimerCheckpointCurrent,   // Still describes the countdown
+    TimerCheckpointDrift,     // Rewritten, the countdown and the deadline drifted apart
+    TimerCheckpointChanged,   // Rewritten, the countdown was started, stopped or set
+} timer_checkpoint_result_t;
+
+typedef struct {
+    uint32_t updates;   // Calls to timer_checkpoint_update()
+    uint32_t drifts;
+    uint32_t changes;
+} timer_checkpoint_stats_t;
+
+void timer_checkpoint_make(timer_checkpoint_t *cp, bool started, uint32_t remaining_s, uint64_t now_us);
+bool timer_checkpoint_valid(const timer_checkpoint_t *cp);
+
+// Countdown left at now_us, rounded up to whole seconds. For a started checkpoint read back
+// after a power loss the epoch has restarted, pass saved_us to get what was left when saved.
+uint32_t timer_checkpoint_remaining_s(const timer_checkpoint_t *cp, uint64_t now_us);
+
+// Rewrites cp if it no longer describes the countdown. Up to a second of difference between
+// the deadline and a running countdown is allowed, two seconds count as drift.
+timer_checkpoint_result_t timer_checkpoint_update(timer_checkpoint_t *cp, bool started, uint32_t remaining_s, uint64_t now_us,
+                             timer_checkpoint_stats_t *stats);
+
+#endif   // _TIMER_CHECKPOINT_H
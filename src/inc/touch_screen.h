@@ -10,8 +10,20 @@ typedef struct {
     uint16_t y;
 } touch_point_t;
 
+// Raw readings at the edges of the screen.
+typedef struct {
+    uint16_t x_min;
+    uint16_t x_max;
+    uint16_t y_min;
+    uint16_t y_max;
+} touch_calibration_t;
+
+// Loads the calibration from the KV store, kv_store_init() must have run.
 void init_touch_screen();
 
+// Applies the calibration and saves it in the KV store.
+void touch_screen_set_calibration(const touch_calibration_t *cal);
+
 // The following functions must be executed in normal context.
 // They should never interrupt each other.
 void tick_touch_screen();
@@ -19,4 +31,15 @@ void tick_touch_screen();
 // Read the last touch point. The last touch point is latching until released.
 touch_point_t get_touch_point();
 
+// A pen down interrupt or a follow-up read is waiting for tick_touch_screen().
+bool touch_screen_read_pending();
+
+// The touch in progress is not reported, e.g. the one that woke the display up.
+void touch_screen_ignore_until_release();
+
+#ifdef BENCHMARK_SUITE
+// Reading conversion throughput, on made up readings.
+void touch_screen_benchmark();
+#endif
+
 #endif   // _TOUCH_SCREEN_H
@@ -0,0 +1,69 @@
+#ifndef _TOUCH_TRACE_H
+#define _TOUCH_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Records the raw XPT2046 readings of real touches and replays them through the touch
+// driver with their original timing, measuring how long each press and release takes to
+// reach an LVGL event and a rendered frame. Traces move between the device and
+// tools/touch_trace.py as shell lines, see the 'rec', 'dump', 'tt', 'play' and 'lat'
+// commands. Only built with TOUCH_TRACE, otherwise the calls compile to nothing.
+
+#define TOUCH_TRACE_MAX_SAMPLES   (512)
+
+typedef struct {
+    uint32_t t_us;     // Since the first sample
+    uint16_t raw_x;
+    uint16_t raw_y;
+} touch_trace_sample_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} touch_latency_t;
+
+#ifdef TOUCH_TRACE
+
+// Recording starts empty and stops when the buffer is full.
+void touch_trace_set_recording(bool on);
+bool touch_trace_recording();
+void touch_trace_record(uint32_t now_us, uint16_t raw_x, uint16_t raw_y);
+
+// The trace in the buffer, recorded or loaded.
+size_t touch_trace_count();
+bool touch_trace_get(size_t idx, touch_trace_sample_t *sample);
+void touch_trace_clear();
+bool touch_trace_load(const touch_trace_sample_t *sample);
+
+// Replay. touch_trace_next() hands out the samples as they come due.
+void touch_trace_start_replay(uint32_t now_us);
+bool touch_trace_replaying();
+bool touch_trace_next(uint32_t now_us, uint16_t *raw_x, uint16_t *raw_y);
+
+// A replayed sample pressed or released, LVGL delivered a press or release event, a frame
+// was rendered. Each edge is matched with the first event and the first frame after it.
+void touch_trace_edge(uint32_t now_us);
+void touch_trace_event(uint32_t now_us);
+void touch_trace_frame(uint32_t now_us);
+
+// Latencies of the last replay.
+void touch_trace_latency(touch_latency_t *to_event, touch_latency_t *to_frame);
+
+#else
+
+static inline bool touch_trace_recording() { return false; }
+static inline void touch_trace_record(uint32_t now_us, uint16_t raw_x, uint16_t raw_y) {}
+static inline bool touch_trace_replaying() { return false; }
+static inline bool touch_trace_next(uint32_t now_us, uint16_t *raw_x, uint16_t *raw_y) { return false; }
+static inline void touch_trace_edge(uint32_t now_us) {}
+static inline void touch_trace_event(uint32_t now_us) {}
+static inline void touch_trace_frame(uint32_t now_us) {}
+
+#endif   // TOUCH_TRACE
+
+#endif   // _TOUCH_TRACE_H
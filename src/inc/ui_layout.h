@@ -0,0 +1,35 @@
+#ifndef _UI_LAYOUT_H
+#define _UI_LAYOUT_H
+
+#include "ui_properties.h"
+#include "ui_font_metrics.h"   // Generated from the linked fonts by tools/ui_fonts.py
+
+// Absolute geometry of every widget, fixed at build time so ui_init() never has to run a
+// layout pass to measure one widget before placing the next.
+
+// Buttons are sized to fit "Reset" with the internal padding around it.
+#define UI_LAYOUT_BTN_WIDTH          (UI_TEXT_WIDTH_RESET + UI_PROP_INTERNAL_PADDING_PX * 4)
+#define UI_LAYOUT_BTN_HEIGHT         (UI_FONT_20_LINE_HEIGHT + UI_PROP_INTERNAL_PADDING_PX * 2)
+
+// The set time screen splits a row in three.
+#define UI_LAYOUT_THIRD_WIDTH        ((UI_PROP_SCREEN_WIDTH_PX - UI_PROP_BORDER_PADDING_PX * 2 - UI_PROP_INTERNAL_PADDING_PX * 2) / 3)
+
+// Two rows of buttons at the bottom, separated by the internal padding.
+#define UI_LAYOUT_ROW_BOTTOM_Y       (UI_PROP_SCREEN_HEIGHT_PX - UI_PROP_BOTTOM_MARGIN_PX - UI_LAYOUT_BTN_HEIGHT)
+#define UI_LAYOUT_ROW_TOP_Y          (UI_LAYOUT_ROW_BOTTOM_Y - UI_PROP_INTERNAL_PADDING_PX - UI_LAYOUT_BTN_HEIGHT)
+
+#define UI_LAYOUT_MID_X              ((UI_PROP_SCREEN_WIDTH_PX - UI_LAYOUT_BTN_WIDTH) / 2)
+#define UI_LAYOUT_LEFT_X             (UI_PROP_BORDER_PADDING_PX)
+#define UI_LAYOUT_RIGHT_X            (UI_PROP_SCREEN_WIDTH_PX - UI_PROP_BORDER_PADDING_PX - UI_LAYOUT_THIRD_WIDTH)
+
+// "Set" sits in the middle of the bottom half.
+#define UI_LAYOUT_SET_X              ((UI_PROP_SCREEN_WIDTH_PX - UI_LAYOUT_THIRD_WIDTH) / 2)
+#define UI_LAYOUT_SET_Y              ((UI_PROP_SCREEN_HEIGHT_PX - UI_LAYOUT_BTN_HEIGHT) / 2 + UI_PROP_SCREEN_HEIGHT_PX / 4)
+
+// The clock is centred in the top half, its x depends on the text width.
+#define UI_LAYOUT_CLOCK_HEIGHT       (UI_FONT_48_LINE_HEIGHT)
+#define UI_LAYOUT_CLOCK_Y            (UI_PROP_SCREEN_HEIGHT_PX / 4 - UI_LAYOUT_CLOCK_HEIGHT / 2)
+
+#define UI_LAYOUT_LINE_Y             (UI_PROP_SCREEN_HEIGHT_PX / 2)
+
+#endif   // _UI_LAYOUT_H
@@ -1,7 +1,20 @@
 #ifndef _UI_PROPERTIES
 #define _UI_PROPERTIES
 
+#define UI_PROP_SCREEN_WIDTH_PX      (240)
+#define UI_PROP_SCREEN_HEIGHT_PX     (320)
+
 #define UI_PROP_BORDER_PADDING_PX    (16)
 #define UI_PROP_INTERNAL_PADDING_PX  (10)
+#define UI_PROP_BOTTOM_MARGIN_PX     (26)
+
+// Fonts are declared by lv_conf.h. The subsets only hold the glyphs the UI uses.
+#ifdef UI_FONT_SUBSET
+#define UI_PROP_FONT_BUTTON          (&ui_font_20)
+#define UI_PROP_FONT_CLOCK           (&ui_font_48)
+#else
+#define UI_PROP_FONT_BUTTON          (&lv_font_montserrat_20)
+#define UI_PROP_FONT_CLOCK           (&lv_font_montserrat_48)
+#endif
 
 #endif   // _UI_PROPERTIES
\ No newline at end of file
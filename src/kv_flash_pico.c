@@ -0,0 +1,83 @@
+#include "kv_store.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include "pico/time.h"
+
+#include <stdio.h>
+
+// The store lives in the last KV_FLASH_SECTOR_COUNT sectors of the on-board flash. Reads go
+// through XIP. Programming and erasing run under flash_safe_execute(), which parks the other
+// core if it runs and masks interrupts here, as nothing may execute from flash meanwhile.
+// A page program takes under a millisecond, a sector erase around 50 ms.
+
+#define KV_FLASH_OFFSET       (PICO_FLASH_SIZE_BYTES - KV_FLASH_SECTOR_COUNT * FLASH_SECTOR_SIZE)
+#define KV_FLASH_TIMEOUT_MS   (10)
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *page;
+} flash_op_t;
+
+extern char __flash_binary_end;
+
+static void do_program(void *param)
+{
+    const flash_op_t *op = param;
+    flash_range_program(KV_FLASH_OFFSET + op->offset, op->page, FLASH_PAGE_SIZE);
+}
+
+static void do_erase(void *param)
+{
+    const flash_op_t *op = param;
+    flash_range_erase(KV_FLASH_OFFSET + op->offset, FLASH_SECTOR_SIZE);
+}
+
+static const uint8_t *pico_read(uint32_t offset)
+{
+    return (const uint8_t *)(XIP_BASE + KV_FLASH_OFFSET + offset);
+}
+
+static bool pico_program(uint32_t offset, const uint8_t *page)
+{
+    flash_op_t op = {.offset = offset, .page = page};
+    const int rc = flash_safe_execute(do_program, &op, KV_FLASH_TIMEOUT_MS);
+    if (rc != PICO_OK) {
+        printf("ERROR: Flash program at %d failed: %d\n\r", (int)offset, rc);
+    }
+    return rc == PICO_OK;
+}
+
+static bool pico_erase(uint32_t offset)
+{
+    flash_op_t op = {.offset = offset};
+    const int rc = flash_safe_execute(do_erase, &op, KV_FLASH_TIMEOUT_MS);
+    if (rc != PICO_OK) {
+        printf("ERROR: Flash erase at %d failed: %d\n\r", (int)offset, rc);
+    }
+    return rc == PICO_OK;
+}
+
+static uint32_t pico_now_us()
+{
+    return time_us_32();
+}
+
+static const kv_flash_port_t pico_port = {
+    .sector_size = FLASH_SECTOR_SIZE,
+    .sector_count = KV_FLASH_SECTOR_COUNT,
+    .page_size = FLASH_PAGE_SIZE,
+    .read = pico_read,
+    .program = pico_program,
+    .erase = pico_erase,
+    .now_us = pico_now_us,
+};
+
+const kv_flash_port_t *kv_flash_pico_port()
+{
+    // A firmware image grown into the store would be erased by the first compaction.
+    if ((uintptr_t)&__flash_binary_end - XIP_BASE > KV_FLASH_OFFSET) {
+        printf("ERROR: Firmware overlaps the KV store flash sectors.\n\r");
+        return NULL;
+    }
+    return &pico_port;
+}
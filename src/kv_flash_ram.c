@@ -0,0 +1,90 @@
+#include "kv_store.h"
+#include "pico/time.h"
+
+#include <string.h>
+
+// Same geometry as the on-board flash port. Programming ANDs the page into the image, like
+// NOR flash, so records can share a page exactly as they do on the device.
+
+#define KV_RAM_SECTOR_SIZE    (4096)
+#define KV_RAM_SECTOR_COUNT   (KV_FLASH_SECTOR_COUNT)
+#define KV_RAM_PAGE_SIZE      (256)
+
+static uint8_t image[KV_RAM_SECTOR_SIZE * KV_RAM_SECTOR_COUNT];
+static bool image_erased = false;
+
+static bool power_cut = false;
+static uint32_t ops_left = 0;
+
+// Counts down the operations left before the power cut. Returns false once it has happened.
+static bool powered()
+{
+    if (!power_cut) {
+        return true;
+    }
+    if (ops_left == 0) {
+        return false;
+    }
+    ops_left--;
+    return true;
+}
+
+static const uint8_t *ram_read(uint32_t offset)
+{
+    if (!image_erased) {
+        memset(image, 0xff, sizeof(image));
+        image_erased = true;
+    }
+    return &image[offset];
+}
+
+static bool ram_program(uint32_t offset, const uint8_t *page)
+{
+    uint8_t *dst = (uint8_t *)ram_read(offset);
+    if (powered()) {
+        for (uint32_t i = 0; i < KV_RAM_PAGE_SIZE; i++) {
+            dst[i] &= page[i];
+        }
+    }
+    return true;   // A power cut is not an error the store gets to see
+}
+
+static bool ram_erase(uint32_t offset)
+{
+    uint8_t *dst = (uint8_t *)ram_read(offset);
+    if (powered()) {
+        memset(dst, 0xff, KV_RAM_SECTOR_SIZE);
+    }
+    return true;
+}
+
+static uint32_t ram_now_us()
+{
+    return time_us_32();
+}
+
+static const kv_flash_port_t ram_port = {
+    .sector_size = KV_RAM_SECTOR_SIZE,
+    .sector_count = KV_RAM_SECTOR_COUNT,
+    .page_size = KV_RAM_PAGE_SIZE,
+    .read = ram_read,
+    .program = ram_program,
+    .erase = ram_erase,
+    .now_us = ram_now_us,
+};
+
+const kv_flash_port_t *kv_flash_ram_port()
+{
+    return &ram_port;
+}
+
+void kv_flash_ram_cut_power(uint32_t ops)
+{
+    power_cut = true;
+    ops_left = ops;
+}
+
+void kv_flash_ram_restore_power()
+{
+    power_cut = false;
+}
@@ -0,0 +1,379 @@
+#include "kv_store.h"
+#include "crc16.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Sector layout: a header at offset 0, then records back to back, each padded to 4 bytes.
+// Erased flash reads 0xFF, so a record key of 0xFF marks the end of the log. The header is
+// programmed last when a sector is filled by a compaction, so a sector only counts once all
+// its records are in place. The valid sector with the highest generation is the active one.
+//
+// Nothing here depends on the SDK, the port does the flash access and the timing.
+
+#define KV_SECTOR_MAGIC   (0x3153564bu)   // "KVS1"
+#define KV_END_KEY        (0xff)
+#define KV_MAX_PAGE_SIZE  (256)
+#define KV_ALIGN(n)       (((n) + 3u) & ~3u)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t generation;
+    uint16_t crc;
+    uint16_t pad;
+    uint32_t reserved;
+} kv_sector_header_t;
+
+typedef struct {
+    uint8_t key;
+    uint8_t len;
+    uint16_t crc;   // Over key, len and the value
+} kv_record_header_t;
+
+typedef struct {
+    bool valid;
+    bool dirty;
+    uint8_t len;
+    uint8_t data[KV_MAX_VALUE_SIZE];
+} kv_entry_t;
+
+static const kv_flash_port_t *port = NULL;
+static kv_entry_t entries[KvKeyCount];
+static kv_stats_t stats;
+static bool needs_compaction = false;   // No usable sector, or the log ends in a torn record
+
+static uint8_t page_buf[KV_MAX_PAGE_SIZE] __attribute__((aligned(4)));
+
+static uint16_t record_crc(const uint8_t key, const uint8_t len, const uint8_t *value)
+{
+    const uint8_t kl[2] = {key, len};
+    return crc16(crc16(CRC16_INIT, kl, sizeof(kl)), value, len);
+}
+
+static uint16_t header_crc(const kv_sector_header_t *hdr)
+{
+    return crc16(CRC16_INIT, hdr, offsetof(kv_sector_header_t, crc));
+}
+
+static uint32_t sector_offset(const uint32_t sector)
+{
+    return sector * port->sector_size;
+}
+
+// Programs len bytes at offset, one page at a time. The rest of each page is left at 0xFF,
+// which does not change what is already programmed there.
+static bool write_bytes(uint32_t offset, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        const uint32_t page = offset & ~(port->page_size - 1);
+        const uint32_t in_page = offset - page;
+        const size_t chunk = (len < port->page_size - in_page) ? len : port->page_size - in_page;
+
+        memset(page_buf, 0xff, port->page_size);
+        memcpy(&page_buf[in_page], data, chunk);
+        if (!port->program(page, page_buf)) {
+            return false;
+        }
+
+        offset += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+    return true;
+}
+
+static bool read_sector_header(const uint32_t sector, uint32_t *generation)
+{
+    kv_sector_header_t hdr;
+    memcpy(&hdr, port->read(sector_offset(sector)), sizeof(hdr));
+    if (hdr.magic != KV_SECTOR_MAGIC || hdr.crc != header_crc(&hdr)) {
+        return false;
+    }
+    *generation = hdr.generation;
+    return true;
+}
+
+// Loads the records of the active sector into the entries, later records win.
+static void replay(const uint32_t sector)
+{
+    const uint8_t *base = port->read(sector_offset(sector));
+    uint32_t offset = sizeof(kv_sector_header_t);
+
+    while (offset + sizeof(kv_record_header_t) <= port->sector_size) {
+        kv_record_header_t rec;
+        memcpy(&rec, &base[offset], sizeof(rec));
+        if (rec.key == KV_END_KEY) {
+            break;
+        }
+
+        const uint32_t size = KV_ALIGN(sizeof(rec) + rec.len);
+        const uint8_t *value = &base[offset + sizeof(rec)];
+        if (rec.len > KV_MAX_VALUE_SIZE || offset + size > port->sector_size ||
+            rec.crc != record_crc(rec.key, rec.len, value)) {
+            // Power went away while this record was programmed. Nothing after it can be
+            // trusted, the next write moves the good records to a fresh sector.
+            printf("KV store: torn record at %d in sector %d\n\r", (int)offset, (int)sector);
+            needs_compaction = true;
+            offset = port->sector_size;
+            break;
+        }
+
+        if (rec.key < KvKeyCount) {   // Keys of newer firmware are dropped at the next compaction
+            kv_entry_t *e = &entries[rec.key];
+            e->valid = true;
+            e->len = rec.len;
+            memcpy(e->data, value, rec.len);
+        }
+        offset += size;
+    }
+
+    stats.used_bytes = offset;
+}
+
+static uint32_t encode_record(const uint8_t key, uint8_t *buf)
+{
+    const kv_entry_t *e = &entries[key];
+    const kv_record_header_t rec = {.key = key, .len = e->len, .crc = record_crc(key, e->len, e->data)};
+    const uint32_t size = KV_ALIGN(sizeof(rec) + e->len);
+
+    memset(buf, 0xff, size);
+    memcpy(buf, &rec, sizeof(rec));
+    memcpy(&buf[sizeof(rec)], e->data, e->len);
+    return size;
+}
+
+// Copies the latest value of every key into the next sector, then writes its header. Sectors
+// are used round robin, so each one is erased once every sector_count compactions.
+static bool compact()
+{
+    const uint32_t start_us = port->now_us();
+    const uint32_t target = (stats.active_sector + 1) % port->sector_count;
+    const uint32_t base = sector_offset(target);
+
+    if (!port->erase(base)) {
+        printf("ERROR: KV store failed to erase sector %d\n\r", (int)target);
+        return false;
+    }
+
+    uint32_t offset = sizeof(kv_sector_header_t);
+    for (uint8_t key = 0; key < KvKeyCount; key++) {
+        if (!entries[key].valid) {
+            continue;
+        }
+        uint8_t rec[KV_ALIGN(sizeof(kv_record_header_t) + KV_MAX_VALUE_SIZE)];
+        const uint32_t size = encode_record(key, rec);
+        if (!write_bytes(base + offset, rec, size)) {
+            printf("ERROR: KV store failed to copy key %d\n\r", (int)key);
+            return false;
+        }
+        offset += size;
+    }
+
+    kv_sector_header_t hdr = {.magic = KV_SECTOR_MAGIC, .generation = stats.generation + 1, .pad = 0xffff, .reserved = 0xffffffff};
+    hdr.crc = header_crc(&hdr);
+    if (!write_bytes(base, (const uint8_t *)&hdr, sizeof(hdr))) {
+        printf("ERROR: KV store failed to write the header of sector %d\n\r", (int)target);
+        return false;
+    }
+
+    for (uint8_t key = 0; key < KvKeyCount; key++) {
+        entries[key].dirty = false;
+    }
+    stats.active_sector = target;
+    stats.generation = hdr.generation;
+    stats.used_bytes = offset;
+    stats.compactions++;
+    needs_compaction = false;
+
+    const uint32_t took_us = port->now_us() - start_us;
+    stats.compact_us_max = (took_us > stats.compact_us_max) ? took_us : stats.compact_us_max;
+    return true;
+}
+
+static bool write_record(const uint8_t key)
+{
+    uint8_t rec[KV_ALIGN(sizeof(kv_record_header_t) + KV_MAX_VALUE_SIZE)];
+    const uint32_t size = encode_record(key, rec);
+    if (needs_compaction || stats.used_bytes + size > port->sector_size) {
+        return compact();
+    }
+
+    const uint32_t start_us = port->now_us();
+    if (!write_bytes(sector_offset(stats.active_sector) + stats.used_bytes, rec, size)) {
+        printf("ERROR: KV store failed to write key %d\n\r", (int)key);
+        needs_compaction = true;   // The record may be half written
+        return false;
+    }
+
+    entries[key].dirty = false;
+    stats.used_bytes += size;
+    stats.records_written++;
+
+    const uint32_t took_us = port->now_us() - start_us;
+    stats.write_us_max = (took_us > stats.write_us_max) ? took_us : stats.write_us_max;
+    return true;
+}
+
+int kv_store_init(const kv_flash_port_t *flash)
+{
+    memset(entries, 0, sizeof(entries));
+    memset(&stats, 0, sizeof(stats));
+    needs_compaction = false;
+    port = flash;
+
+    if (!port) {
+        printf("ERROR: KV store has no flash, settings will not be kept.\n\r");
+        return -1;
+    }
+    if (port->page_size > KV_MAX_PAGE_SIZE || port->sector_count < 2) {
+        printf("ERROR: KV store does not support this flash geometry.\n\r");
+        port = NULL;
+        return -1;
+    }
+
+    bool found = false;
+    for (uint32_t s = 0; s < port->sector_count; s++) {
+        uint32_t generation;
+        if (read_sector_header(s, &generation) && (!found || generation > stats.generation)) {
+            found = true;
+            stats.active_sector = s;
+            stats.generation = generation;
+        }
+    }
+
+    if (found) {
+        replay(stats.active_sector);
+    }
+    else {
+        // Blank or unreadable: the first write formats sector 0.
+        stats.active_sector = port->sector_count - 1;
+        needs_compaction = true;
+    }
+
+    printf("KV store: sector %d, generation %d, %d bytes used\n\r", (int)stats.active_sector,
+           (int)stats.generation, (int)stats.used_bytes);
+    return 0;
+}
+
+int kv_get(uint8_t key, void *value, size_t size)
+{
+    if (key >= KvKeyCount || !entries[key].valid) {
+        return -1;
+    }
+
+    const kv_entry_t *e = &entries[key];
+    memcpy(value, e->data, (size < e->len) ? size : e->len);
+    return e->len;
+}
+
+int kv_set(uint8_t key, const void *value, size_t len)
+{
+    if (key == 0 || key >= KvKeyCount || len > KV_MAX_VALUE_SIZE) {
+        return -1;
+    }
+
+    kv_entry_t *e = &entries[key];
+    if (e->valid && e->len == len && memcmp(e->data, value, len) == 0) {
+        return 0;   // Unchanged, spare the flash
+    }
+
+    memcpy(e->data, value, len);
+    e->len = (uint8_t)len;
+    e->valid = true;
+    e->dirty = true;
+    return 0;
+}
+
+bool kv_store_pending()
+{
+    for (uint8_t key = 0; key < KvKeyCount; key++) {
+        if (entries[key].dirty) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool write_one()
+{
+    for (uint8_t key = 0; key < KvKeyCount; key++) {
+        if (entries[key].dirty) {
+            return write_record(key);
+        }
+    }
+    return false;
+}
+
+void tick_kv_store(bool idle)
+{
+    if (port && idle) {
+        write_one();
+    }
+}
+
+void kv_store_flush()
+{
+    // A failing flash must not hang the caller, give up after a few rounds.
+    for (int i = 0; port && kv_store_pending() && i < 2 * KvKeyCount; i++) {
+        write_one();
+    }
+}
+
+void kv_store_get_stats(kv_stats_t *out)
+{
+    *out = stats;
+}
+
+#ifdef KV_STORE_BENCHMARK
+void kv_store_benchmark()
+{
+    const kv_flash_port_t *ram = kv_flash_ram_port();
+    for (uint32_t s = 0; s < ram->sector_count; s++) {
+        ram->erase(s * ram->sector_size);
+    }
+    kv_store_init(ram);
+
+    const int writes = 1000;
+    uint32_t start_us = ram->now_us();
+    for (int i = 0; i < writes; i++) {
+        const uint32_t value = i;
+        kv_set(KvKeyCountdownPreset, &value, sizeof(value));
+        kv_store_flush();
+    }
+    const uint32_t write_us = (ram->now_us() - start_us) / writes;
+
+    start_us = ram->now_us();
+    uint32_t value = 0;
+    for (int i = 0; i < writes; i++) {
+        kv_get(KvKeyCountdownPreset, &value, sizeof(value));
+    }
+    const uint32_t read_ns = (ram->now_us() - start_us) * 1000 / writes;
+
+    const kv_stats_t written = stats;
+    start_us = ram->now_us();
+    kv_store_init(ram);
+    const uint32_t load_us = ram->now_us() - start_us;
+
+    printf("KV benchmark: %d us per write, %d ns per read, %d us to load, %d compactions, longest %d us\n\r",
+           (int)write_us, (int)read_ns, (int)load_us, (int)written.compactions, (int)written.compact_us_max);
+
+    // Power cut before the header of the new sector is written: the old value must survive.
+    const uint32_t committed = 1234;
+    const uint32_t lost = 5678;
+    kv_set(KvKeyCountdownPreset, &committed, sizeof(committed));
+    kv_store_flush();
+    kv_set(KvKeyCountdownPreset, &lost, sizeof(lost));
+    uint32_t records = 0;
+    for (uint8_t key = 0; key < KvKeyCount; key++) {
+        records += entries[key].valid ? 1 : 0;
+    }
+    kv_flash_ram_cut_power(1 + records);   // The erase and the records, not the header
+    compact();
+    kv_flash_ram_restore_power();
+
+    kv_store_init(ram);
+    value = 0;
+    kv_get(KvKeyCountdownPreset, &value, sizeof(value));
+    printf("KV benchmark: power cut during compaction %s\n\r", (value == committed) ? "recovered" : "FAILED");
+}
+#endif
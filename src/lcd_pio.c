@@ -0,0 +1,178 @@
+#include "lcd_pio.h"
+#include "hot_path.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "lcd_pio.pio.h"
+
+#include <stdio.h>
+
+// PIO transport for the LCD. The DCX level is part of every packet header (see lcd_pio.pio),
+// so command, parameter and pixel packets can be queued back to back without the CPU
+// toggling any pin. Pixel packets are streamed from the LVGL draw buffer by DMA.
+//
+// Throughput for a full 240x320 RGB565 frame at clk_sys = 125 MHz (cycle counts, not
+// including the CASET/RASET/RAMWR preamble):
+//
+//  Transport        | SCK        | Cycles/pixel  | Pixels/s   | Full frame | CPU during flush
+//  -----------------+------------+---------------+------------+------------+-----------------
+//  SPI0 (50 MHz ask)| 31.25 MHz  | 64 (+gaps)    | ~1.9 M     | ~40 ms     | 100 % (blocking)
+//  PIO + DMA        | 62.5 MHz   | 35            | ~3.57 M    | ~21.5 ms   | ~0 % (DMA IRQ)
+//
+// spi_init() rounds 50 MHz down to clk_peri / 4. The PIO runs at the ST7789 limit of 16 ns
+// per serial clock cycle and spends 3 extra cycles per pixel on the unit loop.
+
+#define LCD_PIO_MAX_SCK_HZ   (62500000)
+#define LCD_PIO_MAX_UNITS    (65536)
+
+static PIO lcd_pio = pio0;
+static uint lcd_sm = 0;
+static uint32_t lcd_stall_mask = 0;
+static int lcd_dma_chan = -1;
+static uint32_t lcd_sck_hz = 0;
+
+static volatile bool dma_busy = false;
+static lcd_pio_done_cb_t pending_done_cb = NULL;
+static void *pending_done_ctx = NULL;
+
+static inline uint32_t packet_header(const bool dcx, const uint32_t bits, const uint32_t units)
+{
+    return ((uint32_t)dcx << 31) | ((bits - 1) << 27) | ((units - 1) << 11);
+}
+
+// An empty FIFO is not the end of a transfer, the last word may still be shifting out. The
+// state machine is done once it stalls on the pull of the next header, with CSn high. TXSTALL
+// stays set for as long as it is stalled there, so the flag is cleared after the last word of
+// a transfer has gone into the FIFO: set again it can only mean that stall, and if the state
+// machine got there already it sets again on the next cycle.
+static inline void HOT_PATH_FUNC(clear_tx_stall)()
+{
+    lcd_pio->fdebug = lcd_stall_mask;
+}
+
+static inline bool HOT_PATH_FUNC(tx_idle)()
+{
+    return pio_sm_is_tx_fifo_empty(lcd_pio, lcd_sm) && (lcd_pio->fdebug & lcd_stall_mask);
+}
+
+static void HOT_PATH_FUNC(put_bytes)(const bool dcx, const uint8_t *data, const size_t size)
+{
+    if (!data || size == 0) {
+        return;
+    }
+
+    pio_sm_put_blocking(lcd_pio, lcd_sm, packet_header(dcx, 8, size));
+    for (size_t i = 0; i < size; i++) {
+        pio_sm_put_blocking(lcd_pio, lcd_sm, (uint32_t)data[i] << 24);
+    }
+    clear_tx_stall();
+}
+
+static void HOT_PATH_FUNC(lcd_dma_irq)()
+{
+    if (!dma_channel_get_irq0_status(lcd_dma_chan)) {
+        return;
+    }
+
+    dma_channel_acknowledge_irq0(lcd_dma_chan);
+    // The last pixels are in the FIFO, a stall on an empty FIFO before this was mid packet.
+    clear_tx_stall();
+    dma_busy = false;
+
+    if (pending_done_cb) {
+        pending_done_cb(pending_done_ctx);
+    }
+}
+
+void lcd_pio_init(uint32_t tx_pin, uint32_t csn_pin, uint32_t sck_pin, uint32_t dcx_pin)
+{
+    // Side-set drives CSn and SCK together.
+    hard_assert(sck_pin == csn_pin + 1);
+
+    lcd_sm = pio_claim_unused_sm(lcd_pio, true);
+    lcd_stall_mask = 1u << (PIO_FDEBUG_TXSTALL_LSB + lcd_sm);
+    const uint offset = pio_add_program(lcd_pio, &lcd_pio_program);
+
+    // Two state machine cycles per bit
+    const uint32_t sys_hz = clock_get_hz(clk_sys);
+    uint32_t div = (sys_hz + (2 * LCD_PIO_MAX_SCK_HZ) - 1) / (2 * LCD_PIO_MAX_SCK_HZ);
+    div = (div == 0) ? 1 : div;
+    lcd_sck_hz = sys_hz / (2 * div);
+
+    lcd_pio_program_init(lcd_pio, lcd_sm, offset, tx_pin, csn_pin, dcx_pin, (float)div);
+
+    lcd_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(lcd_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(lcd_pio, lcd_sm, true));
+    dma_channel_configure(lcd_dma_chan, &c, &lcd_pio->txf[lcd_sm], NULL, 0, false);
+
+    dma_channel_set_irq0_enabled(lcd_dma_chan, true);
+    irq_add_shared_handler(DMA_IRQ_0, lcd_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    printf("LCD PIO initialised with: %d SCK\n\r", lcd_sck_hz);
+}
+
+void lcd_pio_set_clkdiv(uint32_t div)
+{
+    if (lcd_dma_chan < 0) {
+        return;
+    }
+    pio_sm_set_clkdiv_int_frac(lcd_pio, lcd_sm, (uint16_t)div, 0);
+    lcd_sck_hz = clock_get_hz(clk_sys) / (2 * div);
+}
+
+uint32_t lcd_pio_get_sck_hz()
+{
+    return lcd_sck_hz;
+}
+
+// Returns once the command is out: callers go on to gate the clocks (SLPIN before sleep) or
+// change the state machine divider, and a command is only a few bytes.
+void lcd_pio_write_cmd(const uint8_t *cmd, size_t cmd_size, const uint8_t *param, size_t param_size)
+{
+    while (dma_busy) {
+        tight_loop_contents();
+    }
+
+    put_bytes(false, cmd, cmd_size);
+    put_bytes(true, param, param_size);
+
+    while (!tx_idle());
+}
+
+void HOT_PATH_FUNC(lcd_pio_write_pixels)(const uint8_t *cmd, size_t cmd_size, const uint16_t *pixels, size_t pixel_count,
+                                        lcd_pio_done_cb_t done_cb, void *ctx)
+{
+    while (dma_busy) {
+        tight_loop_contents();
+    }
+
+    put_bytes(false, cmd, cmd_size);
+
+    if (!pixels || pixel_count == 0) {
+        if (done_cb) {
+            done_cb(ctx);
+        }
+        return;
+    }
+
+    // The draw buffer is a fraction of the screen, this never splits in practice.
+    hard_assert(pixel_count <= LCD_PIO_MAX_UNITS);
+
+    pending_done_cb = done_cb;
+    pending_done_ctx = ctx;
+    dma_busy = true;
+
+    pio_sm_put_blocking(lcd_pio, lcd_sm, packet_header(true, 16, pixel_count));
+    dma_channel_transfer_from_buffer_now(lcd_dma_chan, pixels, pixel_count);
+}
+
+bool lcd_pio_busy()
+{
+    return dma_busy || !tx_idle();
+}
@@ -0,0 +1,139 @@
+#include "metrics.h"
+#include "hot_path.h"
+#include "lvgl.h"
+
+#include <stdio.h>
+
+// Updated from the main loop and the LCD DMA interrupt. Each counter has a single writer,
+// the reset from the shell may lose an increment that races it, which is fine for a rate.
+static volatile uint32_t loop_count = 0;
+static volatile uint32_t frame_count = 0;
+static volatile uint32_t flush_count = 0;
+static volatile uint32_t flush_us_sum = 0;
+static volatile uint32_t flush_us_max = 0;
+static volatile uint32_t lcd_bytes = 0;
+static volatile uint32_t touch_samples = 0;
+static volatile uint32_t touch_latency_us_sum = 0;
+static volatile uint32_t touch_latency_us_max = 0;
+static uint16_t battery_raw = 0;
+static uint32_t battery_mv = 0;
+static uint64_t window_start_us = 0;
+
+void metrics_reset(uint64_t now_us)
+{
+    loop_count = 0;
+    frame_count = 0;
+    flush_count = 0;
+    flush_us_sum = 0;
+    flush_us_max = 0;
+    lcd_bytes = 0;
+    touch_samples = 0;
+    touch_latency_us_sum = 0;
+    touch_latency_us_max = 0;
+    window_start_us = now_us;
+}
+
+void metrics_get_snapshot(uint64_t now_us, metrics_snapshot_t *snap)
+{
+    snap->window_us = now_us - window_start_us;
+    snap->loops = loop_count;
+    snap->frames = frame_count;
+    snap->flushes = flush_count;
+    snap->flush_us_sum = flush_us_sum;
+    snap->flush_us_max = flush_us_max;
+    snap->lcd_bytes = lcd_bytes;
+    snap->touch_samples = touch_samples;
+    snap->touch_latency_us_sum = touch_latency_us_sum;
+    snap->touch_latency_us_max = touch_latency_us_max;
+    snap->battery_raw = battery_raw;
+    snap->battery_mv = battery_mv;
+}
+
+void metrics_loop_tick()
+{
+    loop_count++;
+}
+
+void HOT_PATH_FUNC(metrics_frame_done)()
+{
+    frame_count++;
+}
+
+void HOT_PATH_FUNC(metrics_flush)(uint32_t bytes, uint32_t flush_us)
+{
+    flush_count++;
+    flush_us_sum += flush_us;
+    if (flush_us > flush_us_max) {
+        flush_us_max = flush_us;
+    }
+    lcd_bytes += bytes;
+}
+
+void metrics_touch_sample(uint32_t latency_us)
+{
+    touch_samples++;
+    touch_latency_us_sum += latency_us;
+    if (latency_us > touch_latency_us_max) {
+        touch_latency_us_max = latency_us;
+    }
+}
+
+void metrics_battery(uint16_t raw, uint32_t mv)
+{
+    battery_raw = raw;
+    battery_mv = mv;
+}
+
+// Count per second over the window, in tenths.
+static uint32_t rate_x10(const uint32_t count, const uint64_t window_us)
+{
+    return window_us ? (uint32_t)(((uint64_t)count * 10000000) / window_us) : 0;
+}
+
+bool metrics_format_line(size_t idx, uint64_t now_us, char *buf, size_t size)
+{
+    metrics_snapshot_t s;
+    metrics_get_snapshot(now_us, &s);
+
+    switch (idx) {
+        case 0:
+            snprintf(buf, size, "window    %d ms", (int)(s.window_us / 1000));
+        break;
+        case 1: {
+            const uint32_t fps = rate_x10(s.frames, s.window_us);
+            snprintf(buf, size, "fps       %d.%d", (int)(fps / 10), (int)(fps % 10));
+        }
+        break;
+        case 2:
+            snprintf(buf, size, "flush     %d, avg %d us, max %d us", (int)s.flushes,
+                     s.flushes ? (int)(s.flush_us_sum / s.flushes) : 0, (int)s.flush_us_max);
+        break;
+        case 3:
+            snprintf(buf, size, "lcd       %d bytes, %d B/s", (int)s.lcd_bytes, (int)(rate_x10(s.lcd_bytes, s.window_us) / 10));
+        break;
+        case 4:
+            snprintf(buf, size, "loop      %d /s", (int)(rate_x10(s.loops, s.window_us) / 10));
+        break;
+        case 5: {
+            const uint32_t touch = rate_x10(s.touch_samples, s.window_us);
+            snprintf(buf, size, "touch     %d.%d samples/s, latency avg %d us, max %d us", (int)(touch / 10),
+                     (int)(touch % 10), s.touch_samples ? (int)(s.touch_latency_us_sum / s.touch_samples) : 0,
+                     (int)s.touch_latency_us_max);
+        }
+        break;
+        case 6: {
+            lv_mem_monitor_t mon;
+            lv_mem_monitor(&mon);
+            snprintf(buf, size, "heap      %d of %d bytes, largest free %d, frag %d %%",
+                     (int)(mon.total_size - mon.free_size), (int)mon.total_size, (int)mon.free_biggest_size,
+                     (int)mon.frag_pct);
+        }
+        break;
+        case 7:
+            snprintf(buf, size, "battery   %d mV (raw %d)", (int)s.battery_mv, (int)s.battery_raw);
+        break;
+        default:
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#include "perf_counters.h"
+
+#ifdef PERF_COUNTERS
+
+#include "hardware/structs/xip_ctrl.h"
+#include "hardware/sync.h"
+#include "pico/time.h"
+
+#include <stdio.h>
+
+#define PERF_REPORT_PERIOD_US   (5 * 1000 * 1000)
+
+volatile uint32_t perf_isr_latency_min = UINT32_MAX;
+volatile uint32_t perf_isr_latency_max = 0;
+volatile uint32_t perf_isr_latency_sum = 0;
+volatile uint32_t perf_isr_count = 0;
+
+static uint64_t next_report_us = 0;
+
+void perf_counters_reset()
+{
+    // Any write clears the XIP cache counters.
+    xip_ctrl_hw->ctr_hit = 0;
+    xip_ctrl_hw->ctr_acc = 0;
+
+    const uint32_t status = save_and_disable_interrupts();
+    perf_isr_latency_min = UINT32_MAX;
+    perf_isr_latency_max = 0;
+    perf_isr_latency_sum = 0;
+    perf_isr_count = 0;
+    restore_interrupts(status);
+}
+
+void tick_perf_counters()
+{
+    const uint64_t now_us = time_us_64();
+    if (now_us < next_report_us) {
+        return;
+    }
+
+    if (next_report_us != 0) {
+        const uint32_t hit = xip_ctrl_hw->ctr_hit;
+        const uint32_t acc = xip_ctrl_hw->ctr_acc;
+
+        const uint32_t status = save_and_disable_interrupts();
+        const uint32_t min = perf_isr_latency_min;
+        const uint32_t max = perf_isr_latency_max;
+        const uint32_t sum = perf_isr_latency_sum;
+        const uint32_t count = perf_isr_count;
+        restore_interrupts(status);
+
+        // Hit rate in tenths of a percent, the counters cover the whole period.
+        const uint32_t hit_permille = acc ? (uint32_t)(((uint64_t)hit * 1000) / acc) : 0;
+        printf("XIP cache: %d/%d hits (%d.%d %%)\n\r", (int)hit, (int)acc, (int)(hit_permille / 10), (int)(hit_permille % 10));
+        if (count) {
+            printf("SysTick ISR entry: min %d, avg %d, max %d cycles over %d interrupts\n\r",
+                   (int)min, (int)(sum / count), (int)max, (int)count);
+        }
+    }
+
+    perf_counters_reset();
+    next_report_us = now_us + PERF_REPORT_PERIOD_US;
+}
+
+#endif   // PERF_COUNTERS
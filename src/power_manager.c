@@ -0,0 +1,108 @@
+#include "power_manager.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// A deadline this close is not worth suspending the display for.
+#define POWER_MIN_SLEEP_US   (100 * 1000)
+
+static const power_port_t *port = NULL;
+static power_config_t config;
+static power_stats_t stats;
+static power_state_t state = PowerActive;
+static uint64_t state_since_us = 0;
+
+static void enter(const power_state_t next)
+{
+    const uint64_t now_us = port->now_us();
+    stats.state_us[state] += now_us - state_since_us;
+    state = next;
+    state_since_us = now_us;
+}
+
+void power_manager_init(const power_port_t *p, const power_config_t *c)
+{
+    port = p;
+    config = *c;
+    memset(&stats, 0, sizeof(stats));
+    state = PowerActive;
+    state_since_us = port->now_us();
+}
+
+static bool should_sleep()
+{
+    if (!config.idle_timeout_ms || port->idle_ms() < config.idle_timeout_ms || port->busy()) {
+        return false;
+    }
+
+    const uint64_t deadline_us = port->next_deadline_us();
+    return !deadline_us || deadline_us > port->now_us() + POWER_MIN_SLEEP_US;
+}
+
+void tick_power_manager()
+{
+    if (!port || !should_sleep()) {
+        return;
+    }
+
+    enter(PowerSuspending);
+    port->suspend_ui();
+    enter(PowerSleep);
+    stats.sleeps++;
+
+    // Background work due before the UI deadline is done without resuming the UI.
+    power_wake_t wake;
+    for (;;) {
+        const uint64_t deadline_us = port->next_deadline_us();
+        const uint64_t service_us = port->next_service_us ? port->next_service_us() : 0;
+        const bool service_first = service_us && (!deadline_us || service_us < deadline_us);
+
+        wake = port->sleep_until(service_first ? service_us : deadline_us);
+        if (wake == PowerWakeDeadline && service_first) {
+            stats.wakes_service++;
+            port->service();
+        }
+        else if (wake == PowerWakeOther) {
+            stats.wakes_other++;
+        }
+        else {
+            break;
+        }
+    }
+
+    if (wake == PowerWakeTouch) {
+        stats.wakes_touch++;
+    }
+    else {
+        stats.wakes_deadline++;
+    }
+
+    enter(PowerWaking);
+    port->resume_ui(wake);
+    const uint32_t wake_us = (uint32_t)(port->now_us() - state_since_us);
+    enter(PowerActive);
+
+    stats.wake_us_max = (wake_us > stats.wake_us_max) ? wake_us : stats.wake_us_max;
+    if (config.wake_budget_us && wake_us > config.wake_budget_us) {
+        stats.wake_over_budget++;
+    }
+}
+
+power_state_t power_manager_state()
+{
+    return state;
+}
+
+void power_manager_get_stats(power_stats_t *out)
+{
+    *out = stats;
+    if (port) {
+        out->state_us[state] += port->now_us() - state_since_us;
+    }
+}
+
+const char *power_state_name(power_state_t s)
+{
+    static const char *names[PowerStateCount] = {"active", "suspending", "sleep", "waking"};
+    return (s < PowerStateCount) ? names[s] : "?";
+}
@@ -0,0 +1,160 @@
+#include "power_manager.h"
+#include "battery_monitor.h"
+#include "display_framework.h"
+#include "kv_store.h"
+#include "touch_screen.h"
+#include "touch_trace.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/scb.h"
+#include "hardware/structs/systick.h"
+#include "hardware/sync.h"
+#include "pico/time.h"
+
+// Sleep, not dormant: dormant stops the timer as well, and the countdown deadline needs it.
+// The core waits in WFI with SLEEPDEEP set, which gates every clock not in SLEEP_EN0/1.
+// Kept running: SRAM, XIP, the timer and its watchdog tick, IO and pads for the pen down
+// interrupt, and UART0, so characters typed meanwhile wait in its FIFO.
+
+#define SLEEP_EN0_KEEP  (CLOCKS_SLEEP_EN0_CLK_SYS_SRAM3_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_SRAM2_BITS |      \
+                         CLOCKS_SLEEP_EN0_CLK_SYS_SRAM1_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_SRAM0_BITS |      \
+                         CLOCKS_SLEEP_EN0_CLK_SYS_SIO_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_ROM_BITS |          \
+                         CLOCKS_SLEEP_EN0_CLK_SYS_PADS_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_IO_BITS |          \
+                         CLOCKS_SLEEP_EN0_CLK_SYS_BUSFABRIC_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_BUSCTRL_BITS | \
+                         CLOCKS_SLEEP_EN0_CLK_SYS_CLOCKS_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_PLL_SYS_BITS)
+
+#define SLEEP_EN1_KEEP  (CLOCKS_SLEEP_EN1_CLK_SYS_SRAM5_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_SRAM4_BITS |      \
+                         CLOCKS_SLEEP_EN1_CLK_SYS_XIP_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_XOSC_BITS |         \
+                         CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_WATCHDOG_BITS |   \
+                         CLOCKS_SLEEP_EN1_CLK_SYS_UART0_BITS | CLOCKS_SLEEP_EN1_CLK_PERI_UART0_BITS |     \
+                         SLEEP_EN1_USB)
+
+#ifdef TELEMETRY_USB
+#define SLEEP_EN1_USB   (CLOCKS_SLEEP_EN1_CLK_SYS_USBCTRL_BITS | CLOCKS_SLEEP_EN1_CLK_USB_USBCTRL_BITS)
+#else
+#define SLEEP_EN1_USB   (0)
+#endif
+
+#define LOOP_TIMER_MAX  (4)
+
+typedef struct {
+    repeating_timer_t *timer;
+    int32_t period_ms;
+    repeating_timer_callback_t cb;
+} loop_timer_t;
+
+static loop_timer_t loop_timers[LOOP_TIMER_MAX];
+static size_t loop_timer_count = 0;
+static uint64_t next_battery_us = 0;
+
+static volatile bool deadline_reached = false;
+
+static int64_t deadline_alarm_cb(alarm_id_t id, void *user_data)
+{
+    deadline_reached = true;
+    return 0;
+}
+
+static uint64_t pico_now_us()
+{
+    return time_us_64();
+}
+
+static bool pico_busy()
+{
+    return ui_alarm_active() || kv_store_pending() || touch_trace_replaying();
+}
+
+bool power_pico_add_loop_timer(repeating_timer_t *timer, int32_t period_ms, repeating_timer_callback_t cb)
+{
+    if (loop_timer_count == LOOP_TIMER_MAX || !add_repeating_timer_ms(period_ms, cb, NULL, timer)) {
+        return false;
+    }
+    loop_timers[loop_timer_count++] = (loop_timer_t){.timer = timer, .period_ms = period_ms, .cb = cb};
+    return true;
+}
+
+// The loop timers only count for the main loop, which does not run while the display is off.
+// Left running, each would wake the core once a period.
+static void pico_suspend_ui()
+{
+    ui_suspend();
+    for (size_t i = 0; i < loop_timer_count; i++) {
+        cancel_repeating_timer(loop_timers[i].timer);
+    }
+    next_battery_us = time_us_64() + BATTERY_SLEEP_SAMPLE_MS * 1000ull;
+}
+
+static void pico_resume_ui(power_wake_t wake)
+{
+    ui_resume(wake);
+    for (size_t i = 0; i < loop_timer_count; i++) {
+        add_repeating_timer_ms(loop_timers[i].period_ms, loop_timers[i].cb, NULL, loop_timers[i].timer);
+    }
+}
+
+// The battery is still sampled while asleep, just less often than the loop timer does.
+static uint64_t pico_next_service_us()
+{
+    return next_battery_us;
+}
+
+static void pico_service()
+{
+    battery_monitor_sample();
+    next_battery_us = time_us_64() + BATTERY_SLEEP_SAMPLE_MS * 1000ull;
+}
+
+static power_wake_t pico_sleep_until(uint64_t wake_us)
+{
+    deadline_reached = false;
+    const alarm_id_t alarm = wake_us ? add_alarm_at(from_us_since_boot(wake_us), deadline_alarm_cb, NULL, true) : 0;
+
+    // The LVGL tick is not needed while the display is off, and would wake the core every ms.
+    const uint32_t systick_csr = systick_hw->csr;
+    systick_hw->csr = 0;
+
+    const uint32_t en0 = clocks_hw->sleep_en0;
+    const uint32_t en1 = clocks_hw->sleep_en1;
+    clocks_hw->sleep_en0 = SLEEP_EN0_KEEP;
+    clocks_hw->sleep_en1 = SLEEP_EN1_KEEP;
+    scb_hw->scr |= M0PLUS_SCR_SLEEPDEEP_BITS;
+
+    // With interrupts masked WFI still returns on a pending one, so an interrupt between the
+    // checks and the WFI is not missed. It runs once they are unmasked.
+    const uint32_t irq_state = save_and_disable_interrupts();
+    if (!deadline_reached && !touch_screen_read_pending()) {
+        __wfi();
+    }
+    restore_interrupts(irq_state);
+
+    scb_hw->scr &= ~M0PLUS_SCR_SLEEPDEEP_BITS;
+    clocks_hw->sleep_en0 = en0;
+    clocks_hw->sleep_en1 = en1;
+    systick_hw->csr = systick_csr;
+
+    if (alarm > 0) {
+        cancel_alarm(alarm);
+    }
+
+    if (touch_screen_read_pending()) {
+        return PowerWakeTouch;
+    }
+    return deadline_reached ? PowerWakeDeadline : PowerWakeOther;
+}
+
+static const power_port_t pico_port = {
+    .now_us = pico_now_us,
+    .idle_ms = ui_idle_ms,
+    .busy = pico_busy,
+    .next_deadline_us = ui_next_deadline_us,
+    .suspend_ui = pico_suspend_ui,
+    .resume_ui = pico_resume_ui,
+    .next_service_us = pico_next_service_us,
+    .service = pico_service,
+    .sleep_until = pico_sleep_until,
+};
+
+const power_port_t *power_pico_port()
+{
+    return &pico_port;
+}
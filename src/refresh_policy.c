@@ -0,0 +1,48 @@
+#include "refresh_policy.h"
+
+// No LVGL or SDK calls, so the policy can be run against a recorded or simulated session
+// on a host.
+
+void refresh_policy_init(refresh_policy_t *policy, const refresh_config_t *config, uint32_t now_ms)
+{
+    policy->config = *config;
+    policy->last_active_ms = now_ms;
+    policy->period_ms = config->min_period_ms;
+}
+
+uint32_t refresh_policy_update(refresh_policy_t *policy, uint32_t now_ms, bool active)
+{
+    const refresh_config_t *c = &policy->config;
+    if (active) {
+        policy->last_active_ms = now_ms;
+    }
+
+    const uint32_t quiet_ms = now_ms - policy->last_active_ms;
+    if (quiet_ms < c->hold_ms) {
+        policy->period_ms = c->min_period_ms;
+        return policy->period_ms;
+    }
+
+    // Double once per step, so a touch shortly after still finds a fast timer.
+    const uint32_t steps = c->step_ms ? (quiet_ms - c->hold_ms) / c->step_ms + 1 : 32;
+    uint32_t period_ms = c->min_period_ms;
+    for (uint32_t i = 0; i < steps && period_ms && period_ms < c->idle_period_ms; i++) {
+        period_ms *= 2;
+    }
+    policy->period_ms = period_ms < c->idle_period_ms ? period_ms : c->idle_period_ms;
+    return policy->period_ms;
+}
+
+refresh_mode_t refresh_policy_mode(const refresh_policy_t *policy)
+{
+    if (policy->period_ms <= policy->config.min_period_ms) {
+        return RefreshInteractive;
+    }
+    return policy->period_ms >= policy->config.idle_period_ms ? RefreshIdle : RefreshFallback;
+}
+
+const char *refresh_mode_name(refresh_mode_t mode)
+{
+    static const char *const names[RefreshModeCount] = {"interactive", "fallback", "idle"};
+    return mode < RefreshModeCount ? names[mode] : "?";
+}
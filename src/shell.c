@@ -0,0 +1,469 @@
+#include "shell.h"
+#include "clock_governor.h"
+#include "display_framework.h"
+#include "kv_store.h"
+#include "metrics.h"
+#include "power_manager.h"
+#include "stack_monitor.h"
+#include "touch_trace.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef LVGL_HEAP_PROFILER
+#include "heap_profiler.h"
+#endif
+
+#ifdef UI_FRAME_CAPTURE
+#include "frame_capture.h"
+#endif
+
+// Commands produce their output one line at a time through a line callback. The shell
+// asks for the next line only once the previous one fits into the transmit ring, so a long
+// report is spread over many main loop iterations instead of stalling the UI.
+
+#define SHELL_OUT_LINE_SIZE   (96)
+#define SHELL_PROMPT          "> "
+
+typedef bool (*shell_line_fn_t)(size_t idx, char *buf, size_t size);
+
+typedef struct {
+    const char *name;
+    const char *help;
+    shell_line_fn_t line;
+} shell_cmd_t;
+
+static const shell_port_t *port = NULL;
+
+static char tx_ring[SHELL_TX_BUFFER_SIZE];
+static size_t tx_head = 0;   // Next byte to write into
+static size_t tx_tail = 0;   // Next byte to send
+static size_t tx_used = 0;
+
+static char line[SHELL_LINE_SIZE];
+static size_t line_len = 0;
+
+static const shell_cmd_t *active_cmd = NULL;
+static size_t active_line = 0;
+static const char *active_args = "";   // Rest of the line after the command name
+
+static bool help_line(size_t idx, char *buf, size_t size);
+
+static bool stats_line(size_t idx, char *buf, size_t size)
+{
+    return metrics_format_line(idx, port->now_us(), buf, size);
+}
+
+static bool reset_line(size_t idx, char *buf, size_t size)
+{
+    if (idx > 0) {
+        return false;
+    }
+    metrics_reset(port->now_us());
+    snprintf(buf, size, "counters reset");
+    return true;
+}
+
+static bool stack_line(size_t idx, char *buf, size_t size)
+{
+    if (idx > 1) {
+        return false;
+    }
+    const stack_usage_t usage = stack_monitor_usage(idx == 0 ? StackCore0 : StackCore1);
+    snprintf(buf, size, "stack %d   %d of %d bytes", (int)idx, (int)usage.high_water, (int)usage.size);
+    return true;
+}
+
+static bool kv_line(size_t idx, char *buf, size_t size)
+{
+    kv_stats_t kv;
+    kv_store_get_stats(&kv);
+    switch (idx) {
+        case 0:
+            snprintf(buf, size, "kv sector %d   generation %d, %d bytes used%s", (int)kv.active_sector,
+                     (int)kv.generation, (int)kv.used_bytes, kv_store_pending() ? ", writes pending" : "");
+            return true;
+        case 1:
+            snprintf(buf, size, "kv writes     %d, longest %d us", (int)kv.records_written, (int)kv.write_us_max);
+            return true;
+        case 2:
+            snprintf(buf, size, "kv compaction %d, longest %d us", (int)kv.compactions, (int)kv.compact_us_max);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool checkpoint_line(size_t idx, char *buf, size_t size)
+{
+    if (idx > 0) {
+        return false;
+    }
+    timer_checkpoint_stats_t cp;
+    ui_get_checkpoint_stats(&cp);
+    const uint32_t uptime_s = (uint32_t)(port->now_us() / 1000000) + 1;
+    const uint32_t rewrites = cp.drifts + cp.changes;
+    snprintf(buf, size, "checkpoint %d ticks, %d drift, %d changed, %d.%03d rewrites/s", (int)cp.updates,
+             (int)cp.drifts, (int)cp.changes, (int)(rewrites / uptime_s), (int)((rewrites * 1000 / uptime_s) % 1000));
+    return true;
+}
+
+static bool power_line(size_t idx, char *buf, size_t size)
+{
+    power_stats_t power;
+    power_manager_get_stats(&power);
+    if (idx < PowerStateCount) {
+        snprintf(buf, size, "power %-10s %d ms", power_state_name((power_state_t)idx), (int)(power.state_us[idx] / 1000));
+        return true;
+    }
+    switch (idx - PowerStateCount) {
+        case 0:
+            snprintf(buf, size, "power sleeps %d, woken by touch %d, deadline %d, service %d, other %d", (int)power.sleeps,
+                     (int)power.wakes_touch, (int)power.wakes_deadline, (int)power.wakes_service, (int)power.wakes_other);
+            return true;
+        case 1:
+            snprintf(buf, size, "power wake   longest %d us, %d over budget", (int)power.wake_us_max, (int)power.wake_over_budget);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool clock_line(size_t idx, char *buf, size_t size)
+{
+    clock_governor_stats_t clock;
+    clock_governor_get_stats(&clock);
+    if (idx < CLOCK_STEP_COUNT) {
+        snprintf(buf, size, "clock %6d kHz %d ms", (int)(clock_step_hz(idx) / 1000), (int)(clock.step_us[idx] / 1000));
+        return true;
+    }
+    if (idx == CLOCK_STEP_COUNT) {
+        snprintf(buf, size, "clock transitions %d, avg %d us, max %d us", (int)clock.transitions,
+                 (int)(clock.transitions ? clock.latency_us_sum / clock.transitions : 0), (int)clock.latency_us_max);
+        return true;
+    }
+    return false;
+}
+
+// Refreshes per hour and render CPU share in each refresh mode.
+static bool refresh_line(size_t idx, char *buf, size_t size)
+{
+    if (idx >= RefreshModeCount) {
+        return false;
+    }
+    ui_refresh_stats_t refresh;
+    ui_get_refresh_stats(&refresh);
+    const uint64_t time_us = refresh.time_us[idx] + 1;
+    const uint32_t permille = (uint32_t)(refresh.render_us[idx] * 1000 / time_us);
+    snprintf(buf, size, "refresh %-11s %6d s, %d runs/h, %d renders/h, render %d.%d%% CPU",
+             refresh_mode_name((refresh_mode_t)idx), (int)(refresh.time_us[idx] / 1000000),
+             (int)(refresh.timer_runs[idx] * 3600000000ull / time_us), (int)(refresh.renders[idx] * 3600000000ull / time_us),
+             (int)(permille / 10), (int)(permille % 10));
+    return true;
+}
+
+#ifdef UI_FRAME_CAPTURE
+// Every flush after this goes out on the UART, for tools/st7789_model.py.
+static bool trace_line(size_t idx, char *buf, size_t size)
+{
+    if (idx > 0) {
+        return false;
+    }
+    frame_capture_set_trace(!frame_capture_tracing());
+    snprintf(buf, size, "lcd trace %s", frame_capture_tracing() ? "on" : "off");
+    return true;
+}
+#endif
+
+#ifdef TOUCH_TRACE
+// 'rec on' or 'rec off', toggles without an argument. Recording starts from an empty trace
+// and stops on its own when the buffer is full.
+static bool record_line(size_t idx, char *buf, size_t size)
+{
+    if (idx > 0) {
+        return false;
+    }
+    const bool on = (strcmp(active_args, "on") == 0) ||
+                    (strcmp(active_args, "off") != 0 && !touch_trace_recording());
+    if (on || touch_trace_recording()) {
+        touch_trace_set_recording(on);
+    }
+    snprintf(buf, size, "touch recording %s, %d samples", touch_trace_recording() ? "on" : "off",
+             (int)touch_trace_count());
+    return true;
+}
+
+// One sample per line in the format 'tt' loads: t_us, x, y, little endian, as hex.
+static bool dump_line(size_t idx, char *buf, size_t size)
+{
+    touch_trace_sample_t s;
+    if (!touch_trace_get(idx, &s)) {
+        return false;
+    }
+    const uint8_t bytes[8] = {(uint8_t)s.t_us, (uint8_t)(s.t_us >> 8), (uint8_t)(s.t_us >> 16), (uint8_t)(s.t_us >> 24),
+                              (uint8_t)s.raw_x, (uint8_t)(s.raw_x >> 8), (uint8_t)s.raw_y, (uint8_t)(s.raw_y >> 8)};
+    size_t pos = (size_t)snprintf(buf, size, "tt ");
+    for (size_t i = 0; i < sizeof(bytes) && pos + 2 < size; i++) {
+        pos += (size_t)snprintf(buf + pos, size - pos, "%02x", bytes[i]);
+    }
+    return true;
+}
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Without arguments clears the trace, otherwise appends one sample as printed by 'dump'.
+static bool load_line(size_t idx, char *buf, size_t size)
+{
+    if (idx > 0) {
+        return false;
+    }
+    if (active_args[0] == '\0') {
+        touch_trace_clear();
+        snprintf(buf, size, "touch trace cleared");
+        return true;
+    }
+
+    uint8_t bytes[8];
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        const int hi = hex_digit(active_args[2 * i]);
+        const int lo = (hi < 0) ? -1 : hex_digit(active_args[2 * i + 1]);
+        if (lo < 0) {
+            snprintf(buf, size, "bad sample, expected 16 hex digits");
+            return true;
+        }
+        bytes[i] = (uint8_t)(hi << 4 | lo);
+    }
+    const touch_trace_sample_t s = {
+        .t_us = bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24,
+        .raw_x = (uint16_t)(bytes[4] | bytes[5] << 8),
+        .raw_y = (uint16_t)(bytes[6] | bytes[7] << 8),
+    };
+    if (touch_trace_load(&s)) {
+        snprintf(buf, size, "tt %d", (int)touch_trace_count());
+    }
+    else {
+        snprintf(buf, size, "sample rejected, trace full or out of order");
+    }
+    return true;
+}
+
+static bool play_line(size_t idx, char *buf, size_t size)
+{
+    if (idx > 0) {
+        return false;
+    }
+    touch_trace_start_replay((uint32_t)port->now_us());
+    snprintf(buf, size, "touch replay of %d samples %s", (int)touch_trace_count(),
+             touch_trace_replaying() ? "started" : "not started");
+    return true;
+}
+
+// Replayed press and release to LVGL event and to rendered frame.
+static bool latency_line(size_t idx, char *buf, size_t size)
+{
+    if (idx > 1) {
+        return false;
+    }
+    if (touch_trace_replaying()) {
+        snprintf(buf, size, "replay still running");
+        return idx == 0;
+    }
+    touch_latency_t lat[2];
+    touch_trace_latency(&lat[0], &lat[1]);
+    snprintf(buf, size, "touch to %-5s n %d, p50 %d us, p90 %d us, p99 %d us, max %d us", idx ? "frame" : "event",
+             (int)lat[idx].count, (int)lat[idx].p50_us, (int)lat[idx].p90_us, (int)lat[idx].p99_us, (int)lat[idx].max_us);
+    return true;
+}
+#endif
+
+#ifdef LVGL_HEAP_PROFILER
+// The profiler prints its own table through printf, which does block.
+static bool heap_profile_line(size_t idx, char *buf, size_t size)
+{
+    if (idx > 0) {
+        return false;
+    }
+    heap_profiler_report();
+    snprintf(buf, size, "heap profile done");
+    return true;
+}
+#endif
+
+static const shell_cmd_t commands[] = {
+    {"help",    "list commands",                 help_line},
+    {"stats",   "show runtime metrics",          stats_line},
+    {"reset",   "reset the metric counters",     reset_line},
+    {"stack",   "stack high water marks",        stack_line},
+    {"kv",      "settings store usage",          kv_line},
+    {"timer",   "countdown checkpoint cost",     checkpoint_line},
+    {"power",   "time per power state",          power_line},
+    {"clock",   "time per clock step",           clock_line},
+    {"refresh", "display refresh rate per mode", refresh_line},
+#ifdef UI_FRAME_CAPTURE
+    {"trace",   "toggle the LCD command trace",  trace_line},
+#endif
+#ifdef TOUCH_TRACE
+    {"rec",     "touch recording [on|off]",      record_line},
+    {"dump",    "print the touch trace",         dump_line},
+    {"tt",      "clear or load the touch trace", load_line},
+    {"play",    "replay the touch trace",        play_line},
+    {"lat",     "touch latency of the replay",   latency_line},
+#endif
+#ifdef LVGL_HEAP_PROFILER
+    {"heap",    "LVGL heap profile",             heap_profile_line},
+#endif
+};
+
+#define SHELL_CMD_COUNT   (sizeof(commands) / sizeof(commands[0]))
+
+static bool help_line(size_t idx, char *buf, size_t size)
+{
+    if (idx >= SHELL_CMD_COUNT) {
+        return false;
+    }
+    snprintf(buf, size, "%-8s %s", commands[idx].name, commands[idx].help);
+    return true;
+}
+
+static size_t tx_free()
+{
+    return SHELL_TX_BUFFER_SIZE - tx_used;
+}
+
+// Queues all of data or nothing.
+static bool tx_put_bytes(const void *data, const size_t len)
+{
+    if (len > tx_free()) {
+        return false;
+    }
+
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        tx_ring[tx_head] = (char)bytes[i];
+        tx_head = (tx_head + 1) % SHELL_TX_BUFFER_SIZE;
+    }
+    tx_used += len;
+    return true;
+}
+
+static bool tx_put(const char *s)
+{
+    return tx_put_bytes(s, strlen(s));
+}
+
+static void tx_flush()
+{
+    while (tx_used > 0) {
+        // Contiguous part up to the end of the ring.
+        const size_t chunk = (tx_tail + tx_used > SHELL_TX_BUFFER_SIZE) ? SHELL_TX_BUFFER_SIZE - tx_tail : tx_used;
+        const size_t sent = port->write(&tx_ring[tx_tail], chunk);
+        tx_tail = (tx_tail + sent) % SHELL_TX_BUFFER_SIZE;
+        tx_used -= sent;
+        if (sent < chunk) {
+            return;
+        }
+    }
+}
+
+static void run_line()
+{
+    line[line_len] = '\0';
+    line_len = 0;
+
+    if (line[0] == '\0') {
+        tx_put(SHELL_PROMPT);
+        return;
+    }
+
+    // The line buffer is not touched while the command runs, so the arguments can stay in it.
+    char *args = strchr(line, ' ');
+    if (args) {
+        *args++ = '\0';
+    }
+
+    for (size_t i = 0; i < SHELL_CMD_COUNT; i++) {
+        if (strcmp(line, commands[i].name) == 0) {
+            active_cmd = &commands[i];
+            active_line = 0;
+            active_args = args ? args : "";
+            return;
+        }
+    }
+
+    tx_put("unknown command, try help\r\n" SHELL_PROMPT);
+}
+
+static void read_input()
+{
+    int c;
+    // While a command is still printing, input waits in the UART FIFO.
+    while (!active_cmd && tx_free() >= 2 && (c = port->read_char()) >= 0) {
+        if (c == '\r' || c == '\n') {
+            tx_put("\r\n");
+            run_line();
+        }
+        else if ((c == '\b' || c == 0x7f) && line_len > 0) {
+            line_len--;
+            tx_put("\b \b");
+        }
+        else if (c >= ' ' && c < 0x7f && line_len < SHELL_LINE_SIZE - 1) {
+            const char echo[2] = {(char)c, '\0'};
+            line[line_len++] = (char)c;
+            tx_put(echo);
+        }
+    }
+}
+
+static void write_output()
+{
+    if (!active_cmd || tx_free() < SHELL_OUT_LINE_SIZE + 2) {
+        return;
+    }
+
+    char out[SHELL_OUT_LINE_SIZE + 2];
+    if (active_cmd->line(active_line, out, SHELL_OUT_LINE_SIZE)) {
+        strcat(out, "\r\n");
+        tx_put(out);
+        active_line++;
+    }
+    else {
+        active_cmd = NULL;
+        tx_put(SHELL_PROMPT);
+    }
+}
+
+void shell_init(const shell_port_t *shell_port)
+{
+    port = shell_port;
+    metrics_reset(port->now_us());
+    tx_put("\r\n" SHELL_PROMPT);
+}
+
+bool shell_write(const void *data, size_t len)
+{
+    return port && tx_put_bytes(data, len);
+}
+
+void shell_tick()
+{
+    if (!port) {
+        return;
+    }
+
+    read_input();
+    write_output();
+    tx_flush();
+}
@@ -0,0 +1,304 @@
+#include "slab_alloc.h"
+#include "lvgl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_CUSTOM
+
+#include "lvgl_private.h"
+
+// The UI is built once from a fixed set of widgets, so almost every LVGL allocation is one of
+// a handful of sizes: objects, labels, event descriptors and small style/array blocks. Each
+// size class is a static slab of equal blocks with an intrusive free list, so allocation
+// and free are O(1) and cannot fragment. Anything larger, or a class that has run out,
+// goes to the C heap with a small header recording its size.
+//
+// Classes are tried smallest first; a block may be larger than the request.
+
+#define SLAB_ALIGN(n)   (((n) + 7u) & ~7u)
+
+//         name      block size                        blocks
+#define SLAB_CLASSES(X)                                       \
+    X(small_16,   16,                              96)        \
+    X(small_32,   32,                              96)        \
+    X(small_64,   64,                              48)        \
+    X(obj,        SLAB_ALIGN(sizeof(lv_obj_t)),    32)        \
+    X(label,      SLAB_ALIGN(sizeof(lv_label_t)),  16)        \
+    X(medium_128, 128,                             16)        \
+    X(medium_256, 256,                             8)
+
+#define SLAB_STORAGE(name, size, count) \
+    static uint8_t slab_##name[(size) * (count)] __attribute__((aligned(8)));
+SLAB_CLASSES(SLAB_STORAGE)
+
+typedef struct slab_block {
+    struct slab_block *next;
+} slab_block_t;
+
+typedef struct {
+    slab_class_stats_t stats;
+    uint8_t *mem;
+    slab_block_t *free_list;
+} slab_class_t;
+
+#define SLAB_ENTRY(name, size, count) {.stats = {#name, (size), (count)}, .mem = slab_##name},
+static slab_class_t classes[] = {
+    SLAB_CLASSES(SLAB_ENTRY)
+};
+
+#define SLAB_CLASS_COUNT   (sizeof(classes) / sizeof(classes[0]))
+
+// Heap blocks carry their size, so realloc and the statistics work without a lookup table.
+typedef struct {
+    size_t size;
+    uint32_t pad;
+} heap_header_t;
+
+static slab_heap_stats_t heap_stats;
+
+static slab_class_t *find_class(const void *p)
+{
+    for (size_t i = 0; i < SLAB_CLASS_COUNT; i++) {
+        const slab_class_t *c = &classes[i];
+        if ((const uint8_t *)p >= c->mem && (const uint8_t *)p < c->mem + c->stats.block_size * c->stats.capacity) {
+            return &classes[i];
+        }
+    }
+    return NULL;
+}
+
+// Smallest class the size fits in, full or not.
+static slab_class_t *class_for_size(const size_t size)
+{
+    slab_class_t *best = NULL;
+    for (size_t i = 0; i < SLAB_CLASS_COUNT; i++) {
+        slab_class_t *c = &classes[i];
+        if (c->stats.block_size >= size && (!best || c->stats.block_size < best->stats.block_size)) {
+            best = c;
+        }
+    }
+    return best;
+}
+
+static void *heap_alloc(const size_t size)
+{
+    heap_header_t *hdr = malloc(sizeof(heap_header_t) + size);
+    if (!hdr) {
+        return NULL;
+    }
+
+    hdr->size = size;
+    heap_stats.allocs++;
+    heap_stats.live++;
+    heap_stats.live_bytes += size;
+    heap_stats.peak_live = LV_MAX(heap_stats.peak_live, heap_stats.live);
+    heap_stats.peak_bytes = LV_MAX(heap_stats.peak_bytes, heap_stats.live_bytes);
+    return hdr + 1;
+}
+
+static void heap_free(void *p)
+{
+    heap_header_t *hdr = (heap_header_t *)p - 1;
+    heap_stats.live--;
+    heap_stats.live_bytes -= hdr->size;
+    free(hdr);
+}
+
+static size_t block_size_of(void *p)
+{
+    const slab_class_t *c = find_class(p);
+    return c ? c->stats.block_size : ((heap_header_t *)p - 1)->size;
+}
+
+void lv_mem_init(void)
+{
+    for (size_t i = 0; i < SLAB_CLASS_COUNT; i++) {
+        slab_class_t *c = &classes[i];
+        c->free_list = NULL;
+        c->stats.used = 0;
+
+        // Build the list backwards so blocks are handed out in address order.
+        for (uint32_t b = c->stats.capacity; b > 0; b--) {
+            slab_block_t *block = (slab_block_t *)(c->mem + (b - 1) * c->stats.block_size);
+            block->next = c->free_list;
+            c->free_list = block;
+        }
+    }
+}
+
+void lv_mem_deinit(void)
+{
+}
+
+lv_mem_pool_t lv_mem_add_pool(void *mem, size_t bytes)
+{
+    LV_UNUSED(mem);
+    LV_UNUSED(bytes);
+    printf("Slab allocator: extra pools are not supported.\n\r");
+    return NULL;
+}
+
+void lv_mem_remove_pool(lv_mem_pool_t pool)
+{
+    LV_UNUSED(pool);
+}
+
+void *lv_malloc_core(size_t size)
+{
+    slab_class_t *c = class_for_size(size);
+    if (c && c->free_list) {
+        slab_block_t *block = c->free_list;
+        c->free_list = block->next;
+        c->stats.used++;
+        c->stats.allocs++;
+        c->stats.peak = LV_MAX(c->stats.peak, c->stats.used);
+        return block;
+    }
+
+    if (c) {
+        c->stats.overflows++;
+    }
+    return heap_alloc(size);
+}
+
+void lv_free_core(void *p)
+{
+    if (!p) {
+        return;
+    }
+
+    slab_class_t *c = find_class(p);
+    if (c) {
+        slab_block_t *block = p;
+        block->next = c->free_list;
+        c->free_list = block;
+        c->stats.used--;
+    }
+    else {
+        heap_free(p);
+    }
+}
+
+void *lv_realloc_core(void *p, size_t new_size)
+{
+    if (!p) {
+        return lv_malloc_core(new_size);
+    }
+
+    const size_t old_size = block_size_of(p);
+    if (find_class(p) && new_size <= old_size) {
+        return p;   // Still fits the block
+    }
+
+    void *new_p = lv_malloc_core(new_size);
+    if (new_p) {
+        memcpy(new_p, p, LV_MIN(old_size, new_size));
+        lv_free_core(p);
+    }
+    return new_p;
+}
+
+void lv_mem_monitor_core(lv_mem_monitor_t *mon_p)
+{
+    size_t total = 0;
+    size_t free_size = 0;
+    size_t biggest = 0;
+    uint32_t free_cnt = 0;
+    uint32_t used_cnt = 0;
+    size_t peak = 0;
+
+    for (size_t i = 0; i < SLAB_CLASS_COUNT; i++) {
+        const slab_class_stats_t *s = &classes[i].stats;
+        const uint32_t free_blocks = s->capacity - s->used;
+        total += s->block_size * s->capacity;
+        free_size += s->block_size * free_blocks;
+        free_cnt += free_blocks;
+        used_cnt += s->used;
+        peak += s->block_size * s->peak;
+        if (free_blocks) {
+            biggest = LV_MAX(biggest, s->block_size);
+        }
+    }
+
+    // Heap fallbacks count as used memory on top of the slabs.
+    mon_p->total_size = total + heap_stats.live_bytes;
+    mon_p->free_size = free_size;
+    mon_p->free_cnt = free_cnt;
+    mon_p->free_biggest_size = biggest;
+    mon_p->used_cnt = used_cnt + heap_stats.live;
+    mon_p->max_used = peak + heap_stats.peak_bytes;
+    mon_p->used_pct = mon_p->total_size ? 100 - (uint8_t)((free_size * 100) / mon_p->total_size) : 0;
+    mon_p->frag_pct = 0;   // Fixed blocks do not fragment
+}
+
+lv_result_t lv_mem_test_core(void)
+{
+    for (size_t i = 0; i < SLAB_CLASS_COUNT; i++) {
+        const slab_class_t *c = &classes[i];
+        uint32_t free_blocks = 0;
+        for (const slab_block_t *b = c->free_list; b; b = b->next) {
+            if (find_class(b) != c || free_blocks++ > c->stats.capacity) {
+                return LV_RESULT_INVALID;
+            }
+        }
+        if (free_blocks != c->stats.capacity - c->stats.used) {
+            return LV_RESULT_INVALID;
+        }
+    }
+    return LV_RESULT_OK;
+}
+
+size_t slab_alloc_class_count()
+{
+    return SLAB_CLASS_COUNT;
+}
+
+void slab_alloc_get_class_stats(size_t idx, slab_class_stats_t *stats)
+{
+    if (idx < SLAB_CLASS_COUNT) {
+        *stats = classes[idx].stats;
+    }
+}
+
+void slab_alloc_get_heap_stats(slab_heap_stats_t *stats)
+{
+    *stats = heap_stats;
+}
+
+void slab_alloc_print_stats()
+{
+    printf("Slab allocator:   class  block  used  peak capacity   allocs overflows\n\r");
+    for (size_t i = 0; i < SLAB_CLASS_COUNT; i++) {
+        const slab_class_stats_t *s = &classes[i].stats;
+        printf("  %20s %6d %5d %5d %8d %8d %9d\n\r", s->name, (int)s->block_size, (int)s->used, (int)s->peak,
+               (int)s->capacity, (int)s->allocs, (int)s->overflows);
+    }
+    printf("  %20s %6s %5d %5d %8s %8d bytes live %d, peak %d\n\r", "heap", "-", (int)heap_stats.live,
+           (int)heap_stats.peak_live, "-", (int)heap_stats.allocs, (int)heap_stats.live_bytes, (int)heap_stats.peak_bytes);
+}
+
+#else
+
+size_t slab_alloc_class_count()
+{
+    return 0;
+}
+
+void slab_alloc_get_class_stats(size_t idx, slab_class_stats_t *stats)
+{
+    LV_UNUSED(idx);
+    LV_UNUSED(stats);
+}
+
+void slab_alloc_get_heap_stats(slab_heap_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+void slab_alloc_print_stats()
+{
+}
+
+#endif   // LV_USE_STDLIB_MALLOC == LV_STDLIB_CUSTOM
@@ -0,0 +1,61 @@
+#include "stack_monitor.h"
+
+#include <stdio.h>
+
+// Stack bounds from the SDK linker script. Core 0 runs on SCRATCH_Y, core 1 on SCRATCH_X.
+extern uint32_t __StackBottom;
+extern uint32_t __StackTop;
+extern uint32_t __StackOneBottom;
+extern uint32_t __StackOneTop;
+
+#define STACK_PAINT          (0xC0DEC0DEu)
+#define STACK_PAINT_MARGIN   (64)   // Bytes left below the current frame while painting
+
+static void paint(uint32_t *bottom, uint32_t *top)
+{
+    for (uint32_t *p = bottom; p < top; p++) {
+        *p = STACK_PAINT;
+    }
+}
+
+void stack_monitor_paint()
+{
+    // Everything above this frame is live, paint only below it.
+    uint32_t marker;
+    uint32_t *limit = (uint32_t *)((uintptr_t)&marker - STACK_PAINT_MARGIN);
+    if (limit > &__StackBottom) {
+        paint(&__StackBottom, limit);
+    }
+
+    // Core 1 is not running yet.
+    paint(&__StackOneBottom, &__StackOneTop);
+}
+
+stack_usage_t stack_monitor_usage(stack_id_t stack)
+{
+    uint32_t *bottom = (stack == StackCore0) ? &__StackBottom : &__StackOneBottom;
+    uint32_t *top = (stack == StackCore0) ? &__StackTop : &__StackOneTop;
+
+    // Stacks grow down, the first overwritten word from the bottom is the deepest point.
+    uint32_t *p = bottom;
+    while (p < top && *p == STACK_PAINT) {
+        p++;
+    }
+
+    const stack_usage_t usage = {
+        .size = (uint32_t)((uintptr_t)top - (uintptr_t)bottom),
+        .high_water = (uint32_t)((uintptr_t)top - (uintptr_t)p),
+    };
+    return usage;
+}
+
+void stack_monitor_report()
+{
+    const stack_usage_t core0 = stack_monitor_usage(StackCore0);
+    const stack_usage_t core1 = stack_monitor_usage(StackCore1);
+    printf("Stack high water: core 0 %d of %d bytes, core 1 %d of %d bytes\n\r",
+           (int)core0.high_water, (int)core0.size, (int)core1.high_water, (int)core1.size);
+    if (core0.high_water >= core0.size) {
+        printf("ERROR: Core 0 stack overflowed!\n\r");
+    }
+}
@@ -0,0 +1,146 @@
+#include "telemetry.h"
+#include "crc16.h"
+#include "metrics.h"
+#include "lvgl.h"
+#include "pico/time.h"
+
+#include <string.h>
+
+#ifdef TELEMETRY_USB
+#include "tusb.h"
+#else
+#include "shell.h"
+#endif
+
+// Records are built from metrics deltas, so the shell's 'reset' does not disturb them.
+// A frame is queued whole or dropped; a partial frame would only be thrown away by the
+// decoder anyway. Zero never appears inside a frame, so the decoder resynchronises on the
+// next delimiter after any text or corruption on the line.
+
+static metrics_snapshot_t prev;
+static uint64_t next_record_us = 0;
+static uint16_t seq = 0;
+static uint16_t dropped = 0;
+static uint16_t last_encode_us = 0;
+
+size_t telemetry_cobs_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t code_idx = 0;
+    size_t out_idx = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_idx] = code;
+            code_idx = out_idx++;
+            code = 1;
+            continue;
+        }
+
+        out[out_idx++] = in[i];
+        if (++code == 0xFF) {
+            out[code_idx] = code;
+            code_idx = out_idx++;
+            code = 1;
+        }
+    }
+
+    out[code_idx] = code;
+    out[out_idx++] = 0;
+    return out_idx;
+}
+
+size_t telemetry_encode(const telemetry_record_t *record, uint8_t *frame)
+{
+    uint8_t raw[sizeof(telemetry_record_t) + 2];
+    memcpy(raw, record, sizeof(*record));
+    const uint16_t crc = crc16(CRC16_INIT, raw, sizeof(*record));
+    raw[sizeof(*record)] = crc & 0xFF;
+    raw[sizeof(*record) + 1] = crc >> 8;
+    return telemetry_cobs_encode(raw, sizeof(raw), frame);
+}
+
+static uint16_t clamp16(const uint32_t value)
+{
+    return value > UINT16_MAX ? UINT16_MAX : (uint16_t)value;
+}
+
+// Counts since the previous record. After a shell reset the counters restart from zero.
+static uint32_t delta(const uint32_t now, const uint32_t before)
+{
+    return now >= before ? now - before : now;
+}
+
+static void build_record(const uint64_t now_us, telemetry_record_t *r)
+{
+    metrics_snapshot_t s;
+    metrics_get_snapshot(now_us, &s);
+
+    const bool was_reset = s.window_us < prev.window_us;
+    const uint64_t period_us = was_reset ? s.window_us : s.window_us - prev.window_us;
+    const uint32_t frames = delta(s.frames, prev.frames);
+    const uint32_t flushes = delta(s.flushes, prev.flushes);
+    const uint32_t flush_us = delta(s.flush_us_sum, prev.flush_us_sum);
+    const uint32_t touches = delta(s.touch_samples, prev.touch_samples);
+    const uint32_t touch_us = delta(s.touch_latency_us_sum, prev.touch_latency_us_sum);
+
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+
+    memset(r, 0, sizeof(*r));
+    r->version = TELEMETRY_VERSION;
+    r->seq = seq++;
+    r->timestamp_ms = (uint32_t)(now_us / 1000);
+    r->battery_mv = clamp16(s.battery_mv);
+    if (period_us) {
+        r->loops_per_s = (uint32_t)(((uint64_t)delta(s.loops, prev.loops) * 1000000) / period_us);
+        r->fps_x10 = clamp16((uint32_t)(((uint64_t)frames * 10000000) / period_us));
+        r->lcd_bytes_per_s = (uint32_t)(((uint64_t)delta(s.lcd_bytes, prev.lcd_bytes) * 1000000) / period_us);
+    }
+    r->flush_avg_us = flushes ? clamp16(flush_us / flushes) : 0;
+    r->flush_max_us = clamp16(s.flush_us_max);
+    r->touch_samples = clamp16(touches);
+    r->touch_latency_avg_us = touches ? clamp16(touch_us / touches) : 0;
+    r->touch_latency_max_us = clamp16(s.touch_latency_us_max);
+    r->heap_used = mon.total_size - mon.free_size;
+    r->heap_biggest_free = mon.free_biggest_size;
+    r->heap_frag_pct = mon.frag_pct;
+    r->encode_us = last_encode_us;
+    r->dropped = dropped;
+
+    prev = s;
+}
+
+static bool send_frame(const uint8_t *frame, const size_t len)
+{
+#ifdef TELEMETRY_USB
+    if (!tud_cdc_connected() || tud_cdc_write_available() < len) {
+        return false;
+    }
+    tud_cdc_write(frame, len);
+    tud_cdc_write_flush();
+    return true;
+#else
+    return shell_write(frame, len);
+#endif
+}
+
+void tick_telemetry()
+{
+    const uint64_t now_us = time_us_64();
+    if (now_us < next_record_us) {
+        return;
+    }
+    next_record_us = now_us + TELEMETRY_PERIOD_MS * 1000;
+
+    const uint32_t start_us = time_us_32();
+    telemetry_record_t record;
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    build_record(now_us, &record);
+    const size_t len = telemetry_encode(&record, frame);
+    last_encode_us = clamp16(time_us_32() - start_us);
+
+    if (!send_frame(frame, len)) {
+        dropped++;
+    }
+}
@@ -0,0 +1,67 @@
+#include "timer_checkpoint.h"
+#include "crc16.h"
+#include "kv_store.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define US_PER_S   (1000000u)
+
+static uint32_t checkpoint_crc(const timer_checkpoint_t *cp)
+{
+    // Never 0, so a zeroed checkpoint is invalid.
+    return 0x54430000u | crc16(CRC16_INIT, cp, offsetof(timer_checkpoint_t, crc));
+}
+
+void timer_checkpoint_make(timer_checkpoint_t *cp, bool started, uint32_t remaining_s, uint64_t now_us)
+{
+    memset(cp, 0, sizeof(*cp));
+    cp->started = started;
+    cp->remaining_s = started ? 0 : remaining_s;
+    cp->deadline_us = started ? now_us + (uint64_t)remaining_s * US_PER_S : 0;
+    cp->saved_us = now_us;
+    cp->crc = checkpoint_crc(cp);
+}
+
+bool timer_checkpoint_valid(const timer_checkpoint_t *cp)
+{
+    return cp->crc == checkpoint_crc(cp) && cp->started <= 1 && (!cp->started || cp->deadline_us >= cp->saved_us);
+}
+
+uint32_t timer_checkpoint_remaining_s(const timer_checkpoint_t *cp, uint64_t now_us)
+{
+    if (!cp->started) {
+        return cp->remaining_s;
+    }
+    if (now_us >= cp->deadline_us) {
+        return 0;
+    }
+    return (uint32_t)((cp->deadline_us - now_us + US_PER_S - 1) / US_PER_S);
+}
+
+timer_checkpoint_result_t timer_checkpoint_update(timer_checkpoint_t *cp, bool started, uint32_t remaining_s,
+                                                  uint64_t now_us, timer_checkpoint_stats_t *stats)
+{
+    stats->updates++;
+
+    timer_checkpoint_result_t result = TimerCheckpointChanged;
+    if (timer_checkpoint_valid(cp) && cp->started == started) {
+        const uint32_t expected = timer_checkpoint_remaining_s(cp, now_us);
+        const uint32_t diff = (expected > remaining_s) ? expected - remaining_s : remaining_s - expected;
+        if (diff == 0 || (started && diff == 1)) {
+            return TimerCheckpointCurrent;
+        }
+        if (started && diff == 2) {
+            result = TimerCheckpointDrift;
+        }
+    }
+
+    timer_checkpoint_make(cp, started, remaining_s, now_us);
+    if (result == TimerCheckpointDrift) {
+        stats->drifts++;
+    }
+    else {
+        stats->changes++;
+    }
+    return result;
+}
@@ -1,7 +1,16 @@
 #include "touch_screen.h"
+#include "bench.h"
+#include "clock_plan.h"
+#include "hot_path.h"
+#include "kv_store.h"
+#include "metrics.h"
+#include "touch_trace.h"
 #include "hardware/gpio.h"
 #include "hardware/irq.h"
 #include "hardware/spi.h"
+#if PICO_ON_DEVICE
+#include "hardware/structs/io_bank0.h"
+#endif
 
 #include "pico/time.h"
 #include <stdio.h>
@@ -51,19 +60,26 @@
 
 // Not sure why the reading is usually maxed at ~1800 and min at ~200. I was expecting it to go to 4096.
 // This is detected using manual testing. This might be different for each LEDS. Therefore some calibration
-// is needed.
+// is needed. READING_MIN and READING_MAX are the defaults, a calibration saved in the KV store
+// replaces them.
 
-static bool read = false;
+static touch_calibration_t calibration = {.x_min = READING_MIN, .x_max = READING_MAX,
+                                           .y_min = READING_MIN, .y_max = READING_MAX};
+
+static volatile bool read = false;
+static bool ignore_until_release = false;
+static uint32_t read_requested_us = 0;   // When the pen down interrupt or the alarm asked for a read
 static touch_point_t touch_point = {};
 
 static int64_t alarm_cb_continue_read(alarm_id_t id, void *user_data)
 {
+    read_requested_us = time_us_32();
     read = true;
     return 0;
 }
 
-static uint16_t sanitise_reading(const uint16_t reading, const uint16_t pixel_count,
-                                 const uint16_t max_reading, const uint16_t min_reading)
+static uint16_t HOT_PATH_FUNC(sanitise_reading)(const uint16_t reading, const uint16_t pixel_count,
+                                                const uint16_t max_reading, const uint16_t min_reading)
 {
     uint16_t out_reading = reading;
 
@@ -97,7 +113,7 @@ static bool queue_if_valid(const touch_point_t tp)
     return touch_point.valid;
 }
 
-static uint16_t get_reading(const uint8_t* buffer)
+static uint16_t HOT_PATH_FUNC(get_reading)(const uint8_t* buffer)
 {
     // Only the first 12 bits have valid data.
     // Data is in the buffer MSB first.
@@ -106,17 +122,48 @@ static uint16_t get_reading(const uint8_t* buffer)
     return reading;
 }
 
-void touch_irq()
+// gpio_acknowledge_irq() and gpio_set_irq_enabled(.., false) on the registers, the SDK's are
+// in flash. init_touch_screen() enables the IRQ on core 0.
+static inline void HOT_PATH_FUNC(touch_irq_disable)()
 {
-    // We don't enable interrupts until we detect the release. The release is detected by
-    // contnuously reading the touch sensor and evaluating the reading.
+#if PICO_ON_DEVICE
+    const uint32_t events = GPIO_IRQ_EDGE_FALL << (4 * (TOUCH_SCREEN_IRQ % 8));
+    io_bank0_hw->intr[TOUCH_SCREEN_IRQ / 8] = events;
+    hw_clear_bits(&io_bank0_hw->proc0_irq_ctrl.inte[TOUCH_SCREEN_IRQ / 8], events);
+#else
     gpio_acknowledge_irq(TOUCH_SCREEN_IRQ, GPIO_IRQ_EDGE_FALL);
     gpio_set_irq_enabled(TOUCH_SCREEN_IRQ, GPIO_IRQ_EDGE_FALL, false);
+#endif
+}
+
+void HOT_PATH_FUNC(touch_irq)()
+{
+    // We don't enable interrupts until we detect the release. The release is detected by
+    // contnuously reading the touch sensor and evaluating the reading.
+    touch_irq_disable();
+    read_requested_us = time_us_32();
     read = true;
 }
 
+void touch_screen_set_calibration(const touch_calibration_t *cal)
+{
+    if (cal->x_max <= cal->x_min || cal->y_max <= cal->y_min) {
+        printf("ERROR: Invalid touch calibration.\n\r");
+        return;
+    }
+    calibration = *cal;
+    kv_set(KvKeyTouchCalibration, cal, sizeof(*cal));
+}
+
 void init_touch_screen()
 {
+    touch_calibration_t cal;
+    if (kv_get(KvKeyTouchCalibration, &cal, sizeof(cal)) == sizeof(cal) &&
+        cal.x_max > cal.x_min && cal.y_max > cal.y_min) {
+        calibration = cal;
+        printf("Touch calibration: x %d - %d, y %d - %d\n\r", cal.x_min, cal.x_max, cal.y_min, cal.y_max);
+    }
+
     gpio_init(TOUCH_SCREEN_IRQ);
     gpio_set_dir(TOUCH_SCREEN_IRQ, false);
     irq_set_enabled(IO_IRQ_BANK0, true);
@@ -131,14 +178,21 @@ void init_touch_screen()
     gpio_set_function(GPIO_SPI1_RX, GPIO_FUNC_SPI);
     gpio_set_function(GPIO_SPI1_SCK, GPIO_FUNC_SPI);
     gpio_set_function(GPIO_SPI1_TX, GPIO_FUNC_SPI);
-    const uint baud = spi_init(spi1, 100000);
+    const uint baud = spi_init(spi1, CLOCK_TOUCH_SPI_HZ);
     printf("SPI initialised with: %d baudrate\n\r", baud);
 
     gpio_set_irq_enabled(TOUCH_SCREEN_IRQ, GPIO_IRQ_EDGE_FALL, true);
     gpio_put(GPIO_SPI1_CSn, true);
 }
 
-static touch_point_t read_touch_point()
+static touch_point_t HOT_PATH_FUNC(touch_point_from_raw)(const uint16_t raw_x, const uint16_t raw_y)
+{
+    const touch_point_t tp = {.x = sanitise_reading(raw_x, X_RESOLUTION, calibration.x_max, calibration.x_min),
+                              .y = sanitise_reading(raw_y, Y_RESOLUTION, calibration.y_max, calibration.y_min)};
+    return tp;
+}
+
+static touch_point_t HOT_PATH_FUNC(read_touch_point)()
 {
     gpio_put(GPIO_SPI1_CSn, false);
 
@@ -149,31 +203,60 @@ static touch_point_t read_touch_point()
 
     spi_write_blocking(spi1, &read_y, sizeof(read_y));
     spi_read_blocking(spi1, dummy, buffer, sizeof(buffer));
-    uint16_t reading_y = get_reading(buffer);
+    const uint16_t reading_y = get_reading(buffer);
     // printf("Y: %d\n", reading_y);
-    reading_y = sanitise_reading(reading_y, Y_RESOLUTION, READING_MAX, READING_MIN);
 
     spi_write_blocking(spi1, &read_x, sizeof(read_x));
     spi_read_blocking(spi1, dummy, buffer, sizeof(buffer));
 
-    uint16_t reading_x = get_reading(buffer);
+    const uint16_t reading_x = get_reading(buffer);
     // printf("X: %d\n", reading_x);
-    reading_x = sanitise_reading(reading_x, X_RESOLUTION, READING_MAX, READING_MIN);
-
-    touch_point_t tp = {.x = reading_x, .y = reading_y};
     gpio_put(GPIO_SPI1_CSn, true);
 
-    return tp;
+    touch_trace_record(read_requested_us, reading_x, reading_y);
+    return touch_point_from_raw(reading_x, reading_y);
+}
+
+// A replayed trace stands in for the panel, real touches are dropped until it ends.
+static bool replay_touch_trace()
+{
+    if (!touch_trace_replaying()) {
+        return false;
+    }
+
+    if (read) {
+        read = false;
+        gpio_set_irq_enabled(TOUCH_SCREEN_IRQ, GPIO_IRQ_EDGE_FALL, true);
+    }
+
+    uint16_t raw_x, raw_y;
+    const uint32_t now_us = time_us_32();
+    if (touch_trace_next(now_us, &raw_x, &raw_y)) {
+        const bool was_valid = touch_point.valid;
+        if (queue_if_valid(touch_point_from_raw(raw_x, raw_y)) != was_valid) {
+            touch_trace_edge(now_us);
+        }
+    }
+    return true;
 }
 
 void tick_touch_screen()
 {
+    if (replay_touch_trace()) {
+        return;
+    }
+
     if (read) {
         read = false;
 
         // Read touch point
         const touch_point_t tp = read_touch_point();
+        metrics_touch_sample(time_us_32() - read_requested_us);
         const bool is_valid = queue_if_valid(tp);
+        if (ignore_until_release) {
+            ignore_until_release = is_valid;
+            touch_point.valid = false;
+        }
 
         if (is_valid) {
             // If touch point is valid schedule another read in 200 ms.
@@ -191,3 +274,35 @@ touch_point_t get_touch_point()
     return touch_point;
 }
 
+bool touch_screen_read_pending()
+{
+    return read;
+}
+
+void touch_screen_ignore_until_release()
+{
+    ignore_until_release = true;
+}
+
+#ifdef BENCHMARK_SUITE
+void touch_screen_benchmark()
+{
+    const uint32_t iterations = 100000;
+    volatile uint32_t sink = 0;
+
+    uint64_t start_us = bench_cpu_us();
+    for (uint32_t i = 0; i < iterations; i++) {
+        sink += sanitise_reading((uint16_t)(i & 0x0fff), Y_RESOLUTION, calibration.y_max, calibration.y_min);
+    }
+    bench_report("touch.sanitise_reading", iterations, bench_cpu_us() - start_us, 0);
+
+    uint8_t buffer[2];
+    start_us = bench_cpu_us();
+    for (uint32_t i = 0; i < iterations; i++) {
+        buffer[0] = (uint8_t)(i >> 4);
+        buffer[1] = (uint8_t)(i << 4);
+        sink += get_reading(buffer);
+    }
+    bench_report("touch.get_reading", iterations, bench_cpu_us() - start_us, 0);
+}
+#endif
@@ -0,0 +1,165 @@
+#include "touch_trace.h"
+
+#include <string.h>
+
+// No SDK calls, the caller passes the time in.
+
+#define NO_EDGE   (UINT32_MAX)
+
+static touch_trace_sample_t samples[TOUCH_TRACE_MAX_SAMPLES];
+static size_t sample_count = 0;
+
+static bool recording = false;
+static uint32_t record_start_us = 0;
+
+static bool replaying = false;
+static size_t replay_next = 0;
+static uint32_t replay_start_us = 0;
+
+// Edges waiting for their event and frame, and the latencies found so far.
+static uint32_t edge_event_us = NO_EDGE;
+static uint32_t edge_frame_us = NO_EDGE;
+static uint32_t event_latency_us[TOUCH_TRACE_MAX_SAMPLES];
+static uint32_t frame_latency_us[TOUCH_TRACE_MAX_SAMPLES];
+static size_t event_count = 0;
+static size_t frame_count = 0;
+
+void touch_trace_set_recording(bool on)
+{
+    if (on) {
+        sample_count = 0;
+        replaying = false;
+    }
+    recording = on;
+}
+
+bool touch_trace_recording()
+{
+    return recording;
+}
+
+void touch_trace_record(uint32_t now_us, uint16_t raw_x, uint16_t raw_y)
+{
+    if (!recording) {
+        return;
+    }
+    if (sample_count == 0) {
+        record_start_us = now_us;
+    }
+    samples[sample_count++] = (touch_trace_sample_t){.t_us = now_us - record_start_us, .raw_x = raw_x, .raw_y = raw_y};
+    if (sample_count == TOUCH_TRACE_MAX_SAMPLES) {
+        recording = false;
+    }
+}
+
+size_t touch_trace_count()
+{
+    return sample_count;
+}
+
+bool touch_trace_get(size_t idx, touch_trace_sample_t *sample)
+{
+    if (idx >= sample_count) {
+        return false;
+    }
+    *sample = samples[idx];
+    return true;
+}
+
+void touch_trace_clear()
+{
+    sample_count = 0;
+    recording = false;
+    replaying = false;
+}
+
+bool touch_trace_load(const touch_trace_sample_t *sample)
+{
+    if (sample_count == TOUCH_TRACE_MAX_SAMPLES || (sample_count && sample->t_us < samples[sample_count - 1].t_us)) {
+        return false;
+    }
+    samples[sample_count++] = *sample;
+    return true;
+}
+
+void touch_trace_start_replay(uint32_t now_us)
+{
+    recording = false;
+    replaying = sample_count > 0;
+    replay_next = 0;
+    replay_start_us = now_us;
+    edge_event_us = NO_EDGE;
+    edge_frame_us = NO_EDGE;
+    event_count = 0;
+    frame_count = 0;
+}
+
+bool touch_trace_replaying()
+{
+    return replaying;
+}
+
+bool touch_trace_next(uint32_t now_us, uint16_t *raw_x, uint16_t *raw_y)
+{
+    if (!replaying || now_us - replay_start_us < samples[replay_next].t_us) {
+        return false;
+    }
+
+    *raw_x = samples[replay_next].raw_x;
+    *raw_y = samples[replay_next].raw_y;
+    if (++replay_next == sample_count) {
+        replaying = false;
+    }
+    return true;
+}
+
+void touch_trace_edge(uint32_t now_us)
+{
+    edge_event_us = now_us;
+    edge_frame_us = now_us;
+}
+
+void touch_trace_event(uint32_t now_us)
+{
+    if (edge_event_us != NO_EDGE && event_count < TOUCH_TRACE_MAX_SAMPLES) {
+        event_latency_us[event_count++] = now_us - edge_event_us;
+        edge_event_us = NO_EDGE;
+    }
+}
+
+void touch_trace_frame(uint32_t now_us)
+{
+    if (edge_frame_us != NO_EDGE && frame_count < TOUCH_TRACE_MAX_SAMPLES) {
+        frame_latency_us[frame_count++] = now_us - edge_frame_us;
+        edge_frame_us = NO_EDGE;
+    }
+}
+
+static void percentiles(const uint32_t *latency_us, size_t count, touch_latency_t *out)
+{
+    static uint32_t sorted[TOUCH_TRACE_MAX_SAMPLES];
+    memcpy(sorted, latency_us, count * sizeof(sorted[0]));
+    for (size_t i = 1; i < count; i++) {
+        const uint32_t v = sorted[i];
+        size_t j = i;
+        for (; j > 0 && sorted[j - 1] > v; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->count = count;
+    if (count) {
+        out->p50_us = sorted[(count - 1) * 50 / 100];
+        out->p90_us = sorted[(count - 1) * 90 / 100];
+        out->p99_us = sorted[(count - 1) * 99 / 100];
+        out->max_us = sorted[count - 1];
+    }
+}
+
+void touch_trace_latency(touch_latency_t *to_event, touch_latency_t *to_frame)
+{
+    percentiles(event_latency_us, event_count, to_event);
+    percentiles(frame_latency_us, frame_count, to_frame);
+}
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Extract and compare benchmark results of two builds.
+
+A build with BENCHMARK_SUITE prints one JSON object per line, prefixed with 'bench ', after
+boot (src/bench.c). 'extract' collects them from a capture of the debug UART into a
+results file; 'compare' lines up two results files (or raw captures) by benchmark name and
+fails if any benchmark takes more than --threshold percent longer per operation.
+
+  bench_compare.py extract capture.txt -o baseline.json
+  bench_compare.py extract --port /dev/ttyUSB0 -o candidate.json   (needs pyserial)
+  bench_compare.py compare baseline.json candidate.json --threshold 5
+  bench_compare.py compare baseline.json candidate.json --match ui.render_clock
+"""
+
+import argparse
+import json
+import sys
+
+
+def parse_lines(lines):
+    results = {'build': {}, 'benchmarks': {}}
+    for line in lines:
+        # The shell prompt can come first, the main loop benchmark runs the shell.
+        start = line.find('bench {')
+        if start < 0:
+            continue
+        try:
+            record = json.loads(line[start + len('bench '):].strip())
+        except ValueError:
+            continue
+        if 'build' in record:
+            results['build'] = record['build']
+        elif 'name' in record:
+            results['benchmarks'][record.pop('name')] = record
+    return results
+
+
+def read_serial(port, baud, timeout):
+    import serial   # Only needed for live captures
+    import time
+
+    lines = []
+    deadline = time.monotonic() + timeout
+    with serial.Serial(port, baud, timeout=1) as s:
+        while time.monotonic() < deadline:
+            line = s.readline().decode('ascii', errors='replace')
+            lines.append(line)
+            if 'bench {"done"' in line:
+                break
+    return lines
+
+
+def load(path):
+    """A results file written by 'extract', or a raw capture."""
+    with open(path, encoding='ascii', errors='replace') as f:
+        text = f.read()
+    try:
+        return json.loads(text)
+    except ValueError:
+        return parse_lines(text.splitlines())
+
+
+def extract(args):
+    if args.port:
+        results = parse_lines(read_serial(args.port, args.baud, args.timeout))
+    else:
+        results = load(args.capture)
+    if not results['benchmarks']:
+        print('bench_compare: no results, is BENCHMARK_SUITE on?', file=sys.stderr)
+        return 1
+
+    text = json.dumps(results, indent=2, sort_keys=True) + '\n'
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+    return 0
+
+
+def compare(args):
+    base = load(args.baseline)
+    cand = load(args.candidate)
+
+    for key in sorted(set(base['build']) | set(cand['build'])):
+        a, b = base['build'].get(key), cand['build'].get(key)
+        if a != b:
+            print('bench_compare: build %s differs: %s -> %s' % (key, a, b))
+
+    print('%-32s %12s %12s %8s' % ('benchmark', 'base ns/op', 'new ns/op', 'change'))
+    regressions = []
+    for name in sorted(set(base['benchmarks']) | set(cand['benchmarks'])):
+        if args.match and not name.startswith(args.match):
+            continue
+        a = base['benchmarks'].get(name)
+        b = cand['benchmarks'].get(name)
+        if not a or not b:
+            print('%-32s %12s %12s %8s' % (name, a['ns_per_op'] if a else '-', b['ns_per_op'] if b else '-', 'n/a'))
+            continue
+
+        change = 100.0 * (b['ns_per_op'] - a['ns_per_op']) / a['ns_per_op'] if a['ns_per_op'] else 0.0
+        flag = ''
+        if change > args.threshold:
+            regressions.append(name)
+            flag = '  REGRESSION'
+        print('%-32s %12d %12d %+7.1f%%%s' % (name, a['ns_per_op'], b['ns_per_op'], change, flag))
+
+    if regressions:
+        print('bench_compare: %d benchmarks are over %g%% slower' % (len(regressions), args.threshold), file=sys.stderr)
+        return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    ex = sub.add_parser('extract', help='collect the results of one run')
+    ex.add_argument('capture', nargs='?', help='text captured from the debug UART')
+    ex.add_argument('--port', help='read from a serial port instead')
+    ex.add_argument('--baud', type=int, default=115200)
+    ex.add_argument('--timeout', type=float, default=60, help='seconds to wait for the results')
+    ex.add_argument('-o', '--output', help='results file, stdout if not given')
+    ex.set_defaults(func=extract)
+
+    cmp = sub.add_parser('compare', help='compare two runs')
+    cmp.add_argument('baseline')
+    cmp.add_argument('candidate')
+    cmp.add_argument('--threshold', type=float, default=10, help='percent slower per operation that fails')
+    cmp.add_argument('--match', help='only the benchmarks whose names start with this')
+    cmp.set_defaults(func=compare)
+
+    args = parser.parse_args()
+    if args.command == 'extract' and not args.capture and not args.port:
+        parser.error('give a capture file or --port')
+    return args.func(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
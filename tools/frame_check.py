@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+"""Compare frames captured from the firmware with golden images.
+
+A build with UI_FRAME_CAPTURE renders every UI state at boot (src/display_framework.c,
+capture_frames) and traces the panel traffic as 'fc' lines (src/frame_capture.c). The
+trace is replayed on the panel model of st7789_model.py and the panel contents at the end
+of each scene are compared with <golden>/<scene>.png. Render time and flushed bytes are checked against
+<golden>/frames.json.
+
+A scene fails on any pixel difference, on a render time more than --max-render-regress
+percent above the golden one (or above --max-render-us), or on more flushed bytes than
+--max-bytes-regress percent allows. For a failed pixel comparison the actual frame and a
+diff image (differences in red over the dimmed golden) are written to --out.
+
+  frame_check.py capture.txt
+  frame_check.py --port /dev/ttyUSB0 --timeout 120    (needs pyserial)
+  frame_check.py capture.txt --update                 (accept the capture as golden)
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import zlib
+
+from st7789_model import St7789, frame_rows, replay, rgb565_to_rgb, write_png
+
+DEFAULT_GOLDEN = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'golden')
+TIMINGS = 'frames.json'
+
+
+class Frame:
+    def __init__(self, scene, width, height, pixels, covered, render_us, flushed_bytes):
+        self.scene = scene
+        self.width = width
+        self.height = height
+        self.pixels = pixels
+        self.covered = covered
+        self.render_us = render_us
+        self.flushed_bytes = flushed_bytes
+
+
+def parse_capture(lines):
+    """The panel contents at the end of every scene, in capture order."""
+    frames = []
+    panel = St7789()
+    scene = None
+    for kind, args in replay(lines, panel):
+        if kind == 'begin':
+            scene = args[0]
+            panel.clear_coverage()
+        elif kind == 'end' and scene == args[0]:
+            frames.append(Frame(scene, panel.width, panel.height, list(panel.ram), list(panel.covered),
+                                int(args[1]), int(args[2])))
+            scene = None
+    return frames
+
+
+def rgb_to_rgb565(r, g, b):
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)
+
+
+def read_png(path):
+    """8 bit RGB or RGBA, not interlaced. Returns width, height and RGB565 pixels."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise ValueError('%s: not a PNG file' % path)
+
+    pos, idat = 8, b''
+    width = height = channels = 0
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b'IHDR':
+            width, height, depth, colour, _, _, interlace = struct.unpack('>IIBBBBB', body)
+            if depth != 8 or colour not in (2, 6) or interlace:
+                raise ValueError('%s: only 8 bit RGB(A), non-interlaced PNG files are supported' % path)
+            channels = 3 if colour == 2 else 4
+        elif kind == b'IDAT':
+            idat += body
+        elif kind == b'IEND':
+            break
+
+    raw = zlib.decompress(idat)
+    stride = width * channels
+    prev = bytearray(stride)
+    pixels = []
+    for y in range(height):
+        start = y * (stride + 1)
+        kind, row = raw[start], bytearray(raw[start + 1:start + 1 + stride])
+        for i in range(stride):
+            a = row[i - channels] if i >= channels else 0
+            b = prev[i]
+            c = prev[i - channels] if i >= channels else 0
+            if kind == 1:
+                row[i] = (row[i] + a) & 0xFF
+            elif kind == 2:
+                row[i] = (row[i] + b) & 0xFF
+            elif kind == 3:
+                row[i] = (row[i] + (a + b) // 2) & 0xFF
+            elif kind == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                row[i] = (row[i] + (a if pa <= pb and pa <= pc else b if pb <= pc else c)) & 0xFF
+        pixels.extend(rgb_to_rgb565(*row[x * channels:x * channels + 3]) for x in range(width))
+        prev = row
+    return width, height, pixels
+
+
+def diff_rows(width, height, golden, actual):
+    for y in range(height):
+        row = []
+        for x in range(width):
+            i = y * width + x
+            if golden[i] != actual[i]:
+                row.extend((255, 0, 0))
+            else:
+                row.extend(c // 4 for c in rgb565_to_rgb(golden[i]))
+        yield row
+
+
+def check_frame(frame, golden_dir, timings, args):
+    errors = []
+    path = os.path.join(golden_dir, frame.scene + '.png')
+    if not os.path.exists(path):
+        return ['no golden image %s, run with --update' % path]
+
+    width, height, golden = read_png(path)
+    if (width, height) != (frame.width, frame.height):
+        return ['frame is %dx%d, golden image %dx%d' % (frame.width, frame.height, width, height)]
+
+    diff = [i for i in range(len(golden)) if golden[i] != frame.pixels[i]]
+    if diff:
+        xs = [i % width for i in diff]
+        ys = [i // width for i in diff]
+        errors.append('%d pixels differ in (%d, %d) - (%d, %d)' % (len(diff), min(xs), min(ys), max(xs), max(ys)))
+        os.makedirs(args.out, exist_ok=True)
+        write_png(os.path.join(args.out, frame.scene + '-actual.png'), width, height,
+                  frame_rows(width, height, frame.pixels))
+        write_png(os.path.join(args.out, frame.scene + '-diff.png'), width, height,
+                  diff_rows(width, height, golden, frame.pixels))
+
+    ref = timings.get(frame.scene)
+    if ref:
+        limit_us = ref['render_us'] * (100 + args.max_render_regress) // 100
+        if frame.render_us > limit_us:
+            errors.append('render %d us, golden %d us, limit %d us' % (frame.render_us, ref['render_us'], limit_us))
+        limit_bytes = ref['flushed_bytes'] * (100 + args.max_bytes_regress) // 100
+        if frame.flushed_bytes > limit_bytes:
+            errors.append('flushed %d bytes, golden %d, limit %d' % (frame.flushed_bytes, ref['flushed_bytes'], limit_bytes))
+    if args.max_render_us and frame.render_us > args.max_render_us:
+        errors.append('render %d us, over %d us' % (frame.render_us, args.max_render_us))
+    return errors
+
+
+def update_golden(frames, golden_dir, timings):
+    os.makedirs(golden_dir, exist_ok=True)
+    for frame in frames:
+        write_png(os.path.join(golden_dir, frame.scene + '.png'), frame.width, frame.height,
+                  frame_rows(frame.width, frame.height, frame.pixels))
+        timings[frame.scene] = {'render_us': frame.render_us, 'flushed_bytes': frame.flushed_bytes}
+        print('frame_check: %-10s updated, %d us, %d bytes' % (frame.scene, frame.render_us, frame.flushed_bytes))
+    with open(os.path.join(golden_dir, TIMINGS), 'w') as f:
+        json.dump(timings, f, indent=2, sort_keys=True)
+        f.write('\n')
+
+
+def read_serial(port, baud, timeout):
+    import serial   # Only needed for live captures
+    import time
+
+    lines = []
+    deadline = time.monotonic() + timeout
+    with serial.Serial(port, baud, timeout=1) as s:
+        while time.monotonic() < deadline:
+            line = s.readline().decode('ascii', errors='replace')
+            if line:
+                lines.append(line)
+            if line.startswith('fc done'):
+                break
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('capture', nargs='?', help='text captured from the debug UART')
+    parser.add_argument('--port', help='read the capture from a serial port instead')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--timeout', type=float, default=120, help='seconds to wait for the capture')
+    parser.add_argument('--golden', default=DEFAULT_GOLDEN, help='golden image directory')
+    parser.add_argument('--out', default='frame_check_out', help='where failed frames and diffs are written')
+    parser.add_argument('--update', action='store_true', help='write the capture as the new golden images')
+    parser.add_argument('--max-render-regress', type=int, default=10, help='percent over the golden render time')
+    parser.add_argument('--max-bytes-regress', type=int, default=0, help='percent over the golden flushed bytes')
+    parser.add_argument('--max-render-us', type=int, default=0, help='absolute render time limit, 0 disables')
+    args = parser.parse_args()
+
+    if args.port:
+        lines = read_serial(args.port, args.baud, args.timeout)
+    elif args.capture:
+        with open(args.capture, encoding='ascii', errors='replace') as f:
+            lines = f.readlines()
+    else:
+        parser.error('give a capture file or --port')
+
+    frames = parse_capture(lines)
+    if not frames:
+        print('frame_check: no scenes in the capture, is UI_FRAME_CAPTURE on?', file=sys.stderr)
+        return 1
+
+    timings_path = os.path.join(args.golden, TIMINGS)
+    timings = {}
+    if os.path.exists(timings_path):
+        with open(timings_path) as f:
+            timings = json.load(f)
+
+    if args.update:
+        update_golden(frames, args.golden, timings)
+        return 0
+
+    failed = 0
+    for frame in frames:
+        errors = check_frame(frame, args.golden, timings, args)
+        missing = frame.covered.count(False)
+        if missing:
+            errors.append('%d pixels were never flushed' % missing)
+        if errors:
+            failed += 1
+            for e in errors:
+                print('frame_check: %-10s FAIL %s' % (frame.scene, e), file=sys.stderr)
+        else:
+            print('frame_check: %-10s ok, %d us, %d bytes' % (frame.scene, frame.render_us, frame.flushed_bytes))
+
+    if failed:
+        print('frame_check: %d of %d frames failed, see %s' % (failed, len(frames), args.out), file=sys.stderr)
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
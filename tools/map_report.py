@@ -0,0 +1,257 @@
+#!/usr/bin/env python3
+"""Memory reports from the GNU ld map file of the firmware.
+
+  hot   Lists the functions and tables placed in SRAM through the .time_critical
+        sections (HOT_PATH_FUNC, __not_in_flash and LV_ATTRIBUTE_FAST_MEM) and their
+        SRAM cost. Everything in .time_critical is also kept in flash as the load
+        image, so the cost is paid once in SRAM and once in flash. With the ELF given,
+        disassembles the application's and LVGL's SRAM functions and fails if one of
+        them calls into flash (a long call veneer, or a call below SRAM), where a QSPI
+        cache miss would stall it after all.
+
+  ram   Splits flash, .data and .bss per source file in src/ and per LVGL module
+        (the directory under lvgl/src the file lives in), and reports the heap and
+        stack sizes the linker script leaves. With budgets given, fails the build if
+        the application or LVGL static RAM is over budget, or heap or stack are under.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+# An input section line. Long section names put the address and size on the next line.
+INPUT_SECTION = re.compile(r'^ (\.\S+|COMMON)\s*\n?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$', re.M)
+SYMBOL = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_]\w*)\s*$')
+# objdump -d: a function label and a call, e.g. 'bl 20000308 <__metrics_flush_veneer>'.
+DISASM_LABEL = re.compile(r'^([0-9a-fA-F]+) <([^>]+)>:$')
+DISASM_CALL = re.compile(r'\sbl\s+([0-9a-fA-F]+)\s+<([^>+]+)(?:\+0x[0-9a-fA-F]+)?>')
+VENEER = re.compile(r'^__(\w+?)_veneer$')
+SRAM_BASE = 0x20000000
+ASSIGNMENT = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+(?:PROVIDE \()?([A-Za-z_]\w*)\)?\s*=', re.M)
+
+
+class InputSection:
+    def __init__(self, name, addr, size, obj):
+        self.name = name
+        self.addr = addr
+        self.size = size
+        self.obj = obj
+        self.symbols = []
+
+    @property
+    def source(self):
+        """Source file of the object, e.g. custom_isr.c for .../libApplication.a(custom_isr.c.obj)."""
+        m = re.search(r'\(([^)]+)\)$', self.obj)
+        name = os.path.basename(m.group(1) if m else self.obj)
+        return re.sub(r'\.(obj|o)$', '', name)
+
+
+def read_sections(path):
+    with open(path, encoding='utf-8', errors='replace') as f:
+        text = f.read()
+
+    start = text.find('Linker script and memory map')
+    text = text[start:] if start >= 0 else text
+
+    sections = []
+    matches = list(INPUT_SECTION.finditer(text))
+    for i, m in enumerate(matches):
+        section = InputSection(m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4).strip())
+        if section.size == 0:
+            continue
+
+        end = matches[i + 1].start() if i + 1 < len(matches) else len(text)
+        for line in text[m.end():end].splitlines():
+            s = SYMBOL.match(line)
+            if s:
+                section.symbols.append(s.group(2))
+        sections.append(section)
+    return sections
+
+
+def read_assignments(path):
+    """Linker script symbol assignments, e.g. __StackTop = ORIGIN (SCRATCH_Y) + ..."""
+    with open(path, encoding='utf-8', errors='replace') as f:
+        return {m.group(2): int(m.group(1), 16) for m in ASSIGNMENT.finditer(f.read())}
+
+
+def section_kind(name):
+    if name.startswith(('.bss', '.draw_buf', '.uninitialized_data')) or name == 'COMMON':
+        return 'bss'
+    if name.startswith(('.data', '.time_critical', '.sdata')):
+        return 'data'
+    if name.startswith(('.text', '.rodata', '.init_array', '.fini_array', '.ARM')):
+        return 'flash'
+    return None
+
+
+def lvgl_modules(lvgl_src):
+    """Maps LVGL source file names to the module directory they live in."""
+    modules = {}
+    if not lvgl_src:
+        return modules
+    for root, _, files in os.walk(lvgl_src):
+        rel = os.path.relpath(root, lvgl_src)
+        module = rel.split(os.sep)[0] if rel != '.' else 'lvgl'
+        for f in files:
+            if f.endswith('.c'):
+                modules[f] = module
+    return modules
+
+
+def ram_report(args):
+    app_sources = {f for f in os.listdir(args.app_src) if f.endswith('.c')} if args.app_src else set()
+    modules = lvgl_modules(args.lvgl_src)
+
+    groups = {}
+    for s in read_sections(args.map):
+        kind = section_kind(s.name)
+        if not kind:
+            continue
+        if s.source in app_sources:
+            key = ('src', s.source)
+        elif s.source in modules:
+            key = ('lvgl', modules[s.source])
+        else:
+            key = ('other', s.source)
+        sizes = groups.setdefault(key, {'flash': 0, 'data': 0, 'bss': 0})
+        sizes[kind] += s.size
+
+    totals = {}
+    for area in ('src', 'lvgl', 'other'):
+        rows = sorted(((k[1], v) for k, v in groups.items() if k[0] == area), key=lambda r: -(r[1]['data'] + r[1]['bss']))
+        total = {'flash': 0, 'data': 0, 'bss': 0}
+        for name, sizes in rows:
+            for k in total:
+                total[k] += sizes[k]
+        totals[area] = total
+
+        if args.verbose and rows:
+            print('map_report: %s' % area)
+            print('  %-32s %8s %8s %8s' % ('', 'flash', 'data', 'bss'))
+            for name, sizes in rows:
+                print('  %-32s %8d %8d %8d' % (name, sizes['flash'], sizes['data'], sizes['bss']))
+
+    for area, total in totals.items():
+        print('map_report: %-5s flash %7d  data %6d  bss %6d  (RAM %d)' %
+              (area, total['flash'], total['data'], total['bss'], total['data'] + total['bss']))
+
+    sym = read_assignments(args.map)
+    heap = sym.get('__HeapLimit', 0) - sym.get('__end__', sym.get('end', 0))
+    stack = sym.get('__StackTop', 0) - sym.get('__StackBottom', 0)
+    stack1 = sym.get('__StackOneTop', 0) - sym.get('__StackOneBottom', 0)
+    print('map_report: heap %d, core 0 stack %d, core 1 stack %d' % (heap, stack, stack1))
+
+    failed = []
+    src_ram = totals['src']['data'] + totals['src']['bss']
+    lvgl_ram = totals['lvgl']['data'] + totals['lvgl']['bss']
+    if args.max_src_ram and src_ram > args.max_src_ram:
+        failed.append('src/ uses %d bytes of RAM, budget %d' % (src_ram, args.max_src_ram))
+    if args.max_lvgl_ram and lvgl_ram > args.max_lvgl_ram:
+        failed.append('LVGL uses %d bytes of RAM, budget %d' % (lvgl_ram, args.max_lvgl_ram))
+    if args.min_heap and heap < args.min_heap:
+        failed.append('heap is %d bytes, needs %d' % (heap, args.min_heap))
+    if args.min_stack and stack < args.min_stack:
+        failed.append('core 0 stack is %d bytes, needs %d' % (stack, args.min_stack))
+
+    for f in failed:
+        print('map_report: over budget: %s' % f, file=sys.stderr)
+    return 1 if failed else 0
+
+
+def flash_calls(args, sections):
+    """Calls from the SRAM functions in the given sections into flash, as (caller, callee)."""
+    if not sections:
+        return []
+    start = min(s.addr for s in sections)
+    stop = max(s.addr + s.size for s in sections)
+    out = subprocess.run([args.objdump, '-D', '--start-address=0x%x' % start, '--stop-address=0x%x' % stop,
+                          args.elf], check=True, capture_output=True, text=True).stdout
+
+    calls = []
+    caller = None
+    for line in out.splitlines():
+        m = DISASM_LABEL.match(line)
+        if m:
+            addr = int(m.group(1), 16)
+            hot = any(s.addr <= addr < s.addr + s.size for s in sections)
+            caller = m.group(2) if hot and not VENEER.match(m.group(2)) else None
+            continue
+        m = DISASM_CALL.search(line)
+        if not caller or not m:
+            continue
+        veneer = VENEER.match(m.group(2))
+        if veneer or int(m.group(1), 16) < SRAM_BASE:
+            callee = veneer.group(1) if veneer else m.group(2)
+            if callee not in args.allow and (caller, callee) not in calls:
+                calls.append((caller, callee))
+    return calls
+
+
+def hot_report(args):
+    sections = [s for s in read_sections(args.map) if s.name.startswith('.time_critical')]
+    if not sections:
+        print('map_report: nothing is placed in SRAM')
+        return 0
+
+    total = 0
+    print('map_report: functions and tables moved to SRAM')
+    for s in sorted(sections, key=lambda s: (s.source, s.name)):
+        total += s.size
+        what = ', '.join(s.symbols) if s.symbols else s.name[len('.time_critical.'):]
+        print('  %6d  %-24s %s' % (s.size, s.source, what))
+    print('map_report: SRAM cost %d bytes' % total)
+
+    failed = 0
+    if args.max_bytes and total > args.max_bytes:
+        print('map_report: SRAM hot paths exceed %d bytes' % args.max_bytes, file=sys.stderr)
+        failed = 1
+
+    if args.elf:
+        app_sources = {f for f in os.listdir(args.app_src) if f.endswith('.c')} if args.app_src else set()
+        modules = lvgl_modules(args.lvgl_src)
+        own = [s for s in sections if (not app_sources and not modules) or s.source in app_sources or s.source in modules]
+        calls = flash_calls(args, own)
+        for caller, callee in calls:
+            print('map_report: %s in SRAM calls %s in flash' % (caller, callee), file=sys.stderr)
+        if calls:
+            failed = 1
+        else:
+            print('map_report: no calls from the SRAM hot paths into flash')
+    return failed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    hot = sub.add_parser('hot', help='report the .time_critical sections')
+    hot.add_argument('--max-bytes', type=int, default=0, help='fail if more than this is moved to SRAM')
+    hot.add_argument('--elf', help='firmware ELF, check the hot paths for calls into flash')
+    hot.add_argument('--objdump', default='arm-none-eabi-objdump')
+    hot.add_argument('--app-src', help='application source directory, its SRAM functions are checked')
+    hot.add_argument('--lvgl-src', help='LVGL src directory, its SRAM functions are checked')
+    hot.add_argument('--allow', action='append', default=[], metavar='FUNC',
+                     help='a flash callee that is fine, e.g. one only reached on a failure')
+    hot.add_argument('map')
+    hot.set_defaults(func=hot_report)
+
+    ram = sub.add_parser('ram', help='report RAM use per file and module, check budgets')
+    ram.add_argument('--app-src', help='application source directory')
+    ram.add_argument('--lvgl-src', help='LVGL src directory')
+    ram.add_argument('--max-src-ram', type=int, default=0)
+    ram.add_argument('--max-lvgl-ram', type=int, default=0)
+    ram.add_argument('--min-heap', type=int, default=0)
+    ram.add_argument('--min-stack', type=int, default=0)
+    ram.add_argument('-v', '--verbose', action='store_true', help='list every file and module')
+    ram.add_argument('map')
+    ram.set_defaults(func=ram_report)
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
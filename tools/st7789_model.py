@@ -0,0 +1,328 @@
+#!/usr/bin/env python3
+"""Replay an LCD trace on a model of the ST7789 and report the SPI traffic.
+
+A build with UI_FRAME_CAPTURE traces every command and pixel written to the panel
+(src/frame_capture.c): from boot to the end of the boot scenes, and again after the shell
+'trace' command. The model decodes CASET, RASET, RAMWR, RAMWRC and MADCTL into a
+240x320 RGB565 frame memory and reports, for every refresh (the flushes up to the last
+one of an LVGL refresh):
+
+  cmds       commands sent, RAMWR included
+  windows    CASET/RASET sent, and how many of them set the window already in place
+  pixels     pixels written, and how many of them already had that value
+  bytes      bytes on the wire: command bytes, parameters and 2 bytes per pixel
+  useful     share of the bytes that changed a pixel
+  inval      pixels LVGL invalidated, overlapping areas counted twice
+
+The draw buffers are flushed as rendered, so the pixels written are the pixels the
+renderer drew. --heatmaps accumulates, per pixel, how often it was invalidated, written,
+changed, and written without changing ('wasted'), and writes each as a PNG scaled to its
+maximum count.
+
+  st7789_model.py trace.txt
+  st7789_model.py trace.txt --png panel.png --frames-png frames/ --heatmaps heat/
+  st7789_model.py --port /dev/ttyUSB0 --timeout 30 --png panel.png   (needs pyserial)
+"""
+
+import argparse
+import collections
+import os
+import struct
+import sys
+import zlib
+
+WIDTH = 240
+HEIGHT = 320
+
+CASET = 0x2a
+RASET = 0x2b
+RAMWR = 0x2c
+MADCTL = 0x36
+RAMWRC = 0x3c
+
+MADCTL_MY = 0x80
+MADCTL_MX = 0x40
+MADCTL_MV = 0x20
+
+COMMAND_NAMES = {
+    0x01: 'SWRESET', 0x10: 'SLPIN', 0x11: 'SLPOUT', 0x13: 'NORON', 0x20: 'INVOFF', 0x21: 'INVON',
+    0x26: 'GAMSET', 0x28: 'DISPOFF', 0x29: 'DISPON', CASET: 'CASET', RASET: 'RASET', RAMWR: 'RAMWR',
+    MADCTL: 'MADCTL', 0x3a: 'COLMOD', RAMWRC: 'RAMWRC', 0xb2: 'PORCTRL', 0xb7: 'GCTRL', 0xbb: 'VCOMS',
+    0xc0: 'LCMCTRL', 0xc2: 'VDVVRHEN', 0xc3: 'VRHS', 0xc4: 'VDVS', 0xc6: 'FRCTRL2', 0xd0: 'PWCTRL1',
+    0xe0: 'PVGAMCTRL', 0xe1: 'NVGAMCTRL',
+}
+
+
+class TrafficStats:
+    def __init__(self):
+        self.commands = 0
+        self.window_sets = 0
+        self.redundant_window_sets = 0
+        self.pixels = 0
+        self.unchanged_pixels = 0
+        self.bytes = 0
+        self.invalidated = 0
+
+    def add(self, other):
+        for k, v in vars(other).items():
+            setattr(self, k, getattr(self, k) + v)
+
+    @property
+    def useful_pct(self):
+        changed = self.pixels - self.unchanged_pixels
+        return 100.0 * changed * 2 / self.bytes if self.bytes else 0.0
+
+
+class St7789:
+    def __init__(self, width=WIDTH, height=HEIGHT, on_frame=None):
+        self.on_frame = on_frame
+        self.width = width
+        self.height = height
+        self.ram = [0] * (width * height)
+        self.written = [False] * (width * height)
+        self.covered = [False] * (width * height)   # Written since clear_coverage()
+        self.heat = {k: [0] * (width * height) for k in ('invalidated', 'written', 'changed')}
+        self.madctl = 0
+        self.cols = (0, width - 1)
+        self.rows = (0, height - 1)
+        self.x = 0
+        self.y = 0
+        self.frame = TrafficStats()
+        self.frames = []
+        self.total = TrafficStats()
+        self.command_counts = collections.Counter()
+
+    def command(self, cmd, params):
+        self.command_counts[cmd] += 1
+        self.frame.commands += 1
+        self.frame.bytes += 1 + len(params)
+
+        if cmd in (CASET, RASET) and len(params) >= 4:
+            window = ((params[0] << 8) | params[1], (params[2] << 8) | params[3])
+            self.frame.window_sets += 1
+            if window == (self.cols if cmd == CASET else self.rows):
+                self.frame.redundant_window_sets += 1
+            if cmd == CASET:
+                self.cols = window
+            else:
+                self.rows = window
+        elif cmd == RAMWR:
+            self.x, self.y = self.cols[0], self.rows[0]
+        elif cmd == MADCTL and params:
+            self.madctl = params[0]
+
+    def address(self, x, y):
+        """Frame memory index of window position x, y, or None if it is off the panel."""
+        col, row = (y, x) if self.madctl & MADCTL_MV else (x, y)
+        if self.madctl & MADCTL_MX:
+            col = self.width - 1 - col
+        if self.madctl & MADCTL_MY:
+            row = self.height - 1 - row
+        if 0 <= col < self.width and 0 <= row < self.height:
+            return row * self.width + col
+        return None
+
+    def pixel(self, value):
+        i = self.address(self.x, self.y)
+        self.frame.pixels += 1
+        self.frame.bytes += 2
+        if i is not None:
+            self.heat['written'][i] += 1
+            if self.written[i] and self.ram[i] == value:
+                self.frame.unchanged_pixels += 1
+            else:
+                self.heat['changed'][i] += 1
+            self.ram[i] = value
+            self.written[i] = True
+            self.covered[i] = True
+
+        self.x += 1
+        if self.x > self.cols[1]:
+            self.x = self.cols[0]
+            self.y += 1
+            if self.y > self.rows[1]:
+                self.y = self.rows[0]
+
+    def invalidate(self, x1, y1, x2, y2):
+        """An area LVGL marked for redraw, in display coordinates (rotation 0 here)."""
+        x1, y1 = max(x1, 0), max(y1, 0)
+        x2, y2 = min(x2, self.width - 1), min(y2, self.height - 1)
+        for y in range(y1, y2 + 1):
+            for x in range(x1, x2 + 1):
+                self.heat['invalidated'][y * self.width + x] += 1
+        self.frame.invalidated += max(0, x2 - x1 + 1) * max(0, y2 - y1 + 1)
+
+    def clear_coverage(self):
+        self.covered = [False] * (self.width * self.height)
+
+    def end_frame(self):
+        self.frames.append(self.frame)
+        self.total.add(self.frame)
+        self.frame = TrafficStats()
+        if self.on_frame:
+            self.on_frame(self)
+
+
+def replay(lines, panel):
+    """Feeds the trace to the panel. Yields the records the panel does not handle (begin,
+    end, done) as (kind, args) after everything before them has been applied."""
+    for raw in lines:
+        words = raw.strip().split()
+        if len(words) < 2 or words[0] != 'fc':
+            continue
+        kind, args = words[1], words[2:]
+
+        if kind == 'cmd' and args:
+            panel.command(int(args[0], 16), [int(a, 16) for a in args[1:]])
+        elif kind == 'px':
+            for run in args:
+                count, _, colour = run.rpartition('*')
+                colour = int(colour, 16)
+                for _ in range(int(count) if count else 1):
+                    panel.pixel(colour)
+        elif kind == 'inv' and len(args) == 4:
+            panel.invalidate(*(int(a) for a in args))
+        elif kind == 'frame':
+            panel.end_frame()
+        else:
+            yield kind, args
+
+
+def rgb565_to_rgb(v):
+    r, g, b = (v >> 11) & 0x1F, (v >> 5) & 0x3F, v & 0x1F
+    return (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)
+
+
+def frame_rows(width, height, pixels):
+    for y in range(height):
+        row = []
+        for v in pixels[y * width:(y + 1) * width]:
+            row.extend(rgb565_to_rgb(v))
+        yield row
+
+
+def png_chunk(kind, data):
+    body = kind + data
+    return struct.pack('>I', len(data)) + body + struct.pack('>I', zlib.crc32(body) & 0xFFFFFFFF)
+
+
+def write_png(path, width, height, rgb_rows):
+    raw = b''.join(b'\x00' + bytes(row) for row in rgb_rows)
+    with open(path, 'wb') as f:
+        f.write(b'\x89PNG\r\n\x1a\n')
+        f.write(png_chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, 8, 2, 0, 0, 0)))
+        f.write(png_chunk(b'IDAT', zlib.compress(raw, 9)))
+        f.write(png_chunk(b'IEND', b''))
+
+
+def heat_colour(t):
+    """Black, blue, red, yellow, white for 0 to 1."""
+    stops = ((0, 0, 0), (0, 0, 255), (255, 0, 0), (255, 255, 0), (255, 255, 255))
+    pos = min(max(t, 0.0), 1.0) * (len(stops) - 1)
+    i = min(int(pos), len(stops) - 2)
+    f = pos - i
+    return tuple(int(a + (b - a) * f) for a, b in zip(stops[i], stops[i + 1]))
+
+
+def write_heatmap(path, width, height, counts):
+    """Square root scale, so single writes still show next to the hot spots."""
+    top = max(counts) or 1
+    rows = []
+    for y in range(height):
+        row = []
+        for c in counts[y * width:(y + 1) * width]:
+            row.extend(heat_colour((c / top) ** 0.5))
+        rows.append(row)
+    write_png(path, width, height, rows)
+    return top
+
+
+def read_serial(port, baud, timeout):
+    import serial   # Only needed for live captures
+    import time
+
+    lines = []
+    deadline = time.monotonic() + timeout
+    with serial.Serial(port, baud, timeout=1) as s:
+        while time.monotonic() < deadline:
+            lines.append(s.readline().decode('ascii', errors='replace'))
+    return lines
+
+
+def print_stats(name, s):
+    print('%-8s %6d %5d/%-5d %7d/%-7d %9d %6.1f%% %8d' % (name, s.commands, s.window_sets, s.redundant_window_sets,
+                                                            s.pixels, s.unchanged_pixels, s.bytes, s.useful_pct,
+                                                            s.invalidated))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('trace', nargs='?', help='text captured from the debug UART')
+    parser.add_argument('--port', help='read the trace from a serial port instead')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--timeout', type=float, default=30, help='seconds to record from the port')
+    parser.add_argument('--png', help='write the final panel contents')
+    parser.add_argument('--frames-png', help='write the panel contents after every refresh to this directory')
+    parser.add_argument('--heatmaps', help='write invalidation, write, change and overdraw heatmaps to this directory')
+    parser.add_argument('-q', '--quiet', action='store_true', help='totals only')
+    args = parser.parse_args()
+
+    if args.port:
+        lines = read_serial(args.port, args.baud, args.timeout)
+    elif args.trace:
+        with open(args.trace, encoding='ascii', errors='replace') as f:
+            lines = f.readlines()
+    else:
+        parser.error('give a trace file or --port')
+
+    def on_frame(panel):
+        n = len(panel.frames) - 1
+        if not args.quiet:
+            print_stats(str(n), panel.frames[n])
+        if args.frames_png:
+            write_png(os.path.join(args.frames_png, 'refresh_%04d.png' % n), panel.width, panel.height,
+                      frame_rows(panel.width, panel.height, panel.ram))
+
+    if args.frames_png:
+        os.makedirs(args.frames_png, exist_ok=True)
+    if not args.quiet:
+        print('%-8s %6s %11s %15s %9s %7s %8s' % ('refresh', 'cmds', 'windows/red', 'pixels/unchgd', 'bytes', 'useful',
+                                                 'inval'))
+
+    panel = St7789(on_frame=on_frame)
+    for _ in replay(lines, panel):
+        pass
+    refreshes = len(panel.frames)
+    if panel.frame.commands:
+        # Commands after the last refresh, e.g. a trace of the init sequence alone
+        panel.on_frame = None
+        panel.end_frame()
+        if not args.quiet:
+            print_stats('rest', panel.frames[-1])
+
+    if not panel.frames:
+        print('st7789_model: no LCD traffic in the trace, is UI_FRAME_CAPTURE on?', file=sys.stderr)
+        return 1
+
+    print_stats('total', panel.total)
+    print('st7789_model: %d refreshes, commands: %s' % (refreshes, ', '.join(
+        '%s %d' % (COMMAND_NAMES.get(c, '%02x' % c), n) for c, n in panel.command_counts.most_common())))
+
+    changed = panel.total.pixels - panel.total.unchanged_pixels
+    print('st7789_model: %d pixels invalidated, %d rendered, %d changed, %.2f rendered per changed pixel' %
+          (panel.total.invalidated, panel.total.pixels, changed, panel.total.pixels / changed if changed else 0.0))
+
+    if args.png:
+        write_png(args.png, panel.width, panel.height, frame_rows(panel.width, panel.height, panel.ram))
+    if args.heatmaps:
+        os.makedirs(args.heatmaps, exist_ok=True)
+        maps = dict(panel.heat)
+        maps['wasted'] = [w - c for w, c in zip(panel.heat['written'], panel.heat['changed'])]
+        for name, counts in maps.items():
+            top = write_heatmap(os.path.join(args.heatmaps, name + '.png'), panel.width, panel.height, counts)
+            print('st7789_model: %s.png, hottest pixel %d' % (name, top))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""Decode a telemetry capture into CSV.
+
+The firmware (src/telemetry.c) sends telemetry_record_t records followed by a
+CRC-16/CCITT-FALSE, COBS encoded and terminated by a zero byte. The capture may
+contain text from printf and the shell in between. Anything that does not decode
+to a record with a valid CRC is skipped and counted.
+
+  telemetry_decode.py capture.bin -o telemetry.csv
+  telemetry_decode.py --port /dev/ttyACM0 -o telemetry.csv   (needs pyserial)
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+# Must match telemetry_record_t, little endian and packed.
+RECORD = struct.Struct('<BHIHIHHHIHHHIIBHH')
+FIELDS = ['version', 'seq', 'timestamp_ms', 'battery_mv', 'loops_per_s', 'fps_x10',
+          'flush_avg_us', 'flush_max_us', 'lcd_bytes_per_s', 'touch_samples',
+          'touch_latency_avg_us', 'touch_latency_max_us', 'heap_used', 'heap_biggest_free',
+          'heap_frag_pct', 'encode_us', 'dropped']
+VERSION = 1
+FRAME_SIZE = RECORD.size + 2 + 1   # COBS encoded record and CRC, without the delimiter
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame):
+            raise ValueError('bad COBS code')
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_frame(frame):
+    """Returns the record as a dict, or None if the frame is not a valid record."""
+    try:
+        raw = cobs_decode(frame)
+    except ValueError:
+        return None
+    if len(raw) != RECORD.size + 2:
+        return None
+    body, crc = raw[:-2], raw[-2] | (raw[-1] << 8)
+    if crc16(body) != crc:
+        return None
+    record = dict(zip(FIELDS, RECORD.unpack(body)))
+    if record['version'] != VERSION:
+        return None
+    return record
+
+
+def frames(stream):
+    pending = bytearray()
+    while True:
+        chunk = stream.read(4096)
+        if not chunk:
+            break
+        pending += chunk
+        while True:
+            end = pending.find(b'\x00')
+            if end < 0:
+                break
+            frame = bytes(pending[:end])
+            del pending[:end + 1]
+            if frame:
+                yield frame
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('capture', nargs='?', help='raw capture file, - for stdin')
+    parser.add_argument('--port', help='read live from a serial port instead')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('-o', '--output', help='CSV file, stdout by default')
+    args = parser.parse_args()
+
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud, timeout=1)
+    elif args.capture and args.capture != '-':
+        stream = open(args.capture, 'rb')
+    else:
+        stream = sys.stdin.buffer
+
+    out = open(args.output, 'w', newline='') if args.output else sys.stdout
+    writer = csv.DictWriter(out, fieldnames=FIELDS)
+    writer.writeheader()
+
+    good = bad = 0
+    try:
+        for frame in frames(stream):
+            record = decode_frame(frame)
+            if record is None and len(frame) > FRAME_SIZE:
+                # Text without a zero byte ran into the frame, the record is at the end.
+                record = decode_frame(frame[-FRAME_SIZE:])
+            if record is None:
+                bad += 1
+                continue
+            writer.writerow(record)
+            good += 1
+            if args.port:
+                out.flush()
+    except KeyboardInterrupt:
+        pass
+
+    print('telemetry_decode: %d records, %d frames skipped' % (good, bad), file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""Record touch traces from the device and replay them for latency measurements.
+
+A build with TOUCH_TRACE records the raw XPT2046 readings with their times (src/touch_trace.c)
+and moves them over the debug shell as 'tt <16 hex digits>' lines: t_us (u32), x and y (u16),
+little endian. On the host a trace is a binary file: 'TTR1', the sample count (u32) and the
+samples in the same 8 byte layout.
+
+'record' starts a recording, waits while the panel is being touched and stores the trace.
+'replay' loads a trace into the device, plays it through the touch driver with its original
+timing and prints the touch to event and touch to frame latency percentiles.
+
+  touch_trace.py record --port /dev/ttyUSB0 --seconds 20 -o swipe.ttr   (needs pyserial)
+  touch_trace.py replay swipe.ttr --port /dev/ttyUSB0
+  touch_trace.py show swipe.ttr
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b'TTR1'
+SAMPLE = struct.Struct('<IHH')
+PROMPT = b'> '
+
+
+def write_trace(path, samples):
+    with open(path, 'wb') as f:
+        f.write(MAGIC + struct.pack('<I', len(samples)))
+        for s in samples:
+            f.write(SAMPLE.pack(*s))
+
+
+def read_trace(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:4] != MAGIC:
+        raise ValueError('%s: not a touch trace' % path)
+    count, = struct.unpack_from('<I', data, 4)
+    if len(data) < 8 + count * SAMPLE.size:
+        raise ValueError('%s: truncated, %d samples expected' % (path, count))
+    return [SAMPLE.unpack_from(data, 8 + i * SAMPLE.size) for i in range(count)]
+
+
+def parse_dump(lines):
+    samples = []
+    for line in lines:
+        parts = line.split()
+        if len(parts) == 2 and parts[0] == 'tt' and len(parts[1]) == 2 * SAMPLE.size:
+            try:
+                samples.append(SAMPLE.unpack(bytes.fromhex(parts[1])))
+            except ValueError:
+                continue
+    return samples
+
+
+class Shell:
+    def __init__(self, port, baud, timeout):
+        import serial   # Only needed for live captures
+        self.serial = serial.Serial(port, baud, timeout=timeout)
+        self.command('')
+
+    def command(self, text):
+        """The output lines of one shell command, up to the next prompt."""
+        self.serial.reset_input_buffer()
+        self.serial.write(text.encode('ascii') + b'\r')
+        out = self.serial.read_until(PROMPT)
+        if not out.endswith(PROMPT):
+            raise IOError('no prompt after %r, is TOUCH_TRACE on?' % text)
+        lines = out[:-len(PROMPT)].decode('ascii', errors='replace').splitlines()
+        return [l.strip() for l in lines[1:] if l.strip()]   # The first line is the echo
+
+    def close(self):
+        self.serial.close()
+
+
+def record(args):
+    import time
+
+    shell = Shell(args.port, args.baud, args.timeout)
+    shell.command('rec off')
+    shell.command('rec on')
+    print('touch_trace: recording for %g s, use the touch screen now' % args.seconds)
+    time.sleep(args.seconds)
+    shell.command('rec off')
+    samples = parse_dump(shell.command('dump'))
+    shell.close()
+
+    if not samples:
+        print('touch_trace: no samples recorded', file=sys.stderr)
+        return 1
+    write_trace(args.output, samples)
+    print('touch_trace: %d samples over %.1f s written to %s' % (len(samples), samples[-1][0] / 1e6, args.output))
+    return 0
+
+
+def replay(args):
+    import time
+
+    samples = read_trace(args.trace)
+    shell = Shell(args.port, args.baud, args.timeout)
+    shell.command('tt')
+    for s in samples:
+        out = shell.command('tt ' + SAMPLE.pack(*s).hex())
+        if not out or not out[0].startswith('tt '):
+            print('touch_trace: sample rejected: %s' % ' '.join(out), file=sys.stderr)
+            shell.close()
+            return 1
+
+    print('touch_trace: replaying %d samples over %.1f s' % (len(samples), samples[-1][0] / 1e6))
+    shell.command('play')
+    time.sleep(samples[-1][0] / 1e6 + 1)
+    while any('still running' in l for l in shell.command('lat')):
+        time.sleep(0.5)
+    for line in shell.command('lat'):
+        print('touch_trace: %s' % line)
+    shell.close()
+    return 0
+
+
+def show(args):
+    samples = read_trace(args.trace)
+    print('%10s %6s %6s' % ('t_us', 'x', 'y'))
+    for t_us, x, y in samples:
+        print('%10d %6d %6d' % (t_us, x, y))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    rec = sub.add_parser('record', help='record a trace on the device')
+    rec.add_argument('--seconds', type=float, default=10, help='how long to record')
+    rec.add_argument('-o', '--output', required=True, help='trace file')
+    rec.set_defaults(func=record)
+
+    rep = sub.add_parser('replay', help='replay a trace and report the latencies')
+    rep.add_argument('trace')
+    rep.set_defaults(func=replay)
+
+    sh = sub.add_parser('show', help='print the samples of a trace')
+    sh.add_argument('trace')
+    sh.set_defaults(func=show)
+
+    for p in (rec, rep):
+        p.add_argument('--port', required=True)
+        p.add_argument('--baud', type=int, default=115200)
+        p.add_argument('--timeout', type=float, default=5, help='seconds to wait for each command')
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
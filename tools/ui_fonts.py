@@ -0,0 +1,287 @@
+#!/usr/bin/env python3
+"""Generate subsetted LVGL fonts that contain only the glyphs the UI uses.
+
+The UI sources are scanned for text that ends up on screen:
+  - string literals passed to lv_label_set_text*() and set_clock_text()
+  - `.text = "..."` initialisers and `*_desc_t` widget tables
+  - snprintf() formats (%d expands to the digits), when the buffer they print to
+    is passed to one of the calls above in the same file
+  - `#define <NAME>_CHARS "..."` glyph lists
+
+Each requested font is then generated with lv_font_conv from the Montserrat TTF
+shipped with LVGL. The build fails if a used glyph is missing from a generated
+font. A flash report compares every subset to the stock LVGL font of the same size.
+
+With --metrics the line heights of the linked fonts (the subsets, or the stock
+fonts with --no-generate) and the widths of the --measure strings are written
+to a header, so the UI layout can be fixed at build time. Widths follow LVGL's
+rules: each glyph advance plus kerning, rounded to whole pixels.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+LITERAL = r'"((?:[^"\\]|\\.)*)"'
+
+TEXT_CALLS = [
+    re.compile(r'\blv_label_set_text(?:_static)?\s*\(([^;]*)\);', re.S),
+    re.compile(r'\bset_clock_text\s*\(([^;]*)\);', re.S),
+]
+CALL_PATTERNS = TEXT_CALLS + [
+    re.compile(r'\b\w+_desc_t\s+\w+\[\]\s*=\s*\{(.*?)\n\};', re.S),
+]
+TEXT_FIELD = re.compile(r'\.text\s*=\s*' + LITERAL)
+SNPRINTF = re.compile(r'\bsnprintf\s*\(\s*(\w+)\s*,[^,]+,\s*' + LITERAL)
+IDENTIFIER = re.compile(r'\b[A-Za-z_]\w*\b')
+CHARS_DEFINE = re.compile(r'#define\s+\w*_CHARS\s+' + LITERAL)
+FORMAT_SPEC = re.compile(r'%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l)?([diuxXcs%])')
+
+GLYPH_COMMENT = re.compile(r'/\*\s*U\+([0-9A-Fa-f]+)\s')
+BITMAP_ARRAY = re.compile(r'glyph_bitmap\[\]\s*=\s*\{(.*?)\};', re.S)
+GLYPH_DSC = re.compile(r'\{\s*\.bitmap_index\s*=')
+
+GLYPH_DSC_ADV = re.compile(r'\{\s*\.bitmap_index\s*=\s*\d+\s*,\s*\.adv_w\s*=\s*(\d+)')
+FONT_FIELD = r'\.%s\s*=\s*(-?\d+)'
+
+GLYPH_DSC_SIZE = 8   # sizeof(lv_font_fmt_txt_glyph_dsc_t)
+
+
+def unescape(literal):
+    return bytes(literal, 'utf-8').decode('unicode_escape').encode('latin-1').decode('utf-8')
+
+
+def expand_format(fmt):
+    glyphs = set()
+    pos = 0
+    for m in FORMAT_SPEC.finditer(fmt):
+        glyphs.update(fmt[pos:m.start()])
+        conv = m.group(1)
+        if conv in 'diu':
+            glyphs.update('0123456789')
+        elif conv in 'xX':
+            glyphs.update('0123456789abcdef' if conv == 'x' else '0123456789ABCDEF')
+        elif conv == '%':
+            glyphs.add('%')
+        # %s and %c take their text from elsewhere, which is scanned separately
+        pos = m.end()
+    glyphs.update(fmt[pos:])
+    return glyphs
+
+
+def scan_sources(paths):
+    glyphs = set()
+    for path in paths:
+        with open(path, encoding='utf-8') as f:
+            text = f.read()
+
+        for pattern in CALL_PATTERNS:
+            for call in pattern.finditer(text):
+                for literal in re.finditer(LITERAL, call.group(1)):
+                    glyphs.update(unescape(literal.group(1)))
+
+        for m in TEXT_FIELD.finditer(text):
+            glyphs.update(unescape(m.group(1)))
+
+        for m in CHARS_DEFINE.finditer(text):
+            glyphs.update(unescape(m.group(1)))
+
+        # Only buffers that end up on screen, not benchmark names or shell output
+        shown = set()
+        for pattern in TEXT_CALLS:
+            for call in pattern.finditer(text):
+                shown.update(IDENTIFIER.findall(re.sub(LITERAL, '', call.group(1))))
+        for m in SNPRINTF.finditer(text):
+            if m.group(1) in shown:
+                glyphs.update(expand_format(unescape(m.group(2))))
+
+    glyphs.discard('\n')
+    glyphs.discard('\r')
+    return ''.join(sorted(glyphs))
+
+
+def font_stats(path):
+    """Returns (glyph count, approximate table bytes) of an LVGL font C file."""
+    with open(path, encoding='utf-8') as f:
+        text = f.read()
+
+    m = BITMAP_ARRAY.search(text)
+    bitmap_bytes = m.group(1).count('0x') if m else 0
+    glyphs = len(GLYPH_DSC.findall(text))
+    return glyphs, bitmap_bytes + glyphs * GLYPH_DSC_SIZE
+
+
+def generated_glyphs(path):
+    with open(path, encoding='utf-8') as f:
+        return {chr(int(cp, 16)) for cp in GLYPH_COMMENT.findall(f.read())}
+
+
+def int_array(text, name):
+    m = re.search(r'\b%s\[\]\s*=\s*\{(.*?)\};' % name, text, re.S)
+    if not m:
+        return []
+    body = re.sub(r'/\*.*?\*/', '', m.group(1), flags=re.S)
+    return [int(v, 0) for v in re.findall(r'-?(?:0x[0-9a-fA-F]+|\d+)', body)]
+
+
+class FontMetrics:
+    """Glyph advances and kerning of an lv_font_conv generated font file."""
+
+    def __init__(self, path):
+        with open(path, encoding='utf-8') as f:
+            text = f.read()
+
+        # Glyph ids follow the order of the bitmap comments, id 0 is reserved.
+        bitmap = BITMAP_ARRAY.search(text).group(1)
+        codepoints = [int(cp, 16) for cp in GLYPH_COMMENT.findall(bitmap)]
+        advances = [int(a) for a in GLYPH_DSC_ADV.findall(text)]
+        self.glyph_id = {cp: i + 1 for i, cp in enumerate(codepoints)}
+        self.adv_w = advances
+
+        self.line_height = int(re.search(FONT_FIELD % 'line_height', text).group(1))
+        self.base_line = int(re.search(FONT_FIELD % 'base_line', text).group(1))
+        m = re.search(FONT_FIELD % 'kern_scale', text)
+        self.kern_scale = int(m.group(1)) if m else 0
+
+        self.left_class = int_array(text, 'kern_left_class_mapping')
+        self.right_class = int_array(text, 'kern_right_class_mapping')
+        self.class_values = int_array(text, 'kern_class_values')
+        m = re.search(FONT_FIELD % 'right_class_cnt', text)
+        self.right_class_cnt = int(m.group(1)) if m else 0
+
+        pair_ids = int_array(text, 'kern_pair_glyph_ids')
+        pair_values = int_array(text, 'kern_pair_values')
+        self.pairs = {(pair_ids[2 * i], pair_ids[2 * i + 1]): v for i, v in enumerate(pair_values)}
+
+    def kerning(self, left, right):
+        if left is None or right is None or self.kern_scale == 0:
+            return 0
+
+        value = 0
+        if self.class_values:
+            lc = self.left_class[left]
+            rc = self.right_class[right]
+            if lc > 0 and rc > 0:
+                value = self.class_values[(lc - 1) * self.right_class_cnt + (rc - 1)]
+        else:
+            value = self.pairs.get((left, right), 0)
+        return (value * self.kern_scale) >> 4
+
+    def text_width(self, text):
+        width = 0
+        for i, c in enumerate(text):
+            gid = self.glyph_id.get(ord(c))
+            if gid is None:
+                raise KeyError('glyph %r is not in the font' % c)
+            nxt = self.glyph_id.get(ord(text[i + 1])) if i + 1 < len(text) else None
+            width += (self.adv_w[gid] + self.kerning(gid, nxt) + (1 << 3)) >> 4
+        return width
+
+
+def write_metrics(path, fonts, measures):
+    lines = ['// Generated by tools/ui_fonts.py, do not edit.',
+             '#ifndef _UI_FONT_METRICS_H',
+             '#define _UI_FONT_METRICS_H',
+             '']
+    for name, metrics in fonts.items():
+        lines.append('#define %-32s (%d)' % (name.upper() + '_LINE_HEIGHT', metrics.line_height))
+        lines.append('#define %-32s (%d)' % (name.upper() + '_BASE_LINE', metrics.base_line))
+    lines.append('')
+    for label, font, text in measures:
+        lines.append('#define %-32s (%d)   // "%s"' % ('UI_TEXT_WIDTH_' + label.upper(), fonts[font].text_width(text), text))
+    lines += ['', '#endif   // _UI_FONT_METRICS_H', '']
+
+    content = '\n'.join(lines)
+    if os.path.exists(path):
+        with open(path, encoding='utf-8') as f:
+            if f.read() == content:
+                return
+    with open(path, 'w', encoding='utf-8') as f:
+        f.write(content)
+
+
+def generate(args, name, size, symbols):
+    out = os.path.join(args.out_dir, name + '.c')
+    cmd = [args.lv_font_conv,
+           '--font', args.ttf,
+           '--size', str(size),
+           '--bpp', str(args.bpp),
+           '--format', 'lvgl',
+           '--symbols', symbols,
+           '--lv-font-name', name,
+           '--lv-include', 'lvgl.h',
+           '-o', out]
+    if not args.compress:
+        cmd.append('--no-compress')
+
+    subprocess.run(cmd, check=True)
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--lv-font-conv', default='lv_font_conv')
+    parser.add_argument('--ttf', required=True)
+    parser.add_argument('--out-dir', required=True)
+    parser.add_argument('--stock-dir', help='LVGL src/font directory for the flash report')
+    parser.add_argument('--bpp', type=int, default=4)
+    parser.add_argument('--compress', action='store_true')
+    parser.add_argument('--font', action='append', required=True, metavar='NAME:SIZE')
+    parser.add_argument('--no-generate', action='store_true', help='use the stock fonts, only write metrics')
+    parser.add_argument('--metrics', help='header to write the font metrics to')
+    parser.add_argument('--measure', action='append', default=[], metavar='LABEL:FONT_NAME:TEXT')
+    parser.add_argument('sources', nargs='+')
+    args = parser.parse_args()
+
+    symbols = scan_sources(args.sources)
+    if not symbols:
+        print('ui_fonts: no UI text found in ' + ' '.join(args.sources), file=sys.stderr)
+        return 1
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    print('ui_fonts: glyphs used by the UI: "%s"' % symbols)
+
+    fonts = {}
+    total_saved = 0
+    for spec in args.font:
+        name, size = spec.split(':')
+        if args.no_generate:
+            fonts[name] = FontMetrics(os.path.join(args.stock_dir, 'lv_font_montserrat_%s.c' % size))
+            continue
+
+        out = generate(args, name, int(size), symbols)
+
+        missing = set(symbols) - set(' ') - generated_glyphs(out)
+        if missing:
+            print('ui_fonts: %s is missing glyphs: %s' % (name, ' '.join(sorted(missing))), file=sys.stderr)
+            os.remove(out)
+            return 1
+
+        fonts[name] = FontMetrics(out)
+        glyphs, size_bytes = font_stats(out)
+        line = 'ui_fonts: %-12s %3d glyphs %7d bytes' % (name, glyphs, size_bytes)
+
+        stock = os.path.join(args.stock_dir, 'lv_font_montserrat_%s.c' % size) if args.stock_dir else None
+        if stock and os.path.exists(stock):
+            stock_glyphs, stock_bytes = font_stats(stock)
+            total_saved += stock_bytes - size_bytes
+            line += ' (stock %3d glyphs %7d bytes, saved %d)' % (stock_glyphs, stock_bytes, stock_bytes - size_bytes)
+        print(line)
+
+    if args.stock_dir and not args.no_generate:
+        print('ui_fonts: flash saved %d bytes' % total_saved)
+
+    if args.metrics:
+        measures = [m.split(':', 2) for m in args.measure]
+        try:
+            write_metrics(args.metrics, fonts, measures)
+        except KeyError as e:
+            print('ui_fonts: cannot measure: %s' % e, file=sys.stderr)
+            return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,7 +1,16 @@
 #include <pico/time.h>
 #include <stdio.h>
 #include "pico/stdlib.h"
+#include "bench.h"
+#include "boot_sequencer.h"
+#include "clock_governor.h"
 #include "debug_messages.h"
+#include "kv_store.h"
+#include "metrics.h"
+#include "perf_counters.h"
+#include "power_manager.h"
+#include "stack_monitor.h"
+#include "telemetry.h"
 #include "display_framework.h"
 #include "tick_count.h"
 #include "touch_screen.h"
@@ -15,11 +24,58 @@ static repeating_timer_t battery_monitor_timer;
 static bool debug_messages_timer_cb(repeating_timer_t *rt);
 static bool check_battery_health_cb(repeating_timer_t *rt);
 
+static void main_loop_iteration()
+{
+    tick_ui();
+    tick_touch_screen();
+    tick_battery_monitor();
+    tick_kv_store(ui_is_idle());
+    tick_perf_counters();
+    check_for_messages();
+    tick_telemetry();
+    metrics_loop_tick();
+    // A touch in progress keeps full speed, LVGL boosts for each render itself.
+    tick_clock_governor(touch_screen_read_pending() || ui_idle_ms() < 100);
+    tick_power_manager();
+}
+
+#ifdef BENCHMARK_SUITE
+// Runs before the power manager and the clock governor start, so every build is measured at
+// the boot clock and nothing sleeps.
+static void run_benchmarks()
+{
+    bench_header();
+    touch_screen_benchmark();
+    ui_benchmark();
+
+    const uint32_t iterations = 1000;
+    const uint64_t start_us = time_us_64();
+    for (uint32_t i = 0; i < iterations; i++) {
+        main_loop_iteration();
+    }
+    bench_report("main.loop_iteration", iterations, time_us_64() - start_us, 0);
+    bench_done();
+}
+#endif
+
+// Touch and ADC have no waits of their own, they run while the LCD comes out of reset.
+static const boot_step_t peripheral_boot_steps[] = {
+    {"touch",   init_touch_screen,    0, BootTouchReady, 0},
+    {"battery", battery_monitor_init, 0, 0,              0},
+};
+
 int main()
 {
+    stack_monitor_paint();
     stdio_init_all();
     setup_isr();
 
+#ifdef KV_STORE_BENCHMARK
+    kv_store_benchmark();
+#endif
+    // Settings are needed by the boot steps, the UI shows them with the first frame.
+    kv_store_init(kv_flash_pico_port());
+
     {
         const bool success = (initialise_gui() == 0);
         if (!success) {
@@ -27,33 +83,46 @@ int main()
         }
     }
 
+    boot_sequencer_add_track(peripheral_boot_steps, sizeof(peripheral_boot_steps) / sizeof(peripheral_boot_steps[0]));
+    boot_sequencer_run();
+    printf("Boot to touch ready: %d ms\n\r", (int)boot_sequencer_reached_at_ms(BootTouchReady | BootDisplayReady | BootGuiReady));
+    stack_monitor_report();
+#ifdef BENCHMARK_SUITE
+    run_benchmarks();
+#endif
+
     {
-        init_touch_screen();
+        const power_config_t power_config = {.idle_timeout_ms = POWER_IDLE_TIMEOUT_MS, .wake_budget_us = POWER_WAKE_BUDGET_US};
+        power_manager_init(power_pico_port(), &power_config);
     }
+    clock_governor_init(CLOCK_GOVERNOR_IDLE_HZ);
 
+    // Both only serve the main loop, the power manager stops them while the core sleeps.
     {
-        const bool success = add_repeating_timer_ms(ONE_SECOND_MS, debug_messages_timer_cb, NULL, &debug_messages_timer);
+        const bool success = power_pico_add_loop_timer(&debug_messages_timer, ONE_SECOND_MS, debug_messages_timer_cb);
         if (!success) {
             printf("ERROR: Failed to create debug messages timer.");
         }
     }
 
     {
-        battery_monitor_init();
-        const bool success = add_repeating_timer_ms(ONE_SECOND_MS, check_battery_health_cb, NULL, &battery_monitor_timer);
+        const bool success = power_pico_add_loop_timer(&battery_monitor_timer, ONE_SECOND_MS, check_battery_health_cb);
+        if (!success) {
+            printf("ERROR: Failed to create battery monitor timer.");
+        }
     }
 
     while (true) {
-        tick_ui();
-        tick_touch_screen();
-        tick_battery_monitor();
+        main_loop_iteration();
     }
 }
 
 bool debug_messages_timer_cb(repeating_timer_t *rt) {
     debug_msg_flush_count++;
+    return true;
 }
 
 bool check_battery_health_cb(repeating_timer_t *rt) {
     battery_monitor_cnt++;
+    return true;
 }